@@ -0,0 +1,24 @@
+include(CheckCSourceCompiles)
+function(check_mpicommshared)
+
+  set(CMAKE_REQUIRED_LIBRARIES MPI::MPI_C)
+
+  # MPI_COMM_TYPE_SHARED may be an enumerator rather than a macro,
+  # which check_symbol_exists does not detect.
+  check_c_source_compiles(
+    "
+        #include <mpi.h>
+        int main() {
+          MPI_Comm subcomm;
+          MPI_Init ((int *) 0, (char ***) 0);
+          MPI_Comm_split_type (MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+                               MPI_INFO_NULL, &subcomm);
+          MPI_Finalize ();
+          return 0;
+        }
+    "
+    SC_ENABLE_MPICOMMSHARED)
+
+endfunction()
+
+check_mpicommshared()
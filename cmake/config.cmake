@@ -47,6 +47,30 @@ else()
   endif()
 endif()
 
+# zstd is optional and used for streaming compression in sc_io
+find_path(ZSTD_INCLUDE_DIR zstd.h)
+find_library(ZSTD_LIBRARY zstd)
+if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+  set(CMAKE_REQUIRED_INCLUDES ${ZSTD_INCLUDE_DIR})
+  set(CMAKE_REQUIRED_LIBRARIES ${ZSTD_LIBRARY})
+
+  check_c_source_compiles("#include <zstd.h>
+  int main(void)
+  {
+    ZSTD_CCtx *c = ZSTD_createCCtx ();
+    ZSTD_outBuffer out = { NULL, 0, 0 };
+    ZSTD_inBuffer in = { NULL, 0, 0 };
+    ZSTD_compressStream2 (c, &out, &in, ZSTD_e_end);
+    return 0;
+  }"
+  SC_HAVE_ZSTD
+  )
+  unset(CMAKE_REQUIRED_INCLUDES)
+  unset(CMAKE_REQUIRED_LIBRARIES)
+else()
+  set(SC_HAVE_ZSTD 0 CACHE BOOL "Zstd not found")
+endif()
+
 find_package(Threads)
 
 if(json)
@@ -102,10 +126,14 @@ set(SC_CPPFLAGS \"\")
 set(SC_LDFLAGS \"${MPI_C_LINK_FLAGS}\")
 
 if(SC_HAVE_ZLIB)
-  set(SC_LIBS \"${ZLIB_LIBRARIES}\ m\")
+  set(SC_LIBS "${ZLIB_LIBRARIES}\ m")
 else()
-  set(SC_LIBS \"m\")
+  set(SC_LIBS "m")
 endif()
+if(SC_HAVE_ZSTD)
+  set(SC_LIBS "${ZSTD_LIBRARY}\ ${SC_LIBS}")
+endif()
+set(SC_LIBS \"${SC_LIBS}\")
 
 set(SC_ENABLE_PTHREAD ${CMAKE_USE_PTHREADS_INIT})
 set(SC_ENABLE_MEMALIGN 1)
@@ -120,7 +148,8 @@ if(NOT SC_ENABLE_MPI EQUAL CACHE{SC_ENABLE_MPI})
 endif()
 
 if(SC_ENABLE_MPI)
-  check_symbol_exists(MPI_COMM_TYPE_SHARED mpi.h SC_ENABLE_MPICOMMSHARED)
+  # perform check to set SC_ENABLE_MPICOMMSHARED
+  include(cmake/check_mpicommshared.cmake)
   # perform check to set SC_ENABLE_MPIIO
   include(cmake/check_mpiio.cmake)
   check_symbol_exists(MPI_Init_thread mpi.h SC_ENABLE_MPITHREAD)
@@ -140,6 +169,7 @@ check_symbol_exists(backtrace_symbols execinfo.h SC_HAVE_BACKTRACE_SYMBOLS)
 
 check_include_file(execinfo.h SC_HAVE_EXECINFO_H)
 check_symbol_exists(fsync unistd.h SC_HAVE_FSYNC)
+check_symbol_exists(mmap sys/mman.h SC_HAVE_MMAP)
 check_include_file(inttypes.h SC_HAVE_INTTYPES_H)
 check_include_file(memory.h SC_HAVE_MEMORY_H)
 
@@ -162,6 +192,32 @@ if(SC_HAVE_QSORT_R)
 endif()
 set(CMAKE_REQUIRED_DEFINITIONS)
 
+check_c_source_compiles("#include <stddef.h>
+int main(void)
+{
+  int i = 0; size_t zz = 0; void *p = NULL;
+  (void) __atomic_fetch_add (&i, 1, __ATOMIC_RELAXED);
+  (void) __atomic_fetch_sub (&zz, 1, __ATOMIC_ACQ_REL);
+  (void) __atomic_compare_exchange_n (&p, &p, NULL, 0,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+  return __atomic_load_n (&i, __ATOMIC_RELAXED) != 1;
+}"
+SC_HAVE_ATOMIC_BUILTINS)
+
+check_c_source_compiles("__attribute__ ((target_clones (\"avx512f\", \"avx2\", \"default\")))
+static int sc_simd_add (const int *a, int n)
+{
+  int i, s = 0;
+  for (i = 0; i < n; ++i) s += a[i];
+  return s;
+}
+int main(void)
+{
+  int a[4] = { 1, 2, 3, 4 };
+  return sc_simd_add (a, 4) != 10;
+}"
+SC_HAVE_ATTRIBUTE_TARGET_CLONES)
+
 check_symbol_exists(fabs math.h SC_HAVE_FABS)
 
 check_include_file(signal.h SC_HAVE_SIGNAL_H)
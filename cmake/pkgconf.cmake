@@ -5,6 +5,9 @@ if(SC_ENABLE_MPI)
 elseif(SC_HAVE_ZLIB)
   string(APPEND pc_req_private " zlib")
 endif()
+if(SC_HAVE_ZSTD)
+  string(APPEND pc_req_private " libzstd")
+endif()
 
 include(cmake/utils.cmake)
 convert_yn(mpi mpi_pc)
@@ -0,0 +1,28 @@
+
+dnl SC_CHECK_ATOMIC_BUILTINS(PREFIX)
+dnl Check whether the compiler supports the __atomic builtin functions
+dnl
+dnl This macro links a test program using __atomic_fetch_add and friends.
+dnl If it works, define PREFIX_HAVE_ATOMIC_BUILTINS.
+dnl
+AC_DEFUN([SC_CHECK_ATOMIC_BUILTINS], [
+  AC_MSG_CHECKING([for __atomic builtins])
+  AC_LINK_IFELSE([AC_LANG_PROGRAM(
+[[
+#include <stddef.h>
+]],[[
+  int                 i = 0;
+  size_t              zz = 0;
+  void               *p = NULL;
+
+  (void) __atomic_fetch_add (&i, 1, __ATOMIC_RELAXED);
+  (void) __atomic_fetch_sub (&zz, 1, __ATOMIC_ACQ_REL);
+  (void) __atomic_compare_exchange_n (&p, &p, NULL, 0,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+  return __atomic_load_n (&i, __ATOMIC_RELAXED) != 1;
+]])],
+    [AC_DEFINE([HAVE_ATOMIC_BUILTINS], 1,
+               [Define to 1 if the compiler supports __atomic builtins])
+     AC_MSG_RESULT([yes])],
+    [AC_MSG_RESULT([no])])
+])
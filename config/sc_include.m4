@@ -199,6 +199,25 @@ if (a == adler32_combine (a, b, len)) {;}
   [$1_HAVE_ZLIB=])
 ])
 
+dnl SC_CHECK_ZSTD(PREFIX)
+dnl Check whether ZSTD_compressStream2 is found, possibly in -lzstd.
+dnl We AC_DEFINE HAVE_ZSTD to 1 depending on whether it is found.
+dnl We set the shell variable PREFIX_HAVE_ZSTD to yes if found.
+dnl
+AC_DEFUN([SC_CHECK_ZSTD],
+[
+  SC_SEARCH_LIBS([ZSTD_compressStream2], [[#include <zstd.h>]],
+[[
+ZSTD_CCtx *c = ZSTD_createCCtx ();
+ZSTD_outBuffer out = { NULL, 0, 0 };
+ZSTD_inBuffer in = { NULL, 0, 0 };
+if (ZSTD_compressStream2 (c, &out, &in, ZSTD_e_end)) {;}
+]], [zstd],
+  [AC_DEFINE([HAVE_ZSTD], [1], [Define to 1 if zstd's ZSTD_compressStream2 links])
+   $1_HAVE_ZSTD="yes"],
+  [$1_HAVE_ZSTD=])
+])
+
 dnl SC_CHECK_JSON(PREFIX)
 dnl Check whether json_integer, json_real are found (in -ljansson).
 dnl We AC_DEFINE HAVE_JSON to 1 depending on whether it is found.
@@ -392,6 +411,7 @@ AC_DEFINE([USING_AUTOCONF], 1, [Define to 1 if using autoconf build])
 AC_CHECK_PROG([$1_HAVE_DOT], [dot], [YES], [NO])
 SC_CHECK_MATH([$1])
 SC_CHECK_ZLIB([$1])
+SC_CHECK_ZSTD([$1])
 SC_CHECK_JSON([$1])
 dnl SC_CHECK_LIB([lua53 lua5.3 lua52 lua5.2 lua51 lua5.1 lua5 lua],
 dnl              [lua_createtable], [LUA], [$1])
@@ -401,6 +421,8 @@ SC_CHECK_PTHREAD([$1])
 SC_CHECK_OPENMP([$1])
 SC_CHECK_MEMALIGN([$1])
 SC_CHECK_QSORT_R([$1])
+SC_CHECK_ATOMIC_BUILTINS([$1])
+SC_CHECK_TARGET_CLONES([$1])
 SC_CHECK_V4L2([$1])
 dnl SC_CUDA([$1])
 ])
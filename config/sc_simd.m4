@@ -0,0 +1,34 @@
+dnl sc_simd.m4 - custom macros for vectorized code
+
+dnl SC_CHECK_TARGET_CLONES(PREFIX)
+dnl Check whether the compiler can build a function for several instruction
+dnl sets and select one at runtime using the target_clones attribute.
+dnl
+dnl This macro links a test program with such a function.
+dnl If it works, define PREFIX_HAVE_ATTRIBUTE_TARGET_CLONES.
+dnl
+AC_DEFUN([SC_CHECK_TARGET_CLONES], [
+  AC_MSG_CHECKING([for the target_clones attribute])
+  AC_LINK_IFELSE([AC_LANG_PROGRAM(
+[[
+__attribute__ ((target_clones ("avx512f", "avx2", "default")))
+static int
+sc_simd_add (const int *a, int n)
+{
+  int                 i, s = 0;
+
+  for (i = 0; i < n; ++i) {
+    s += a[i];
+  }
+  return s;
+}
+]],[[
+  int                 a[4] = { 1, 2, 3, 4 };
+
+  return sc_simd_add (a, 4) != 10;
+]])],
+    [AC_DEFINE([HAVE_ATTRIBUTE_TARGET_CLONES], 1,
+               [Define to 1 if the compiler supports target_clones])
+     AC_MSG_RESULT([yes])],
+    [AC_MSG_RESULT([no])])
+])
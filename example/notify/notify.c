@@ -0,0 +1,81 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/*
+ * Benchmark all sc_notify algorithms on the communicator of this run and
+ * write the calibration file used by the SC_NOTIFY_AUTO algorithm.
+ * To collect data for several process counts, pass the previous
+ * output file with --load and the same name with --file on each run.
+ */
+
+#include <sc_notify.h>
+#include <sc_options.h>
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 first_arg;
+  int                 reps;
+  int                 retval;
+  const char         *filename, *loadname;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 'r', "reps", &reps, 3,
+                      "Time the fastest of this many runs");
+  sc_options_add_string (opt, 'f', "file", &filename, NULL,
+                         "Write the calibration to this file");
+  sc_options_add_string (opt, 'l', "load", &loadname, NULL,
+                         "Load a previous calibration to extend it");
+
+  retval = 0;
+  first_arg = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first_arg < 0 || first_arg != argc) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    retval = 1;
+  }
+  else {
+    sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+    if (loadname != NULL && sc_notify_auto_load (loadname)) {
+      SC_GLOBAL_LERRORF ("Could not load %s\n", loadname);
+    }
+    if (sc_notify_auto_calibrate (sc_MPI_COMM_WORLD, reps, filename)) {
+      SC_GLOBAL_LERROR ("Could not write the calibration\n");
+      retval = 1;
+    }
+  }
+  sc_options_destroy (opt);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return retval;
+}
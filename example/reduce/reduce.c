@@ -0,0 +1,183 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/*
+ * Time the local combine step of sc_reduce and sc_allreduce against
+ * plain element-by-element loops, and the one-pass minimum, maximum and
+ * sum against separate passes.  Only the local computation is measured.
+ */
+
+#include <sc_reduce.h>
+#include <sc_options.h>
+
+static void
+reduce_plain_max (const double *s, double *r, int n)
+{
+  int                 i;
+
+  for (i = 0; i < n; ++i)
+    if (s[i] > r[i])
+      r[i] = s[i];
+}
+
+static void
+reduce_plain_sum (const int *s, int *r, int n)
+{
+  int                 i;
+
+  for (i = 0; i < n; ++i)
+    r[i] += s[i];
+}
+
+static void
+reduce_plain_minmaxsum (const double *v, int n, double *res)
+{
+  int                 i;
+
+  res[0] = res[1] = v[0];
+  res[2] = res[3] = 0.;
+  for (i = 0; i < n; ++i)
+    res[0] = SC_MIN (res[0], v[i]);
+  for (i = 0; i < n; ++i)
+    res[1] = SC_MAX (res[1], v[i]);
+  for (i = 0; i < n; ++i)
+    res[2] += v[i];
+  for (i = 0; i < n; ++i)
+    res[3] += v[i] * v[i];
+}
+
+static void
+reduce_run (int count, int reps)
+{
+  int                 i, rep;
+  int                *isend, *irecv1, *irecv2;
+  double             *dsend, *drecv1, *drecv2;
+  double              res[4], fused[4];
+  double              t_plain, t_local;
+
+  dsend = SC_ALLOC (double, count);
+  drecv1 = SC_ALLOC (double, count);
+  drecv2 = SC_ALLOC (double, count);
+  isend = SC_ALLOC (int, count);
+  irecv1 = SC_ALLOC (int, count);
+  irecv2 = SC_ALLOC (int, count);
+  for (i = 0; i < count; ++i) {
+    dsend[i] = (double) (i % 101);
+    drecv1[i] = drecv2[i] = (double) (i % 37);
+    isend[i] = i % 103;
+    irecv1[i] = irecv2[i] = 0;
+  }
+
+  t_plain = -sc_MPI_Wtime ();
+  for (rep = 0; rep < reps; ++rep) {
+    reduce_plain_max (dsend, drecv1, count);
+  }
+  t_plain += sc_MPI_Wtime ();
+  t_local = -sc_MPI_Wtime ();
+  for (rep = 0; rep < reps; ++rep) {
+    sc_reduce_local (dsend, drecv2, count, sc_MPI_DOUBLE, sc_MPI_MAX);
+  }
+  t_local += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (!memcmp (drecv1, drecv2, count * sizeof (double)),
+                  "Max mismatch");
+  SC_GLOBAL_PRODUCTIONF ("double max: plain %g local %g\n",
+                         t_plain, t_local);
+
+  t_plain = -sc_MPI_Wtime ();
+  for (rep = 0; rep < reps; ++rep) {
+    reduce_plain_sum (isend, irecv1, count);
+  }
+  t_plain += sc_MPI_Wtime ();
+  t_local = -sc_MPI_Wtime ();
+  for (rep = 0; rep < reps; ++rep) {
+    sc_reduce_local (isend, irecv2, count, sc_MPI_INT, sc_MPI_SUM);
+  }
+  t_local += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (!memcmp (irecv1, irecv2, count * sizeof (int)),
+                  "Sum mismatch");
+  SC_GLOBAL_PRODUCTIONF ("int sum: plain %g local %g\n", t_plain, t_local);
+
+  t_plain = -sc_MPI_Wtime ();
+  for (rep = 0; rep < reps; ++rep) {
+    reduce_plain_minmaxsum (dsend, count, res);
+  }
+  t_plain += sc_MPI_Wtime ();
+  t_local = -sc_MPI_Wtime ();
+  for (rep = 0; rep < reps; ++rep) {
+    sc_reduce_minmaxsum (dsend, count, fused, fused + 1, fused + 2,
+                         fused + 3);
+  }
+  t_local += sc_MPI_Wtime ();
+  /* the values are integers, so the sums are exact */
+  SC_CHECK_ABORT (!memcmp (res, fused, 4 * sizeof (double)),
+                  "Minmaxsum mismatch");
+  SC_GLOBAL_PRODUCTIONF ("min/max/sum: separate %g fused %g\n",
+                         t_plain, t_local);
+
+  SC_FREE (dsend);
+  SC_FREE (drecv1);
+  SC_FREE (drecv2);
+  SC_FREE (isend);
+  SC_FREE (irecv1);
+  SC_FREE (irecv2);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 first_arg;
+  int                 count, reps;
+  int                 retval;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 'n', "count", &count, 1 << 16,
+                      "Number of elements per array");
+  sc_options_add_int (opt, 'r', "reps", &reps, 1000,
+                      "Number of repetitions");
+
+  retval = 0;
+  first_arg = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first_arg < 0 || first_arg != argc || count <= 0 || reps <= 0) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    retval = 1;
+  }
+  else {
+    sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+    reduce_run (count, reps);
+  }
+  sc_options_destroy (opt);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return retval;
+}
@@ -0,0 +1,239 @@
+/*
+ * adapted from libb64 by CB
+ */
+
+/*
+b64bench.c - c source to verify and time the base64 code paths
+
+Usage: sc_b64bench [megabytes [repetitions]]
+With zero megabytes only the consistency checks are run.
+*/
+
+#include "libb64.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char  *level_names[] = { "steps", "scalar", "ssse3", "avx2" };
+
+static void
+fill_random (char *data, size_t length)
+{
+  size_t              i;
+  unsigned long       x = 2463534242UL;
+
+  for (i = 0; i < length; ++i) {
+    x ^= (x << 13) & 0xffffffffUL;
+    x ^= x >> 17;
+    x ^= (x << 5) & 0xffffffffUL;
+    data[i] = (char) (x >> 7);
+  }
+}
+
+/* encode in pieces of at most chunk bytes, or all at once for chunk 0 */
+static size_t
+encode_chunked (const char *plain, size_t length, char *code, size_t chunk)
+{
+  size_t              pos, n, codelength;
+  base64_encodestate  state;
+
+  base64_init_encodestate (&state);
+  codelength = 0;
+  for (pos = 0; pos < length; pos += n) {
+    n = chunk == 0 || length - pos < chunk ? length - pos : chunk;
+    codelength += base64_encode_block (plain + pos, n, code + codelength,
+                                       &state);
+  }
+  codelength += base64_encode_blockend (code + codelength, &state);
+  return codelength;
+}
+
+static size_t
+decode_chunked (const char *code, size_t length, char *plain, size_t chunk)
+{
+  size_t              pos, n, plainlength;
+  base64_decodestate  state;
+
+  base64_init_decodestate (&state);
+  plainlength = 0;
+  for (pos = 0; pos < length; pos += n) {
+    n = chunk == 0 || length - pos < chunk ? length - pos : chunk;
+    plainlength += base64_decode_block (code + pos, n, plain + plainlength,
+                                        &state);
+  }
+  return plainlength;
+}
+
+/* insert a line break every width characters; sc_io uses 76 */
+static size_t
+wrap_lines (const char *code, size_t length, size_t width, char *wrapped)
+{
+  size_t              i, w;
+
+  for (i = w = 0; i < length; ++i) {
+    if (i > 0 && i % width == 0) {
+      wrapped[w++] = '\n';
+    }
+    wrapped[w++] = code[i];
+  }
+  return w;
+}
+
+/* compare all code paths against the original state machine */
+static int
+check_levels (int max_level)
+{
+  const size_t        maxlen = 300;
+  const size_t        chunks[] = { 0, 1, 5, 16, 31, 64 };
+  const size_t        num_chunks = sizeof (chunks) / sizeof (chunks[0]);
+  const size_t        widths[] = { 76, 37 };
+  char               *plain, *code, *ref, *wrapped, *back;
+  size_t              length, codelength, reflength, wraplength, c, w;
+  int                 level, errors = 0;
+
+  plain = (char *) malloc (maxlen);
+  code = (char *) malloc (2 * maxlen + 4);
+  ref = (char *) malloc (2 * maxlen + 4);
+  wrapped = (char *) malloc (4 * maxlen + 8);
+  back = (char *) malloc (4 * maxlen + 8);
+  fill_random (plain, maxlen);
+
+  for (length = 0; length <= maxlen; ++length) {
+    base64_set_level (BASE64_LEVEL_STEPS);
+    reflength = encode_chunked (plain, length, ref, 0);
+
+    for (level = BASE64_LEVEL_STEPS; level <= max_level; ++level) {
+      base64_set_level (level);
+      for (c = 0; c < num_chunks; ++c) {
+        codelength = encode_chunked (plain, length, code, chunks[c]);
+        if (codelength != reflength || memcmp (code, ref, reflength)) {
+          fprintf (stderr, "encode mismatch: level %s length %lu chunk %lu\n",
+                   level_names[level], (unsigned long) length,
+                   (unsigned long) chunks[c]);
+          ++errors;
+        }
+        if (decode_chunked (ref, reflength, back, chunks[c]) != length ||
+            memcmp (back, plain, length)) {
+          fprintf (stderr, "decode mismatch: level %s length %lu chunk %lu\n",
+                   level_names[level], (unsigned long) length,
+                   (unsigned long) chunks[c]);
+          ++errors;
+        }
+        for (w = 0; w < 2; ++w) {
+          wraplength = wrap_lines (ref, reflength, widths[w], wrapped);
+          if (decode_chunked (wrapped, wraplength, back, chunks[c]) != length
+              || memcmp (back, plain, length)) {
+            fprintf (stderr, "wrapped decode mismatch: level %s length %lu "
+                     "chunk %lu width %lu\n", level_names[level],
+                     (unsigned long) length, (unsigned long) chunks[c],
+                     (unsigned long) widths[w]);
+            ++errors;
+          }
+        }
+      }
+    }
+  }
+
+  free (plain);
+  free (code);
+  free (ref);
+  free (wrapped);
+  free (back);
+  return errors;
+}
+
+static double
+seconds (clock_t start)
+{
+  return (double) (clock () - start) / CLOCKS_PER_SEC;
+}
+
+int
+main (int argc, char **argv)
+{
+  size_t              length, codelength, plainlength;
+  long                megabytes = 64, repetitions = 8, r;
+  int                 level, max_level, errors;
+  char               *plain, *code, *back;
+  double              te, td, encode_base = 0., decode_base = 0.;
+  clock_t             start;
+
+  if (argc > 1) {
+    megabytes = strtol (argv[1], NULL, 10);
+  }
+  if (argc > 2) {
+    repetitions = strtol (argv[2], NULL, 10);
+  }
+  if (megabytes < 0 || repetitions < 1) {
+    fprintf (stderr, "Usage: %s [megabytes [repetitions]]\n", argv[0]);
+    return 1;
+  }
+
+  /* the level set initially is the highest one available */
+  max_level = base64_get_level ();
+  printf ("base64 code paths up to %s\n", level_names[max_level]);
+
+  errors = check_levels (max_level);
+  if (errors) {
+    fprintf (stderr, "%d consistency errors\n", errors);
+    return 1;
+  }
+  if (megabytes == 0) {
+    return 0;
+  }
+
+  length = (size_t) megabytes << 20;
+  plain = (char *) malloc (length);
+  code = (char *) malloc (2 * length + 4);
+  back = (char *) malloc (2 * length + 4);
+  if (plain == NULL || code == NULL || back == NULL) {
+    fprintf (stderr, "Out of memory\n");
+    return 1;
+  }
+  fill_random (plain, length);
+
+  printf ("%-8s %12s %12s\n", "level", "encode GB/s", "decode GB/s");
+  for (level = BASE64_LEVEL_STEPS; level <= max_level; ++level) {
+    base64_set_level (level);
+
+    codelength = 0;
+    start = clock ();
+    for (r = 0; r < repetitions; ++r) {
+      codelength = encode_chunked (plain, length, code, 0);
+    }
+    te = seconds (start);
+    if (level == BASE64_LEVEL_STEPS) {
+      encode_base = te;
+    }
+
+    plainlength = 0;
+    start = clock ();
+    for (r = 0; r < repetitions; ++r) {
+      plainlength = decode_chunked (code, codelength, back, 0);
+    }
+    td = seconds (start);
+    if (level == BASE64_LEVEL_STEPS) {
+      decode_base = td;
+    }
+
+    /* throughput is counted in plaintext bytes for both directions */
+    printf ("%-8s %12.3f %12.3f", level_names[level],
+            repetitions * (double) length / te * 1e-9,
+            repetitions * (double) length / td * 1e-9);
+    if (level > BASE64_LEVEL_STEPS) {
+      printf ("   speedup %5.2f %5.2f", encode_base / te, decode_base / td);
+    }
+    printf ("\n");
+
+    if (plainlength != length || memcmp (plain, back, length)) {
+      fprintf (stderr, "Round trip failed at level %s\n", level_names[level]);
+      ++errors;
+    }
+  }
+
+  free (plain);
+  free (code);
+  free (back);
+  return errors ? 1 : 0;
+}
@@ -11,6 +11,14 @@ For details, see http://sourceforge.net/projects/libb64
 */
 
 #include "libb64.h"
+#ifdef BASE64_SIMD_X86
+#include <immintrin.h>
+#endif
+#include <string.h>
+
+/* CB: number of characters given to the state machine at a time
+ * before the fast path is tried again */
+#define BASE64_DECODE_RUN 8
 
 static inline char
 base64_decode_value (char value_in)
@@ -29,6 +37,191 @@ base64_decode_value (char value_in)
     -1 : decoding[(int) value_in];
 }
 
+/* CB: decode complete 4-character groups until one holds a character
+ * outside of the alphabet, such as a line break or padding */
+static size_t
+base64_decode_groups (const char *code_in, size_t length_in,
+                      char *plaintext_out, size_t *consumed)
+{
+  size_t              i, o;
+  unsigned long       v;
+  signed char         a, b, c, d;
+
+  for (i = o = 0; length_in - i >= 4; i += 4, o += 3) {
+    a = (signed char) base64_decode_value (code_in[i]);
+    b = (signed char) base64_decode_value (code_in[i + 1]);
+    c = (signed char) base64_decode_value (code_in[i + 2]);
+    d = (signed char) base64_decode_value (code_in[i + 3]);
+    if ((a | b | c | d) < 0) {
+      break;
+    }
+    v = (unsigned long) a << 18 | (unsigned long) b << 12 |
+      (unsigned long) c << 6 | (unsigned long) d;
+    plaintext_out[o] = (char) (v >> 16);
+    plaintext_out[o + 1] = (char) (v >> 8);
+    plaintext_out[o + 2] = (char) v;
+  }
+  *consumed = i;
+  return o;
+}
+
+#ifdef BASE64_SIMD_X86
+
+/* CB: the vector kernels follow W. Mula and D. Lemire, "Faster Base64
+ * Encoding and Decoding Using AVX2 Instructions", ACM TOW 12(3), 2018.
+ * A block is validated by a nibble lookup and left to the scalar code
+ * if any of its characters is outside of the alphabet. */
+
+__attribute__ ((target ("ssse3")))
+static size_t
+base64_decode_ssse3 (const char *code_in, size_t length_in,
+                     char *plaintext_out, size_t *consumed)
+{
+  size_t              i, o;
+  int                 tail;
+  const __m128i       shift_lut = _mm_setr_epi8 (0, 0, 19, 4, -65, -65,
+                                                 -71, -71, 0, 0, 0, 0,
+                                                 0, 0, 0, 0);
+  const __m128i       mask_lut = _mm_setr_epi8 ((char) 0xa8, (char) 0xf8,
+                                                (char) 0xf8, (char) 0xf8,
+                                                (char) 0xf8, (char) 0xf8,
+                                                (char) 0xf8, (char) 0xf8,
+                                                (char) 0xf8, (char) 0xf8,
+                                                (char) 0xf0, 0x54, 0x50,
+                                                0x50, 0x50, 0x54);
+  const __m128i       bit_lut = _mm_setr_epi8 (0x01, 0x02, 0x04, 0x08,
+                                               0x10, 0x20, 0x40, (char) 0x80,
+                                               0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i       pack = _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                            14, 13, 12, -1, -1, -1, -1);
+  __m128i             v, hi, lo, slash, shift;
+
+  for (i = o = 0; length_in - i >= 16; i += 16, o += 12) {
+    v = _mm_loadu_si128 ((const __m128i *) (code_in + i));
+    hi = _mm_and_si128 (_mm_srli_epi32 (v, 4), _mm_set1_epi8 (0x0f));
+    lo = _mm_and_si128 (v, _mm_set1_epi8 (0x0f));
+    if (_mm_movemask_epi8
+        (_mm_cmpeq_epi8 (_mm_and_si128 (_mm_shuffle_epi8 (mask_lut, lo),
+                                        _mm_shuffle_epi8 (bit_lut, hi)),
+                         _mm_setzero_si128 ()))) {
+      break;
+    }
+
+    /* translate ASCII to 6-bit values; '/' shares its high nibble */
+    slash = _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('/'));
+    shift = _mm_or_si128 (_mm_andnot_si128 (slash,
+                                            _mm_shuffle_epi8 (shift_lut, hi)),
+                          _mm_and_si128 (slash, _mm_set1_epi8 (16)));
+    v = _mm_add_epi8 (v, shift);
+
+    /* merge the 6-bit values into three bytes per group */
+    v = _mm_maddubs_epi16 (v, _mm_set1_epi32 (0x01400140));
+    v = _mm_madd_epi16 (v, _mm_set1_epi32 (0x00011000));
+    v = _mm_shuffle_epi8 (v, pack);
+    _mm_storel_epi64 ((__m128i *) (plaintext_out + o), v);
+    tail = _mm_cvtsi128_si32 (_mm_srli_si128 (v, 8));
+    memcpy (plaintext_out + o + 8, &tail, 4);
+  }
+  *consumed = i;
+  return o;
+}
+
+__attribute__ ((target ("avx2")))
+static size_t
+base64_decode_avx2 (const char *code_in, size_t length_in,
+                    char *plaintext_out, size_t *consumed)
+{
+  size_t              i, o;
+  const __m256i       shift_lut = _mm256_setr_epi8 (0, 0, 19, 4, -65, -65,
+                                                    -71, -71, 0, 0, 0, 0,
+                                                    0, 0, 0, 0,
+                                                    0, 0, 19, 4, -65, -65,
+                                                    -71, -71, 0, 0, 0, 0,
+                                                    0, 0, 0, 0);
+  const __m256i       mask_lut =
+    _mm256_setr_epi8 ((char) 0xa8, (char) 0xf8, (char) 0xf8, (char) 0xf8,
+                      (char) 0xf8, (char) 0xf8, (char) 0xf8, (char) 0xf8,
+                      (char) 0xf8, (char) 0xf8, (char) 0xf0, 0x54,
+                      0x50, 0x50, 0x50, 0x54,
+                      (char) 0xa8, (char) 0xf8, (char) 0xf8, (char) 0xf8,
+                      (char) 0xf8, (char) 0xf8, (char) 0xf8, (char) 0xf8,
+                      (char) 0xf8, (char) 0xf8, (char) 0xf0, 0x54,
+                      0x50, 0x50, 0x50, 0x54);
+  const __m256i       bit_lut =
+    _mm256_setr_epi8 (0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char) 0x80,
+                      0, 0, 0, 0, 0, 0, 0, 0,
+                      0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char) 0x80,
+                      0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i       pack = _mm256_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                               14, 13, 12, -1, -1, -1, -1,
+                                               2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                               14, 13, 12, -1, -1, -1, -1);
+  __m256i             v, hi, lo, slash, shift;
+
+  for (i = o = 0; length_in - i >= 32; i += 32, o += 24) {
+    v = _mm256_loadu_si256 ((const __m256i *) (code_in + i));
+    hi = _mm256_and_si256 (_mm256_srli_epi32 (v, 4), _mm256_set1_epi8 (0x0f));
+    lo = _mm256_and_si256 (v, _mm256_set1_epi8 (0x0f));
+    if (_mm256_movemask_epi8
+        (_mm256_cmpeq_epi8
+         (_mm256_and_si256 (_mm256_shuffle_epi8 (mask_lut, lo),
+                            _mm256_shuffle_epi8 (bit_lut, hi)),
+          _mm256_setzero_si256 ()))) {
+      break;
+    }
+
+    slash = _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('/'));
+    shift = _mm256_or_si256
+      (_mm256_andnot_si256 (slash, _mm256_shuffle_epi8 (shift_lut, hi)),
+       _mm256_and_si256 (slash, _mm256_set1_epi8 (16)));
+    v = _mm256_add_epi8 (v, shift);
+
+    v = _mm256_maddubs_epi16 (v, _mm256_set1_epi32 (0x01400140));
+    v = _mm256_madd_epi16 (v, _mm256_set1_epi32 (0x00011000));
+    v = _mm256_shuffle_epi8 (v, pack);
+
+    /* move the 12 bytes of each lane next to each other */
+    v = _mm256_permutevar8x32_epi32 (v, _mm256_setr_epi32 (0, 1, 2, 4,
+                                                           5, 6, 3, 7));
+    _mm_storeu_si128 ((__m128i *) (plaintext_out + o),
+                      _mm256_castsi256_si128 (v));
+    _mm_storel_epi64 ((__m128i *) (plaintext_out + o + 16),
+                      _mm256_extracti128_si256 (v, 1));
+  }
+  *consumed = i;
+  return o;
+}
+
+#endif /* BASE64_SIMD_X86 */
+
+/* CB: decode as many complete groups as possible with the best code path */
+static size_t
+base64_decode_fast (int level, const char *code_in, size_t length_in,
+                    char *plaintext_out, size_t *consumed)
+{
+  size_t              i, o, n;
+
+  i = o = 0;
+#ifdef BASE64_SIMD_X86
+  if (level >= BASE64_LEVEL_AVX2) {
+    o += base64_decode_avx2 (code_in, length_in, plaintext_out, &n);
+    i += n;
+  }
+  if (level >= BASE64_LEVEL_SSSE3) {
+    o += base64_decode_ssse3 (code_in + i, length_in - i,
+                              plaintext_out + o, &n);
+    i += n;
+  }
+#endif
+  if (level >= BASE64_LEVEL_SCALAR) {
+    o += base64_decode_groups (code_in + i, length_in - i,
+                               plaintext_out + o, &n);
+    i += n;
+  }
+  *consumed = i;
+  return o;
+}
+
 void
 base64_init_decodestate (base64_decodestate * state_in)
 {
@@ -36,8 +229,8 @@ base64_init_decodestate (base64_decodestate * state_in)
   state_in->plainchar = 0;
 }
 
-size_t
-base64_decode_block (const char *code_in, size_t length_in,
+static size_t
+base64_decode_steps (const char *code_in, size_t length_in,
                      char *plaintext_out, base64_decodestate * state_in)
 {
   /*@unused@ */
@@ -103,3 +296,31 @@ base64_decode_block (const char *code_in, size_t length_in,
   /* control should not reach here */
   return (size_t) (plainchar - plaintext_out);
 }
+
+size_t
+base64_decode_block (const char *code_in, size_t length_in,
+                     char *plaintext_out, base64_decodestate * state_in)
+{
+  const int           level = base64_get_level ();
+  size_t              i, o, n;
+
+  if (level == BASE64_LEVEL_STEPS) {
+    return base64_decode_steps (code_in, length_in, plaintext_out, state_in);
+  }
+
+  /* alternate between the fast path on aligned groups and the state
+     machine, which skips over characters outside of the alphabet */
+  i = o = 0;
+  do {
+    if (state_in->step == step_a) {
+      o += base64_decode_fast (level, code_in + i, length_in - i,
+                               plaintext_out + o, &n);
+      i += n;
+    }
+    n = length_in - i < BASE64_DECODE_RUN ? length_in - i : BASE64_DECODE_RUN;
+    o += base64_decode_steps (code_in + i, n, plaintext_out + o, state_in);
+    i += n;
+  }
+  while (i < length_in);
+  return o;
+}
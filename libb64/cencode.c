@@ -11,20 +11,196 @@ For details, see http://sourceforge.net/projects/libb64
 */
 
 #include "libb64.h"
+#ifdef BASE64_SIMD_X86
+#include <immintrin.h>
+#endif
 
 #ifdef SC_BASE64_WRAP
 const int           CHARS_PER_LINE = 72;
 #endif
 
+static int          base64_level = BASE64_LEVEL_AVX2;
+
+static const char  *base64_encoding =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
 static inline char
 base64_encode_value (char value_in)
 {
-  static const char  *encoding =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  return value_in > 63 ? '=' : base64_encoding[(int) value_in];
+}
+
+void
+base64_set_level (int level)
+{
+  base64_level = level < BASE64_LEVEL_STEPS ? BASE64_LEVEL_STEPS :
+    level > BASE64_LEVEL_AVX2 ? BASE64_LEVEL_AVX2 : level;
+}
+
+int
+base64_get_level (void)
+{
+  int                 level = base64_level;
+
+#ifdef BASE64_SIMD_X86
+  if (level >= BASE64_LEVEL_AVX2 && !__builtin_cpu_supports ("avx2")) {
+    level = BASE64_LEVEL_SSSE3;
+  }
+  if (level >= BASE64_LEVEL_SSSE3 && !__builtin_cpu_supports ("ssse3")) {
+    level = BASE64_LEVEL_SCALAR;
+  }
+#else
+  if (level > BASE64_LEVEL_SCALAR) {
+    level = BASE64_LEVEL_SCALAR;
+  }
+#endif
+  return level;
+}
+
+#ifndef SC_BASE64_WRAP
+
+/* CB: encode complete 3-byte groups one at a time */
+static size_t
+base64_encode_groups (const unsigned char *in, size_t length_in,
+                      char *code_out, size_t *consumed)
+{
+  size_t              i, o;
+  unsigned long       v;
 
-  return value_in > 63 ? '=' : encoding[(int) value_in];
+  for (i = o = 0; length_in - i >= 3; i += 3, o += 4) {
+    v = (unsigned long) in[i] << 16 | (unsigned long) in[i + 1] << 8 |
+      (unsigned long) in[i + 2];
+    code_out[o] = base64_encoding[v >> 18];
+    code_out[o + 1] = base64_encoding[(v >> 12) & 0x3f];
+    code_out[o + 2] = base64_encoding[(v >> 6) & 0x3f];
+    code_out[o + 3] = base64_encoding[v & 0x3f];
+  }
+  *consumed = i;
+  return o;
 }
 
+#ifdef BASE64_SIMD_X86
+
+/* CB: the vector kernels follow W. Mula and D. Lemire, "Faster Base64
+ * Encoding and Decoding Using AVX2 Instructions", ACM TOW 12(3), 2018.
+ * Each 128-bit lane reads 16 bytes and uses the first 12 of them. */
+
+__attribute__ ((target ("ssse3")))
+static size_t
+base64_encode_ssse3 (const unsigned char *in, size_t length_in,
+                     char *code_out, size_t *consumed)
+{
+  size_t              i, o;
+  const __m128i       shuf = _mm_setr_epi8 (1, 0, 2, 1, 4, 3, 5, 4,
+                                            7, 6, 8, 7, 10, 9, 11, 10);
+  const __m128i       lut = _mm_setr_epi8 ('a' - 26, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0);
+  __m128i             v, idx, r;
+
+  for (i = o = 0; length_in - i >= 16; i += 12, o += 16) {
+    v = _mm_loadu_si128 ((const __m128i *) (in + i));
+    v = _mm_shuffle_epi8 (v, shuf);
+
+    /* spread the four 6-bit indices of each group over its bytes */
+    idx = _mm_or_si128
+      (_mm_mulhi_epu16 (_mm_and_si128 (v, _mm_set1_epi32 (0x0fc0fc00)),
+                        _mm_set1_epi32 (0x04000040)),
+       _mm_mullo_epi16 (_mm_and_si128 (v, _mm_set1_epi32 (0x003f03f0)),
+                        _mm_set1_epi32 (0x01000010)));
+
+    /* map the indices to ASCII by adding a per-range offset */
+    r = _mm_subs_epu8 (idx, _mm_set1_epi8 (51));
+    r = _mm_or_si128 (r, _mm_and_si128 (_mm_cmpgt_epi8 (_mm_set1_epi8 (26),
+                                                        idx),
+                                        _mm_set1_epi8 (13)));
+    r = _mm_add_epi8 (_mm_shuffle_epi8 (lut, r), idx);
+    _mm_storeu_si128 ((__m128i *) (code_out + o), r);
+  }
+  *consumed = i;
+  return o;
+}
+
+__attribute__ ((target ("avx2")))
+static size_t
+base64_encode_avx2 (const unsigned char *in, size_t length_in,
+                    char *code_out, size_t *consumed)
+{
+  size_t              i, o;
+  const __m256i       shuf = _mm256_setr_epi8 (1, 0, 2, 1, 4, 3, 5, 4,
+                                               7, 6, 8, 7, 10, 9, 11, 10,
+                                               1, 0, 2, 1, 4, 3, 5, 4,
+                                               7, 6, 8, 7, 10, 9, 11, 10);
+  const __m256i       lut = _mm256_setr_epi8 ('a' - 26, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0,
+                                              'a' - 26, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0);
+  __m256i             v, idx, r;
+
+  for (i = o = 0; length_in - i >= 28; i += 24, o += 32) {
+    v = _mm256_inserti128_si256
+      (_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (in + i))),
+       _mm_loadu_si128 ((const __m128i *) (in + i + 12)), 1);
+    v = _mm256_shuffle_epi8 (v, shuf);
+
+    idx = _mm256_or_si256
+      (_mm256_mulhi_epu16 (_mm256_and_si256
+                           (v, _mm256_set1_epi32 (0x0fc0fc00)),
+                           _mm256_set1_epi32 (0x04000040)),
+       _mm256_mullo_epi16 (_mm256_and_si256
+                           (v, _mm256_set1_epi32 (0x003f03f0)),
+                           _mm256_set1_epi32 (0x01000010)));
+
+    r = _mm256_subs_epu8 (idx, _mm256_set1_epi8 (51));
+    r = _mm256_or_si256 (r, _mm256_and_si256
+                         (_mm256_cmpgt_epi8 (_mm256_set1_epi8 (26), idx),
+                          _mm256_set1_epi8 (13)));
+    r = _mm256_add_epi8 (_mm256_shuffle_epi8 (lut, r), idx);
+    _mm256_storeu_si256 ((__m256i *) (code_out + o), r);
+  }
+  *consumed = i;
+  return o;
+}
+
+#endif /* BASE64_SIMD_X86 */
+
+/* CB: encode as many complete groups as possible with the best code path */
+static size_t
+base64_encode_fast (int level, const char *plaintext_in, size_t length_in,
+                    char *code_out, size_t *consumed)
+{
+  const unsigned char *in = (const unsigned char *) plaintext_in;
+  size_t              i, o, n;
+
+  i = o = 0;
+#ifdef BASE64_SIMD_X86
+  if (level >= BASE64_LEVEL_AVX2) {
+    o += base64_encode_avx2 (in, length_in, code_out, &n);
+    i += n;
+  }
+  if (level >= BASE64_LEVEL_SSSE3) {
+    o += base64_encode_ssse3 (in + i, length_in - i, code_out + o, &n);
+    i += n;
+  }
+#endif
+  if (level >= BASE64_LEVEL_SCALAR) {
+    o += base64_encode_groups (in + i, length_in - i, code_out + o, &n);
+    i += n;
+  }
+  *consumed = i;
+  return o;
+}
+
+#endif /* !SC_BASE64_WRAP */
+
 void
 base64_init_encodestate (base64_encodestate * state_in)
 {
@@ -33,8 +209,8 @@ base64_init_encodestate (base64_encodestate * state_in)
   state_in->stepcount = 0;
 }
 
-size_t
-base64_encode_block (const char *plaintext_in, size_t length_in,
+static size_t
+base64_encode_steps (const char *plaintext_in, size_t length_in,
                      char *code_out, base64_encodestate * state_in)
 {
   /*@unused@ */
@@ -99,6 +275,38 @@ base64_encode_block (const char *plaintext_in, size_t length_in,
   return (size_t) (codechar - code_out);
 }
 
+size_t
+base64_encode_block (const char *plaintext_in, size_t length_in,
+                     char *code_out, base64_encodestate * state_in)
+{
+#ifndef SC_BASE64_WRAP
+  const int           level = base64_get_level ();
+  size_t              consumed, o;
+
+  if (level > BASE64_LEVEL_STEPS) {
+    o = 0;
+    if (state_in->step != step_A) {
+      /* complete the group begun by a previous call */
+      consumed = state_in->step == step_B ? 2 : 1;
+      consumed = length_in < consumed ? length_in : consumed;
+      o = base64_encode_steps (plaintext_in, consumed, code_out, state_in);
+      plaintext_in += consumed;
+      length_in -= consumed;
+    }
+    if (state_in->step == step_A) {
+      o += base64_encode_fast (level, plaintext_in, length_in, code_out + o,
+                               &consumed);
+      state_in->stepcount += (int) (consumed / 3);
+      plaintext_in += consumed;
+      length_in -= consumed;
+    }
+    return o + base64_encode_steps (plaintext_in, length_in, code_out + o,
+                                    state_in);
+  }
+#endif
+  return base64_encode_steps (plaintext_in, length_in, code_out, state_in);
+}
+
 size_t
 base64_encode_blockend (char *code_out, base64_encodestate * state_in)
 {
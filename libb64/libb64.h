@@ -5,6 +5,12 @@
 
 /* #define SC_BASE64_WRAP */
 
+/* CB: vectorized code paths for x86 compilers that know target attributes */
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__) && \
+  (defined __clang__ || __GNUC__ >= 5)
+#define BASE64_SIMD_X86
+#endif
+
 #include <stdlib.h>
 
 /*
@@ -129,6 +135,28 @@ size_t              base64_encode_block (const char *plaintext_in,
 size_t              base64_encode_blockend (char *code_out,
                                             base64_encodestate * state_in);
 
+/* CB: the block functions process whole groups of input in a fast path
+ * whenever the state is at a group boundary, using SSSE3 or AVX2 code if
+ * the running CPU supports it.  The streaming semantics are unchanged.
+ * The level below caps the code path used and is meant for testing. */
+#define BASE64_LEVEL_STEPS 0    /**< Original state machine only. */
+#define BASE64_LEVEL_SCALAR 1   /**< Table-driven loop over groups. */
+#define BASE64_LEVEL_SSSE3 2    /**< 16-byte vectors where supported. */
+#define BASE64_LEVEL_AVX2 3     /**< 32-byte vectors where supported. */
+
+/** Cap the code path used by the encode and decode block functions.
+ * This function is not thread-safe with concurrent coding calls.
+ * \param [in] level            One of the BASE64_LEVEL_* values.
+ *                              The default is BASE64_LEVEL_AVX2.
+ */
+void                base64_set_level (int level);
+
+/** Query the code path used by the encode and decode block functions.
+ * \return                      The level set by \ref base64_set_level,
+ *                              lowered to what the running CPU supports.
+ */
+int                 base64_get_level (void);
+
 #ifdef __cplusplus
 #if 0
 {
@@ -22,6 +22,8 @@
 */
 
 #include <sc_private.h>
+#include <sc_log_async.h>
+#include <sc_timeline.h>
 
 #ifdef SC_HAVE_SIGNAL_H
 #include <signal.h>
@@ -58,6 +60,7 @@ typedef struct sc_package
   int                 free_count;
   int                 rc_active;
   int                 abort_mismatch;
+  sc_allocator_t      allocator;
   const char         *name;
   const char         *full;
 #ifdef SC_ENABLE_PTHREAD
@@ -260,12 +263,16 @@ sc_set_signal_handler (int catch_signals)
   }
 }
 
+/** Format the prefix of a message as written by the builtin log handler.
+ * \param [out] prefix     Buffer of at least BUFSIZ bytes.
+ */
 static void
-sc_log_handler (FILE * log_stream, const char *filename, int lineno,
-                int package, int category, int priority, const char *msg)
+sc_log_prefix (char *prefix, const char *filename, int lineno,
+               int package, int category, int priority)
 {
   int                 wp = 0, wi = 0;
   int                 lindent = 0;
+  size_t              len = 0;
 
   if (package != -1) {
     if (!sc_package_is_registered (package))
@@ -277,15 +284,17 @@ sc_log_handler (FILE * log_stream, const char *filename, int lineno,
   }
   wi = (category == SC_LC_NORMAL && sc_identifier >= 0);
 
+  prefix[0] = '\0';
   if (wp || wi) {
-    fputc ('[', log_stream);
-    if (wp)
-      fprintf (log_stream, "%s", sc_packages[package].name);
     if (wp && wi)
-      fputc (' ', log_stream);
-    if (wi)
-      fprintf (log_stream, "%d", sc_identifier);
-    fprintf (log_stream, "] %*s", lindent, "");
+      snprintf (prefix, BUFSIZ, "[%s %d] %*s", sc_packages[package].name,
+                sc_identifier, lindent, "");
+    else if (wp)
+      snprintf (prefix, BUFSIZ, "[%s] %*s", sc_packages[package].name,
+                lindent, "");
+    else
+      snprintf (prefix, BUFSIZ, "[%d] %*s", sc_identifier, lindent, "");
+    len = strlen (prefix);
   }
 
   if (priority == SC_LP_TRACE) {
@@ -297,9 +306,18 @@ sc_log_handler (FILE * log_stream, const char *filename, int lineno,
 #else
     bp = bn;
 #endif
-    fprintf (log_stream, "%s:%d ", bp, lineno);
+    snprintf (prefix + len, BUFSIZ - len, "%s:%d ", bp, lineno);
   }
+}
+
+static void
+sc_log_handler (FILE * log_stream, const char *filename, int lineno,
+                int package, int category, int priority, const char *msg)
+{
+  char                prefix[BUFSIZ];
 
+  sc_log_prefix (prefix, filename, lineno, package, category, priority);
+  fputs (prefix, log_stream);
   fputs (msg, log_stream);
   fflush (log_stream);
 }
@@ -326,8 +344,38 @@ sc_free_count (int package)
   return &sc_packages[package].free_count;
 }
 
+/* Increment an allocation counter.  With atomic builtins we avoid the
+ * package mutex, which becomes a bottleneck with many threads allocating.
+ * Otherwise the mutex protects the counter when pthreads are enabled. */
+static inline void
+sc_count_increment (int package, int *counter)
+{
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  (void) __atomic_fetch_add (counter, 1, __ATOMIC_RELAXED);
+#else
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+#endif
+  ++*counter;
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_unlock (package);
+#endif
+#endif
+}
+
 #endif
 
+/* read an allocation counter that may be updated concurrently */
+static inline int
+sc_count_read (const int *counter)
+{
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  return __atomic_load_n (counter, __ATOMIC_RELAXED);
+#else
+  return *counter;
+#endif
+}
+
 #ifdef SC_ENABLE_MEMALIGN
 
 /* *INDENT-OFF* */
@@ -534,15 +582,12 @@ sc_realloc_aligned (void *ptr, size_t alignment, size_t size)
 
 #endif /* SC_ENABLE_MEMALIGN */
 
-void               *
-sc_malloc (int package, size_t size)
+/* allocate from the system, possibly with alignment */
+static void        *
+sc_malloc_system (size_t size)
 {
   void               *ret;
-#ifndef SC_NOCOUNT_MALLOC
-  int                *malloc_count = sc_malloc_count (package);
-#endif
 
-  /* allocate memory */
 #ifdef SC_ENABLE_MEMALIGN
   ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, size);
 #else
@@ -552,30 +597,431 @@ sc_malloc (int package, size_t size)
                      (long long int) size);
   }
 #endif
+  return ret;
+}
+
+static void        *
+sc_realloc_system (void *ptr, size_t size)
+{
+  void               *ret;
+
+#ifdef SC_ENABLE_MEMALIGN
+  ret = sc_realloc_aligned (ptr, SC_MEMALIGN_BYTES, size);
+#else
+  ret = realloc (ptr, size);
+  SC_CHECK_ABORTF (ret != NULL, "Reallocation (realloc size %lli)",
+                   (long long int) size);
+#endif
+  return ret;
+}
+
+static void
+sc_free_system (void *ptr)
+{
+#ifdef SC_ENABLE_MEMALIGN
+  sc_free_aligned (ptr, SC_MEMALIGN_BYTES);
+#else
+  free (ptr);
+#endif
+}
+
+/* The caching allocator serves small sizes from a fixed set of size classes.
+ * Every thread keeps a free list per class that it allocates from and frees
+ * to without locking.  Blocks move between the thread caches and a global
+ * free list in batches.  The global lists are refilled from large slabs.
+ * A header in front of each block records its class for sc_free. */
+
+/** Header size and alignment of the blocks of the caching allocator. */
+#if defined SC_MEMALIGN_BYTES && SC_MEMALIGN_BYTES > 16
+#define SC_CACHE_ALIGN SC_MEMALIGN_BYTES
+#else
+#define SC_CACHE_ALIGN 16
+#endif
+#define SC_CACHE_NUM_CLASSES 28
+#define SC_CACHE_MAX_SIZE 4096
+#define SC_CACHE_LARGE ((size_t) -1)
+#define SC_CACHE_BATCH 32
+#define SC_CACHE_SLAB_SIZE ((size_t) 1 << 16)
+
+typedef struct sc_cache_block
+{
+  struct sc_cache_block *next;
+}
+sc_cache_block_t;
+
+typedef struct sc_cache_thread
+{
+  int                 generation;
+  int                 count[SC_CACHE_NUM_CLASSES];
+  sc_cache_block_t   *head[SC_CACHE_NUM_CLASSES];
+}
+sc_cache_thread_t;
+
+/* four classes per doubling of the size, multiples of 16 bytes */
+static const size_t sc_cache_class_size[SC_CACHE_NUM_CLASSES] = {
+  16, 32, 48, 64, 80, 96, 112, 128,
+  160, 192, 224, 256, 320, 384, 448, 512,
+  640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+  2560, 3072, 3584, 4096
+};
+
+static sc_allocator_t sc_default_allocator = SC_ALLOCATOR_SYSTEM;
+static sc_cache_block_t *sc_cache_head[SC_CACHE_NUM_CLASSES];
+static char        *sc_cache_slabs = NULL;
+static long         sc_cache_live = 0;
+static int          sc_cache_generation = 0;
 
-  /* count the allocations */
 #ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
+static pthread_mutex_t sc_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t sc_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t sc_cache_key;
+#else
+static sc_cache_thread_t sc_cache_single;
 #endif
 
-#ifndef SC_NOCOUNT_MALLOC
-  if (size > 0) {
-    ++*malloc_count;
+static inline int
+sc_cache_class (size_t size)
+{
+  int                 lo, hi, mid;
+
+  SC_ASSERT (size <= SC_CACHE_MAX_SIZE);
+  if (size <= 128) {
+    /* like malloc we return a unique pointer for size zero */
+    return size == 0 ? 0 : (int) ((size - 1) >> 4);
   }
-  else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
+  lo = 8;
+  hi = SC_CACHE_NUM_CLASSES - 1;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (sc_cache_class_size[mid] < size) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
   }
+  return lo;
+}
+
+static inline size_t
+sc_cache_stride (int cls)
+{
+  return SC_CACHE_ALIGN + (sc_cache_class_size[cls] + SC_CACHE_ALIGN - 1) /
+    SC_CACHE_ALIGN * SC_CACHE_ALIGN;
+}
+
+static inline void
+sc_cache_lock (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth = pthread_mutex_lock (&sc_cache_mutex);
+  sc_check_abort_thread (pth == 0, -1, "sc_cache_lock");
 #endif
+}
 
+static inline void
+sc_cache_unlock (void)
+{
 #ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
+  int                 pth = pthread_mutex_unlock (&sc_cache_mutex);
+  sc_check_abort_thread (pth == 0, -1, "sc_cache_unlock");
+#endif
+}
+
+/* Count the blocks in use.  A block may be freed by another thread than the
+ * one that allocated it, so the count is global and not per thread cache. */
+static inline void
+sc_cache_live_add (long delta)
+{
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  (void) __atomic_fetch_add (&sc_cache_live, delta, __ATOMIC_RELAXED);
+#else
+  sc_cache_lock ();
+  sc_cache_live += delta;
+  sc_cache_unlock ();
 #endif
+}
+
+/* return all blocks of a thread cache to the global lists; needs the lock */
+static void
+sc_cache_flush_all (sc_cache_thread_t * tc)
+{
+  int                 cls;
+  sc_cache_block_t   *block;
+
+  if (tc->generation == sc_count_read (&sc_cache_generation)) {
+    for (cls = 0; cls < SC_CACHE_NUM_CLASSES; ++cls) {
+      if ((block = tc->head[cls]) != NULL) {
+        while (block->next != NULL) {
+          block = block->next;
+        }
+        block->next = sc_cache_head[cls];
+        sc_cache_head[cls] = tc->head[cls];
+      }
+    }
+  }
+  memset (tc, 0, sizeof (*tc));
+  tc->generation = sc_count_read (&sc_cache_generation);
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void
+sc_cache_thread_exit (void *v)
+{
+  sc_cache_thread_t  *tc = (sc_cache_thread_t *) v;
+
+  sc_cache_lock ();
+  sc_cache_flush_all (tc);
+  sc_cache_unlock ();
+  free (tc);
+}
+
+static void
+sc_cache_init_once (void)
+{
+  int                 pth;
+
+  pth = pthread_key_create (&sc_cache_key, sc_cache_thread_exit);
+  sc_check_abort_thread (pth == 0, -1, "sc_cache_key");
+}
+
+#endif
+
+static sc_cache_thread_t *
+sc_cache_thread (void)
+{
+  sc_cache_thread_t  *tc;
+  const int           generation = sc_count_read (&sc_cache_generation);
+
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_once (&sc_cache_once, sc_cache_init_once);
+  sc_check_abort_thread (pth == 0, -1, "sc_cache_once");
+  tc = (sc_cache_thread_t *) pthread_getspecific (sc_cache_key);
+  if (tc == NULL) {
+    tc = (sc_cache_thread_t *) calloc (1, sizeof (sc_cache_thread_t));
+    sc_check_abort_thread (tc != NULL, -1, "sc_cache_thread");
+    tc->generation = generation;
+    pth = pthread_setspecific (sc_cache_key, tc);
+    sc_check_abort_thread (pth == 0, -1, "sc_cache_thread");
+  }
+#else
+  tc = &sc_cache_single;
+#endif
+
+  /* the slabs have been released since this cache was last used */
+  if (tc->generation != generation) {
+    memset (tc, 0, sizeof (*tc));
+    tc->generation = generation;
+  }
+  return tc;
+}
+
+/* move a batch of blocks from the global list into the thread cache */
+static void
+sc_cache_refill (sc_cache_thread_t * tc, int cls)
+{
+  const size_t        stride = sc_cache_stride (cls);
+  size_t              zz, num_blocks;
+  char               *slab;
+  sc_cache_block_t   *block;
+
+  sc_cache_lock ();
+  if (sc_cache_head[cls] == NULL) {
+    /* carve a new slab into blocks, its first bytes link the slabs */
+    slab = (char *) sc_malloc_system (SC_CACHE_SLAB_SIZE);
+    *(char **) slab = sc_cache_slabs;
+    sc_cache_slabs = slab;
+    num_blocks = (SC_CACHE_SLAB_SIZE - SC_CACHE_ALIGN) / stride;
+    SC_ASSERT (num_blocks > 0);
+    for (zz = num_blocks; zz > 0; --zz) {
+      block = (sc_cache_block_t *)
+        (slab + SC_CACHE_ALIGN + (zz - 1) * stride + SC_CACHE_ALIGN);
+      ((size_t *) block)[-SC_CACHE_ALIGN / sizeof (size_t)] = (size_t) cls;
+      block->next = sc_cache_head[cls];
+      sc_cache_head[cls] = block;
+    }
+  }
+  for (zz = 0; zz < SC_CACHE_BATCH && sc_cache_head[cls] != NULL; ++zz) {
+    block = sc_cache_head[cls];
+    sc_cache_head[cls] = block->next;
+    block->next = tc->head[cls];
+    tc->head[cls] = block;
+    ++tc->count[cls];
+  }
+  sc_cache_unlock ();
+}
+
+static void        *
+sc_cache_malloc (size_t size)
+{
+  int                 cls;
+  size_t             *header;
+  sc_cache_block_t   *block;
+  sc_cache_thread_t  *tc;
+
+  if (size > SC_CACHE_MAX_SIZE) {
+    /* large blocks go to the system with a header of our own */
+    header = (size_t *) sc_malloc_system (SC_CACHE_ALIGN + size);
+    header[0] = SC_CACHE_LARGE;
+    header[1] = size;
+    return (char *) header + SC_CACHE_ALIGN;
+  }
+
+  cls = sc_cache_class (size);
+  tc = sc_cache_thread ();
+  if (tc->head[cls] == NULL) {
+    sc_cache_refill (tc, cls);
+  }
+  block = tc->head[cls];
+  tc->head[cls] = block->next;
+  --tc->count[cls];
+  sc_cache_live_add (1);
+  return block;
+}
+
+static void
+sc_cache_free (void *ptr)
+{
+  int                 cls, i;
+  size_t             *header;
+  sc_cache_block_t   *block, *last;
+  sc_cache_thread_t  *tc;
 
+  header = (size_t *) ((char *) ptr - SC_CACHE_ALIGN);
+  if (header[0] == SC_CACHE_LARGE) {
+    sc_free_system (header);
+    return;
+  }
+
+  cls = (int) header[0];
+  SC_ASSERT (0 <= cls && cls < SC_CACHE_NUM_CLASSES);
+  tc = sc_cache_thread ();
+  block = (sc_cache_block_t *) ptr;
+  block->next = tc->head[cls];
+  tc->head[cls] = block;
+  sc_cache_live_add (-1);
+  if (++tc->count[cls] > 2 * SC_CACHE_BATCH) {
+    /* return a batch of blocks to the global list */
+    last = block;
+    for (i = 1; i < SC_CACHE_BATCH; ++i) {
+      last = last->next;
+    }
+    tc->head[cls] = last->next;
+    tc->count[cls] -= SC_CACHE_BATCH;
+    sc_cache_lock ();
+    last->next = sc_cache_head[cls];
+    sc_cache_head[cls] = block;
+    sc_cache_unlock ();
+  }
+}
+
+static void        *
+sc_cache_realloc (void *ptr, size_t size)
+{
+  size_t              old_size;
+  size_t             *header;
+  void               *ret;
+
+  header = (size_t *) ((char *) ptr - SC_CACHE_ALIGN);
+  if (header[0] == SC_CACHE_LARGE) {
+    old_size = header[1];
+  }
+  else {
+    old_size = sc_cache_class_size[header[0]];
+    if (size <= old_size && sc_cache_class (size) == (int) header[0]) {
+      /* the block is of the right class already */
+      return ptr;
+    }
+  }
+  ret = sc_cache_malloc (size);
+  memcpy (ret, ptr, SC_MIN (old_size, size));
+  sc_cache_free (ptr);
   return ret;
 }
 
+/* release all slabs if no block of the caching allocator is in use */
+static int
+sc_cache_finalize (void)
+{
+  int                 num_errors = 0;
+  long                live;
+  char               *slab;
+  sc_cache_thread_t  *tc;
+
+  sc_cache_lock ();
+  if (sc_cache_slabs != NULL) {
+#ifdef SC_ENABLE_PTHREAD
+    tc = (sc_cache_thread_t *) pthread_getspecific (sc_cache_key);
+#else
+    tc = &sc_cache_single;
+#endif
+    if (tc != NULL) {
+      sc_cache_flush_all (tc);
+    }
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+    live = __atomic_load_n (&sc_cache_live, __ATOMIC_RELAXED);
+#else
+    live = sc_cache_live;
+#endif
+    if (live != 0) {
+      /* keep the slabs since there may be blocks still in use */
+      SC_LERRORF ("Caching allocator has %ld blocks in use\n", live);
+      ++num_errors;
+    }
+    else {
+      while ((slab = sc_cache_slabs) != NULL) {
+        sc_cache_slabs = *(char **) slab;
+        sc_free_system (slab);
+      }
+      memset (sc_cache_head, 0, sizeof (sc_cache_head));
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+      (void) __atomic_add_fetch (&sc_cache_generation, 1, __ATOMIC_RELEASE);
+#else
+      ++sc_cache_generation;
+#endif
+    }
+  }
+  sc_cache_unlock ();
+  return num_errors;
+}
+
+static              sc_allocator_t
+sc_package_allocator (int package)
+{
+  if (package == -1) {
+    return SC_ALLOCATOR_SYSTEM;
+  }
+  SC_ASSERT (sc_package_is_registered (package));
+  return sc_packages[package].allocator;
+}
+
+void
+sc_set_allocator_default (sc_allocator_t allocator)
+{
+  SC_ASSERT (allocator == SC_ALLOCATOR_SYSTEM ||
+             allocator == SC_ALLOCATOR_CACHING);
+  sc_default_allocator = allocator;
+}
+
+void
+sc_package_set_allocator (int package_id, sc_allocator_t allocator)
+{
+  SC_ASSERT (allocator == SC_ALLOCATOR_SYSTEM ||
+             allocator == SC_ALLOCATOR_CACHING);
+  SC_CHECK_ABORT (sc_package_is_registered (package_id),
+                  "Package id is not registered");
+#ifndef SC_NOCOUNT_MALLOC
+  SC_CHECK_ABORT (sc_memory_status (package_id) == 0,
+                  "Package allocator changed with memory in use");
+#endif
+  sc_packages[package_id].allocator = allocator;
+}
+
 void               *
-sc_calloc (int package, size_t nmemb, size_t size)
+sc_malloc (int package, size_t size)
 {
   void               *ret;
 #ifndef SC_NOCOUNT_MALLOC
@@ -583,33 +1029,56 @@ sc_calloc (int package, size_t nmemb, size_t size)
 #endif
 
   /* allocate memory */
-#ifdef SC_ENABLE_MEMALIGN
-  ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, nmemb * size);
-  memset (ret, 0, nmemb * size);
-#else
-  ret = calloc (nmemb, size);
-  if (nmemb * size > 0) {
-    SC_CHECK_ABORTF (ret != NULL, "Allocation (calloc size %lli)",
-                     (long long int) size);
+  if (sc_package_allocator (package) == SC_ALLOCATOR_CACHING) {
+    ret = sc_cache_malloc (size);
+  }
+  else {
+    ret = sc_malloc_system (size);
   }
-#endif
 
   /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
+#ifndef SC_NOCOUNT_MALLOC
+  if (size > 0 || ret != NULL) {
+    sc_count_increment (package, malloc_count);
+  }
 #endif
 
+  return ret;
+}
+
+void               *
+sc_calloc (int package, size_t nmemb, size_t size)
+{
+  void               *ret;
 #ifndef SC_NOCOUNT_MALLOC
-  if (nmemb * size > 0) {
-    ++*malloc_count;
+  int                *malloc_count = sc_malloc_count (package);
+#endif
+
+  /* allocate memory */
+  if (sc_package_allocator (package) == SC_ALLOCATOR_CACHING) {
+    ret = sc_cache_malloc (nmemb * size);
+    if (ret != NULL) {
+      memset (ret, 0, nmemb * size);
+    }
   }
   else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
-  }
+#ifdef SC_ENABLE_MEMALIGN
+    ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, nmemb * size);
+    memset (ret, 0, nmemb * size);
+#else
+    ret = calloc (nmemb, size);
+    if (nmemb * size > 0) {
+      SC_CHECK_ABORTF (ret != NULL, "Allocation (calloc size %lli)",
+                       (long long int) size);
+    }
 #endif
+  }
 
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
+  /* count the allocations */
+#ifndef SC_NOCOUNT_MALLOC
+  if (nmemb * size > 0 || ret != NULL) {
+    sc_count_increment (package, malloc_count);
+  }
 #endif
 
   return ret;
@@ -625,18 +1094,11 @@ sc_realloc (int package, void *ptr, size_t size)
     sc_free (package, ptr);
     return NULL;
   }
+  else if (sc_package_allocator (package) == SC_ALLOCATOR_CACHING) {
+    return sc_cache_realloc (ptr, size);
+  }
   else {
-    void               *ret;
-
-#ifdef SC_ENABLE_MEMALIGN
-    ret = sc_realloc_aligned (ptr, SC_MEMALIGN_BYTES, size);
-#else
-    ret = realloc (ptr, size);
-    SC_CHECK_ABORTF (ret != NULL, "Reallocation (realloc size %lli)",
-                     (long long int) size);
-#endif
-
-    return ret;
+    return sc_realloc_system (ptr, size);
   }
 }
 
@@ -666,28 +1128,17 @@ sc_free (int package, void *ptr)
   else {
     /* uncount the allocations */
 #ifndef SC_NOCOUNT_MALLOC
-    int                *free_count = sc_free_count (package);
-#endif
-
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_lock (package);
-#endif
-
-#ifndef SC_NOCOUNT_MALLOC
-    ++*free_count;
-#endif
-
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_unlock (package);
+    sc_count_increment (package, sc_free_count (package));
 #endif
   }
 
   /* free memory */
-#ifdef SC_ENABLE_MEMALIGN
-  sc_free_aligned (ptr, SC_MEMALIGN_BYTES);
-#else
-  free (ptr);
-#endif
+  if (sc_package_allocator (package) == SC_ALLOCATOR_CACHING) {
+    sc_cache_free (ptr);
+  }
+  else {
+    sc_free_system (ptr);
+  }
 }
 
 int
@@ -696,12 +1147,14 @@ sc_memory_status (int package)
   sc_package_t       *p;
 
   if (package == -1) {
-    return (default_malloc_count - default_free_count);
+    return (sc_count_read (&default_malloc_count) -
+            sc_count_read (&default_free_count));
   }
   else {
     SC_ASSERT (sc_package_is_registered (package));
     p = sc_packages + package;
-    return (p->malloc_count - p->free_count);
+    return (sc_count_read (&p->malloc_count) -
+            sc_count_read (&p->free_count));
   }
 }
 
@@ -730,7 +1183,8 @@ sc_memory_check_noabort (int package)
       SC_LERROR ("Leftover references (default)\n");
       ++num_errors;
     }
-    if (default_malloc_count != default_free_count) {
+    if (sc_count_read (&default_malloc_count) !=
+        sc_count_read (&default_free_count)) {
       SC_LERROR ("Memory balance (default)\n");
       ++num_errors;
     }
@@ -747,7 +1201,8 @@ sc_memory_check_noabort (int package)
         SC_LERRORF ("Leftover references (%s)\n", p->name);
         ++num_errors;
       }
-      if (p->malloc_count != p->free_count) {
+      if (sc_count_read (&p->malloc_count) !=
+          sc_count_read (&p->free_count)) {
         SC_LERRORF ("Memory balance (%s)\n", p->name);
         ++num_errors;
       }
@@ -894,6 +1349,19 @@ sc_log (const char *filename, int lineno,
   if (category == SC_LC_GLOBAL && sc_identifier > 0)
     return;
 
+  if (sc_log_async_active && log_handler == sc_log_handler) {
+    char                prefix[BUFSIZ];
+
+    /* format on this thread and let the background thread write */
+    sc_log_prefix (prefix, filename, lineno, package, category, priority);
+    if (sc_trace_file != NULL && priority >= sc_trace_prio)
+      sc_log_async_push (sc_trace_file, 0, priority, prefix, msg);
+    if (priority >= log_threshold)
+      sc_log_async_push (sc_log_stream != NULL ? sc_log_stream : stdout, 1,
+                         priority, prefix, msg);
+    return;
+  }
+
 #ifdef SC_ENABLE_PTHREAD
   sc_package_lock (package);
 #endif
@@ -926,6 +1394,13 @@ sc_logv (const char *filename, int lineno,
 {
   char                buffer[BUFSIZ];
 
+  if (sc_log_async_active) {
+    /* the asynchronous backend does not serialize the threads */
+    vsnprintf (buffer, BUFSIZ, fmt, ap);
+    sc_log (filename, lineno, package, category, priority, buffer);
+    return;
+  }
+
 #ifdef SC_ENABLE_PTHREAD
   sc_package_lock (package);
 #endif
@@ -991,6 +1466,8 @@ sc_set_abort_handler (sc_abort_handler_t abort_handler)
 void
 sc_abort (void)
 {
+  /* write what has been logged before a custom handler takes over */
+  sc_log_async_flush ();
   sc_default_abort_handler ();
   abort ();                     /* if the user supplied callback incorrecty returns, abort */
 }
@@ -1033,6 +1510,7 @@ sc_abort_handler (void)
     SC_LERROR ("Abort\n");
   }
 
+  sc_log_async_flush ();
   fflush (stdout);
   fflush (stderr);
 #ifdef _MSC_VER
@@ -1151,6 +1629,7 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
       p->malloc_count = 0;
       p->free_count = 0;
       p->rc_active = 0;
+      p->allocator = SC_ALLOCATOR_SYSTEM;
       p->name = NULL;
       p->full = NULL;
     }
@@ -1164,6 +1643,7 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
   new_package->free_count = 0;
   new_package->rc_active = 0;
   new_package->abort_mismatch = 1;
+  new_package->allocator = sc_default_allocator;
   new_package->name = name;
   new_package->full = full;
 #ifdef SC_ENABLE_PTHREAD
@@ -1225,6 +1705,7 @@ sc_package_unregister_noabort (int package_id)
     p->log_threshold = SC_LP_DEFAULT;
     p->malloc_count = p->free_count = 0;
     p->rc_active = 0;
+    p->allocator = SC_ALLOCATOR_SYSTEM;
 #ifdef SC_ENABLE_PTHREAD
     if (pthread_mutex_destroy (&p->mutex)) {
       SC_LERRORF ("Mutex destroy failed for package %s", p->name);
@@ -1261,7 +1742,8 @@ sc_package_print_summary (int log_priority)
     if (p->is_registered) {
       SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
                    "   %3d: %-15s +%d-%d   %s\n",
-                   i, p->name, p->malloc_count, p->free_count, p->full);
+                   i, p->name, sc_count_read (&p->malloc_count),
+                   sc_count_read (&p->free_count), p->full);
     }
   }
 }
@@ -1274,6 +1756,12 @@ sc_init (sc_MPI_Comm mpicomm,
   int                 w;
   const char         *trace_file_name;
   const char         *trace_file_prio;
+  const char         *allocator_name;
+  const char         *timeline_name;
+  const char         *timeline_gather;
+  const char         *log_async;
+  const char         *log_file_name;
+  const char         *log_flush;
 
   sc_identifier = -1;
   sc_mpicomm = sc_MPI_COMM_NULL;
@@ -1287,10 +1775,38 @@ sc_init (sc_MPI_Comm mpicomm,
     SC_CHECK_MPI (mpiret);
   }
 
+  allocator_name = getenv ("SC_ALLOCATOR");
+  if (allocator_name != NULL) {
+    if (!strcmp (allocator_name, "system")) {
+      sc_set_allocator_default (SC_ALLOCATOR_SYSTEM);
+    }
+    else if (!strcmp (allocator_name, "caching")) {
+      sc_set_allocator_default (SC_ALLOCATOR_CACHING);
+    }
+    else {
+      SC_ABORT ("Invalid allocator");
+    }
+  }
+
   sc_set_signal_handler (catch_signals);
   sc_package_id = sc_package_register (log_handler, log_threshold,
                                        "libsc", "The SC Library");
 
+  log_async = getenv ("SC_LOG_ASYNC");
+  log_file_name = getenv ("SC_LOG_FILE");
+  if ((log_async != NULL && atoi (log_async)) || log_file_name != NULL) {
+    log_flush = getenv ("SC_LOG_FLUSH");
+    sc_log_async_start (sc_mpicomm, log_file_name, log_flush != NULL ?
+                        (size_t) SC_MAX (sc_atol (log_flush), 0) : 0);
+  }
+
+  timeline_name = getenv ("SC_TIMELINE_FILE");
+  if (timeline_name != NULL) {
+    timeline_gather = getenv ("SC_TIMELINE_GATHER");
+    sc_timeline_start (sc_mpicomm, timeline_name,
+                       timeline_gather != NULL && atoi (timeline_gather));
+  }
+
   trace_file_name = getenv ("SC_TRACE_FILE");
   if (trace_file_name != NULL) {
     char                buffer[BUFSIZ];
@@ -1373,6 +1889,17 @@ sc_finalize_noabort (void)
   int                 i;
   int                 num_errors = 0;
 
+  /* write the timeline while the communicator is still valid */
+  if (sc_timeline_stop ()) {
+    ++num_errors;
+  }
+
+  /* write the remaining messages and log synchronously from now on */
+  num_errors += sc_log_async_stop ();
+
+  /* free the communicator attribute keys while MPI is still alive */
+  sc_notify_finalize ();
+
   /* sc_packages is static and thus initialized to all zeros */
   for (i = sc_num_packages_alloc - 1; i >= 0; --i)
     if (sc_packages[i].is_registered)
@@ -1380,6 +1907,7 @@ sc_finalize_noabort (void)
 
   SC_ASSERT (sc_num_packages == 0);
   num_errors += sc_memory_check_noabort (-1);
+  num_errors += sc_cache_finalize ();
 
   free (sc_packages);
   sc_packages = NULL;
@@ -1601,6 +2129,16 @@ sc_have_zlib (void)
 #endif
 }
 
+int
+sc_have_zstd (void)
+{
+#ifndef SC_HAVE_ZSTD
+  return 0;
+#else
+  return 1;
+#endif
+}
+
 int
 sc_have_json (void)
 {
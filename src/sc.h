@@ -671,9 +671,43 @@ void                sc_abort_verbosev (const char *filename, int lineno,
 void                sc_abort_collective (const char *msg)
   __attribute__ ((noreturn));
 
+/** The memory allocators available for \ref sc_malloc and friends. */
+typedef enum sc_allocator
+{
+  SC_ALLOCATOR_SYSTEM,      /**< The system malloc, aligned if configured. */
+  SC_ALLOCATOR_CACHING      /**< Small sizes are rounded up to one of a set
+                                 of size classes and served from per-thread
+                                 caches without locking.  Large sizes are
+                                 passed to the system allocator. */
+}
+sc_allocator_t;
+
+/** Set the allocator for all packages registered from now on.
+ * Calling this function before \ref sc_init selects the allocator of libsc
+ * itself.  Alternatively, sc_init reads the environment variable
+ * SC_ALLOCATOR, which may be "system" or "caching".
+ * Memory allocated for the default package -1 always uses the system.
+ * Both allocators respect the alignment of SC_MEMALIGN_BYTES, if set.
+ * With the caching allocator, memory is only returned to the system in \ref
+ * sc_finalize and the overhead per allocation is 16 bytes or the alignment.
+ * This function must only be called before additional threads are created.
+ * \param [in] allocator        The allocator to use by default.
+ */
+void                sc_set_allocator_default (sc_allocator_t allocator);
+
+/** Set the allocator of a registered package.
+ * The package must not have any memory allocated at this point.
+ * This function must only be called before additional threads are created.
+ * \param [in] package_id       A registered package identifier.
+ * \param [in] allocator        The allocator to use for this package.
+ */
+void                sc_package_set_allocator (int package_id,
+                                              sc_allocator_t allocator);
+
 /** Register a software package with SC.
  * This function must only be called before additional threads are created.
  * The logging parameters are as in sc_set_log_defaults.
+ * The package uses the allocator set by \ref sc_set_allocator_default.
  * \return                   Returns a unique package id.
  */
 int                 sc_package_register (sc_log_handler_t log_handler,
@@ -873,6 +907,13 @@ int                 sc_version_point (void);
  */
 int                 sc_have_zlib (void);
 
+/** Return a boolean indicating whether zstd has been configured.
+ * \return          True if zstd including ZSTD_compressStream2 (3)
+ *                  has been found on running configure
+ *                  or respectively on calling cmake.
+ */
+int                 sc_have_zstd (void);
+
 /** Return whether we have found a JSON library at configure time.
  * \return          True if and only if SC_HAVE_JSON is defined.
  */
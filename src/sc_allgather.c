@@ -22,6 +22,10 @@
 */
 
 #include <sc_allgather.h>
+#include <sc_shmem.h>
+#include <sc_timeline.h>
+
+int                 sc_allgather_hierarchical = 0;
 
 void
 sc_allgather_alltoall (sc_MPI_Comm mpicomm, char *data, int datasize,
@@ -154,14 +158,64 @@ sc_allgather (void *sendbuf, int sendcount, sc_MPI_Datatype sendtype,
 
   SC_ASSERT (datasize == datasize2);
 
+  SC_TIMELINE_BEGIN ("sc_allgather");
+  if (sc_allgather_hierarchical && sc_shmem_is_shared (mpicomm)) {
+    mpiret = sc_allgather_node (sendbuf, sendcount, sendtype,
+                                recvbuf, recvcount, recvtype, mpicomm);
+  }
+  else {
+    mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+    SC_CHECK_MPI (mpiret);
+
+    memcpy (((char *) recvbuf) + mpirank * datasize, sendbuf, datasize);
+    sc_allgather_recursive (mpicomm, (char *) recvbuf, (int) datasize,
+                            mpisize, mpirank, mpirank);
+  }
+  SC_TIMELINE_END ("sc_allgather");
+
+  return mpiret;
+}
+
+int
+sc_allgather_node (void *sendbuf, int sendcount, sc_MPI_Datatype sendtype,
+                   void *recvbuf, int recvcount, sc_MPI_Datatype recvtype,
+                   sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize;
+  int                 mpirank;
+  size_t              datasize;
+  char               *shared;
+
+  SC_ASSERT (sendcount >= 0 && recvcount >= 0);
+
+  /* *INDENT-OFF* HORRIBLE indent bug */
+  datasize = (size_t) recvcount * sc_mpi_sizeof (recvtype);
+  /* *INDENT-ON* */
+
   mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
   SC_CHECK_MPI (mpiret);
-  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
-  SC_CHECK_MPI (mpiret);
 
-  memcpy (((char *) recvbuf) + mpirank * datasize, sendbuf, datasize);
-  sc_allgather_recursive (mpicomm, (char *) recvbuf, (int) datasize,
-                          mpisize, mpirank, mpirank);
+  if (!sc_shmem_is_shared (mpicomm)) {
+    /* without shared memory the staging would only add copies */
+    mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+    SC_CHECK_MPI (mpiret);
+    SC_ASSERT (datasize == (size_t) sendcount * sc_mpi_sizeof (sendtype));
+    memcpy (((char *) recvbuf) + mpirank * datasize, sendbuf, datasize);
+    sc_allgather_recursive (mpicomm, (char *) recvbuf, (int) datasize,
+                            mpisize, mpirank, mpirank);
+    return sc_MPI_SUCCESS;
+  }
+
+  /* gather on the node roots, exchange between them, read on every rank */
+  shared = (char *) sc_shmem_malloc (sc_package_id, datasize,
+                                     (size_t) mpisize, mpicomm);
+  sc_shmem_allgather (sendbuf, sendcount, sendtype,
+                      shared, recvcount, recvtype, mpicomm);
+  memcpy (recvbuf, shared, mpisize * datasize);
+  sc_shmem_free (sc_package_id, shared, mpicomm);
 
   return sc_MPI_SUCCESS;
 }
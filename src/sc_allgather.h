@@ -42,6 +42,10 @@
 
 SC_EXTERN_C_BEGIN;
 
+/** If true, \ref sc_allgather calls \ref sc_allgather_node.
+ * This may be changed at runtime; initialized to 0. */
+extern int          sc_allgather_hierarchical;
+
 /** Allgather by direct point-to-point communication.
  * This function is only efficient for small group sizes.
  * \param [in] mpicomm      Valid MPI communicator.
@@ -86,6 +90,25 @@ int                 sc_allgather (void *sendbuf, int sendcount,
                                   int recvcount, sc_MPI_Datatype recvtype,
                                   sc_MPI_Comm mpicomm);
 
+/** Node-aware allgather replacement.
+ * It is active if \ref sc_shmem_is_shared is true for \a mpicomm, that is,
+ * after \ref sc_mpi_comm_attach_node_comms and \ref sc_shmem_set_type with
+ * a shared type.  Then the node root gathers the data of its node, the
+ * node roots exchange it over the internode communicator into a shared
+ * array, and every process copies the result from there.
+ * As for \ref sc_shmem_allgather, the ranks of each node must be
+ * consecutive in \a mpicomm.  Otherwise, we call \ref sc_allgather_recursive.
+ * The shared array is allocated on every call; repeated calls with the
+ * same size may rather use \ref sc_shmem_allgather on a persistent array.
+ * Parameters as in \ref sc_allgather.
+ * \return int              sc_MPI_SUCCESS if not aborting on MPI error.
+ */
+int                 sc_allgather_node (void *sendbuf, int sendcount,
+                                       sc_MPI_Datatype sendtype,
+                                       void *recvbuf, int recvcount,
+                                       sc_MPI_Datatype recvtype,
+                                       sc_MPI_Comm mpicomm);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_ALLGATHER_H */
@@ -25,6 +25,9 @@
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
 #endif
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
 
 /* array routines */
 
@@ -211,16 +214,137 @@ sc_array_rewind (sc_array_t * array, size_t new_count)
   }
 }
 
+/* the growth policy and reallocation counters are shared by all arrays */
+static sc_array_policy_t sc_array_policy = { 2., 4. };
+static sc_array_counts_t sc_array_counts;
+#if defined SC_ENABLE_PTHREAD && !defined SC_HAVE_ATOMIC_BUILTINS
+static pthread_mutex_t sc_array_counts_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 void
-sc_array_resize (sc_array_t * array, size_t new_count)
+sc_array_set_policy (const sc_array_policy_t * policy)
+{
+  SC_ASSERT (policy != NULL);
+  SC_ASSERT (policy->growth > 1.);
+  SC_ASSERT (policy->shrink == 0. || policy->shrink >= policy->growth);
+
+  sc_array_policy = *policy;
+}
+
+void
+sc_array_get_policy (sc_array_policy_t * policy)
+{
+  SC_ASSERT (policy != NULL);
+
+  *policy = sc_array_policy;
+}
+
+void
+sc_array_get_counts (sc_array_counts_t * counts)
+{
+  SC_ASSERT (counts != NULL);
+
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  counts->grows = __atomic_load_n (&sc_array_counts.grows, __ATOMIC_RELAXED);
+  counts->shrinks =
+    __atomic_load_n (&sc_array_counts.shrinks, __ATOMIC_RELAXED);
+  counts->bytes = __atomic_load_n (&sc_array_counts.bytes, __ATOMIC_RELAXED);
+#else
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_array_counts_mutex);
+#endif
+  *counts = sc_array_counts;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_array_counts_mutex);
+#endif
+#endif
+}
+
+void
+sc_array_reset_counts (void)
+{
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  __atomic_store_n (&sc_array_counts.grows, 0, __ATOMIC_RELAXED);
+  __atomic_store_n (&sc_array_counts.shrinks, 0, __ATOMIC_RELAXED);
+  __atomic_store_n (&sc_array_counts.bytes, 0, __ATOMIC_RELAXED);
+#else
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_array_counts_mutex);
+#endif
+  memset (&sc_array_counts, 0, sizeof (sc_array_counts_t));
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_array_counts_mutex);
+#endif
+#endif
+}
+
+/* record one reallocation that carries over the given number of bytes */
+static void
+sc_array_count (size_t * counter, size_t bytes)
 {
-  size_t              newoffs, roundup, newsize;
-#if !defined SC_ENABLE_USE_REALLOC || defined SC_ENABLE_DEBUG
-  size_t              oldoffs, minoffs;
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  (void) __atomic_fetch_add (counter, 1, __ATOMIC_RELAXED);
+  (void) __atomic_fetch_add (&sc_array_counts.bytes, bytes, __ATOMIC_RELAXED);
+#else
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_array_counts_mutex);
 #endif
+  ++*counter;
+  sc_array_counts.bytes += bytes;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_array_counts_mutex);
+#endif
+#endif
+}
+
+/* the allocation for a number of bytes, at least the old one times the
+ * growth factor; a factor of 2 rounds up to the next power of two */
+static size_t
+sc_array_capacity (size_t newoffs, size_t byte_alloc)
+{
+  if (sc_array_policy.growth == 2.) {
+    return (size_t) SC_ROUNDUP2_64 (newoffs);
+  }
+  return SC_MAX (newoffs,
+                 (size_t) (sc_array_policy.growth * (double) byte_alloc));
+}
+
+/* move the array contents into an allocation of newsize bytes */
+static void
+sc_array_realloc (sc_array_t * array, size_t newsize, size_t keepoffs)
+{
 #ifndef SC_ENABLE_USE_REALLOC
   char               *ptr;
 #endif
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (newsize > 0 && keepoffs <= newsize);
+
+  sc_array_count (newsize > (size_t) array->byte_alloc ?
+                  &sc_array_counts.grows : &sc_array_counts.shrinks,
+                  keepoffs);
+  array->byte_alloc = (ssize_t) newsize;
+#ifdef SC_ENABLE_USE_REALLOC
+  array->array = SC_REALLOC (array->array, char, newsize);
+#else
+  ptr = SC_ALLOC (char, newsize);
+  if (keepoffs > 0) {
+    /* avoid calling memcpy on less well supported corner cases */
+    memcpy (ptr, array->array, keepoffs);
+  }
+  SC_FREE (array->array);
+  array->array = ptr;
+#endif
+
+#ifdef SC_ENABLE_DEBUG
+  memset (array->array + keepoffs, -1, newsize - keepoffs);
+#endif
+}
+
+void
+sc_array_resize (sc_array_t * array, size_t new_count)
+{
+  size_t              newoffs, oldoffs, newsize;
 #ifdef SC_ENABLE_DEBUG
   size_t              i;
 #endif
@@ -242,52 +366,64 @@ sc_array_resize (sc_array_t * array, size_t new_count)
 
   /* Figure out how the array size will change */
   newoffs = new_count * array->elem_size;
-#if defined SC_ENABLE_DEBUG || !defined SC_ENABLE_USE_REALLOC
   oldoffs = array->elem_count * array->elem_size;
-  minoffs = SC_MIN (oldoffs, newoffs);
-#endif
   array->elem_count = new_count;
-  roundup = (size_t) SC_ROUNDUP2_64 (newoffs);
-  SC_ASSERT (roundup >= newoffs && roundup <= 2 * newoffs);
 
-  if (newoffs > (size_t) array->byte_alloc ||
-      roundup < (size_t) array->byte_alloc) {
-    /* we will reallocate the array memory, either grow or shrink it */
-    array->byte_alloc = (ssize_t) roundup;
+  if (newoffs > (size_t) array->byte_alloc) {
+    /* grow by the policy's factor to amortize the copies */
+    newsize = sc_array_capacity (newoffs, (size_t) array->byte_alloc);
+    sc_array_realloc (array, newsize, oldoffs);
+    return;
   }
-  else {
-#ifdef SC_ENABLE_DEBUG
-    if (newoffs < oldoffs) {
-      memset (array->array + newoffs, -1, oldoffs - newoffs);
-    }
-    for (i = oldoffs; i < newoffs; ++i) {
-      SC_ASSERT (array->array[i] == (char) -1);
+  if (newoffs < oldoffs && sc_array_policy.shrink > 0. &&
+      (double) newoffs * sc_array_policy.shrink <=
+      (double) array->byte_alloc) {
+    /* shrink only well below the allocation to avoid oscillation */
+    newsize = sc_array_capacity (newoffs, 0);
+    if (newsize < (size_t) array->byte_alloc) {
+      sc_array_realloc (array, newsize, SC_MIN (oldoffs, newoffs));
+      return;
     }
-#endif
-    /* we keep the current allocation */
-    return;
   }
 
-  /* byte_alloc is the size to be realloced to, it may be smaller than oldoffs */
-  SC_ASSERT ((size_t) array->byte_alloc >= newoffs);
-
-  newsize = (size_t) array->byte_alloc;
-#ifdef SC_ENABLE_USE_REALLOC
-  array->array = SC_REALLOC (array->array, char, newsize);
-#else
-  ptr = SC_ALLOC (char, newsize);
-  if (minoffs > 0) {
-    /* avoid calling memcpy on less well supported corner cases */
-    memcpy (ptr, array->array, minoffs);
+#ifdef SC_ENABLE_DEBUG
+  if (newoffs < oldoffs) {
+    memset (array->array + newoffs, -1, oldoffs - newoffs);
+  }
+  for (i = oldoffs; i < newoffs; ++i) {
+    SC_ASSERT (array->array[i] == (char) -1);
   }
-  SC_FREE (array->array);
-  array->array = ptr;
 #endif
+  /* we keep the current allocation */
+}
 
-#ifdef SC_ENABLE_DEBUG
-  SC_ASSERT (minoffs <= newsize);
-  memset (array->array + minoffs, -1, newsize - minoffs);
-#endif
+void
+sc_array_reserve (sc_array_t * array, size_t elem_count)
+{
+  size_t              newoffs;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  newoffs = elem_count * array->elem_size;
+  if (newoffs > (size_t) array->byte_alloc) {
+    sc_array_realloc (array, newoffs, array->elem_count * array->elem_size);
+  }
+}
+
+void
+sc_array_shrink_to_fit (sc_array_t * array)
+{
+  size_t              newoffs;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  newoffs = array->elem_count * array->elem_size;
+  if (newoffs == 0) {
+    sc_array_reset (array);
+  }
+  else if (newoffs < (size_t) array->byte_alloc) {
+    sc_array_realloc (array, newoffs, newoffs);
+  }
 }
 
 void
@@ -342,6 +478,216 @@ sc_array_sort (sc_array_t * array, int (*compar) (const void *, const void *))
   qsort (array->array, array->elem_count, array->elem_size, compar);
 }
 
+/** Number of bits sorted in one pass of the radix sort. */
+#define SC_RADIX_BITS 8
+#define SC_RADIX_BUCKETS (1 << SC_RADIX_BITS)
+
+/** Minimum number of elements per thread in the threaded radix sort. */
+#define SC_RADIX_THREAD_MIN (1 << 15)
+
+/** Shared and per-thread state of one radix sort pass. */
+typedef struct sc_radix_pass
+{
+  const char         *src;
+  char               *dest;
+  size_t              elem_size;
+  size_t              key_offset;
+  size_t              key_width;
+  int                 key_signed;
+  int                 shift;
+  size_t              first, last;
+  size_t              hist[SC_RADIX_BUCKETS];
+}
+sc_radix_pass_t;
+
+/* extract a key as an unsigned integer of the same order */
+static inline       uint64_t
+sc_radix_key (const sc_radix_pass_t * rp, const char *elem)
+{
+  uint64_t            key;
+  uint32_t            k32;
+  uint16_t            k16;
+  uint8_t             k8;
+
+  elem += rp->key_offset;
+  switch (rp->key_width) {
+  case 1:
+    memcpy (&k8, elem, 1);
+    key = rp->key_signed ? (uint64_t) (uint8_t) (k8 ^ 0x80U) : k8;
+    break;
+  case 2:
+    memcpy (&k16, elem, 2);
+    key = rp->key_signed ? (uint64_t) (uint16_t) (k16 ^ 0x8000U) : k16;
+    break;
+  case 4:
+    memcpy (&k32, elem, 4);
+    key = rp->key_signed ? (uint64_t) (k32 ^ 0x80000000U) : k32;
+    break;
+  default:
+    SC_ASSERT (rp->key_width == 8);
+    memcpy (&key, elem, 8);
+    if (rp->key_signed) {
+      key ^= (uint64_t) 1 << 63;
+    }
+  }
+  return key;
+}
+
+static void        *
+sc_radix_count (void *v)
+{
+  sc_radix_pass_t    *rp = (sc_radix_pass_t *) v;
+  const char         *elem = rp->src + rp->first * rp->elem_size;
+  size_t              zz;
+
+  memset (rp->hist, 0, sizeof (rp->hist));
+  for (zz = rp->first; zz < rp->last; ++zz, elem += rp->elem_size) {
+    ++rp->hist[(sc_radix_key (rp, elem) >> rp->shift) &
+               (SC_RADIX_BUCKETS - 1)];
+  }
+  return NULL;
+}
+
+/* scatter elements to the offsets in the histogram, which is consumed */
+static void        *
+sc_radix_scatter (void *v)
+{
+  sc_radix_pass_t    *rp = (sc_radix_pass_t *) v;
+  const size_t        elem_size = rp->elem_size;
+  const char         *elem = rp->src + rp->first * elem_size;
+  size_t              zz, *pos;
+
+  for (zz = rp->first; zz < rp->last; ++zz, elem += elem_size) {
+    pos = &rp->hist[(sc_radix_key (rp, elem) >> rp->shift) &
+                    (SC_RADIX_BUCKETS - 1)];
+    memcpy (rp->dest + *pos * elem_size, elem, elem_size);
+    ++*pos;
+  }
+  return NULL;
+}
+
+/* run a pass function on all threads, or serially if threads are off */
+static void
+sc_radix_run (sc_radix_pass_t * rps, int num_threads,
+              void *(*func) (void *))
+{
+  int                 t;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t          *threads;
+
+  if (num_threads > 1) {
+    threads = SC_ALLOC (pthread_t, num_threads - 1);
+    for (t = 1; t < num_threads; ++t) {
+      pth = pthread_create (&threads[t - 1], NULL, func, &rps[t]);
+      SC_CHECK_ABORT (pth == 0, "Radix sort thread create");
+    }
+    func (&rps[0]);
+    for (t = 1; t < num_threads; ++t) {
+      pth = pthread_join (threads[t - 1], NULL);
+      SC_CHECK_ABORT (pth == 0, "Radix sort thread join");
+    }
+    SC_FREE (threads);
+    return;
+  }
+#endif
+  for (t = 0; t < num_threads; ++t) {
+    func (&rps[t]);
+  }
+}
+
+void
+sc_array_sort_key (sc_array_t * array, size_t key_offset,
+                   size_t key_width, int key_signed)
+{
+  sc_array_sort_key_ext (array, key_offset, key_width, key_signed, 1);
+}
+
+void
+sc_array_sort_key_ext (sc_array_t * array, size_t key_offset,
+                       size_t key_width, int key_signed, int num_threads)
+{
+  const size_t        count = array->elem_count;
+  const size_t        elem_size = array->elem_size;
+  int                 t, pass;
+  size_t              b, offset, chunk;
+  char               *buffer, *src, *dest, *swap;
+  sc_radix_pass_t    *rps;
+
+  SC_ASSERT (key_width == 1 || key_width == 2 ||
+             key_width == 4 || key_width == 8);
+  SC_ASSERT (key_offset + key_width <= elem_size);
+  SC_ASSERT (num_threads >= 1);
+
+  if (count <= 1) {
+    return;
+  }
+
+  /* use threads only if each one gets a sizable chunk */
+#ifdef SC_ENABLE_PTHREAD
+  num_threads = (int) SC_MIN ((size_t) num_threads,
+                              SC_MAX (count / SC_RADIX_THREAD_MIN, 1));
+#else
+  num_threads = 1;
+#endif
+  rps = SC_ALLOC (sc_radix_pass_t, num_threads);
+  chunk = (count + num_threads - 1) / num_threads;
+  for (t = 0; t < num_threads; ++t) {
+    rps[t].elem_size = elem_size;
+    rps[t].key_offset = key_offset;
+    rps[t].key_width = key_width;
+    rps[t].key_signed = key_signed;
+    rps[t].first = SC_MIN ((size_t) t * chunk, count);
+    rps[t].last = SC_MIN ((size_t) (t + 1) * chunk, count);
+  }
+
+  /* least significant digit first, stable in every pass */
+  buffer = SC_ALLOC (char, count * elem_size);
+  src = array->array;
+  dest = buffer;
+  for (pass = 0; pass < (int) key_width; ++pass) {
+    for (t = 0; t < num_threads; ++t) {
+      rps[t].src = src;
+      rps[t].dest = dest;
+      rps[t].shift = pass * SC_RADIX_BITS;
+    }
+    sc_radix_run (rps, num_threads, sc_radix_count);
+
+    /* skip the pass if all elements share the same digit */
+    for (b = 0; b < SC_RADIX_BUCKETS; ++b) {
+      for (t = 0, offset = 0; t < num_threads; ++t) {
+        offset += rps[t].hist[b];
+      }
+      if (offset > 0) {
+        break;
+      }
+    }
+    if (offset == count) {
+      continue;
+    }
+
+    /* exclusive prefix sum over buckets, then threads within a bucket */
+    for (b = 0, offset = 0; b < SC_RADIX_BUCKETS; ++b) {
+      for (t = 0; t < num_threads; ++t) {
+        chunk = rps[t].hist[b];
+        rps[t].hist[b] = offset;
+        offset += chunk;
+      }
+    }
+    SC_ASSERT (offset == count);
+    sc_radix_run (rps, num_threads, sc_radix_scatter);
+
+    swap = src;
+    src = dest;
+    dest = swap;
+  }
+  if (src != array->array) {
+    memcpy (array->array, src, count * elem_size);
+  }
+  SC_FREE (buffer);
+  SC_FREE (rps);
+}
+
 int
 sc_array_is_sorted (sc_array_t * array,
                     int (*compar) (const void *, const void *))
@@ -652,116 +998,130 @@ sc_array_checksum (sc_array_t * array)
 #endif
 }
 
+/* the priority queues are 4-ary heaps: fewer levels than a binary heap,
+ * and the children of a node are adjacent in memory */
+#define SC_PQUEUE_ARITY 4
+#define SC_PQUEUE_PARENT(i) (((i) - 1) / SC_PQUEUE_ARITY)
+#define SC_PQUEUE_CHILD(i) (SC_PQUEUE_ARITY * (i) + 1)
+
+/* Move the hole at position down to where elem fits and store it there.
+ * The element must not live in the range [0, count) of the array. */
+static size_t
+sc_array_pqueue_sift_down (sc_array_t * array, size_t position, size_t count,
+                           const void *elem,
+                           int (*compar) (const void *, const void *))
+{
+  size_t              child, last, c, moves;
+  const size_t        size = array->elem_size;
+  char               *m;
+
+  moves = 0;
+  while ((child = SC_PQUEUE_CHILD (position)) < count) {
+    /* find the smallest child */
+    last = SC_MIN (child + SC_PQUEUE_ARITY, count);
+    m = array->array + size * child;
+    for (c = child + 1; c < last; ++c) {
+      if (compar (array->array + size * c, m) < 0) {
+        m = array->array + size * c;
+        child = c;
+      }
+    }
+
+    /* stop if elem is not larger; otherwise move the child up */
+    if (compar (elem, m) <= 0) {
+      break;
+    }
+    memcpy (array->array + size * position, m, size);
+    position = child;
+    ++moves;
+  }
+  memcpy (array->array + size * position, elem, size);
+
+  return moves;
+}
+
 size_t
 sc_array_pqueue_add (sc_array_t * array, void *temp,
                      int (*compar) (const void *, const void *))
 {
-  int                 comp;
-  size_t              parent, child, swaps;
+  size_t              parent, child, moves;
   const size_t        size = array->elem_size;
-  void               *p, *c;
+  char               *p;
 
   /* this works on a pre-allocated array that is not a view */
   SC_ASSERT (SC_ARRAY_IS_OWNER (array));
   SC_ASSERT (array->elem_count > 0);
 
-  /* PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED. */
-  SC_ABORT_NOT_REACHED ();
-
-  swaps = 0;
+  /* lift the new element out and move larger parents into the hole */
+  moves = 0;
   child = array->elem_count - 1;
-  c = array->array + (size * child);
+  memcpy (temp, array->array + size * child, size);
   while (child > 0) {
-    parent = (child - 1) / 2;
-    p = array->array + (size * parent);
-
-    /* compare child to parent */
-    comp = compar (p, c);
-    if (comp <= 0) {
+    parent = SC_PQUEUE_PARENT (child);
+    p = array->array + size * parent;
+    if (compar (p, temp) <= 0) {
       break;
     }
-
-    /* swap child and parent */
-    memcpy (temp, c, size);
-    memcpy (c, p, size);
-    memcpy (p, temp, size);
-    ++swaps;
-
-    /* walk up the tree */
+    memcpy (array->array + size * child, p, size);
     child = parent;
-    c = p;
+    ++moves;
+  }
+  if (moves > 0) {
+    memcpy (array->array + size * child, temp, size);
   }
 
-  return swaps;
+  return moves;
 }
 
 size_t
 sc_array_pqueue_pop (sc_array_t * array, void *result,
                      int (*compar) (const void *, const void *))
 {
-  int                 comp;
-  size_t              new_count, swaps;
-  size_t              parent, child, child1;
+  size_t              new_count, moves;
   const size_t        size = array->elem_size;
-  void               *p, *c, *c1;
-  void               *temp;
 
   /* array must not be empty or a view */
   SC_ASSERT (SC_ARRAY_IS_OWNER (array));
   SC_ASSERT (array->elem_count > 0);
 
-  /* PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED. */
-  SC_ABORT_NOT_REACHED ();
-
-  swaps = 0;
-  new_count = array->elem_count - 1;
-
   /* extract root */
-  parent = 0;
-  p = array->array + (size * parent);
-  memcpy (result, p, size);
+  memcpy (result, array->array, size);
 
-  /* copy the last element to the top and reuse it as temp storage */
-  temp = array->array + (size * new_count);
+  /* the last element stays in place while it sifts down from the root */
+  moves = 0;
+  new_count = array->elem_count - 1;
   if (new_count > 0) {
-    memcpy (p, temp, size);
+    moves = sc_array_pqueue_sift_down (array, 0, new_count,
+                                       array->array + size * new_count,
+                                       compar);
   }
+  array->elem_count = new_count;
 
-  /* sift down the tree */
-  while ((child = 2 * parent + 1) < new_count) {
-    c = array->array + (size * child);
-
-    /* check if child has a sibling and use that one if it is smaller */
-    if ((child1 = 2 * parent + 2) < new_count) {
-      c1 = array->array + (size * child1);
-      comp = compar (c, c1);
-      if (comp > 0) {
-        child = child1;
-        c = c1;
-      }
-    }
+  return moves;
+}
 
-    /* sift down the parent if it is larger */
-    comp = compar (p, c);
-    if (comp <= 0) {
-      break;
-    }
+size_t
+sc_array_pqueue_heapify (sc_array_t * array, void *temp,
+                         int (*compar) (const void *, const void *))
+{
+  size_t              count, position, moves;
+  const size_t        size = array->elem_size;
 
-    /* swap child and parent */
-    memcpy (temp, c, size);
-    memcpy (c, p, size);
-    memcpy (p, temp, size);
-    ++swaps;
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
 
-    /* walk down the tree */
-    parent = child;
-    p = c;
+  /* sift down every parent from the bottom up in linear total time */
+  count = array->elem_count;
+  if (count < 2) {
+    return 0;
+  }
+  moves = 0;
+  position = SC_PQUEUE_PARENT (count - 1) + 1;
+  while (position-- > 0) {
+    memcpy (temp, array->array + size * position, size);
+    moves += sc_array_pqueue_sift_down (array, position, count, temp, compar);
   }
 
-  /* we can resize down here only since we need the temp element above */
-  sc_array_resize (array, new_count);
-
-  return swaps;
+  return moves;
 }
 
 /* memory stamp routines */
@@ -867,87 +1227,537 @@ sc_mstamp_memory_used (sc_mstamp_t * mst)
 
 /* mempool routines */
 
-size_t
-sc_mempool_memory_used (sc_mempool_t * mempool)
+/* number of elements exchanged with the shared list of a concurrent pool */
+#define SC_MEMPOOL_BATCH 64
+
+#ifdef SC_ENABLE_PTHREAD
+
+/* the private part of a concurrent pool owned by one thread */
+typedef struct sc_mempool_thread
 {
-  return sizeof (sc_mempool_t) +
-    sc_mstamp_memory_used (&mempool->mstamp) +
-    sc_array_memory_used (&mempool->freed, 0);
+  int                 active;   /**< Boolean; still attached to a thread */
+  long                count;    /**< allocations minus frees of the thread */
+  sc_mstamp_t         mstamp;   /**< the thread's own stamp cursor */
+  sc_array_t          freed;    /**< elements freed by the thread */
+  sc_mempool_shared_t *shared;  /**< back pointer to the shared state */
 }
+sc_mempool_thread_t;
 
-/** This function is static; we do not like to expose _ext functions in libsc. */
-static void
-sc_mempool_init_ext (sc_mempool_t * mempool, size_t elem_size,
-                     int zero_and_persist)
+struct sc_mempool_shared
 {
-  mempool->elem_size = elem_size;
-  mempool->elem_count = 0;
-  mempool->zero_and_persist = zero_and_persist;
-
-  sc_mstamp_init (&mempool->mstamp, 4096, elem_size);
-  sc_array_init (&mempool->freed, sizeof (void *));
-}
+  size_t              slot;     /**< index into the thread tables */
+  size_t              serial;   /**< distinguishes pools of the same slot */
+  size_t              num_freed; /**< freed count to read unlocked */
+  pthread_mutex_t     mutex;    /**< protects all members below */
+  sc_array_t          freed;    /**< batches returned by the threads */
+  sc_array_t          threads;  /**< all thread states ever created */
+};
 
-void
-sc_mempool_init (sc_mempool_t * mempool, size_t elem_size)
+/* the states of one thread in all concurrent pools, indexed by slot */
+typedef struct sc_mempool_entry
 {
-  sc_mempool_init_ext (mempool, elem_size, 0);
+  size_t              serial;   /**< the pool of the state or 0 */
+  sc_mempool_thread_t *mt;      /**< the state of the thread */
 }
+sc_mempool_entry_t;
 
-/** This function is static; we do not like to expose _ext functions in libsc. */
-static sc_mempool_t *
-sc_mempool_new_ext (size_t elem_size, int zero_and_persist)
+typedef struct sc_mempool_table
 {
-  sc_mempool_t       *mempool;
-
-  SC_ASSERT (elem_size > 0);
+  size_t              num_entries;
+  sc_mempool_entry_t *entries;
+}
+sc_mempool_table_t;
 
-  mempool = SC_ALLOC (sc_mempool_t, 1);
+/* All concurrent pools share one thread-specific key, since the number of
+ * keys is limited.  The registry maps the slots to the existing pools.
+ * The tables and the registry outlive sc_finalize and use the system. */
+static pthread_once_t sc_mempool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t sc_mempool_key;
+static pthread_mutex_t sc_mempool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sc_mempool_shared_t **sc_mempool_pools = NULL;
+static size_t       sc_mempool_num_slots = 0;
+static size_t       sc_mempool_num_pools = 0;
+static size_t       sc_mempool_serial = 0;
 
-  sc_mempool_init_ext (mempool, elem_size, zero_and_persist);
+static void
+sc_mempool_registry_lock (void)
+{
+  int                 pth = pthread_mutex_lock (&sc_mempool_mutex);
+  SC_CHECK_ABORT (pth == 0, "Mempool registry lock");
+}
 
-  return mempool;
+static void
+sc_mempool_registry_unlock (void)
+{
+  int                 pth = pthread_mutex_unlock (&sc_mempool_mutex);
+  SC_CHECK_ABORT (pth == 0, "Mempool registry unlock");
 }
 
-sc_mempool_t       *
-sc_mempool_new (size_t elem_size)
+static void
+sc_mempool_shared_lock (sc_mempool_shared_t * shared)
 {
-  return sc_mempool_new_ext (elem_size, 0);
+  int                 pth = pthread_mutex_lock (&shared->mutex);
+  SC_CHECK_ABORT (pth == 0, "Mempool lock");
 }
 
-sc_mempool_t       *
-sc_mempool_new_zero_and_persist (size_t elem_size)
+static void
+sc_mempool_shared_unlock (sc_mempool_shared_t * shared)
 {
-  return sc_mempool_new_ext (elem_size, 1);
+  int                 pth = pthread_mutex_unlock (&shared->mutex);
+  SC_CHECK_ABORT (pth == 0, "Mempool unlock");
 }
 
-void
-sc_mempool_reset (sc_mempool_t * mempool)
+/* publish the size of the shared free list; needs the lock */
+static inline void
+sc_mempool_shared_count (sc_mempool_shared_t * shared)
 {
-  sc_array_reset (&mempool->freed);
-  sc_mstamp_reset (&mempool->mstamp);
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  __atomic_store_n (&shared->num_freed, shared->freed.elem_count,
+                    __ATOMIC_RELAXED);
+#else
+  shared->num_freed = shared->freed.elem_count;
+#endif
 }
 
-void
-sc_mempool_destroy (sc_mempool_t * mempool)
+/* Check without the lock whether the shared free list may hold elements.
+ * A stale answer only delays the reuse of freed elements. */
+static inline int
+sc_mempool_shared_available (sc_mempool_shared_t * shared)
 {
-  sc_mempool_reset (mempool);
-  SC_FREE (mempool);
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  return __atomic_load_n (&shared->num_freed, __ATOMIC_RELAXED) > 0;
+#else
+  return 1;
+#endif
 }
 
-void
-sc_mempool_destroy_null (sc_mempool_t ** pmempool)
+/* move up to num elements from the end of one pointer array to another */
+static void
+sc_mempool_move (sc_array_t * from, sc_array_t * to, size_t num)
 {
-  SC_ASSERT (pmempool != NULL);
-  SC_ASSERT (*pmempool != NULL);
+  const size_t        nfrom = from->elem_count;
 
-  sc_mempool_destroy (*pmempool);
-  *pmempool = NULL;
+  num = SC_MIN (num, nfrom);
+  if (num > 0) {
+    memcpy (sc_array_push_count (to, num),
+            sc_array_index (from, nfrom - num), num * sizeof (void *));
+    sc_array_resize (from, nfrom - num);
+  }
 }
 
-void
-sc_mempool_truncate (sc_mempool_t * mempool)
+/* called on thread exit: hand over the free lists and keep the stamps */
+static void
+sc_mempool_thread_exit (void *v)
+{
+  sc_mempool_table_t *table = (sc_mempool_table_t *) v;
+  sc_mempool_shared_t *shared;
+  sc_mempool_thread_t *mt;
+  size_t              zz;
+
+  /* the registry lock keeps the pools from being destroyed meanwhile */
+  sc_mempool_registry_lock ();
+  for (zz = 0; zz < table->num_entries; ++zz) {
+    if (table->entries[zz].serial == 0 || zz >= sc_mempool_num_slots ||
+        (shared = sc_mempool_pools[zz]) == NULL ||
+        shared->serial != table->entries[zz].serial) {
+      /* this thread has not used the pool in this slot */
+      continue;
+    }
+    mt = table->entries[zz].mt;
+    sc_mempool_shared_lock (shared);
+    sc_mempool_move (&mt->freed, &shared->freed, mt->freed.elem_count);
+    sc_mempool_shared_count (shared);
+    sc_array_reset (&mt->freed);
+    mt->active = 0;
+    sc_mempool_shared_unlock (shared);
+  }
+  sc_mempool_registry_unlock ();
+  free (table->entries);
+  free (table);
+}
+
+static void
+sc_mempool_init_once (void)
+{
+  int                 pth;
+
+  pth = pthread_key_create (&sc_mempool_key, sc_mempool_thread_exit);
+  SC_CHECK_ABORT (pth == 0, "Mempool key");
+}
+
+/* assign a slot and a serial number to a new concurrent pool */
+static void
+sc_mempool_register (sc_mempool_shared_t * shared)
+{
+  size_t              zz, num_slots;
+  int                 pth;
+
+  pth = pthread_once (&sc_mempool_once, sc_mempool_init_once);
+  SC_CHECK_ABORT (pth == 0, "Mempool once");
+
+  sc_mempool_registry_lock ();
+  for (zz = 0; zz < sc_mempool_num_slots; ++zz) {
+    if (sc_mempool_pools[zz] == NULL) {
+      break;
+    }
+  }
+  if (zz == sc_mempool_num_slots) {
+    num_slots = SC_MAX (2 * sc_mempool_num_slots, 8);
+    sc_mempool_pools = (sc_mempool_shared_t **)
+      realloc (sc_mempool_pools, num_slots * sizeof (sc_mempool_shared_t *));
+    SC_CHECK_ABORT (sc_mempool_pools != NULL, "Mempool registry");
+    memset (sc_mempool_pools + zz, 0,
+            (num_slots - zz) * sizeof (sc_mempool_shared_t *));
+    sc_mempool_num_slots = num_slots;
+  }
+  sc_mempool_pools[zz] = shared;
+  shared->slot = zz;
+  shared->serial = ++sc_mempool_serial;
+  ++sc_mempool_num_pools;
+  sc_mempool_registry_unlock ();
+}
+
+/* remove a pool from the registry; the slot may be reused afterwards */
+static void
+sc_mempool_unregister (sc_mempool_shared_t * shared)
+{
+  sc_mempool_registry_lock ();
+  SC_ASSERT (sc_mempool_pools[shared->slot] == shared);
+  sc_mempool_pools[shared->slot] = NULL;
+  if (--sc_mempool_num_pools == 0) {
+    free (sc_mempool_pools);
+    sc_mempool_pools = NULL;
+    sc_mempool_num_slots = 0;
+  }
+  sc_mempool_registry_unlock ();
+}
+
+/* find or create the state of the calling thread */
+static sc_mempool_thread_t *
+sc_mempool_thread (sc_mempool_t * mempool)
+{
+  sc_mempool_shared_t *shared = mempool->shared;
+  sc_mempool_thread_t *mt;
+  sc_mempool_table_t *table;
+  size_t              zz, num_entries;
+  int                 pth;
+
+  table = (sc_mempool_table_t *) pthread_getspecific (sc_mempool_key);
+  if (table != NULL && shared->slot < table->num_entries &&
+      table->entries[shared->slot].serial == shared->serial) {
+    return table->entries[shared->slot].mt;
+  }
+
+  /* the table entry of a destroyed pool in the same slot is overwritten */
+  if (table == NULL) {
+    table = (sc_mempool_table_t *) calloc (1, sizeof (sc_mempool_table_t));
+    SC_CHECK_ABORT (table != NULL, "Mempool thread table");
+    pth = pthread_setspecific (sc_mempool_key, table);
+    SC_CHECK_ABORT (pth == 0, "Mempool thread table");
+  }
+  if (shared->slot >= table->num_entries) {
+    num_entries = SC_MAX (2 * table->num_entries, shared->slot + 1);
+    table->entries = (sc_mempool_entry_t *)
+      realloc (table->entries, num_entries * sizeof (sc_mempool_entry_t));
+    SC_CHECK_ABORT (table->entries != NULL, "Mempool thread table");
+    memset (table->entries + table->num_entries, 0,
+            (num_entries - table->num_entries) * sizeof (sc_mempool_entry_t));
+    table->num_entries = num_entries;
+  }
+
+  /* reuse the stamps left behind by an exited thread if possible */
+  sc_mempool_shared_lock (shared);
+  for (zz = 0; zz < shared->threads.elem_count; ++zz) {
+    mt = *(sc_mempool_thread_t **) sc_array_index (&shared->threads, zz);
+    if (!mt->active) {
+      break;
+    }
+  }
+  if (zz == shared->threads.elem_count) {
+    mt = SC_ALLOC (sc_mempool_thread_t, 1);
+    mt->count = 0;
+    mt->shared = shared;
+    sc_mstamp_init (&mt->mstamp, 4096, mempool->elem_size);
+    *(sc_mempool_thread_t **) sc_array_push (&shared->threads) = mt;
+  }
+  mt->active = 1;
+  sc_array_init (&mt->freed, sizeof (void *));
+  sc_mempool_shared_unlock (shared);
+
+  table->entries[shared->slot].serial = shared->serial;
+  table->entries[shared->slot].mt = mt;
+  return mt;
+}
+
+void               *
+sc_mempool_alloc_concurrent (sc_mempool_t * mempool)
+{
+  void               *ret;
+  sc_mempool_thread_t *mt;
+
+  SC_ASSERT (mempool->shared != NULL);
+  mt = sc_mempool_thread (mempool);
+  ++mt->count;
+
+  /* refill a batch from the shared list before growing the stamps */
+  if (mt->freed.elem_count == 0 &&
+      sc_mempool_shared_available (mempool->shared)) {
+    sc_mempool_shared_lock (mempool->shared);
+    sc_mempool_move (&mempool->shared->freed, &mt->freed, SC_MEMPOOL_BATCH);
+    sc_mempool_shared_count (mempool->shared);
+    sc_mempool_shared_unlock (mempool->shared);
+  }
+  if (mt->freed.elem_count > 0) {
+    ret = *(void **) sc_array_pop (&mt->freed);
+  }
+  else {
+    ret = sc_mstamp_alloc (&mt->mstamp);
+    if (mempool->zero_and_persist) {
+      memset (ret, 0, mempool->elem_size);
+    }
+  }
+
+#ifdef SC_ENABLE_DEBUG
+  if (!mempool->zero_and_persist) {
+    memset (ret, -1, mempool->elem_size);
+  }
+#endif
+
+  return ret;
+}
+
+void
+sc_mempool_free_concurrent (sc_mempool_t * mempool, void *elem)
+{
+  sc_mempool_thread_t *mt;
+
+  SC_ASSERT (mempool->shared != NULL);
+  mt = sc_mempool_thread (mempool);
+
+#ifdef SC_ENABLE_DEBUG
+  if (!mempool->zero_and_persist) {
+    memset (elem, -1, mempool->elem_size);
+  }
+#endif
+
+  --mt->count;
+  *(void **) sc_array_push (&mt->freed) = elem;
+
+  /* return a batch to the shared list if we hold too many */
+  if (mt->freed.elem_count >= 2 * SC_MEMPOOL_BATCH) {
+    sc_mempool_shared_lock (mempool->shared);
+    sc_mempool_move (&mt->freed, &mempool->shared->freed, SC_MEMPOOL_BATCH);
+    sc_mempool_shared_count (mempool->shared);
+    sc_mempool_shared_unlock (mempool->shared);
+  }
+}
+
+#else
+
+void               *
+sc_mempool_alloc_concurrent (sc_mempool_t * mempool)
+{
+  SC_ABORT_NOT_REACHED ();
+  return NULL;
+}
+
+void
+sc_mempool_free_concurrent (sc_mempool_t * mempool, void *elem)
+{
+  SC_ABORT_NOT_REACHED ();
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+size_t
+sc_mempool_memory_used (sc_mempool_t * mempool)
+{
+  size_t              s;
+#ifdef SC_ENABLE_PTHREAD
+  size_t              zz;
+  sc_mempool_shared_t *shared = mempool->shared;
+  sc_mempool_thread_t *mt;
+#endif
+
+  s = sizeof (sc_mempool_t) +
+    sc_mstamp_memory_used (&mempool->mstamp) +
+    sc_array_memory_used (&mempool->freed, 0);
+#ifdef SC_ENABLE_PTHREAD
+  if (shared != NULL) {
+    s += sizeof (sc_mempool_shared_t) +
+      sc_array_memory_used (&shared->freed, 0) +
+      sc_array_memory_used (&shared->threads, 0);
+    for (zz = 0; zz < shared->threads.elem_count; ++zz) {
+      mt = *(sc_mempool_thread_t **) sc_array_index (&shared->threads, zz);
+      s += sizeof (sc_mempool_thread_t) +
+        sc_mstamp_memory_used (&mt->mstamp) +
+        sc_array_memory_used (&mt->freed, 0);
+    }
+  }
+#endif
+  return s;
+}
+
+/** This function is static; we do not like to expose _ext functions in libsc. */
+static void
+sc_mempool_init_ext (sc_mempool_t * mempool, size_t elem_size,
+                     int zero_and_persist)
+{
+  mempool->elem_size = elem_size;
+  mempool->elem_count = 0;
+  mempool->zero_and_persist = zero_and_persist;
+  mempool->shared = NULL;
+
+  sc_mstamp_init (&mempool->mstamp, 4096, elem_size);
+  sc_array_init (&mempool->freed, sizeof (void *));
+}
+
+void
+sc_mempool_init (sc_mempool_t * mempool, size_t elem_size)
+{
+  sc_mempool_init_ext (mempool, elem_size, 0);
+}
+
+/** This function is static; we do not like to expose _ext functions in libsc. */
+static sc_mempool_t *
+sc_mempool_new_ext (size_t elem_size, int zero_and_persist)
+{
+  sc_mempool_t       *mempool;
+
+  SC_ASSERT (elem_size > 0);
+
+  mempool = SC_ALLOC (sc_mempool_t, 1);
+
+  sc_mempool_init_ext (mempool, elem_size, zero_and_persist);
+
+  return mempool;
+}
+
+sc_mempool_t       *
+sc_mempool_new (size_t elem_size)
+{
+  return sc_mempool_new_ext (elem_size, 0);
+}
+
+sc_mempool_t       *
+sc_mempool_new_zero_and_persist (size_t elem_size)
+{
+  return sc_mempool_new_ext (elem_size, 1);
+}
+
+sc_mempool_t       *
+sc_mempool_new_concurrent (size_t elem_size, int zero_and_persist)
+{
+  sc_mempool_t       *mempool;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  sc_mempool_shared_t *shared;
+#endif
+
+  mempool = sc_mempool_new_ext (elem_size, zero_and_persist);
+#ifdef SC_ENABLE_PTHREAD
+  shared = mempool->shared = SC_ALLOC (sc_mempool_shared_t, 1);
+  pth = pthread_mutex_init (&shared->mutex, NULL);
+  SC_CHECK_ABORT (pth == 0, "Mempool mutex");
+  sc_mempool_register (shared);
+  shared->num_freed = 0;
+  sc_array_init (&shared->freed, sizeof (void *));
+  sc_array_init (&shared->threads, sizeof (sc_mempool_thread_t *));
+#endif
+
+  return mempool;
+}
+
+void
+sc_mempool_sync (sc_mempool_t * mempool)
+{
+#ifdef SC_ENABLE_PTHREAD
+  long                count;
+  size_t              zz;
+  sc_mempool_shared_t *shared = mempool->shared;
+  sc_mempool_thread_t *mt;
+
+  if (shared != NULL) {
+    count = 0;
+    sc_mempool_shared_lock (shared);
+    for (zz = 0; zz < shared->threads.elem_count; ++zz) {
+      mt = *(sc_mempool_thread_t **) sc_array_index (&shared->threads, zz);
+      count += mt->count;
+    }
+    sc_mempool_shared_unlock (shared);
+    SC_ASSERT (count >= 0);
+    mempool->elem_count = (size_t) count;
+  }
+#endif
+}
+
+void
+sc_mempool_reset (sc_mempool_t * mempool)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  size_t              zz;
+  sc_mempool_shared_t *shared = mempool->shared;
+  sc_mempool_thread_t *mt;
+
+  if (shared != NULL) {
+    /* the thread table entries of an unregistered pool are stale */
+    sc_mempool_unregister (shared);
+    for (zz = 0; zz < shared->threads.elem_count; ++zz) {
+      mt = *(sc_mempool_thread_t **) sc_array_index (&shared->threads, zz);
+      sc_mstamp_reset (&mt->mstamp);
+      sc_array_reset (&mt->freed);
+      SC_FREE (mt);
+    }
+    sc_array_reset (&shared->threads);
+    sc_array_reset (&shared->freed);
+    pth = pthread_mutex_destroy (&shared->mutex);
+    SC_CHECK_ABORT (pth == 0, "Mempool mutex destroy");
+    SC_FREE (shared);
+    mempool->shared = NULL;
+  }
+#endif
+  sc_array_reset (&mempool->freed);
+  sc_mstamp_reset (&mempool->mstamp);
+}
+
+void
+sc_mempool_destroy (sc_mempool_t * mempool)
+{
+  sc_mempool_reset (mempool);
+  SC_FREE (mempool);
+}
+
+void
+sc_mempool_destroy_null (sc_mempool_t ** pmempool)
+{
+  SC_ASSERT (pmempool != NULL);
+  SC_ASSERT (*pmempool != NULL);
+
+  sc_mempool_destroy (*pmempool);
+  *pmempool = NULL;
+}
+
+void
+sc_mempool_truncate (sc_mempool_t * mempool)
 {
+#ifdef SC_ENABLE_PTHREAD
+  size_t              zz;
+  sc_mempool_shared_t *shared = mempool->shared;
+  sc_mempool_thread_t *mt;
+
+  if (shared != NULL) {
+    /* the thread states stay attached to their threads */
+    for (zz = 0; zz < shared->threads.elem_count; ++zz) {
+      mt = *(sc_mempool_thread_t **) sc_array_index (&shared->threads, zz);
+      mt->count = 0;
+      sc_mstamp_truncate (&mt->mstamp);
+      sc_array_truncate (&mt->freed);
+    }
+    sc_array_reset (&shared->freed);
+    sc_mempool_shared_count (shared);
+  }
+#endif
   sc_array_reset (&mempool->freed);
   sc_mstamp_truncate (&mempool->mstamp);
   mempool->elem_count = 0;
@@ -1730,57 +2540,983 @@ sc_hash_array_rip (sc_hash_array_t * hash_array, sc_array_t * rip)
   SC_FREE (hash_array);
 }
 
-void
-sc_recycle_array_init (sc_recycle_array_t * rec_array, size_t elem_size)
+/* flat hash table routines */
+
+#define SC_FHASH_EMPTY   ((unsigned char) 0x00)
+#define SC_FHASH_DELETED ((unsigned char) 0x01)
+#define SC_FHASH_FULL    ((unsigned char) 0x80)
+
+static const size_t sc_fhash_minimal_size = (size_t) (1 << 4);
+
+/** Maximum number of occupied and deleted slots before we resize. */
+static inline size_t
+sc_fhash_max_load (size_t slot_count)
 {
-  sc_array_init (&rec_array->a, elem_size);
-  sc_array_init (&rec_array->f, sizeof (size_t));
+  return slot_count - slot_count / 8;
+}
 
-  rec_array->elem_count = 0;
+/** Spread the hash value with a Fibonacci multiplier.
+ * The slot is taken from the highest bits of the product and the
+ * metadata tag from the seven bits just below.
+ */
+static inline size_t
+sc_fhash_position (const sc_fhash_t * fhash, unsigned int hval,
+                   unsigned char *tag)
+{
+  const uint64_t      x = (uint64_t) hval * (uint64_t) 0x9E3779B97F4A7C15ULL;
+
+  *tag = (unsigned char) (SC_FHASH_FULL |
+                          ((x >> (fhash->shift - 7)) & 0x7f));
+  return (size_t) (x >> fhash->shift);
 }
 
-void
-sc_recycle_array_reset (sc_recycle_array_t * rec_array)
+static void
+sc_fhash_allocate (sc_fhash_t * fhash, size_t slot_count)
 {
-  SC_ASSERT (rec_array->a.elem_count ==
-             rec_array->elem_count + rec_array->f.elem_count);
+  SC_ASSERT (slot_count >= sc_fhash_minimal_size);
+  SC_ASSERT ((slot_count & (slot_count - 1)) == 0);
 
-  sc_array_reset (&rec_array->a);
-  sc_array_reset (&rec_array->f);
+  fhash->slot_count = slot_count;
+  fhash->deleted_count = 0;
+  fhash->shift = 64 - SC_LOG2_64 (slot_count);
+  fhash->meta = SC_ALLOC_ZERO (unsigned char, slot_count);
+  fhash->slots = SC_ALLOC (char, slot_count * fhash->elem_size);
+}
 
-  rec_array->elem_count = 0;
+static void
+sc_fhash_rehash (sc_fhash_t * fhash, size_t new_size)
+{
+  const size_t        size = fhash->elem_size;
+  const size_t        old_size = fhash->slot_count;
+  unsigned char      *old_meta = fhash->meta;
+  char               *old_slots = fhash->slots;
+  unsigned char       tag;
+  size_t              zz, pos, mask;
+#ifdef SC_ENABLE_DEBUG
+  size_t              new_count = 0;
+#endif
+
+  ++fhash->resize_actions;
+  sc_fhash_allocate (fhash, new_size);
+  mask = new_size - 1;
+
+  /* every item is unique, so we only need to find an empty slot */
+  for (zz = 0; zz < old_size; ++zz) {
+    if (!(old_meta[zz] & SC_FHASH_FULL)) {
+      continue;
+    }
+    pos = sc_fhash_position
+      (fhash, fhash->hash_fn (old_slots + zz * size, fhash->user_data), &tag);
+    while (fhash->meta[pos] != SC_FHASH_EMPTY) {
+      pos = (pos + 1) & mask;
+    }
+    fhash->meta[pos] = tag;
+    memcpy (fhash->slots + pos * size, old_slots + zz * size, size);
+#ifdef SC_ENABLE_DEBUG
+    ++new_count;
+#endif
+  }
+  SC_ASSERT (new_count == fhash->elem_count);
+
+  SC_FREE (old_meta);
+  SC_FREE (old_slots);
 }
 
-void               *
-sc_recycle_array_insert (sc_recycle_array_t * rec_array, size_t *position)
+size_t
+sc_fhash_memory_used (sc_fhash_t * fhash)
 {
-  size_t              newpos;
-  void               *newitem;
+  return sizeof (sc_fhash_t) + fhash->slot_count * (1 + fhash->elem_size);
+}
 
-  if (rec_array->f.elem_count > 0) {
-    newpos = *(size_t *) sc_array_pop (&rec_array->f);
-    newitem = sc_array_index (&rec_array->a, newpos);
-  }
-  else {
-    newpos = rec_array->a.elem_count;
-    newitem = sc_array_push (&rec_array->a);
-  }
+sc_fhash_t         *
+sc_fhash_new (size_t elem_size, sc_hash_function_t hash_fn,
+              sc_equal_function_t equal_fn, void *user_data)
+{
+  sc_fhash_t         *fhash;
 
-  if (position != NULL) {
-    *position = newpos;
-  }
-  ++rec_array->elem_count;
+  SC_ASSERT (elem_size > 0);
 
-  return newitem;
+  fhash = SC_ALLOC (sc_fhash_t, 1);
+
+  fhash->elem_size = elem_size;
+  fhash->elem_count = 0;
+  fhash->user_data = user_data;
+  fhash->hash_fn = hash_fn;
+  fhash->equal_fn = equal_fn;
+  fhash->resize_checks = 0;
+  fhash->resize_actions = 0;
+  sc_fhash_allocate (fhash, sc_fhash_minimal_size);
+
+  return fhash;
 }
 
-void               *
-sc_recycle_array_remove (sc_recycle_array_t * rec_array, size_t position)
+void
+sc_fhash_destroy (sc_fhash_t * fhash)
 {
-  SC_ASSERT (rec_array->elem_count > 0);
+  SC_FREE (fhash->meta);
+  SC_FREE (fhash->slots);
 
-  *(size_t *) sc_array_push (&rec_array->f) = position;
-  --rec_array->elem_count;
+  SC_FREE (fhash);
+}
 
-  return sc_array_index (&rec_array->a, position);
+void
+sc_fhash_destroy_null (sc_fhash_t ** pfhash)
+{
+  SC_ASSERT (pfhash != NULL);
+  SC_ASSERT (*pfhash != NULL);
+
+  sc_fhash_destroy (*pfhash);
+  *pfhash = NULL;
+}
+
+void
+sc_fhash_truncate (sc_fhash_t * fhash)
+{
+  if (fhash->slot_count == sc_fhash_minimal_size) {
+    memset (fhash->meta, 0, fhash->slot_count);
+    fhash->deleted_count = 0;
+  }
+  else {
+    SC_FREE (fhash->meta);
+    SC_FREE (fhash->slots);
+    sc_fhash_allocate (fhash, sc_fhash_minimal_size);
+  }
+  fhash->elem_count = 0;
+}
+
+int
+sc_fhash_lookup (sc_fhash_t * fhash, const void *v, void **found)
+{
+  const size_t        mask = fhash->slot_count - 1;
+  unsigned char       tag, m;
+  size_t              pos;
+  char               *item;
+
+  pos = sc_fhash_position (fhash, fhash->hash_fn (v, fhash->user_data), &tag);
+
+  /* there is always at least one empty slot to terminate the loop */
+  while ((m = fhash->meta[pos]) != SC_FHASH_EMPTY) {
+    if (m == tag) {
+      item = fhash->slots + pos * fhash->elem_size;
+      if (fhash->equal_fn (item, v, fhash->user_data)) {
+        if (found != NULL) {
+          *found = item;
+        }
+        return 1;
+      }
+    }
+    pos = (pos + 1) & mask;
+  }
+  return 0;
+}
+
+int
+sc_fhash_insert_unique (sc_fhash_t * fhash, const void *v, void **found)
+{
+  const size_t        size = fhash->elem_size;
+  unsigned char       tag, m;
+  size_t              pos, mask, target;
+  char               *item;
+
+  /* make sure that one more item fits before we probe */
+  ++fhash->resize_checks;
+  if (fhash->elem_count + fhash->deleted_count + 1 >
+      sc_fhash_max_load (fhash->slot_count)) {
+    /* double the size when it is more than half full, else purge deletions */
+    sc_fhash_rehash (fhash, fhash->elem_count + 1 > fhash->slot_count / 2 ?
+                     2 * fhash->slot_count : fhash->slot_count);
+  }
+
+  /* search for an equal item while remembering the first deleted slot */
+  mask = fhash->slot_count - 1;
+  target = fhash->slot_count;
+  pos = sc_fhash_position (fhash, fhash->hash_fn (v, fhash->user_data), &tag);
+  while ((m = fhash->meta[pos]) != SC_FHASH_EMPTY) {
+    if (m == tag) {
+      item = fhash->slots + pos * size;
+      if (fhash->equal_fn (item, v, fhash->user_data)) {
+        if (found != NULL) {
+          *found = item;
+        }
+        return 0;
+      }
+    }
+    else if (m == SC_FHASH_DELETED && target == fhash->slot_count) {
+      target = pos;
+    }
+    pos = (pos + 1) & mask;
+  }
+
+  /* reuse a deleted slot if we have passed one */
+  if (target < fhash->slot_count) {
+    SC_ASSERT (fhash->deleted_count > 0);
+    --fhash->deleted_count;
+    pos = target;
+  }
+  fhash->meta[pos] = tag;
+  item = fhash->slots + pos * size;
+  memcpy (item, v, size);
+  if (found != NULL) {
+    *found = item;
+  }
+  ++fhash->elem_count;
+
+  return 1;
+}
+
+int
+sc_fhash_remove (sc_fhash_t * fhash, const void *v, void *found)
+{
+  const size_t        mask = fhash->slot_count - 1;
+  unsigned char       tag, m;
+  size_t              pos;
+  char               *item;
+
+  pos = sc_fhash_position (fhash, fhash->hash_fn (v, fhash->user_data), &tag);
+  while ((m = fhash->meta[pos]) != SC_FHASH_EMPTY) {
+    if (m == tag) {
+      item = fhash->slots + pos * fhash->elem_size;
+      if (fhash->equal_fn (item, v, fhash->user_data)) {
+        if (found != NULL) {
+          memcpy (found, item, fhash->elem_size);
+        }
+
+        /* a slot followed by an empty one does not continue any probe */
+        if (fhash->meta[(pos + 1) & mask] == SC_FHASH_EMPTY) {
+          fhash->meta[pos] = SC_FHASH_EMPTY;
+        }
+        else {
+          fhash->meta[pos] = SC_FHASH_DELETED;
+          ++fhash->deleted_count;
+        }
+        --fhash->elem_count;
+
+        /* shrink the table when it has become sparse */
+        ++fhash->resize_checks;
+        if (fhash->slot_count > sc_fhash_minimal_size &&
+            fhash->elem_count < fhash->slot_count / 8) {
+          sc_fhash_rehash (fhash, fhash->slot_count / 2);
+        }
+        return 1;
+      }
+    }
+    pos = (pos + 1) & mask;
+  }
+  return 0;
+}
+
+void
+sc_fhash_foreach (sc_fhash_t * fhash, sc_fhash_foreach_t fn)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < fhash->slot_count; ++zz) {
+    if (fhash->meta[zz] & SC_FHASH_FULL) {
+      if (!fn (fhash->slots + zz * fhash->elem_size, fhash->user_data)) {
+        return;
+      }
+    }
+  }
+}
+
+void
+sc_fhash_print_statistics (int package_id, int log_priority,
+                           sc_fhash_t * fhash)
+{
+  size_t              zz, run, maxrun, numruns, sumruns;
+
+  /* clusters of non-empty slots determine the probing cost */
+  run = maxrun = numruns = sumruns = 0;
+  for (zz = 0; zz <= fhash->slot_count; ++zz) {
+    if (zz < fhash->slot_count && fhash->meta[zz] != SC_FHASH_EMPTY) {
+      ++run;
+    }
+    else if (run > 0) {
+      ++numruns;
+      sumruns += run;
+      maxrun = SC_MAX (maxrun, run);
+      run = 0;
+    }
+  }
+
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Flat hash size %lu load %.3g deleted %lu"
+               " avg run %.3g max run %lu checks %lu %lu\n",
+               (unsigned long) fhash->slot_count,
+               fhash->elem_count / (double) fhash->slot_count,
+               (unsigned long) fhash->deleted_count,
+               numruns > 0 ? sumruns / (double) numruns : 0.,
+               (unsigned long) maxrun,
+               (unsigned long) fhash->resize_checks,
+               (unsigned long) fhash->resize_actions);
+}
+
+/* flat hash array routines */
+
+/** The position that refers to the item currently looked up or inserted. */
+static const size_t sc_fhash_array_current = (size_t) -1;
+
+static inline void *
+sc_fhash_array_item (const sc_fhash_array_t * fa, const void *v)
+{
+  const size_t        zz = *(const size_t *) v;
+
+  return zz == sc_fhash_array_current ? fa->current_item :
+    sc_array_index ((sc_array_t *) & fa->a, zz);
+}
+
+static unsigned int
+sc_fhash_array_hash_fn (const void *v, const void *u)
+{
+  const sc_fhash_array_t *fa = (const sc_fhash_array_t *) u;
+
+  return fa->hash_fn (sc_fhash_array_item (fa, v), fa->user_data);
+}
+
+static int
+sc_fhash_array_equal_fn (const void *v1, const void *v2, const void *u)
+{
+  const sc_fhash_array_t *fa = (const sc_fhash_array_t *) u;
+
+  return fa->equal_fn (sc_fhash_array_item (fa, v1),
+                       sc_fhash_array_item (fa, v2), fa->user_data);
+}
+
+size_t
+sc_fhash_array_memory_used (sc_fhash_array_t * fa)
+{
+  return sizeof (sc_fhash_array_t) +
+    sc_array_memory_used (&fa->a, 0) + sc_fhash_memory_used (fa->h);
+}
+
+sc_fhash_array_t   *
+sc_fhash_array_new (size_t elem_size, sc_hash_function_t hash_fn,
+                    sc_equal_function_t equal_fn, void *user_data)
+{
+  sc_fhash_array_t   *fa;
+
+  fa = SC_ALLOC (sc_fhash_array_t, 1);
+  fa->user_data = user_data;
+  fa->hash_fn = hash_fn;
+  fa->equal_fn = equal_fn;
+  fa->current_item = NULL;
+
+  /* the hash table stores array positions and passes us as user data */
+  sc_array_init (&fa->a, elem_size);
+  fa->h = sc_fhash_new (sizeof (size_t), sc_fhash_array_hash_fn,
+                        sc_fhash_array_equal_fn, fa);
+
+  return fa;
+}
+
+void
+sc_fhash_array_destroy (sc_fhash_array_t * fhash_array)
+{
+  sc_fhash_destroy (fhash_array->h);
+  sc_array_reset (&fhash_array->a);
+
+  SC_FREE (fhash_array);
+}
+
+int
+sc_fhash_array_is_valid (sc_fhash_array_t * fhash_array)
+{
+  int                 found;
+  size_t              zz, position;
+  void               *v;
+
+  SC_ASSERT (fhash_array != NULL);
+
+  if (fhash_array->a.elem_count != fhash_array->h->elem_count) {
+    return 0;
+  }
+
+  for (zz = 0; zz < fhash_array->a.elem_count; ++zz) {
+    v = sc_array_index (&fhash_array->a, zz);
+    found = sc_fhash_array_lookup (fhash_array, v, &position);
+    if (!found || position != zz) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+void
+sc_fhash_array_truncate (sc_fhash_array_t * fhash_array)
+{
+  sc_fhash_truncate (fhash_array->h);
+  sc_array_reset (&fhash_array->a);
+}
+
+int
+sc_fhash_array_lookup (sc_fhash_array_t * fhash_array, void *v,
+                       size_t *position)
+{
+  int                 found;
+  void               *found_void;
+
+  /* verify general invariant */
+  SC_ASSERT (fhash_array != NULL);
+  SC_ASSERT (fhash_array->a.elem_count == fhash_array->h->elem_count);
+  SC_ASSERT (fhash_array->current_item == NULL);
+
+  fhash_array->current_item = v;
+  found = sc_fhash_lookup (fhash_array->h, &sc_fhash_array_current,
+                           &found_void);
+  fhash_array->current_item = NULL;
+
+  if (found) {
+    if (position != NULL) {
+      *position = *(size_t *) found_void;
+    }
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}
+
+void               *
+sc_fhash_array_insert_unique (sc_fhash_array_t * fhash_array, void *v,
+                              size_t *position)
+{
+  int                 added;
+  void               *found_void;
+
+  /* verify general invariant */
+  SC_ASSERT (fhash_array != NULL);
+  SC_ASSERT (fhash_array->a.elem_count == fhash_array->h->elem_count);
+  SC_ASSERT (fhash_array->current_item == NULL);
+
+  fhash_array->current_item = v;
+  added = sc_fhash_insert_unique (fhash_array->h, &sc_fhash_array_current,
+                                  &found_void);
+  fhash_array->current_item = NULL;
+
+  if (added) {
+    if (position != NULL) {
+      *position = fhash_array->a.elem_count;
+    }
+    *(size_t *) found_void = fhash_array->a.elem_count;
+    return sc_array_push (&fhash_array->a);
+  }
+  else {
+    if (position != NULL) {
+      *position = *(size_t *) found_void;
+    }
+    return NULL;
+  }
+}
+
+void
+sc_fhash_array_rip (sc_fhash_array_t * fhash_array, sc_array_t * rip)
+{
+  sc_fhash_destroy (fhash_array->h);
+  memcpy (rip, &fhash_array->a, sizeof (sc_array_t));
+
+  SC_FREE (fhash_array);
+}
+
+/* concurrent hash array routines */
+
+/* default number of stripes of a concurrent hash array */
+#define SC_CHASH_STRIPES 256
+
+/* a query refers to an item outside of the stripe's array */
+typedef struct sc_chash_query
+{
+  size_t              index;    /**< Always SC_CHASH_QUERY. */
+  const void         *item;     /**< The item looked up or inserted. */
+}
+sc_chash_query_t;
+
+#define SC_CHASH_QUERY ((size_t) -1)
+
+struct sc_chash_stripe
+{
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_t     mutex;    /**< Protects the stripe before freezing. */
+#endif
+  sc_chash_t         *chash;    /**< Back pointer for the callbacks. */
+  sc_array_t          a;        /**< Items in order of insertion. */
+  sc_fhash_t         *h;        /**< Flat hash map of positions in array. */
+};
+
+/* the fhash entries are either array positions or a query */
+static inline const void *
+sc_chash_item (const sc_chash_stripe_t * stripe, const void *v)
+{
+  const size_t        zz = *(const size_t *) v;
+
+  return zz == SC_CHASH_QUERY ? ((const sc_chash_query_t *) v)->item :
+    sc_array_index ((sc_array_t *) & stripe->a, zz);
+}
+
+static unsigned int
+sc_chash_hash_fn (const void *v, const void *u)
+{
+  const sc_chash_stripe_t *stripe = (const sc_chash_stripe_t *) u;
+
+  return stripe->chash->hash_fn (sc_chash_item (stripe, v),
+                                 stripe->chash->user_data);
+}
+
+static int
+sc_chash_equal_fn (const void *v1, const void *v2, const void *u)
+{
+  const sc_chash_stripe_t *stripe = (const sc_chash_stripe_t *) u;
+
+  return stripe->chash->equal_fn (sc_chash_item (stripe, v1),
+                                  sc_chash_item (stripe, v2),
+                                  stripe->chash->user_data);
+}
+
+/* choose a stripe independently of the slot chosen by the flat hash */
+static sc_chash_stripe_t *
+sc_chash_stripe (sc_chash_t * chash, const void *v, int *s)
+{
+  uint32_t            x;
+
+  x = (uint32_t) chash->hash_fn (v, chash->user_data) * 0x85ebca6bU;
+  x ^= x >> 16;
+  *s = (int) (x & (uint32_t) (chash->num_stripes - 1));
+  return chash->stripes[*s];
+}
+
+static void
+sc_chash_lock (sc_chash_t * chash, sc_chash_stripe_t * stripe)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  if (!chash->frozen) {
+    pth = pthread_mutex_lock (&stripe->mutex);
+    SC_CHECK_ABORT (pth == 0, "Concurrent hash lock");
+  }
+#endif
+}
+
+static void
+sc_chash_unlock (sc_chash_t * chash, sc_chash_stripe_t * stripe)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  if (!chash->frozen) {
+    pth = pthread_mutex_unlock (&stripe->mutex);
+    SC_CHECK_ABORT (pth == 0, "Concurrent hash unlock");
+  }
+#endif
+}
+
+size_t
+sc_chash_memory_used (sc_chash_t * chash)
+{
+  int                 s;
+  size_t              total;
+  sc_chash_stripe_t  *stripe;
+
+  total = sizeof (sc_chash_t) +
+    chash->num_stripes * sizeof (sc_chash_stripe_t *) +
+    (chash->num_stripes + 1) * sizeof (size_t);
+  for (s = 0; s < chash->num_stripes; ++s) {
+    stripe = chash->stripes[s];
+    total += sizeof (sc_chash_stripe_t) +
+      sc_array_memory_used (&stripe->a, 0) + sc_fhash_memory_used (stripe->h);
+  }
+  return total;
+}
+
+sc_chash_t         *
+sc_chash_new (size_t elem_size, sc_hash_function_t hash_fn,
+              sc_equal_function_t equal_fn, void *user_data, int num_stripes)
+{
+  int                 s;
+  sc_chash_t         *chash;
+  sc_chash_stripe_t  *stripe;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+#endif
+
+  SC_ASSERT (elem_size > 0);
+
+  chash = SC_ALLOC (sc_chash_t, 1);
+  chash->elem_size = elem_size;
+  chash->elem_count = 0;
+  chash->user_data = user_data;
+  chash->frozen = 0;
+  chash->hash_fn = hash_fn;
+  chash->equal_fn = equal_fn;
+
+  /* the stripe count is a power of two */
+  if (num_stripes <= 0) {
+    num_stripes = SC_CHASH_STRIPES;
+  }
+  chash->num_stripes = 1;
+  while (chash->num_stripes < num_stripes) {
+    chash->num_stripes *= 2;
+  }
+  chash->stripes = SC_ALLOC (sc_chash_stripe_t *, chash->num_stripes);
+  chash->offsets = SC_ALLOC_ZERO (size_t, chash->num_stripes + 1);
+
+  /* stripes are allocated separately to keep their locks apart in memory */
+  for (s = 0; s < chash->num_stripes; ++s) {
+    stripe = chash->stripes[s] = SC_ALLOC (sc_chash_stripe_t, 1);
+#ifdef SC_ENABLE_PTHREAD
+    pth = pthread_mutex_init (&stripe->mutex, NULL);
+    SC_CHECK_ABORT (pth == 0, "Concurrent hash mutex");
+#endif
+    stripe->chash = chash;
+    sc_array_init (&stripe->a, elem_size);
+    stripe->h = sc_fhash_new (sizeof (size_t), sc_chash_hash_fn,
+                              sc_chash_equal_fn, stripe);
+  }
+
+  return chash;
+}
+
+void
+sc_chash_destroy (sc_chash_t * chash)
+{
+  int                 s;
+  sc_chash_stripe_t  *stripe;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+#endif
+
+  for (s = 0; s < chash->num_stripes; ++s) {
+    stripe = chash->stripes[s];
+    sc_fhash_destroy (stripe->h);
+    sc_array_reset (&stripe->a);
+#ifdef SC_ENABLE_PTHREAD
+    pth = pthread_mutex_destroy (&stripe->mutex);
+    SC_CHECK_ABORT (pth == 0, "Concurrent hash mutex destroy");
+#endif
+    SC_FREE (stripe);
+  }
+  SC_FREE (chash->offsets);
+  SC_FREE (chash->stripes);
+  SC_FREE (chash);
+}
+
+int
+sc_chash_insert_unique (sc_chash_t * chash, const void *v, void *found)
+{
+  int                 s, added;
+  void               *found_void;
+  sc_chash_query_t    query;
+  sc_chash_stripe_t  *stripe;
+
+  SC_ASSERT (!chash->frozen);
+
+  query.index = SC_CHASH_QUERY;
+  query.item = v;
+  stripe = sc_chash_stripe (chash, v, &s);
+
+  sc_chash_lock (chash, stripe);
+  added = sc_fhash_insert_unique (stripe->h, &query, &found_void);
+  if (added) {
+    *(size_t *) found_void = stripe->a.elem_count;
+    memcpy (sc_array_push (&stripe->a), v, chash->elem_size);
+  }
+  else if (found != NULL) {
+    memcpy (found, sc_array_index (&stripe->a, *(size_t *) found_void),
+            chash->elem_size);
+  }
+  sc_chash_unlock (chash, stripe);
+
+  if (added && found != NULL) {
+    memcpy (found, v, chash->elem_size);
+  }
+  return added;
+}
+
+int
+sc_chash_lookup (sc_chash_t * chash, const void *v, size_t *position)
+{
+  int                 s, found;
+  void               *found_void;
+  sc_chash_query_t    query;
+  sc_chash_stripe_t  *stripe;
+
+  SC_ASSERT (chash->frozen || position == NULL);
+
+  query.index = SC_CHASH_QUERY;
+  query.item = v;
+  stripe = sc_chash_stripe (chash, v, &s);
+
+  /* after freezing the stripes are read only and need no locking */
+  sc_chash_lock (chash, stripe);
+  found = sc_fhash_lookup (stripe->h, &query, &found_void);
+  sc_chash_unlock (chash, stripe);
+
+  if (found && position != NULL) {
+    *position = chash->offsets[s] + *(size_t *) found_void;
+  }
+  return found;
+}
+
+void
+sc_chash_freeze (sc_chash_t * chash)
+{
+  int                 s;
+
+  SC_ASSERT (!chash->frozen);
+
+  for (s = 0; s < chash->num_stripes; ++s) {
+    chash->offsets[s + 1] =
+      chash->offsets[s] + chash->stripes[s]->a.elem_count;
+  }
+  chash->elem_count = chash->offsets[chash->num_stripes];
+  chash->frozen = 1;
+}
+
+void               *
+sc_chash_index (sc_chash_t * chash, size_t position)
+{
+  int                 low, high, mid;
+
+  SC_ASSERT (chash->frozen);
+  SC_ASSERT (position < chash->elem_count);
+
+  /* find the last stripe whose offset does not exceed the position */
+  low = 0;
+  high = chash->num_stripes - 1;
+  while (low < high) {
+    mid = (low + high + 1) / 2;
+    if (chash->offsets[mid] <= position) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  return sc_array_index (&chash->stripes[low]->a,
+                         position - chash->offsets[low]);
+}
+
+void
+sc_chash_rip (sc_chash_t * chash, sc_array_t * rip)
+{
+  int                 s;
+  sc_chash_stripe_t  *stripe;
+
+  SC_ASSERT (chash->frozen);
+
+  /* the positions are contiguous in stripe order */
+  sc_array_init_count (rip, chash->elem_size, chash->elem_count);
+  for (s = 0; s < chash->num_stripes; ++s) {
+    stripe = chash->stripes[s];
+    if (stripe->a.elem_count > 0) {
+      memcpy (sc_array_index (rip, chash->offsets[s]), stripe->a.array,
+              stripe->a.elem_count * chash->elem_size);
+    }
+  }
+  sc_chash_destroy (chash);
+}
+
+void
+sc_recycle_array_init (sc_recycle_array_t * rec_array, size_t elem_size)
+{
+  sc_array_init (&rec_array->a, elem_size);
+  sc_array_init (&rec_array->f, sizeof (size_t));
+
+  rec_array->elem_count = 0;
+}
+
+void
+sc_recycle_array_reset (sc_recycle_array_t * rec_array)
+{
+  SC_ASSERT (rec_array->a.elem_count ==
+             rec_array->elem_count + rec_array->f.elem_count);
+
+  sc_array_reset (&rec_array->a);
+  sc_array_reset (&rec_array->f);
+
+  rec_array->elem_count = 0;
+}
+
+void               *
+sc_recycle_array_insert (sc_recycle_array_t * rec_array, size_t *position)
+{
+  size_t              newpos;
+  void               *newitem;
+
+  if (rec_array->f.elem_count > 0) {
+    newpos = *(size_t *) sc_array_pop (&rec_array->f);
+    newitem = sc_array_index (&rec_array->a, newpos);
+  }
+  else {
+    newpos = rec_array->a.elem_count;
+    newitem = sc_array_push (&rec_array->a);
+  }
+
+  if (position != NULL) {
+    *position = newpos;
+  }
+  ++rec_array->elem_count;
+
+  return newitem;
+}
+
+void               *
+sc_recycle_array_remove (sc_recycle_array_t * rec_array, size_t position)
+{
+  SC_ASSERT (rec_array->elem_count > 0);
+
+  *(size_t *) sc_array_push (&rec_array->f) = position;
+  --rec_array->elem_count;
+
+  return sc_array_index (&rec_array->a, position);
+}
+
+/* indexed priority queue routines */
+
+#define SC_PQUEUE_NONE ((size_t) -1)
+
+/* compare the keys of two handles */
+static inline int
+sc_pqueue_compare (sc_pqueue_t * pq, size_t h1, size_t h2)
+{
+  return pq->compar (pq->keys + pq->elem_size * h1,
+                     pq->keys + pq->elem_size * h2);
+}
+
+/* move the hole at position up to where handle fits and store it there */
+static void
+sc_pqueue_sift_up (sc_pqueue_t * pq, size_t position, size_t handle)
+{
+  size_t              parent;
+
+  while (position > 0) {
+    parent = SC_PQUEUE_PARENT (position);
+    if (sc_pqueue_compare (pq, pq->heap[parent], handle) <= 0) {
+      break;
+    }
+    pq->heap[position] = pq->heap[parent];
+    pq->position[pq->heap[position]] = position;
+    position = parent;
+  }
+  pq->heap[position] = handle;
+  pq->position[handle] = position;
+}
+
+/* move the hole at position down to where handle fits and store it there */
+static void
+sc_pqueue_sift_down (sc_pqueue_t * pq, size_t position, size_t handle)
+{
+  size_t              child, last, c;
+
+  while ((child = SC_PQUEUE_CHILD (position)) < pq->elem_count) {
+    last = SC_MIN (child + SC_PQUEUE_ARITY, pq->elem_count);
+    for (c = child + 1; c < last; ++c) {
+      if (sc_pqueue_compare (pq, pq->heap[c], pq->heap[child]) < 0) {
+        child = c;
+      }
+    }
+    if (sc_pqueue_compare (pq, handle, pq->heap[child]) <= 0) {
+      break;
+    }
+    pq->heap[position] = pq->heap[child];
+    pq->position[pq->heap[position]] = position;
+    position = child;
+  }
+  pq->heap[position] = handle;
+  pq->position[handle] = position;
+}
+
+void
+sc_pqueue_init (sc_pqueue_t * pq, size_t elem_size, size_t num_handles,
+                int (*compar) (const void *, const void *))
+{
+  size_t              zz;
+
+  SC_ASSERT (elem_size > 0);
+  SC_ASSERT (compar != NULL);
+
+  pq->elem_size = elem_size;
+  pq->num_handles = num_handles;
+  pq->elem_count = 0;
+  pq->compar = compar;
+
+  pq->keys = SC_ALLOC (char, elem_size * num_handles);
+  pq->heap = SC_ALLOC (size_t, num_handles);
+  pq->position = SC_ALLOC (size_t, num_handles);
+  for (zz = 0; zz < num_handles; ++zz) {
+    pq->position[zz] = SC_PQUEUE_NONE;
+  }
+}
+
+void
+sc_pqueue_reset (sc_pqueue_t * pq)
+{
+  SC_FREE (pq->keys);
+  SC_FREE (pq->heap);
+  SC_FREE (pq->position);
+
+  pq->elem_count = 0;
+}
+
+int
+sc_pqueue_contains (sc_pqueue_t * pq, size_t handle)
+{
+  SC_ASSERT (handle < pq->num_handles);
+
+  return pq->position[handle] != SC_PQUEUE_NONE;
+}
+
+void               *
+sc_pqueue_key (sc_pqueue_t * pq, size_t handle)
+{
+  SC_ASSERT (handle < pq->num_handles);
+
+  return pq->keys + pq->elem_size * handle;
+}
+
+void
+sc_pqueue_push (sc_pqueue_t * pq, size_t handle, const void *key)
+{
+  SC_ASSERT (!sc_pqueue_contains (pq, handle));
+  SC_ASSERT (pq->elem_count < pq->num_handles);
+
+  memcpy (pq->keys + pq->elem_size * handle, key, pq->elem_size);
+  sc_pqueue_sift_up (pq, pq->elem_count++, handle);
+}
+
+void
+sc_pqueue_decrease (sc_pqueue_t * pq, size_t handle, const void *key)
+{
+  char               *k;
+
+  SC_ASSERT (sc_pqueue_contains (pq, handle));
+
+  k = pq->keys + pq->elem_size * handle;
+  SC_ASSERT (pq->compar (key, k) <= 0);
+  memcpy (k, key, pq->elem_size);
+  sc_pqueue_sift_up (pq, pq->position[handle], handle);
+}
+
+size_t
+sc_pqueue_top (sc_pqueue_t * pq)
+{
+  SC_ASSERT (pq->elem_count > 0);
+
+  return pq->heap[0];
+}
+
+size_t
+sc_pqueue_pop (sc_pqueue_t * pq)
+{
+  size_t              top;
+
+  SC_ASSERT (pq->elem_count > 0);
+
+  top = pq->heap[0];
+  pq->position[top] = SC_PQUEUE_NONE;
+  if (--pq->elem_count > 0) {
+    sc_pqueue_sift_down (pq, 0, pq->heap[pq->elem_count]);
+  }
+
+  return top;
 }
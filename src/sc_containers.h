@@ -39,6 +39,8 @@
  * The \ref sc_array structure serves as lightweight resizable array.
  * Based on this array, we implement the \ref sc_hash table and
  * the \ref sc_hash_array.
+ * The open addressing \ref sc_fhash table and \ref sc_fhash_array
+ * store their items inline and avoid the linked lists of \ref sc_hash.
  * We also add a string implementation in \ref sc_string.h.
  */
 
@@ -111,7 +113,9 @@ typedef int         (*sc_hash_foreach_t) (void **v, const void *u);
  * \ref sc_array_resize and \ref sc_array_rewind.
  * Elements can be sorted with \ref sc_array_sort.
  * If the array is sorted, it can be searched with \ref sc_array_bsearch.
- * A priority queue is implemented with pqueue_add and pqueue_pop (untested).
+ * A priority queue is implemented with \ref sc_array_pqueue_add,
+ * \ref sc_array_pqueue_pop and \ref sc_array_pqueue_heapify.
+ * For a queue with decrease-key, see \ref sc_pqueue_t.
  */
 typedef struct sc_array
 {
@@ -144,6 +148,56 @@ sc_array_t;
  */
 size_t              sc_array_memory_used (sc_array_t * array, int is_dynamic);
 
+/** The policy for the allocation of all arrays that are not views.
+ * When an array outgrows its allocation, the new one is at least \a growth
+ * times larger, so the cost of copying is amortized over the additions.
+ * An array shrinks only when it is resized down and its allocation exceeds
+ * \a shrink times its contents.  This hysteresis avoids reallocating an
+ * array repeatedly while its size oscillates around a boundary.
+ */
+typedef struct sc_array_policy
+{
+  double              growth;   /**< Growth factor greater than 1.  The
+                                     default 2 rounds the allocation up
+                                     to the next power of two. */
+  double              shrink;   /**< Shrink threshold not less than the
+                                     growth factor, or 0 to never shrink
+                                     but by \ref sc_array_shrink_to_fit.
+                                     The default is 4.  A value of 2
+                                     reproduces the shrinking of
+                                     earlier versions. */
+}
+sc_array_policy_t;
+
+/** Set the allocation policy of all arrays.
+ * This function is not thread-safe and best called once after sc_init.
+ * \param [in] policy      The policy is copied.
+ */
+void                sc_array_set_policy (const sc_array_policy_t * policy);
+
+/** Query the allocation policy of all arrays.
+ * \param [out] policy     The current policy is copied into this structure.
+ */
+void                sc_array_get_policy (sc_array_policy_t * policy);
+
+/** Process-wide counters of the reallocations of array memory. */
+typedef struct sc_array_counts
+{
+  size_t              grows;    /**< Reallocations to a larger size */
+  size_t              shrinks;  /**< Reallocations to a smaller size */
+  size_t              bytes;    /**< Bytes carried over by the above */
+}
+sc_array_counts_t;
+
+/** Read the reallocation counters of all arrays.
+ * The counters are updated atomically or under a lock with pthreads.
+ * \param [out] counts     The current counter values.
+ */
+void                sc_array_get_counts (sc_array_counts_t * counts);
+
+/** Set the reallocation counters of all arrays to zero. */
+void                sc_array_reset_counts (void);
+
 /** Creates a new array structure with 0 elements.
  * \param [in] elem_size    Size of one array element in bytes.
  * \return                  Return an allocated array of zero length.
@@ -299,7 +353,8 @@ void                sc_array_truncate (sc_array_t * array);
 void                sc_array_rewind (sc_array_t * array, size_t new_count);
 
 /** Sets the element count to new_count.
- * If the array is not a view, reallocation takes place occasionally.
+ * If the array is not a view, reallocation takes place occasionally
+ * according to the policy set by \ref sc_array_set_policy.
  * If the array is a view, new_count must not be greater than the element
  * count of the view when it was created.  The original offset of the view
  * cannot be changed.
@@ -310,6 +365,22 @@ void                sc_array_rewind (sc_array_t * array, size_t new_count);
  */
 void                sc_array_resize (sc_array_t * array, size_t new_count);
 
+/** Make room for a number of elements without changing the element count.
+ * This function is not allowed for views.
+ * If the allocation is too small, it is enlarged to exactly this size.
+ * The array will not shrink below this size until it is resized down.
+ * \param [in,out] array    The allocation of this array may change.
+ * \param [in] elem_count   Number of elements to make room for.
+ */
+void                sc_array_reserve (sc_array_t * array, size_t elem_count);
+
+/** Release the memory that is allocated beyond the array's contents.
+ * This function is not allowed for views.
+ * \param [in,out] array    The allocation of this array may change.
+ *                          An array of zero elements is reset.
+ */
+void                sc_array_shrink_to_fit (sc_array_t * array);
+
 /** Copy the contents of one array into another.
  * Both arrays must have equal element sizes.
  * The source array may be a view.
@@ -358,6 +429,38 @@ void                sc_array_sort (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** Sorts the array in ascending order of an integer key inside each element.
+ * This is an LSD radix sort that is usually much faster than \ref
+ * sc_array_sort.  Unlike the latter, it is stable:  elements with equal
+ * keys keep their relative order.  A temporary copy of the array is used.
+ * The key is read in the native byte order of the machine.
+ * \param [in,out] array    The array to sort.  May be a view.
+ * \param [in] key_offset   Offset in bytes of the key inside an element.
+ * \param [in] key_width    Size in bytes of the key; 1, 2, 4, or 8.
+ *                          \b key_offset + \b key_width must not be
+ *                          larger than the element size.
+ * \param [in] key_signed   True if the key is a signed integer such as
+ *                          int32_t or int64_t, false for unsigned keys.
+ */
+void                sc_array_sort_key (sc_array_t * array, size_t key_offset,
+                                       size_t key_width, int key_signed);
+
+/** Sorts the array by an integer key, optionally multithreaded.
+ * This function works like \ref sc_array_sort_key.
+ * If the library is configured with pthreads, each pass of the sort is
+ * split between up to \b num_threads threads; threads are only used for
+ * sufficiently large arrays.  Without pthreads the sort runs serially.
+ * \param [in,out] array    The array to sort.  May be a view.
+ * \param [in] key_offset   Offset in bytes of the key inside an element.
+ * \param [in] key_width    Size in bytes of the key; 1, 2, 4, or 8.
+ * \param [in] key_signed   True if the key is a signed integer.
+ * \param [in] num_threads  Maximum number of threads to use, at least 1.
+ */
+void                sc_array_sort_key_ext (sc_array_t * array,
+                                           size_t key_offset,
+                                           size_t key_width, int key_signed,
+                                           int num_threads);
+
 /** Check whether the array is sorted wrt. the comparison function.
  * \param [in] array    The array to check.
  * \param [in] compar   The comparison function to be used.
@@ -453,16 +556,16 @@ void                sc_array_permute (sc_array_t * array,
 unsigned int        sc_array_checksum (sc_array_t * array);
 
 /** Adds an element to a priority queue.
- * \note PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
  * This function is not allowed for views.
  * The priority queue is implemented as a heap in ascending order.
- * A heap is a binary tree where the children are not less than their parent.
+ * The heap is a 4-ary tree where the children are not less than their parent.
+ * Element [i] has the children [4 * i + 1]..[4 * i + 4].
  * Assumes that elements [0]..[elem_count-2] form a valid heap.
- * Then propagates [elem_count-1] upward by swapping if necessary.
+ * Then moves larger parents of [elem_count-1] down until it fits.
  * \param [in,out] array    Valid priority queue object.
  * \param [in] temp    Pointer to unused allocated memory of elem_size.
  * \param [in] compar  The comparison function to be used.
- * \return Returns the number of swap operations.
+ * \return Returns the number of levels the new element moved up.
  * \note  If the return value is zero for all elements in an array,
  *        the array is sorted linearly and unchanged.
  */
@@ -472,20 +575,32 @@ size_t              sc_array_pqueue_add (sc_array_t * array,
                                                         const void *));
 
 /** Pops the smallest element from a priority queue.
- * \note PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
  * This function is not allowed for views.
  * This function assumes that the array forms a valid heap in ascending order.
  * \param [in,out] array    Valid priority queue object.
  * \param [out] result  Pointer to unused allocated memory of elem_size.
  * \param [in]  compar  The comparison function to be used.
- * \return Returns the number of swap operations.
- * \note This function resizes the array to elem_count-1.
+ * \return Returns the number of levels the last element moved down.
+ * \note This function reduces the elem_count of the array by one.
  */
 size_t              sc_array_pqueue_pop (sc_array_t * array,
                                          void *result,
                                          int (*compar) (const void *,
                                                         const void *));
 
+/** Arranges arbitrary array contents into a priority queue.
+ * This function is not allowed for views.
+ * It takes linear time and is faster than adding the elements one by one.
+ * \param [in,out] array    Any array; on output a valid priority queue.
+ * \param [in] temp    Pointer to unused allocated memory of elem_size.
+ * \param [in] compar  The comparison function to be used.
+ * \return Returns the total number of levels that elements moved down.
+ */
+size_t              sc_array_pqueue_heapify (sc_array_t * array,
+                                             void *temp,
+                                             int (*compar) (const void *,
+                                                            const void *));
+
 /** Returns a pointer to an array element.
  * \param [in] array Valid array.
  * \param [in] index needs to be in [0]..[elem_count-1].
@@ -702,6 +817,9 @@ void               *sc_mstamp_alloc (sc_mstamp_t * mst);
  */
 size_t              sc_mstamp_memory_used (sc_mstamp_t * mst);
 
+/** Opaque state of a mempool that is shared between threads. */
+typedef struct sc_mempool_shared sc_mempool_shared_t;
+
 /** The sc_mempool object provides a large pool of equal-size elements.
  * The pool grows dynamically for element allocation.
  * Elements are referenced by their address which never changes.
@@ -710,17 +828,26 @@ size_t              sc_mstamp_memory_used (sc_mstamp_t * mst);
  * If the zero_and_persist option is selected, new elements are initialized to
  * all zeros on creation, and the contents of an element are not touched
  * between freeing and re-returning it.
+ *
+ * A pool created by \ref sc_mempool_new_concurrent may be used by many
+ * threads at the same time.  Each thread allocates from its own stamp and
+ * keeps its own list of freed elements, which is exchanged in batches with
+ * a list shared by all threads.  An element may be freed by a thread
+ * different from the one that allocated it.
  */
 typedef struct sc_mempool
 {
   /* interface variables */
   size_t              elem_size;        /**< size of a single element */
-  size_t              elem_count;       /**< number of valid elements */
+  size_t              elem_count;       /**< number of valid elements;
+                                             see \ref sc_mempool_sync for
+                                             a concurrent pool */
   int                 zero_and_persist; /**< Boolean; is set in constructor. */
 
   /* implementation variables */
   sc_mstamp_t         mstamp;   /**< fixed-size chunk allocator */
   sc_array_t          freed;    /**< buffers the freed elements */
+  sc_mempool_shared_t *shared;  /**< NULL unless the pool is concurrent */
 }
 sc_mempool_t;
 
@@ -745,6 +872,44 @@ sc_mempool_t       *sc_mempool_new (size_t elem_size);
  */
 sc_mempool_t       *sc_mempool_new_zero_and_persist (size_t elem_size);
 
+/** Creates a new mempool structure that may be used by concurrent threads.
+ * Allocation and free may be called by any number of threads at the same
+ * time, for example to populate one \ref sc_list_t per thread from a
+ * single pool of \ref sc_link_t.  All other mempool functions require
+ * exclusive access.  All concurrent pools share one thread-specific key,
+ * so their number is not limited by the system.  If configured without
+ * --enable-pthread, the pool behaves like one created by \ref sc_mempool_new.
+ * \param [in] elem_size         Size of one element in bytes.
+ * \param [in] zero_and_persist  Boolean; see \ref sc_mempool_t.
+ * \return Returns an allocated and initialized memory pool.
+ */
+sc_mempool_t       *sc_mempool_new_concurrent (size_t elem_size,
+                                               int zero_and_persist);
+
+/** Update the element count of a concurrent mempool.
+ * Threads count their allocations privately while using a concurrent pool.
+ * This function sums their counts into the elem_count member.
+ * It must not be called while other threads use the pool.
+ * For a serial pool it does nothing.
+ * \param [in,out] mempool      Valid mempool object.
+ */
+void                sc_mempool_sync (sc_mempool_t * mempool);
+
+/** Allocate a single element from a concurrent pool.
+ * Called by \ref sc_mempool_alloc; not meant to be used directly.
+ * \param [in,out] mempool      Valid mempool created concurrent.
+ * \return Returns a new or recycled element pointer.
+ */
+void               *sc_mempool_alloc_concurrent (sc_mempool_t * mempool);
+
+/** Return an element to a concurrent pool.
+ * Called by \ref sc_mempool_free; not meant to be used directly.
+ * \param [in,out] mempool      Valid mempool created concurrent.
+ * \param [in] elem             The element to be returned to the pool.
+ */
+void                sc_mempool_free_concurrent (sc_mempool_t * mempool,
+                                                void *elem);
+
 /** Same as sc_mempool_new, but for an already allocated object.
  * \param [out] mempool   Allocated memory is overwritten and initialized.
  * \param [in] elem_size  Size of one element in bytes.
@@ -787,6 +952,10 @@ sc_mempool_alloc (sc_mempool_t * mempool)
   void               *ret;
   sc_array_t         *freed = &mempool->freed;
 
+  if (mempool->shared != NULL) {
+    return sc_mempool_alloc_concurrent (mempool);
+  }
+
   ++mempool->elem_count;
 
   if (freed->elem_count > 0) {
@@ -817,6 +986,11 @@ sc_mempool_free (sc_mempool_t * mempool, void *elem)
 {
   sc_array_t         *freed = &mempool->freed;
 
+  if (mempool->shared != NULL) {
+    sc_mempool_free_concurrent (mempool, elem);
+    return;
+  }
+
   SC_ASSERT (mempool->elem_count > 0);
 
 #ifdef SC_ENABLE_DEBUG
@@ -1153,6 +1327,322 @@ void                sc_hash_array_foreach (sc_hash_array_t * hash_array,
 void                sc_hash_array_rip (sc_hash_array_t * hash_array,
                                        sc_array_t * rip);
 
+/** Function to call on every item of a flat hash table.
+ * \param [in] v   The address of the item stored inline in the table.
+ * \param [in] u   Arbitrary user data.
+ * \return Return true if the traversal should continue, false to stop.
+ */
+typedef int         (*sc_fhash_foreach_t) (void *v, const void *u);
+
+/** The sc_fhash implements a hash table with open addressing.
+ * The items are fixed-size records stored inline in one contiguous array.
+ * A second array holds one metadata byte per slot, which is either empty,
+ * deleted, or a 7-bit fragment of the item's hash value.
+ * Lookups probe linearly and only call the equality function on slots
+ * whose hash fragment matches, which keeps the probing cache friendly.
+ * The addresses of the items change on insertion and removal.
+ */
+typedef struct sc_fhash
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of a single item */
+  size_t              elem_count;       /**< total number of items contained */
+  void               *user_data;        /**< User data passed to hash function. */
+
+  /* implementation variables */
+  size_t              slot_count;       /**< Power of two number of slots. */
+  size_t              deleted_count;    /**< Number of deleted markers. */
+  int                 shift;    /**< Shift to extract the slot from a hash. */
+  unsigned char      *meta;     /**< One metadata byte per slot. */
+  char               *slots;    /**< Inline item storage. */
+  sc_hash_function_t  hash_fn;  /**< Function called to compute the hash value. */
+  sc_equal_function_t equal_fn; /**< Function called to check objects for equality. */
+  size_t              resize_checks;    /**< Running count of resize checks. */
+  size_t              resize_actions;   /**< Running count of resize actions. */
+}
+sc_fhash_t;
+
+/** Calculate the memory used by a flat hash table.
+ * \param [in] fhash       The hash table.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_fhash_memory_used (sc_fhash_t * fhash);
+
+/** Create a new flat hash table.
+ * The number of slots is chosen dynamically.
+ * \param [in] elem_size   Size of one item in bytes.  Must be positive.
+ * \param [in] hash_fn     Function to compute the hash value of an item.
+ * \param [in] equal_fn    Function to test two items for equality.
+ * \param [in] user_data   User data passed through to the hash function.
+ */
+sc_fhash_t         *sc_fhash_new (size_t elem_size,
+                                  sc_hash_function_t hash_fn,
+                                  sc_equal_function_t equal_fn,
+                                  void *user_data);
+
+/** Destroy a flat hash table in O(1).
+ * \param [in,out] fhash        Valid flat hash table is deallocated.
+ */
+void                sc_fhash_destroy (sc_fhash_t * fhash);
+
+/** Destroy a flat hash table and set its pointer to NULL.
+ * \param [in,out] pfhash       Address of pointer to flat hash table.
+ *                              On output, pointer is NULLed.
+ */
+void                sc_fhash_destroy_null (sc_fhash_t ** pfhash);
+
+/** Remove all items from a flat hash table.
+ * The slot memory is shrunk to the minimal size.
+ * \param [in,out] fhash        Valid flat hash table.
+ */
+void                sc_fhash_truncate (sc_fhash_t * fhash);
+
+/** Check if an item is contained in the flat hash table.
+ * \param [in] fhash   Valid flat hash table.
+ * \param [in]  v      The item to be looked up.
+ * \param [out] found  If found != NULL, *found is set to the address of the
+ *                     item stored in the table if it is found.
+ *                     This address is valid until the table is modified.
+ * \return Returns true if the item is found, false otherwise.
+ */
+int                 sc_fhash_lookup (sc_fhash_t * fhash, const void *v,
+                                     void **found);
+
+/** Insert an item into a flat hash table if it is not contained already.
+ * The item is copied into the table by its element size.
+ * \param [in,out] fhash    Valid flat hash table.
+ * \param [in]  v      The item to be inserted.
+ * \param [out] found  If found != NULL, *found is set to the address of the
+ *                     already contained, or if not present, the new item.
+ *                     This address is valid until the table is modified.
+ *                     The item may be modified as long as its hash value
+ *                     and equality with other items stay the same.
+ * \return Returns true if the item is added, false if it is contained.
+ */
+int                 sc_fhash_insert_unique (sc_fhash_t * fhash,
+                                            const void *v, void **found);
+
+/** Remove an item from a flat hash table.
+ * \param [in,out] fhash    Valid flat hash table.
+ * \param [in]  v      The item to be removed.
+ * \param [out] found  If found != NULL and the item exists, its content is
+ *                     copied into this memory of at least elem_size bytes.
+ * \return Returns true if the item is found, false if is not contained.
+ */
+int                 sc_fhash_remove (sc_fhash_t * fhash, const void *v,
+                                     void *found);
+
+/** Invoke a callback for every item of the flat hash table.
+ * The hashing and equality functions are not called from within this function.
+ * \param [in,out] fhash    Valid flat hash table.
+ * \param [in] fn           Callback executed on every item.
+ */
+void                sc_fhash_foreach (sc_fhash_t * fhash,
+                                      sc_fhash_foreach_t fn);
+
+/** Compute and print statistical information about the occupancy.
+ * \param [in] package_id   Library package id for logging.
+ * \param [in] log_priority Priority for logging; see \ref sc_log.
+ * \param [in] fhash    Valid flat hash table.
+ */
+void                sc_fhash_print_statistics (int package_id,
+                                               int log_priority,
+                                               sc_fhash_t * fhash);
+
+/** The sc_fhash_array implements an array backed up by a flat hash table.
+ * It has the same semantics as \ref sc_hash_array_t.
+ * The flat hash table stores array positions inline, which avoids the
+ * linked list nodes and the pointer chasing of \ref sc_hash_t.
+ */
+typedef struct sc_fhash_array
+{
+  /* interface variables */
+  void               *user_data;        /**< Context passed by the user. */
+
+  /* implementation variables */
+  sc_array_t          a;        /**< Array storing the elements. */
+  sc_fhash_t         *h;        /**< Flat hash map of positions in array. */
+  sc_hash_function_t  hash_fn;  /**< Function to hash an element. */
+  sc_equal_function_t equal_fn; /**< Function to compare two elements. */
+  void               *current_item;     /**< Item looked up or inserted. */
+}
+sc_fhash_array_t;
+
+/** Calculate the memory used by a flat hash array.
+ * \param [in] fa          The flat hash array.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_fhash_array_memory_used (sc_fhash_array_t * fa);
+
+/** Create a new flat hash array.
+ * \param [in] elem_size   Size of one array element in bytes.
+ * \param [in] hash_fn     Function to compute the hash value.
+ * \param [in] equal_fn    Function to test two objects for equality.
+ * \param [in] user_data   Anonymous context data stored in the hash array.
+ */
+sc_fhash_array_t   *sc_fhash_array_new (size_t elem_size,
+                                        sc_hash_function_t hash_fn,
+                                        sc_equal_function_t equal_fn,
+                                        void *user_data);
+
+/** Destroy a flat hash array.
+ * \param [in,out] fhash_array  Valid flat hash array is deallocated.
+ */
+void                sc_fhash_array_destroy (sc_fhash_array_t * fhash_array);
+
+/** Check the internal consistency of a flat hash array.
+ * \param [in] fhash_array      Flat hash array is checked for validity.
+ * \return                      True if and only if \a fhash_array is valid.
+ */
+int                 sc_fhash_array_is_valid (sc_fhash_array_t * fhash_array);
+
+/** Remove all elements from the flat hash array.
+ * \param [in,out] fhash_array  Flat hash array to truncate.
+ */
+void                sc_fhash_array_truncate (sc_fhash_array_t * fhash_array);
+
+/** Check if an object is contained in a flat hash array.
+ * \param [in,out] fhash_array  Valid flat hash array.
+ * \param [in]  v          A pointer to the object.
+ * \param [out] position   If position != NULL, *position is set to the
+ *                         array position of the already contained object
+ *                         if found.
+ * \return                 True if object is found, false otherwise.
+ */
+int                 sc_fhash_array_lookup (sc_fhash_array_t * fhash_array,
+                                           void *v, size_t *position);
+
+/** Insert an object into a flat hash array if it is not contained already.
+ * The object is not copied into the array.  Use the return value for that.
+ * New objects are guaranteed to be added at the end of the array.
+ *
+ * \param [in,out] fhash_array  Valid flat hash array.
+ * \param [in]  v          A pointer to the object.  Used for search only.
+ * \param [out] position   If position != NULL, *position is set to the
+ *                         array position of the already contained, or if
+ *                         not present, the new object.
+ * \return                 Returns NULL if the object is already contained.
+ *                         Otherwise returns its new address in the array.
+ */
+void               *sc_fhash_array_insert_unique (sc_fhash_array_t *
+                                                  fhash_array, void *v,
+                                                  size_t *position);
+
+/** Extract the array data from a flat hash array and destroy everything else.
+ * \param [in] fhash_array  The flat hash array is destroyed after extraction.
+ * \param [in] rip          Array structure that will be overwritten.
+ *                          All previous array data (if any) will be leaked.
+ *                          The filled array can be freed with sc_array_reset.
+ */
+void                sc_fhash_array_rip (sc_fhash_array_t * fhash_array,
+                                        sc_array_t * rip);
+
+/** Internal lock-protected part of a concurrent hash array. */
+typedef struct sc_chash_stripe sc_chash_stripe_t;
+
+/** The sc_chash implements a hash array that threads may fill concurrently.
+ * The items are distributed by their hash value onto a fixed number of
+ * stripes.  Each stripe is a \ref sc_fhash_array_t protected by its own
+ * lock, such that threads only contend when they touch the same stripe.
+ * The container is used in two phases:  In the insertion phase, any
+ * number of threads may call \ref sc_chash_insert_unique and
+ * \ref sc_chash_lookup.  After \ref sc_chash_freeze, the items are
+ * numbered densely and threads may look up their positions without
+ * locking, and \ref sc_chash_rip extracts them into one array.
+ * The position of an item depends on the order of concurrent insertions.
+ */
+typedef struct sc_chash
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of a single item */
+  size_t              elem_count;       /**< number of items; only
+                                             valid after freezing */
+  void               *user_data;        /**< Context passed by the user. */
+
+  /* implementation variables */
+  int                 frozen;   /**< Boolean; insertion phase has ended. */
+  int                 num_stripes;      /**< Power of two stripe count. */
+  sc_chash_stripe_t **stripes;  /**< Independently locked hash arrays. */
+  size_t             *offsets;  /**< First position of each stripe. */
+  sc_hash_function_t  hash_fn;  /**< Function to hash an item. */
+  sc_equal_function_t equal_fn; /**< Function to compare two items. */
+}
+sc_chash_t;
+
+/** Calculate the memory used by a concurrent hash array.
+ * \param [in] chash       The concurrent hash array.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_chash_memory_used (sc_chash_t * chash);
+
+/** Create a new concurrent hash array in its insertion phase.
+ * \param [in] elem_size   Size of one item in bytes.
+ * \param [in] hash_fn     Function to compute the hash value.
+ *                         Called concurrently and more than once per item.
+ * \param [in] equal_fn    Function to test two items for equality.
+ * \param [in] user_data   Anonymous context data passed to the callbacks.
+ * \param [in] num_stripes Number of independently locked parts.
+ *                         Rounded up to a power of two; if not positive,
+ *                         a default suitable for tens of threads is used.
+ * \return                 A valid concurrent hash array.
+ */
+sc_chash_t         *sc_chash_new (size_t elem_size,
+                                  sc_hash_function_t hash_fn,
+                                  sc_equal_function_t equal_fn,
+                                  void *user_data, int num_stripes);
+
+/** Destroy a concurrent hash array.
+ * \param [in,out] chash        Valid concurrent hash array is deallocated.
+ */
+void                sc_chash_destroy (sc_chash_t * chash);
+
+/** Insert a copy of an item if it is not contained already.
+ * May be called by many threads at the same time before freezing.
+ * \param [in,out] chash   Valid concurrent hash array, not frozen.
+ * \param [in] v           The item to be inserted.
+ * \param [out] found      If not NULL, the contained item, which may
+ *                         have been inserted by another thread, is copied
+ *                         into this memory of at least elem_size bytes.
+ * \return                 True if the item is added, false if contained.
+ */
+int                 sc_chash_insert_unique (sc_chash_t * chash,
+                                            const void *v, void *found);
+
+/** Check if an item is contained in a concurrent hash array.
+ * May be called by many threads at the same time in either phase.
+ * \param [in] chash       Valid concurrent hash array.
+ * \param [in] v           The item to be looked up.
+ * \param [out] position   If not NULL and the item is found, set to
+ *                         the item's position.  Only legal after freezing.
+ * \return                 True if the item is found, false otherwise.
+ */
+int                 sc_chash_lookup (sc_chash_t * chash, const void *v,
+                                     size_t *position);
+
+/** End the insertion phase and number the items densely.
+ * Must not be called while other threads use the container.
+ * \param [in,out] chash   Valid concurrent hash array, not frozen.
+ *                         On output, elem_count is the number of items.
+ */
+void                sc_chash_freeze (sc_chash_t * chash);
+
+/** Return the address of an item of a frozen concurrent hash array.
+ * \param [in] chash       Valid and frozen concurrent hash array.
+ * \param [in] position    Position less than elem_count.
+ * \return                 The address of the item at this position.
+ */
+void               *sc_chash_index (sc_chash_t * chash, size_t position);
+
+/** Extract the items of a frozen concurrent hash array by their positions
+ * and destroy everything else.
+ * \param [in] chash       Valid and frozen concurrent hash array.
+ *                         It is destroyed after extraction.
+ * \param [in] rip         Array structure that will be overwritten.
+ *                         All previous array data (if any) will be leaked.
+ *                         The filled array can be freed with sc_array_reset.
+ */
+void                sc_chash_rip (sc_chash_t * chash, sc_array_t * rip);
+
 /** The sc_recycle_array object provides an array of slots that can be reused.
  *
  * It keeps a list of free slots in the array which will be used for insertion
@@ -1206,6 +1696,82 @@ void               *sc_recycle_array_insert (sc_recycle_array_t * rec_array,
 void               *sc_recycle_array_remove (sc_recycle_array_t * rec_array,
                                              size_t position);
 
+/** The sc_pqueue object is a priority queue of handles with decrease-key.
+ *
+ * Handles are the integers 0 <= handle < num_handles, such as mesh vertex
+ * numbers.  Each handle owns one key of elem_size bytes and may be in the
+ * queue at most once.  The queue is a 4-ary heap of handles that tracks the
+ * position of each handle, so the key of a queued handle can be lowered.
+ */
+typedef struct sc_pqueue
+{
+  /* interface variables */
+  size_t              elem_size;        /**< Size of one key. */
+  size_t              num_handles;      /**< Number of possible handles. */
+  size_t              elem_count;       /**< Number of queued handles. */
+
+  /* implementation variables */
+  int                 (*compar) (const void *, const void *);
+  char               *keys;             /**< The key of every handle. */
+  size_t             *heap;             /**< Queued handles in heap order. */
+  size_t             *position;         /**< Heap position of each handle. */
+}
+sc_pqueue_t;
+
+/** Initialize an empty indexed priority queue.
+ * \param [out] pq          Uninitialized turned into a priority queue.
+ * \param [in] elem_size    Size of the key of each handle, positive.
+ * \param [in] num_handles  Handles range from 0 to num_handles - 1.
+ * \param [in] compar       Comparison function for two keys.
+ */
+void                sc_pqueue_init (sc_pqueue_t * pq, size_t elem_size,
+                                    size_t num_handles,
+                                    int (*compar) (const void *,
+                                                   const void *));
+
+/** Reset an indexed priority queue and free its memory. */
+void                sc_pqueue_reset (sc_pqueue_t * pq);
+
+/** Query whether a handle is currently in the queue.
+ * \param [in] pq       Valid priority queue.
+ * \param [in] handle   Handle less than num_handles.
+ * \return              True if the handle has been pushed and not popped.
+ */
+int                 sc_pqueue_contains (sc_pqueue_t * pq, size_t handle);
+
+/** Return the storage of the key of a handle.
+ * The key is valid after a push, and remains so after the handle is popped.
+ * It must not be modified while the handle is in the queue.
+ */
+void               *sc_pqueue_key (sc_pqueue_t * pq, size_t handle);
+
+/** Add a handle to the queue.
+ * \param [in,out] pq   Valid priority queue.
+ * \param [in] handle   Handle that is not in the queue.
+ * \param [in] key      The key is copied into the queue.
+ */
+void                sc_pqueue_push (sc_pqueue_t * pq, size_t handle,
+                                    const void *key);
+
+/** Lower the key of a handle in the queue.
+ * \param [in,out] pq   Valid priority queue.
+ * \param [in] handle   Handle that is in the queue.
+ * \param [in] key      Not larger than the handle's current key.
+ */
+void                sc_pqueue_decrease (sc_pqueue_t * pq, size_t handle,
+                                        const void *key);
+
+/** Return the handle with the smallest key without removing it.
+ * The queue must not be empty.
+ */
+size_t              sc_pqueue_top (sc_pqueue_t * pq);
+
+/** Remove the handle with the smallest key from the queue.
+ * The queue must not be empty.
+ * \return              The handle; its key is found by \ref sc_pqueue_key.
+ */
+size_t              sc_pqueue_pop (sc_pqueue_t * pq);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_CONTAINERS_H */
@@ -23,6 +23,7 @@
 
 #include <sc_io.h>
 #include <sc_puff.h>
+#include <sc_timeline.h>
 #include <libb64.h>
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
@@ -33,9 +34,99 @@
 #endif
 #endif
 
+#ifdef SC_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
 #ifndef SC_ENABLE_MPIIO
 #include <errno.h>
 #endif
+#ifdef SC_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* byte size of the buffers used by a streaming encoding */
+#define SC_IO_CODEC_CHUNK (1 << 16)
+
+struct sc_io_codec
+{
+  sc_io_encode_t      encode;   /**< The compression format. */
+  int                 started;  /**< Boolean; a stream is in progress. */
+  char               *buf;      /**< Compressed data chunk. */
+  size_t              buf_pos;  /**< Source: first unconsumed byte. */
+  size_t              buf_len;  /**< Source: bytes read from input. */
+  char               *out;      /**< Source: decompressed data chunk. */
+  size_t              out_pos;  /**< Source: first byte not passed out. */
+  size_t              out_len;  /**< Source: bytes decompressed. */
+#ifdef SC_HAVE_ZLIB
+  z_stream            zs;       /**< zlib stream state. */
+#endif
+#ifdef SC_HAVE_ZSTD
+  ZSTD_CStream       *zc;       /**< zstd compression state. */
+  ZSTD_DStream       *zd;       /**< zstd decompression state. */
+#endif
+};
+
+/* create a codec for compression or decompression, or NULL if unsupported */
+static sc_io_codec_t *
+sc_io_codec_new (sc_io_encode_t encode, int compress)
+{
+  sc_io_codec_t      *codec;
+  int                 success = 0;
+
+  codec = SC_ALLOC_ZERO (sc_io_codec_t, 1);
+  codec->encode = encode;
+#ifdef SC_HAVE_ZLIB
+  if (encode == SC_IO_ENCODE_ZLIB) {
+    success = (compress ? deflateInit (&codec->zs, Z_DEFAULT_COMPRESSION) :
+               inflateInit (&codec->zs)) == Z_OK;
+  }
+#endif
+#ifdef SC_HAVE_ZSTD
+  if (encode == SC_IO_ENCODE_ZSTD) {
+    if (compress) {
+      success = (codec->zc = ZSTD_createCStream ()) != NULL;
+    }
+    else {
+      success = (codec->zd = ZSTD_createDStream ()) != NULL;
+    }
+  }
+#endif
+  if (!success) {
+    SC_FREE (codec);
+    return NULL;
+  }
+  codec->buf = SC_ALLOC (char, SC_IO_CODEC_CHUNK);
+  if (!compress) {
+    codec->out = SC_ALLOC (char, SC_IO_CODEC_CHUNK);
+  }
+  return codec;
+}
+
+static void
+sc_io_codec_destroy (sc_io_codec_t * codec, int compress)
+{
+#ifdef SC_HAVE_ZLIB
+  if (codec->encode == SC_IO_ENCODE_ZLIB) {
+    (void) (compress ? deflateEnd (&codec->zs) : inflateEnd (&codec->zs));
+  }
+#endif
+#ifdef SC_HAVE_ZSTD
+  if (codec->encode == SC_IO_ENCODE_ZSTD) {
+    (void) (compress ? ZSTD_freeCStream (codec->zc) :
+            ZSTD_freeDStream (codec->zd));
+  }
+#endif
+  SC_FREE (codec->buf);
+  SC_FREE (codec->out);
+  SC_FREE (codec);
+}
 
 sc_io_sink_t       *
 sc_io_sink_new (int iotype, int iomode, int ioencode, ...)
@@ -87,6 +178,16 @@ sc_io_sink_new (int iotype, int iomode, int ioencode, ...)
   }
   va_end (ap);
 
+  /* a compressing encoding may not be available */
+  if (sink->encode != SC_IO_ENCODE_NONE &&
+      (sink->codec = sc_io_codec_new (sink->encode, 1)) == NULL) {
+    if (iotype == SC_IO_TYPE_FILENAME) {
+      (void) fclose (sink->file);
+    }
+    SC_FREE (sink);
+    return NULL;
+  }
+
   /* this sink can now be called for writing */
   return sink;
 }
@@ -104,6 +205,9 @@ sc_io_sink_destroy (sc_io_sink_t * sink)
     /* Attempt close even on complete error */
     retval = fclose (sink->file) || retval;
   }
+  if (sink->codec != NULL) {
+    sc_io_codec_destroy (sink->codec, 1);
+  }
   SC_FREE (sink);
 
   return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
@@ -128,15 +232,13 @@ sc_io_sink_destroy_null (sc_io_sink_t ** sink)
   return retval;
 }
 
-int
-sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
+/* write to the underlying buffer or file without encoding */
+static int
+sc_io_sink_write_raw (sc_io_sink_t * sink, const void *data,
+                      size_t bytes_avail)
 {
   size_t              bytes_out;
 
-  /* basic output preconditions */
-  SC_ASSERT (sink != NULL);
-  SC_ASSERT (data != NULL || bytes_avail == 0);
-
   /* do nothing if there is no data requested */
   if (bytes_avail == 0) {
     return SC_IO_ERROR_NONE;
@@ -177,8 +279,100 @@ sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
   }
 
   /* update internal state and return on successful operation */
-  sink->bytes_in += bytes_avail;
   sink->bytes_out += bytes_out;
+  return SC_IO_ERROR_NONE;
+}
+
+/* compress data and write the output whenever it becomes available */
+static int
+sc_io_sink_encode (sc_io_sink_t * sink, const void *data,
+                   size_t bytes_avail, int finish)
+{
+  sc_io_codec_t      *codec = sink->codec;
+  int                 done = 0;
+
+  SC_ASSERT (codec != NULL);
+#ifdef SC_HAVE_ZLIB
+  if (codec->encode == SC_IO_ENCODE_ZLIB) {
+    int                 zrv;
+    size_t              bytes_done;
+
+    while (!done) {
+      /* zlib counts bytes in a possibly narrower type */
+      bytes_done = SC_MIN (bytes_avail, (size_t) (1U << 30));
+      codec->zs.next_in = (Bytef *) data;
+      codec->zs.avail_in = (uInt) bytes_done;
+      do {
+        codec->zs.next_out = (Bytef *) codec->buf;
+        codec->zs.avail_out = SC_IO_CODEC_CHUNK;
+        zrv = deflate (&codec->zs, finish && bytes_done == bytes_avail ?
+                       Z_FINISH : Z_NO_FLUSH);
+        if (zrv == Z_STREAM_ERROR ||
+            sc_io_sink_write_raw (sink, codec->buf, SC_IO_CODEC_CHUNK -
+                                  codec->zs.avail_out)) {
+          return SC_IO_ERROR_FATAL;
+        }
+      }
+      while (codec->zs.avail_out == 0);
+      SC_ASSERT (codec->zs.avail_in == 0);
+      data = (const char *) data + bytes_done;
+      bytes_avail -= bytes_done;
+      done = bytes_avail == 0 && (!finish || zrv == Z_STREAM_END);
+    }
+    if (finish && deflateReset (&codec->zs) != Z_OK) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+#endif
+#ifdef SC_HAVE_ZSTD
+  if (codec->encode == SC_IO_ENCODE_ZSTD) {
+    size_t              zrv;
+    ZSTD_inBuffer       in;
+    ZSTD_outBuffer      out;
+
+    in.src = data;
+    in.size = bytes_avail;
+    in.pos = 0;
+    while (!done) {
+      out.dst = codec->buf;
+      out.size = SC_IO_CODEC_CHUNK;
+      out.pos = 0;
+      zrv = ZSTD_compressStream2 (codec->zc, &out, &in, finish ?
+                                  ZSTD_e_end : ZSTD_e_continue);
+      if (ZSTD_isError (zrv) ||
+          sc_io_sink_write_raw (sink, codec->buf, out.pos)) {
+        return SC_IO_ERROR_FATAL;
+      }
+      done = finish ? zrv == 0 : in.pos == in.size;
+    }
+  }
+#endif
+  SC_ASSERT (done);
+  codec->started = !finish;
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
+{
+  int                 retval;
+
+  /* basic output preconditions */
+  SC_ASSERT (sink != NULL);
+  SC_ASSERT (data != NULL || bytes_avail == 0);
+
+  /* do nothing if there is no data requested */
+  if (bytes_avail == 0) {
+    return SC_IO_ERROR_NONE;
+  }
+
+  /* the output counter is updated by the raw write */
+  retval = sink->codec == NULL ? sc_io_sink_write_raw (sink, data, bytes_avail)
+    : sc_io_sink_encode (sink, data, bytes_avail, 0);
+  if (retval) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sink->bytes_in += bytes_avail;
 
   /* success! */
   return SC_IO_ERROR_NONE;
@@ -189,6 +383,12 @@ sc_io_sink_complete (sc_io_sink_t * sink, size_t *bytes_in, size_t *bytes_out)
 {
   int                 retval;
 
+  /* end the compressed stream if one has been begun */
+  if (sink->codec != NULL && sink->codec->started &&
+      sc_io_sink_encode (sink, NULL, 0, 1)) {
+    return SC_IO_ERROR_FATAL;
+  }
+
   retval = 0;
   if (sink->iotype == SC_IO_TYPE_BUFFER) {
     SC_ASSERT (sink->buffer != NULL);
@@ -270,11 +470,34 @@ sc_io_source_new (int iotype, int ioencode, ...)
       return NULL;
     }
   }
+  else if (iotype == SC_IO_TYPE_MMAP) {
+    const char         *filename = va_arg (ap, const char *);
+
+    /* map a file on disk by name and read it like a buffer */
+    source->buffer = sc_io_file_map (filename);
+    if (source->buffer == NULL) {
+      SC_FREE (source);
+      return NULL;
+    }
+  }
   else {
     SC_ABORT_NOT_REACHED ();
   }
   va_end (ap);
 
+  /* a compressing encoding may not be available */
+  if (source->encode != SC_IO_ENCODE_NONE &&
+      (source->codec = sc_io_codec_new (source->encode, 0)) == NULL) {
+    if (iotype == SC_IO_TYPE_FILENAME) {
+      (void) fclose (source->file);
+    }
+    else if (iotype == SC_IO_TYPE_MMAP) {
+      (void) sc_io_file_unmap (source->buffer);
+    }
+    SC_FREE (source);
+    return NULL;
+  }
+
   /* this source can now be called for reading */
   return source;
 }
@@ -300,6 +523,12 @@ sc_io_source_destroy (sc_io_source_t * source)
     /* Attempt close even on complete error */
     retval = fclose (source->file) || retval;
   }
+  else if (source->iotype == SC_IO_TYPE_MMAP) {
+    retval = sc_io_file_unmap (source->buffer) || retval;
+  }
+  if (source->codec != NULL) {
+    sc_io_codec_destroy (source->codec, 0);
+  }
   SC_FREE (source);
 
   return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
@@ -324,30 +553,21 @@ sc_io_source_destroy_null (sc_io_source_t ** source)
   return retval;
 }
 
-int
-sc_io_source_read (sc_io_source_t * source, void *data,
-                   size_t bytes_avail, size_t *bytes_out)
+/* read from the underlying buffer or file without decoding */
+static int
+sc_io_source_read_raw (sc_io_source_t * source, void *data,
+                       size_t bytes_avail, size_t *bytes_out)
 {
   int                 retval;
   size_t              bbytes_out;
 
-  /* basic input preconditions.  It is legal if data is NULL */
-  SC_ASSERT (source != NULL);
-
-  /* do nothing also if the end of the file has been reached */
-  if (bytes_avail == 0 || source->is_eof) {
-    if (bytes_out != NULL) {
-      *bytes_out = 0;
-    }
-    return SC_IO_ERROR_NONE;
-  }
-
   /* do a regular read */
   retval = 0;
   bbytes_out = 0;
 
   /* switch on the type of source */
-  if (source->iotype == SC_IO_TYPE_BUFFER) {
+  if (source->iotype == SC_IO_TYPE_BUFFER ||
+      source->iotype == SC_IO_TYPE_MMAP) {
     SC_ASSERT (source->buffer != NULL);
 
     /* access available elements by their byte count */
@@ -391,9 +611,6 @@ sc_io_source_read (sc_io_source_t * source, void *data,
         retval = !(source->is_eof = feof (source->file)) ||
                  ferror (source->file);
       }
-      if (retval == SC_IO_ERROR_NONE && source->mirror != NULL) {
-        retval = sc_io_sink_write (source->mirror, data, bbytes_out);
-      }
     }
     else {
       /* seek now and check for potential end of file next time */
@@ -402,6 +619,146 @@ sc_io_source_read (sc_io_source_t * source, void *data,
     }
   }
 
+  *bytes_out = bbytes_out;
+  source->bytes_in += bbytes_out;
+  return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+/* decompress the next chunk of output; leave it empty only at the end */
+static int
+sc_io_source_decode (sc_io_source_t * source)
+{
+  sc_io_codec_t      *codec = source->codec;
+  size_t              bytes_in;
+
+  SC_ASSERT (codec != NULL);
+  SC_ASSERT (codec->out_pos == codec->out_len);
+
+  codec->out_pos = codec->out_len = 0;
+  while (codec->out_len == 0) {
+    /* read ahead a chunk of compressed input */
+    if (codec->buf_pos == codec->buf_len) {
+      codec->buf_pos = codec->buf_len = 0;
+      if (source->is_eof) {
+        bytes_in = 0;
+      }
+      else if (sc_io_source_read_raw (source, codec->buf,
+                                      SC_IO_CODEC_CHUNK, &bytes_in)) {
+        return SC_IO_ERROR_FATAL;
+      }
+      if (bytes_in == 0) {
+        /* a truncated stream is an error */
+        source->is_eof = 1;
+        return codec->started ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+      }
+      codec->buf_len = bytes_in;
+    }
+#ifdef SC_HAVE_ZLIB
+    if (codec->encode == SC_IO_ENCODE_ZLIB) {
+      int                 zrv;
+
+      /* begin the next of several concatenated streams */
+      if (!codec->started && inflateReset (&codec->zs) != Z_OK) {
+        return SC_IO_ERROR_FATAL;
+      }
+      codec->started = 1;
+      codec->zs.next_in = (Bytef *) codec->buf + codec->buf_pos;
+      codec->zs.avail_in = (uInt) (codec->buf_len - codec->buf_pos);
+      codec->zs.next_out = (Bytef *) codec->out;
+      codec->zs.avail_out = SC_IO_CODEC_CHUNK;
+      zrv = inflate (&codec->zs, Z_NO_FLUSH);
+      if (zrv == Z_STREAM_END) {
+        codec->started = 0;
+      }
+      else if (zrv != Z_OK) {
+        return SC_IO_ERROR_FATAL;
+      }
+      codec->buf_pos = codec->buf_len - codec->zs.avail_in;
+      codec->out_len = SC_IO_CODEC_CHUNK - codec->zs.avail_out;
+    }
+#endif
+#ifdef SC_HAVE_ZSTD
+    if (codec->encode == SC_IO_ENCODE_ZSTD) {
+      size_t              zrv;
+      ZSTD_inBuffer       in;
+      ZSTD_outBuffer      out;
+
+      /* the decompressor continues with concatenated frames by itself */
+      in.src = codec->buf;
+      in.size = codec->buf_len;
+      in.pos = codec->buf_pos;
+      out.dst = codec->out;
+      out.size = SC_IO_CODEC_CHUNK;
+      out.pos = 0;
+      zrv = ZSTD_decompressStream (codec->zd, &out, &in);
+      if (ZSTD_isError (zrv)) {
+        return SC_IO_ERROR_FATAL;
+      }
+      codec->started = zrv != 0;
+      codec->buf_pos = in.pos;
+      codec->out_len = out.pos;
+    }
+#endif
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+/* pass out decompressed data, decoding more whenever it is used up */
+static int
+sc_io_source_read_decode (sc_io_source_t * source, void *data,
+                          size_t bytes_avail, size_t *bytes_out)
+{
+  sc_io_codec_t      *codec = source->codec;
+  size_t              bbytes_out, n;
+
+  bbytes_out = 0;
+  while (bbytes_out < bytes_avail) {
+    if (codec->out_pos == codec->out_len) {
+      if (sc_io_source_decode (source)) {
+        return SC_IO_ERROR_FATAL;
+      }
+      if (codec->out_len == 0) {
+        break;
+      }
+    }
+    n = SC_MIN (bytes_avail - bbytes_out, codec->out_len - codec->out_pos);
+    if (data != NULL) {
+      memcpy ((char *) data + bbytes_out, codec->out + codec->out_pos, n);
+    }
+    codec->out_pos += n;
+    bbytes_out += n;
+  }
+  *bytes_out = bbytes_out;
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_read (sc_io_source_t * source, void *data,
+                   size_t bytes_avail, size_t *bytes_out)
+{
+  int                 retval;
+  size_t              bbytes_out;
+
+  /* basic input preconditions.  It is legal if data is NULL */
+  SC_ASSERT (source != NULL);
+
+  /* do nothing also if the end of the file has been reached;
+     a decompressor may still hold data that has been read ahead */
+  if (bytes_avail == 0 || (source->is_eof && source->codec == NULL)) {
+    if (bytes_out != NULL) {
+      *bytes_out = 0;
+    }
+    return SC_IO_ERROR_NONE;
+  }
+
+  /* read directly or through the decompressor */
+  retval = source->codec == NULL ?
+    sc_io_source_read_raw (source, data, bytes_avail, &bbytes_out) :
+    sc_io_source_read_decode (source, data, bytes_avail, &bbytes_out);
+  if (retval == SC_IO_ERROR_NONE && data != NULL && source->mirror != NULL) {
+    retval = sc_io_sink_write (source->mirror, data, bbytes_out);
+  }
+
   /* process error conditions */
   if (retval) {
     return SC_IO_ERROR_FATAL;
@@ -414,7 +771,6 @@ sc_io_source_read (sc_io_source_t * source, void *data,
   if (bytes_out != NULL) {
     *bytes_out = bbytes_out;
   }
-  source->bytes_in += bbytes_out;
   source->bytes_out += bbytes_out;
 
   /* success! */
@@ -427,7 +783,20 @@ sc_io_source_complete (sc_io_source_t * source,
 {
   int                 retval = SC_IO_ERROR_NONE;
 
-  if (source->iotype == SC_IO_TYPE_BUFFER) {
+  /* decompressed data may be pending behind a trailer or read-ahead input */
+  if (source->codec != NULL) {
+    if (source->codec->out_pos == source->codec->out_len &&
+        (source->codec->started ||
+         source->codec->buf_pos < source->codec->buf_len) &&
+        sc_io_source_decode (source)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    if (source->codec->out_pos < source->codec->out_len) {
+      return SC_IO_ERROR_AGAIN;
+    }
+  }
+  if (source->iotype == SC_IO_TYPE_BUFFER ||
+      source->iotype == SC_IO_TYPE_MMAP) {
     SC_ASSERT (source->buffer != NULL);
     if (source->buffer_bytes % source->buffer->elem_size != 0) {
       return SC_IO_ERROR_AGAIN;
@@ -464,7 +833,9 @@ sc_io_source_align (sc_io_source_t * source, size_t bytes_align)
 int
 sc_io_source_activate_mirror (sc_io_source_t * source)
 {
-  if (source->iotype == SC_IO_TYPE_BUFFER) {
+  /* the data of a buffer or mapping is in memory already */
+  if (source->iotype == SC_IO_TYPE_BUFFER ||
+      source->iotype == SC_IO_TYPE_MMAP) {
     return SC_IO_ERROR_FATAL;
   }
   if (source->mirror != NULL) {
@@ -570,6 +941,28 @@ sc_io_file_load (const char *filename, sc_array_t * buffer)
   SC_ASSERT (buffer->elem_size == 1);
   SC_ASSERT (SC_ARRAY_IS_OWNER (buffer));
 
+#ifdef SC_HAVE_MMAP
+  {
+    struct stat         st;
+    sc_array_t         *map;
+
+    /* copy a regular file of known size in one go */
+    if (!stat (filename, &st) && S_ISREG (st.st_mode) && st.st_size > 0) {
+      if ((map = sc_io_file_map (filename)) == NULL) {
+        SC_LERRORF ("sc_io_file_load: error mapping %s\n", filename);
+        return -1;
+      }
+      sc_array_resize (buffer, map->elem_count);
+      memcpy (buffer->array, map->array, map->elem_count);
+      if (sc_io_file_unmap (map)) {
+        SC_LERRORF ("sc_io_file_load: error unmapping %s\n", filename);
+        return -1;
+      }
+      return 0;
+    }
+  }
+#endif
+
   /* open a file to read from */
   if ((source = sc_io_source_new
        (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE, filename)) == NULL) {
@@ -612,6 +1005,73 @@ sc_io_file_load (const char *filename, sc_array_t * buffer)
   return file_return (0, sink, source);
 }
 
+sc_array_t         *
+sc_io_file_map (const char *filename)
+{
+#ifdef SC_HAVE_MMAP
+  int                 fd;
+  void               *addr;
+  struct stat         st;
+
+  SC_ASSERT (filename != NULL);
+
+  if ((fd = open (filename, O_RDONLY)) < 0) {
+    return NULL;
+  }
+  if (fstat (fd, &st) || !S_ISREG (st.st_mode) ||
+      (off_t) (size_t) st.st_size != st.st_size) {
+    (void) close (fd);
+    return NULL;
+  }
+
+  /* a mapping of zero length is invalid */
+  addr = NULL;
+  if (st.st_size > 0) {
+    addr = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      (void) close (fd);
+      return NULL;
+    }
+  }
+
+  /* the mapping stays valid after closing the descriptor */
+  if (close (fd)) {
+    if (addr != NULL) {
+      (void) munmap (addr, (size_t) st.st_size);
+    }
+    return NULL;
+  }
+  return sc_array_new_data (addr, 1, (size_t) st.st_size);
+#else
+  sc_array_t         *map;
+
+  /* without memory mapping we load a copy */
+  map = sc_array_new (1);
+  if (sc_io_file_load (filename, map)) {
+    sc_array_destroy (map);
+    return NULL;
+  }
+  return map;
+#endif
+}
+
+int
+sc_io_file_unmap (sc_array_t * map)
+{
+  int                 retval = 0;
+
+  SC_ASSERT (map != NULL);
+  SC_ASSERT (map->elem_size == 1);
+
+#ifdef SC_HAVE_MMAP
+  if (!SC_ARRAY_IS_OWNER (map) && map->elem_count > 0) {
+    retval = munmap (map->array, map->elem_count);
+  }
+#endif
+  sc_array_destroy (map);
+  return retval ? -1 : 0;
+}
+
 /* byte count for one line of data must be a multiple of 3 */
 #define SC_IO_DBC 57
 #if SC_IO_DBC % 3 != 0
@@ -861,9 +1321,241 @@ sc_io_nonuncompress (char *dest, size_t dest_size,
   return 0;
 }
 
-#endif /* !SC_HAVE_ZLIB */
+#endif /* !SC_HAVE_ZLIB */
+
+#define SC_IO_ENCODE_INFO_LEN 9
+
+/* default uncompressed byte size of one block of the chunked format */
+#define SC_IO_CHUNK_BYTES ((size_t) 1 << 20)
+
+/* header of the chunked format: info, block size, and block count */
+#define SC_IO_CHUNK_INFO_LEN (SC_IO_ENCODE_INFO_LEN + 8)
+
+/* context shared by the threads of an encode or decode operation */
+typedef struct sc_io_work
+{
+  const char         *in;       /**< Input data. */
+  size_t              in_size;  /**< Byte size of input data. */
+  char               *out;      /**< Output data. */
+  size_t              num_lines;        /**< Lines of base 64 code. */
+  size_t              last_out; /**< Bytes decoded from the final line. */
+  int                 line_break_character;     /**< First line break. */
+  int                 level;    /**< zlib compression level. */
+  size_t              block_size;       /**< Bytes per uncompressed block. */
+  char              **blocks;   /**< Encode: compressed blocks. */
+  size_t             *lengths;  /**< Byte sizes of compressed blocks. */
+  size_t             *offsets;  /**< Decode: positions of the blocks. */
+}
+sc_io_work_t;
+
+/* a range of lines or blocks processed by one thread */
+typedef struct sc_io_task
+{
+  size_t              first, last;      /**< Range of items to process. */
+  int                 error;    /**< Set to nonzero on error. */
+  sc_io_work_t       *work;     /**< Context shared by all tasks. */
+}
+sc_io_task_t;
+
+/* split count items evenly between threads and process them */
+static int
+sc_io_run (sc_io_work_t * work, size_t count, int num_threads,
+           void *(*func) (void *))
+{
+  int                 t, error;
+  sc_io_task_t       *tasks;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t          *threads;
+#else
+  num_threads = 1;
+#endif
+
+  num_threads = (int) SC_MAX (1, SC_MIN ((size_t) num_threads, count));
+  tasks = SC_ALLOC (sc_io_task_t, num_threads);
+  for (t = 0; t < num_threads; ++t) {
+    tasks[t].first = (count * t) / num_threads;
+    tasks[t].last = (count * (t + 1)) / num_threads;
+    tasks[t].error = 0;
+    tasks[t].work = work;
+  }
+#ifdef SC_ENABLE_PTHREAD
+  if (num_threads > 1) {
+    threads = SC_ALLOC (pthread_t, num_threads - 1);
+    for (t = 1; t < num_threads; ++t) {
+      pth = pthread_create (&threads[t - 1], NULL, func, &tasks[t]);
+      SC_CHECK_ABORT (pth == 0, "sc_io thread create");
+    }
+    func (&tasks[0]);
+    for (t = 1; t < num_threads; ++t) {
+      pth = pthread_join (threads[t - 1], NULL);
+      SC_CHECK_ABORT (pth == 0, "sc_io thread join");
+    }
+    SC_FREE (threads);
+  }
+  else
+#endif
+  {
+    func (&tasks[0]);
+  }
+  error = 0;
+  for (t = 0; t < num_threads; ++t) {
+    error = error || tasks[t].error;
+  }
+  SC_FREE (tasks);
+  return error;
+}
+
+/* base 64 encode lines; each starts with a fresh state at 57 bytes each */
+static void        *
+sc_io_base64_encode_run (void *v)
+{
+  sc_io_task_t       *task = (sc_io_task_t *) v;
+  sc_io_work_t       *work = task->work;
+  size_t              zlin, lein, lout;
+  char               *opos;
+  base64_encodestate  bstate;
+
+  for (zlin = task->first; zlin < task->last; ++zlin) {
+    lein = SC_MIN (work->in_size - zlin * SC_IO_DBC, SC_IO_DBC);
+    opos = work->out + zlin * SC_IO_LBE;
+    SC_ASSERT (lein > 0);
+    base64_init_encodestate (&bstate);
+    lout = base64_encode_block (work->in + zlin * SC_IO_DBC, lein,
+                                opos, &bstate);
+    if (zlin < work->num_lines - 1) {
+      /* not the final line */
+      SC_ASSERT (lein == SC_IO_DBC);
+      SC_ASSERT (lout == SC_IO_LBC);
+      opos[SC_IO_LBC] = (char) work->line_break_character;
+      opos[SC_IO_LBD] = '\n';
+    }
+    else {
+      /* the final line */
+      SC_ASSERT (lout <= SC_IO_LBC);
+      lout += base64_encode_blockend (opos + lout, &bstate);
+      SC_ASSERT (lout <= SC_IO_LBC);
+      opos[lout] = (char) work->line_break_character;
+      opos[lout + 1] = '\n';
+      opos[lout + 2] = '\0';
+    }
+  }
+  return NULL;
+}
+
+/* base 64 encode binary data into lines with two line break characters */
+static void
+sc_io_base64_encode (const char *in, size_t in_size, sc_array_t *out,
+                     int line_break_character, int num_threads)
+{
+  size_t              encoded_size;
+  sc_io_work_t        work;
+
+  SC_ASSERT (in_size > 0);
+  SC_ASSERT (out->elem_size == 1);
+
+  memset (&work, 0, sizeof (sc_io_work_t));
+  work.in = in;
+  work.in_size = in_size;
+  work.num_lines = (in_size + SC_IO_DBC - 1) / SC_IO_DBC;
+  work.line_break_character = line_break_character;
+  encoded_size = 4 * ((in_size + 2) / 3) + 2 * work.num_lines + 1;
+  sc_array_resize (out, encoded_size);
+  work.out = out->array;
+  (void) sc_io_run (&work, work.num_lines, num_threads,
+                    sc_io_base64_encode_run);
+  SC_ASSERT (out->array[encoded_size - 1] == '\0');
+}
+
+/* base 64 decode lines of 76 code characters and two line break bytes */
+static void        *
+sc_io_base64_decode_run (void *v)
+{
+  sc_io_task_t       *task = (sc_io_task_t *) v;
+  sc_io_work_t       *work = task->work;
+  size_t              zlin, lein, lout;
+  char                base_out[SC_IO_LBC];
+  base64_decodestate  bstate;
+
+  for (zlin = task->first; zlin < task->last; ++zlin) {
+    lein = SC_MIN (work->in_size - zlin * SC_IO_LBC, SC_IO_LBC);
+    SC_ASSERT (lein > 0);
+    base64_init_decodestate (&bstate);
+    lout = base64_decode_block (work->in + zlin * SC_IO_LBE, lein,
+                                base_out, &bstate);
+    if (lout == 0) {
+      SC_LERROR ("base 64 decode short\n");
+      task->error = 1;
+      return NULL;
+    }
+    if (zlin < work->num_lines - 1) {
+      SC_ASSERT (lein == SC_IO_LBC);
+      if (lout != SC_IO_DBC) {
+        SC_LERROR ("base 64 decode mismatch\n");
+        task->error = 1;
+        return NULL;
+      }
+    }
+    else {
+      SC_ASSERT (lout <= SC_IO_DBC);
+      work->last_out = lout;
+    }
+    memcpy (work->out + zlin * SC_IO_DBC, base_out, lout);
+  }
+  return NULL;
+}
+
+/* decode a NUL-terminated string of lines and return the decoded size */
+static int
+sc_io_base64_decode (sc_array_t *data, sc_array_t *out, size_t *ocnt,
+                     int num_threads)
+{
+  size_t              encoded_size;
+  sc_io_work_t        work;
+
+  encoded_size = data->elem_count;
+  SC_ASSERT (encoded_size > 0);
+
+  memset (&work, 0, sizeof (sc_io_work_t));
+  work.num_lines = (encoded_size - 1 + SC_IO_LBD) / SC_IO_LBE;
+  SC_ASSERT (encoded_size >= work.num_lines + 1);
+  work.in = data->array;
+  work.in_size = encoded_size - 1 - 2 * work.num_lines;
+  sc_array_init_count (out, 1, work.num_lines * SC_IO_DBC);
+  work.out = out->array;
+  if (sc_io_run (&work, work.num_lines, num_threads,
+                 sc_io_base64_decode_run)) {
+    return -1;
+  }
+  *ocnt = work.num_lines == 0 ? 0 :
+    (work.num_lines - 1) * SC_IO_DBC + work.last_out;
+  SC_ASSERT (*ocnt <= out->elem_count);
+  return 0;
+}
+
+static void
+sc_io_put_be64 (char *dest, size_t value)
+{
+  int                 i;
 
-#define SC_IO_ENCODE_INFO_LEN 9
+  for (i = 0; i < 8; ++i) {
+    /* enforce big endian byte order */
+    dest[i] = (char) ((value >> ((7 - i) * 8)) & 0xFF);
+  }
+}
+
+static size_t
+sc_io_get_be64 (const char *src)
+{
+  int                 i;
+  size_t              value = 0;
+
+  for (i = 0; i < 8; ++i) {
+    /* read big endian byte order */
+    value |= ((size_t) (unsigned char) src[i]) << ((7 - i) * 8);
+  }
+  return value;
+}
 
 void
 sc_io_encode (sc_array_t *data, sc_array_t *out)
@@ -875,7 +1567,6 @@ void
 sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
                    int zlib_compression_level, int line_break_character)
 {
-  int                 i;
   size_t              input_size;
 #ifndef SC_HAVE_ZLIB
   size_t              input_compress_bound;
@@ -883,17 +1574,7 @@ sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
   int                 zrv;
   uLong               input_compress_bound;
 #endif
-  char               *ipos, *opos;
-  char                base_out[2 * SC_IO_LBC];
-  size_t              base64_lines;
-  size_t              encoded_size;
-  size_t              zlin, irem;
-#ifdef SC_ENABLE_DEBUG
-  size_t              ocnt;
-#endif
-  unsigned char       original_size[SC_IO_ENCODE_INFO_LEN];
   sc_array_t          compressed;
-  base64_encodestate  bstate;
 
   SC_ASSERT (data != NULL);
   if (out == NULL) {
@@ -912,15 +1593,8 @@ sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
              (zlib_compression_level >= 0 && zlib_compression_level <= 9));
 #endif
 
-  /* save original size to output */
-  input_size = data->elem_count * data->elem_size;
-  for (i = 0; i < 8; ++i) {
-    /* enforce big endian byte order for original size */
-    original_size[i] = (input_size >> ((7 - i) * 8)) & 0xFF;
-  }
-  original_size[SC_IO_ENCODE_INFO_LEN - 1] = 'z';
-
   /* zlib compress input */
+  input_size = data->elem_count * data->elem_size;
 #ifndef SC_HAVE_ZLIB
   input_compress_bound = sc_io_noncompress_bound (input_size);
 #else
@@ -928,7 +1602,10 @@ sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
 #endif /* SC_HAVE_ZLIB */
   sc_array_init_count (&compressed, 1,
                        SC_IO_ENCODE_INFO_LEN + input_compress_bound);
-  memcpy (compressed.array, original_size, SC_IO_ENCODE_INFO_LEN);
+
+  /* save original size and format to output */
+  sc_io_put_be64 (compressed.array, input_size);
+  compressed.array[SC_IO_ENCODE_INFO_LEN - 1] = 'z';
 #ifndef SC_HAVE_ZLIB
   sc_io_noncompress (compressed.array + SC_IO_ENCODE_INFO_LEN,
                      input_compress_bound, data->array, input_size);
@@ -939,81 +1616,114 @@ sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
   SC_CHECK_ABORT (zrv == Z_OK, "Error on zlib compression");
 #endif /* SC_HAVE_ZLIB */
 
-  /* prepare output array */
+  /* run base64 encoder */
   if (out == NULL) {
     out = data;
   }
-  SC_ASSERT (out->elem_size == 1);
-  input_size = (size_t) (SC_IO_ENCODE_INFO_LEN + input_compress_bound);
-  base64_lines = (input_size + SC_IO_DBC - 1) / SC_IO_DBC;
-  encoded_size = 4 * ((input_size + 2) / 3) + 2 * base64_lines + 1;
-  sc_array_resize (out, encoded_size);
+  sc_io_base64_encode (compressed.array, (size_t)
+                       (SC_IO_ENCODE_INFO_LEN + input_compress_bound),
+                       out, line_break_character, 1);
 
-  /* run base64 encoder */
-  base64_init_encodestate (&bstate);
-  ipos = compressed.array;
-  irem = input_size;
-  opos = out->array;
-#ifdef SC_ENABLE_DEBUG
-  ocnt = 0;
-#endif
-  SC_ASSERT (ocnt + 1 <= encoded_size);
-  opos[0] = '\0';
-  for (zlin = 0; zlin < base64_lines; ++zlin) {
-    size_t              lein = SC_MIN (irem, SC_IO_DBC);
-    size_t              lout =
-      base64_encode_block (ipos, lein, base_out, &bstate);
+  /* free temporary memory */
+  sc_array_reset (&compressed);
+}
 
-    SC_ASSERT (lein > 0);
-    if (zlin < base64_lines - 1) {
-      /* not the final line */
-      SC_ASSERT (irem > SC_IO_DBC);
-      SC_ASSERT (lout == SC_IO_LBC);
-      SC_ASSERT (ocnt + SC_IO_LBF <= encoded_size);
-      memcpy (opos, base_out, SC_IO_LBC);
-      opos[SC_IO_LBC] = (char) line_break_character;
-      opos[SC_IO_LBD] = '\n';
-      opos[SC_IO_LBE] = '\0';
-      opos += SC_IO_LBE;
-#ifdef SC_ENABLE_DEBUG
-      ocnt += SC_IO_LBE;
-#endif
-      ipos += SC_IO_DBC;
-      irem -= SC_IO_DBC;
-    }
-    else {
-      /* the final line */
-      SC_ASSERT (irem <= SC_IO_DBC);
-      SC_ASSERT (lout <= SC_IO_LBC);
-      SC_ASSERT (ocnt + lout <= encoded_size);
-      memcpy (opos, base_out, lout);
-      opos += lout;
-#ifdef SC_ENABLE_DEBUG
-      ocnt += lout;
-#endif
-      lout = base64_encode_blockend (base_out, &bstate);
-      SC_ASSERT (lout <= 4);
-      SC_ASSERT (ocnt + lout <= encoded_size);
-      memcpy (opos, base_out, lout);
-      opos += lout;
-#ifdef SC_ENABLE_DEBUG
-      ocnt += lout;
+/* compress independent blocks of the input */
+static void        *
+sc_io_compress_run (void *v)
+{
+  sc_io_task_t       *task = (sc_io_task_t *) v;
+  sc_io_work_t       *work = task->work;
+  size_t              zb, bsize;
+  const char         *src;
+#ifndef SC_HAVE_ZLIB
+  size_t              bound;
+#else
+  int                 zrv;
+  uLong               bound;
 #endif
-      SC_ASSERT (ocnt + 3 <= encoded_size);
-      opos[0] = (char) line_break_character;
-      opos[1] = '\n';
-      opos[2] = '\0';
-      opos = NULL;
-#ifdef SC_ENABLE_DEBUG
-      ocnt += 3;
+
+  for (zb = task->first; zb < task->last; ++zb) {
+    src = work->in + zb * work->block_size;
+    bsize = SC_MIN (work->block_size, work->in_size - zb * work->block_size);
+#ifndef SC_HAVE_ZLIB
+    bound = sc_io_noncompress_bound (bsize);
+    work->blocks[zb] = SC_ALLOC (char, bound);
+    sc_io_noncompress (work->blocks[zb], bound, src, bsize);
+#else
+    bound = compressBound ((uLong) bsize);
+    work->blocks[zb] = SC_ALLOC (char, bound);
+    zrv = compress2 ((Bytef *) work->blocks[zb], &bound, (const Bytef *) src,
+                     (uLong) bsize, work->level);
+    SC_CHECK_ABORT (zrv == Z_OK, "Error on zlib compression");
 #endif
-      SC_ASSERT (ocnt == encoded_size);
-      ipos = NULL;
-      irem = 0;
-    }
+    work->lengths[zb] = (size_t) bound;
   }
+  return NULL;
+}
 
-  /* free temporary memory */
+void
+sc_io_encode_chunked (sc_array_t *data, sc_array_t *out,
+                      int zlib_compression_level, int line_break_character,
+                      size_t block_size, int num_threads)
+{
+  size_t              input_size, num_blocks, zb, pos;
+  sc_array_t          compressed;
+  sc_io_work_t        work;
+
+  SC_ASSERT (data != NULL);
+  if (out == NULL) {
+    /* in-place operation on string */
+    SC_ASSERT (SC_ARRAY_IS_OWNER (data));
+    SC_ASSERT (data->elem_size == 1);
+  }
+  else {
+    /* data is placed in output string */
+    SC_ASSERT (SC_ARRAY_IS_OWNER (out));
+    SC_ASSERT (out->elem_size == 1);
+  }
+  SC_ASSERT (-1 <= zlib_compression_level && zlib_compression_level <= 9);
+
+  /* compress the blocks independently of each other */
+  input_size = data->elem_count * data->elem_size;
+  memset (&work, 0, sizeof (sc_io_work_t));
+  work.in = data->array;
+  work.in_size = input_size;
+  work.level = zlib_compression_level;
+  work.block_size = block_size > 0 ? block_size : SC_IO_CHUNK_BYTES;
+  num_blocks = (input_size + work.block_size - 1) / work.block_size;
+  work.blocks = SC_ALLOC (char *, num_blocks);
+  work.lengths = SC_ALLOC (size_t, num_blocks);
+  (void) sc_io_run (&work, num_blocks, num_threads, sc_io_compress_run);
+
+  /* concatenate header, block sizes, and compressed blocks */
+  pos = SC_IO_CHUNK_INFO_LEN + 8 * num_blocks;
+  for (zb = 0; zb < num_blocks; ++zb) {
+    pos += work.lengths[zb];
+  }
+  sc_array_init_count (&compressed, 1, pos);
+  sc_io_put_be64 (compressed.array, input_size);
+  compressed.array[SC_IO_ENCODE_INFO_LEN - 1] = 'p';
+  sc_io_put_be64 (compressed.array + SC_IO_ENCODE_INFO_LEN, work.block_size);
+  pos = SC_IO_CHUNK_INFO_LEN;
+  for (zb = 0; zb < num_blocks; ++zb, pos += 8) {
+    sc_io_put_be64 (compressed.array + pos, work.lengths[zb]);
+  }
+  for (zb = 0; zb < num_blocks; ++zb) {
+    memcpy (compressed.array + pos, work.blocks[zb], work.lengths[zb]);
+    pos += work.lengths[zb];
+    SC_FREE (work.blocks[zb]);
+  }
+  SC_ASSERT (pos == compressed.elem_count);
+  SC_FREE (work.blocks);
+  SC_FREE (work.lengths);
+
+  /* run base64 encoder */
+  if (out == NULL) {
+    out = data;
+  }
+  sc_io_base64_encode (compressed.array, compressed.elem_count,
+                       out, line_break_character, num_threads);
   sc_array_reset (&compressed);
 }
 
@@ -1021,7 +1731,6 @@ int
 sc_io_decode_info (sc_array_t *data, size_t *original_size,
                    char *format_char, void *re)
 {
-  int                 i;
   size_t              osize;
   char                dec[12];
   base64_decodestate  bstate;
@@ -1057,14 +1766,7 @@ sc_io_decode_info (sc_array_t *data, size_t *original_size,
 
   /* decode original length of data */
   if (original_size != NULL) {
-    unsigned char       uc;
-    osize = 0;
-    for (i = 0; i < 8; ++i) {
-      /* read original byte order in big endian */
-      uc = (unsigned char) dec[i];
-      osize |= ((size_t) uc) << ((7 - i) * 8);
-    }
-    *original_size = osize;
+    *original_size = sc_io_get_be64 (dec);
   }
 
   /* return format character */
@@ -1076,26 +1778,114 @@ sc_io_decode_info (sc_array_t *data, size_t *original_size,
   return 0;
 }
 
+/* uncompress independent blocks into their place in the output */
+static void        *
+sc_io_uncompress_run (void *v)
+{
+  sc_io_task_t       *task = (sc_io_task_t *) v;
+  sc_io_work_t       *work = task->work;
+  size_t              zb, bsize;
+  char               *dest;
+#ifdef SC_HAVE_ZLIB
+  int                 zrv;
+  uLong               uncompsize;
+#endif
+
+  for (zb = task->first; zb < task->last; ++zb) {
+    dest = work->out + zb * work->block_size;
+    bsize = SC_MIN (work->block_size, work->in_size - zb * work->block_size);
+#ifndef SC_HAVE_ZLIB
+    if (sc_io_nonuncompress (dest, bsize, work->in + work->offsets[zb],
+                             work->lengths[zb], NULL)) {
+      task->error = 1;
+      return NULL;
+    }
+#else
+    uncompsize = (uLong) bsize;
+    zrv = uncompress ((Bytef *) dest, &uncompsize,
+                      (const Bytef *) work->in + work->offsets[zb],
+                      (uLong) work->lengths[zb]);
+    if (zrv != Z_OK || uncompsize != (uLong) bsize) {
+      SC_LERROR ("zlib uncompress block error\n");
+      task->error = 1;
+      return NULL;
+    }
+#endif
+  }
+  return NULL;
+}
+
+/* verify the block table of the chunked format and uncompress in parallel */
+static int
+sc_io_decode_blocks (sc_array_t *compressed, size_t ocnt, char *out,
+                     size_t original_size, int num_threads)
+{
+  int                 retval;
+  size_t              zb, num_blocks, pos;
+  sc_io_work_t        work;
+
+  memset (&work, 0, sizeof (sc_io_work_t));
+  if (ocnt < SC_IO_CHUNK_INFO_LEN ||
+      (work.block_size = sc_io_get_be64 (compressed->array +
+                                         SC_IO_ENCODE_INFO_LEN)) == 0) {
+    SC_LERROR ("chunked header corrupt\n");
+    return -1;
+  }
+  num_blocks = original_size / work.block_size +
+    (original_size % work.block_size > 0);
+  if (num_blocks > (ocnt - SC_IO_CHUNK_INFO_LEN) / 8) {
+    SC_LERROR ("chunked block table short\n");
+    return -1;
+  }
+  work.lengths = SC_ALLOC (size_t, num_blocks);
+  work.offsets = SC_ALLOC (size_t, num_blocks);
+  pos = SC_IO_CHUNK_INFO_LEN + 8 * num_blocks;
+  for (zb = 0; zb < num_blocks; ++zb) {
+    work.lengths[zb] = sc_io_get_be64 (compressed->array +
+                                       SC_IO_CHUNK_INFO_LEN + 8 * zb);
+    work.offsets[zb] = pos;
+    if (work.lengths[zb] > ocnt - pos) {
+      break;
+    }
+    pos += work.lengths[zb];
+  }
+  if (zb < num_blocks || pos != ocnt) {
+    SC_LERROR ("chunked block sizes mismatch\n");
+    retval = -1;
+  }
+  else {
+    work.in = compressed->array;
+    work.in_size = original_size;
+    work.out = out;
+    retval = sc_io_run (&work, num_blocks, num_threads,
+                        sc_io_uncompress_run) ? -1 : 0;
+  }
+  SC_FREE (work.lengths);
+  SC_FREE (work.offsets);
+  return retval;
+}
+
 int
 sc_io_decode (sc_array_t *data, sc_array_t *out,
               size_t max_original_size, void *re)
 {
-  int                 i;
+  return sc_io_decode_threads (data, out, max_original_size, 1, re);
+}
+
+int
+sc_io_decode_threads (sc_array_t *data, sc_array_t *out,
+                      size_t max_original_size, int num_threads, void *re)
+{
   int                 zrv;
   int                 retval = -1;
-  char               *ipos, *opos;
-  char                base_out[SC_IO_LBC];
-  size_t              compressed_size;
-  size_t              base64_lines;
+  char                format_char;
   size_t              encoded_size;
   size_t              current_size;
-  size_t              zlin, irem;
   size_t              ocnt;
 #ifdef SC_HAVE_ZLIB
   uLong               uncompsize;
 #endif
   sc_array_t          compressed;
-  base64_decodestate  bstate;
 
   /* in the future we will add runtime error reporting */
   SC_ASSERT (re == NULL);
@@ -1111,75 +1901,22 @@ sc_io_decode (sc_array_t *data, sc_array_t *out,
   }
 
   /* decode line by line from base 64 */
-  base64_init_decodestate (&bstate);
-  base64_lines = (encoded_size - 1 + SC_IO_LBD) / SC_IO_LBE;
-  compressed_size = base64_lines * SC_IO_DBC;
-  ipos = data->array;
-  SC_ASSERT (encoded_size >= base64_lines + 1);
-  irem = encoded_size - 1 - 2 * base64_lines;
-  sc_array_init_count (&compressed, 1, compressed_size);
-  opos = compressed.array;
-  ocnt = 0;
-  for (zlin = 0; zlin < base64_lines; ++zlin) {
-    size_t              lein = SC_MIN (irem, SC_IO_LBC);
-    size_t              lout =
-      base64_decode_block (ipos, lein, base_out, &bstate);
-
-    SC_ASSERT (lein > 0);
-    if (lout == 0) {
-      SC_LERROR ("base 64 decode short\n");
-      goto decode_error;
-    }
-#if 0
-    if (ipos[lein] != '\n') {
-      SC_LERROR ("base 64 missing newline\n");
-      goto decode_error;
-    }
-#endif
-    if (zlin < base64_lines - 1) {
-      SC_ASSERT (lein == SC_IO_LBC);
-      if (lout != SC_IO_DBC) {
-        SC_LERROR ("base 64 decode mismatch\n");
-        goto decode_error;
-      }
-      memcpy (opos, base_out, SC_IO_DBC);
-      ipos += SC_IO_LBE;
-      SC_ASSERT (irem >= SC_IO_LBC);
-      irem -= SC_IO_LBC;
-      opos += SC_IO_DBC;
-      ocnt += SC_IO_DBC;
-    }
-    else {
-      SC_ASSERT (lein <= SC_IO_LBC);
-      SC_ASSERT (lout <= SC_IO_DBC);
-      memcpy (opos, base_out, lout);
-      ipos += lein + 2;
-      SC_ASSERT (irem >= lein);
-      irem -= lein;
-      opos += lout;
-      ocnt += lout;
-    }
+  if (sc_io_base64_decode (data, &compressed, &ocnt, num_threads)) {
+    goto decode_error;
   }
-  SC_ASSERT (irem == 0);
-  SC_ASSERT (ocnt <= compressed_size);
-  SC_ASSERT (ipos + 1 == data->array + encoded_size);
   if (ocnt < SC_IO_ENCODE_INFO_LEN) {
     SC_LERRORF ("base 64 decodes to less than %d bytes\n",
                 SC_IO_ENCODE_INFO_LEN);
     goto decode_error;
   }
-  if (compressed.array[SC_IO_ENCODE_INFO_LEN - 1] != 'z') {
+  format_char = compressed.array[SC_IO_ENCODE_INFO_LEN - 1];
+  if (format_char != 'z' && format_char != 'p') {
     SC_LERROR ("encoded format character mismatch\n");
     goto decode_error;
   }
 
   /* determine length of uncompressed data */
-  encoded_size = 0;
-  for (i = 0; i < 8; ++i) {
-    /* enforce big endian byte order for original size */
-    unsigned char       uc = (unsigned char) compressed.array[i];
-    encoded_size |= ((size_t) uc) << ((7 - i) * 8);
-  }
+  encoded_size = sc_io_get_be64 (compressed.array);
   if (out == NULL) {
     /* allow for in-place operation */
     out = data;
@@ -1203,6 +1940,16 @@ sc_io_decode (sc_array_t *data, sc_array_t *out,
   }
   sc_array_resize (out, encoded_size / out->elem_size);
 
+  /* decompress independent blocks in parallel */
+  if (format_char == 'p') {
+    if (sc_io_decode_blocks (&compressed, ocnt, out->array,
+                             encoded_size, num_threads)) {
+      goto decode_error;
+    }
+    retval = 0;
+    goto decode_error;
+  }
+
   /* decompress decoded data */
 #ifndef SC_HAVE_ZLIB
   zrv = sc_io_nonuncompress (out->array, encoded_size,
@@ -1404,6 +2151,223 @@ sc_vtk_write_compressed (FILE * vtkfile, char *numeric_data,
   return 0;
 }
 
+/* VTK's own block size for compressed data */
+#define SC_IO_VTK_BLOCK ((size_t) 1 << 15)
+
+/* bytes given to the base 64 encoder at a time */
+#define SC_IO_VTK_PIECE ((size_t) 1 << 16)
+
+/* compressed blocks per thread held in memory at a time */
+#define SC_IO_VTK_BATCH 16
+
+/* base 64 encode data into the stream piece by piece */
+static void
+sc_vtk_write_base64 (FILE * vtkfile, const char *data, size_t length,
+                     char *base_data, base64_encodestate * encode_state)
+{
+  size_t              pos, writenow, base_length;
+
+  for (pos = 0; pos < length; pos += writenow) {
+    writenow = SC_MIN (length - pos, SC_IO_VTK_PIECE);
+    base_length = base64_encode_block (data + pos, writenow, base_data,
+                                       encode_state);
+    SC_ASSERT (base_length <= 2 * SC_IO_VTK_PIECE);
+    (void) fwrite (base_data, 1, base_length, vtkfile);
+  }
+}
+
+/* write data raw or as a complete base 64 stream */
+static void
+sc_vtk_write_block (FILE * vtkfile, const char *data, size_t length,
+                    sc_vtk_format_t format, char *base_data)
+{
+  size_t              base_length;
+  base64_encodestate  encode_state;
+
+  if (format == SC_VTK_FORMAT_RAW) {
+    (void) fwrite (data, 1, length, vtkfile);
+    return;
+  }
+  base64_init_encodestate (&encode_state);
+  sc_vtk_write_base64 (vtkfile, data, length, base_data, &encode_state);
+  base_length = base64_encode_blockend (base_data, &encode_state);
+  (void) fwrite (base_data, 1, base_length, vtkfile);
+}
+
+int
+sc_vtk_write_binary_uint64 (FILE * vtkfile, const char *numeric_data,
+                            size_t byte_length, sc_vtk_format_t format)
+{
+  size_t              base_length;
+  uint64_t            int_header;
+  char               *base_data;
+  base64_encodestate  encode_state;
+
+  SC_ASSERT (vtkfile != NULL);
+  SC_ASSERT (numeric_data != NULL || byte_length == 0);
+  SC_ASSERT (0 <= format && format < SC_VTK_FORMAT_LAST);
+
+  int_header = (uint64_t) byte_length;
+  if (format == SC_VTK_FORMAT_RAW) {
+    (void) fwrite (&int_header, sizeof (int_header), 1, vtkfile);
+    if (byte_length > 0) {
+      (void) fwrite (numeric_data, 1, byte_length, vtkfile);
+    }
+    return ferror (vtkfile) ? -1 : 0;
+  }
+
+  /* header and data form one base 64 stream */
+  base_data = SC_ALLOC (char, 2 * SC_IO_VTK_PIECE + 4);
+  base64_init_encodestate (&encode_state);
+  sc_vtk_write_base64 (vtkfile, (const char *) &int_header,
+                       sizeof (int_header), base_data, &encode_state);
+  sc_vtk_write_base64 (vtkfile, numeric_data, byte_length,
+                       base_data, &encode_state);
+  base_length = base64_encode_blockend (base_data, &encode_state);
+  (void) fwrite (base_data, 1, base_length, vtkfile);
+  SC_FREE (base_data);
+
+  return ferror (vtkfile) ? -1 : 0;
+}
+
+int
+sc_vtk_write_compressed_uint64 (FILE * vtkfile, const char *numeric_data,
+                                size_t byte_length, sc_vtk_format_t format,
+                                int zlib_compression_level, int num_threads)
+{
+  int                 fseek1, fseek2;
+  size_t              zb, zc, batch, lastsize, num_blocks;
+  size_t              header_entries, header_size, base_length;
+  long                header_pos, final_pos;
+  char               *base_data;
+  uint64_t           *compression_header;
+  sc_io_work_t        work;
+  base64_encodestate  encode_state;
+
+  SC_ASSERT (vtkfile != NULL);
+  SC_ASSERT (numeric_data != NULL || byte_length == 0);
+  SC_ASSERT (0 <= format && format < SC_VTK_FORMAT_LAST);
+  SC_ASSERT (-1 <= zlib_compression_level && zlib_compression_level <= 9);
+
+  /* compute block sizes */
+  lastsize = byte_length % SC_IO_VTK_BLOCK;
+  num_blocks = (byte_length + SC_IO_VTK_BLOCK - 1) / SC_IO_VTK_BLOCK;
+  header_entries = 3 + num_blocks;
+  header_size = header_entries * sizeof (uint64_t);
+  base_data = format == SC_VTK_FORMAT_RAW ? NULL :
+    SC_ALLOC (char, 2 * SC_IO_VTK_PIECE + 4);
+
+  /* write the header with zero block sizes to be filled in later */
+  compression_header = SC_ALLOC_ZERO (uint64_t, header_entries);
+  compression_header[0] = (uint64_t) num_blocks;
+  compression_header[1] = (uint64_t) SC_IO_VTK_BLOCK;
+  compression_header[2] = (uint64_t)
+    (lastsize > 0 || byte_length == 0 ? lastsize : SC_IO_VTK_BLOCK);
+  header_pos = ftell (vtkfile);
+  sc_vtk_write_block (vtkfile, (const char *) compression_header,
+                      header_size, format, base_data);
+
+  /* compress a batch of blocks in parallel, then write it in order */
+  memset (&work, 0, sizeof (sc_io_work_t));
+  work.level = zlib_compression_level;
+  work.block_size = SC_IO_VTK_BLOCK;
+  batch = SC_IO_VTK_BATCH * (size_t) SC_MAX (1, num_threads);
+  work.blocks = SC_ALLOC (char *, SC_MIN (batch, num_blocks));
+  work.lengths = SC_ALLOC (size_t, SC_MIN (batch, num_blocks));
+  base64_init_encodestate (&encode_state);
+  for (zb = 0; zb < num_blocks; zb += batch) {
+    batch = SC_MIN (batch, num_blocks - zb);
+    work.in = numeric_data + zb * SC_IO_VTK_BLOCK;
+    work.in_size = SC_MIN (byte_length - zb * SC_IO_VTK_BLOCK,
+                           batch * SC_IO_VTK_BLOCK);
+    (void) sc_io_run (&work, batch, num_threads, sc_io_compress_run);
+    for (zc = 0; zc < batch; ++zc) {
+      compression_header[3 + zb + zc] = (uint64_t) work.lengths[zc];
+      if (format == SC_VTK_FORMAT_RAW) {
+        (void) fwrite (work.blocks[zc], 1, work.lengths[zc], vtkfile);
+      }
+      else {
+        sc_vtk_write_base64 (vtkfile, work.blocks[zc], work.lengths[zc],
+                             base_data, &encode_state);
+      }
+      SC_FREE (work.blocks[zc]);
+    }
+  }
+  if (format != SC_VTK_FORMAT_RAW) {
+    base_length = base64_encode_blockend (base_data, &encode_state);
+    (void) fwrite (base_data, 1, base_length, vtkfile);
+  }
+  SC_FREE (work.blocks);
+  SC_FREE (work.lengths);
+
+  /* seek back, write header block, seek forward */
+  final_pos = ftell (vtkfile);
+  fseek1 = fseek (vtkfile, header_pos, SEEK_SET);
+  sc_vtk_write_block (vtkfile, (const char *) compression_header,
+                      header_size, format, base_data);
+  fseek2 = fseek (vtkfile, final_pos, SEEK_SET);
+
+  /* clean up and return */
+  SC_FREE (compression_header);
+  SC_FREE (base_data);
+  if (header_pos < 0 || fseek1 != 0 || fseek2 != 0 || ferror (vtkfile)) {
+    return -1;
+  }
+  return 0;
+}
+
+void
+sc_vtk_compress_uint64 (sc_array_t * out, const char *numeric_data,
+                        size_t byte_length, int zlib_compression_level,
+                        int num_threads)
+{
+  size_t              zb, pos, lastsize, num_blocks, header_size;
+  uint64_t            entry;
+  sc_io_work_t        work;
+
+  SC_ASSERT (out != NULL && out->elem_size == 1);
+  SC_ASSERT (numeric_data != NULL || byte_length == 0);
+  SC_ASSERT (-1 <= zlib_compression_level && zlib_compression_level <= 9);
+
+  lastsize = byte_length % SC_IO_VTK_BLOCK;
+  num_blocks = (byte_length + SC_IO_VTK_BLOCK - 1) / SC_IO_VTK_BLOCK;
+  header_size = (3 + num_blocks) * sizeof (uint64_t);
+
+  /* compress all blocks in parallel */
+  memset (&work, 0, sizeof (sc_io_work_t));
+  work.in = numeric_data;
+  work.in_size = byte_length;
+  work.level = zlib_compression_level;
+  work.block_size = SC_IO_VTK_BLOCK;
+  work.blocks = SC_ALLOC (char *, num_blocks);
+  work.lengths = SC_ALLOC (size_t, num_blocks);
+  (void) sc_io_run (&work, num_blocks, num_threads, sc_io_compress_run);
+
+  /* concatenate header and compressed blocks */
+  pos = header_size;
+  for (zb = 0; zb < num_blocks; ++zb) {
+    pos += work.lengths[zb];
+  }
+  sc_array_resize (out, pos);
+  entry = (uint64_t) num_blocks;
+  memcpy (out->array, &entry, sizeof (uint64_t));
+  entry = (uint64_t) SC_IO_VTK_BLOCK;
+  memcpy (out->array + 8, &entry, sizeof (uint64_t));
+  entry = (uint64_t)
+    (lastsize > 0 || byte_length == 0 ? lastsize : SC_IO_VTK_BLOCK);
+  memcpy (out->array + 16, &entry, sizeof (uint64_t));
+  pos = header_size;
+  for (zb = 0; zb < num_blocks; ++zb) {
+    entry = (uint64_t) work.lengths[zb];
+    memcpy (out->array + 8 * (3 + zb), &entry, sizeof (uint64_t));
+    memcpy (out->array + pos, work.blocks[zb], work.lengths[zb]);
+    pos += work.lengths[zb];
+    SC_FREE (work.blocks[zb]);
+  }
+  SC_FREE (work.blocks);
+  SC_FREE (work.lengths);
+}
+
 FILE               *
 sc_fopen (const char *filename, const char *mode, const char *errmsg)
 {
@@ -1787,9 +2751,10 @@ sc_io_read_at (sc_MPI_File mpifile, sc_MPI_Offset offset, void *ptr,
 #endif
 }
 
-int
-sc_io_read_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset, void *ptr,
-                   int count, sc_MPI_Datatype t, int *ocount)
+static int
+sc_io_read_at_all_body (sc_MPI_File mpifile, sc_MPI_Offset offset,
+                        void *ptr, int count, sc_MPI_Datatype t,
+                        int *ocount)
 {
 #ifdef SC_ENABLE_MPI
   int                 mpiret, errcode, retval;
@@ -1961,6 +2926,19 @@ sc_io_read_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset, void *ptr,
 #endif
 }
 
+int
+sc_io_read_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset, void *ptr,
+                   int count, sc_MPI_Datatype t, int *ocount)
+{
+  int                 retval;
+
+  SC_TIMELINE_BEGIN ("sc_io_read_at_all");
+  retval = sc_io_read_at_all_body (mpifile, offset, ptr, count, t, ocount);
+  SC_TIMELINE_END ("sc_io_read_at_all");
+
+  return retval;
+}
+
 void
 sc_io_write (sc_MPI_File mpifile, const void *ptr, size_t zcount,
              sc_MPI_Datatype t, const char *errmsg)
@@ -2072,10 +3050,10 @@ sc_io_write_at (sc_MPI_File mpifile, sc_MPI_Offset offset,
 #endif
 }
 
-int
-sc_io_write_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset,
-                    const void *ptr, int count, sc_MPI_Datatype t,
-                    int *ocount)
+static int
+sc_io_write_at_all_body (sc_MPI_File mpifile, sc_MPI_Offset offset,
+                         const void *ptr, int count, sc_MPI_Datatype t,
+                         int *ocount)
 {
 #ifdef SC_ENABLE_MPI
   int                 mpiret, errcode, retval;
@@ -2250,6 +3228,20 @@ sc_io_write_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset,
 #endif
 }
 
+int
+sc_io_write_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset,
+                    const void *ptr, int count, sc_MPI_Datatype t,
+                    int *ocount)
+{
+  int                 retval;
+
+  SC_TIMELINE_BEGIN ("sc_io_write_at_all");
+  retval = sc_io_write_at_all_body (mpifile, offset, ptr, count, t, ocount);
+  SC_TIMELINE_END ("sc_io_write_at_all");
+
+  return retval;
+}
+
 int
 sc_io_close (sc_MPI_File * mpifile)
 {
@@ -37,6 +37,9 @@
  *  - To write to the VTK binary compressed format, we provide suitable
  *    functions to base64 encode and zlib-compress as required; see
  *    \ref sc_vtk_write_binary and \ref sc_vtk_write_compressed.
+ *    Their variants \ref sc_vtk_write_binary_uint64 and \ref
+ *    sc_vtk_write_compressed_uint64 use 64-bit headers and may write raw
+ *    data for the appended section of a VTK XML file.
  *  - To support self-contained ASCII-armored compression, we provide the
  *    functions \ref sc_io_encode, \ref sc_io_decode_info and \ref
  *    sc_io_decode.
@@ -86,20 +89,30 @@ typedef enum
 }
 sc_io_mode_t;
 
-/** Enum to specify encoding for \ref sc_io_sink and \ref sc_io_source. */
+/** Enum to specify encoding for \ref sc_io_sink and \ref sc_io_source.
+ * The compressing encodings work in a streaming fashion with a small,
+ * fixed amount of memory independent of the total data size.
+ */
 typedef enum
 {
   SC_IO_ENCODE_NONE,    /**< No encoding */
+  SC_IO_ENCODE_ZLIB,    /**< zlib format (RFC 1950); requires zlib */
+  SC_IO_ENCODE_ZSTD,    /**< zstd frame format (RFC 8878); requires zstd */
   SC_IO_ENCODE_LAST     /**< Invalid entry to close list */
 }
 sc_io_encode_t;
 
+/** Opaque state of a streaming encoding. */
+typedef struct sc_io_codec sc_io_codec_t;
+
 /** The type of I/O operation \ref sc_io_sink and \ref sc_io_source. */
 typedef enum
 {
   SC_IO_TYPE_BUFFER,    /**< Write to a buffer */
   SC_IO_TYPE_FILENAME,  /**< Write to a file to be opened */
   SC_IO_TYPE_FILEFILE,  /**< Write to an already opened file */
+  SC_IO_TYPE_MMAP,      /**< Read from a file mapped into memory;
+                             not available for sinks */
   SC_IO_TYPE_LAST       /**< Invalid entry to close list */
 }
 sc_io_type_t;
@@ -118,6 +131,8 @@ typedef struct sc_io_sink
   size_t              bytes_in;        /**< input bytes count */
   size_t              bytes_out;       /**< written bytes count */
   int                 is_eof;          /**< Have we reached the end of file? */
+  sc_io_codec_t      *codec;           /**< compressor unless encoding
+                                            is \ref SC_IO_ENCODE_NONE */
 }
 sc_io_sink_t;
 
@@ -127,10 +142,12 @@ typedef struct sc_io_source
   sc_io_type_t        iotype;          /**< type of the I/O operation */
   sc_io_encode_t      encode;          /**< encoding of data */
   sc_array_t         *buffer;          /**< buffer for the iotype
-                                            \ref SC_IO_TYPE_BUFFER */
+                                            \ref SC_IO_TYPE_BUFFER, or the
+                                            mapping for \ref SC_IO_TYPE_MMAP */
   size_t              buffer_bytes;    /**< distinguish from array elements */
-  FILE               *file;            /**< file pointer for iotype unequal to
-                                            \ref SC_IO_TYPE_BUFFER */
+  FILE               *file;            /**< file pointer for the iotypes
+                                            \ref SC_IO_TYPE_FILENAME and
+                                            \ref SC_IO_TYPE_FILEFILE */
   size_t              bytes_in;        /**< input bytes count */
   size_t              bytes_out;       /**< read bytes count */
   int                 is_eof;          /**< Have we reached the end of file? */
@@ -138,6 +155,8 @@ typedef struct sc_io_source
                                             data */
   sc_array_t         *mirror_buffer;   /**< if activated, the buffer for the
                                             mirror */
+  sc_io_codec_t      *codec;           /**< decompressor unless encoding
+                                            is \ref SC_IO_ENCODE_NONE */
 }
 sc_io_source_t;
 
@@ -160,10 +179,18 @@ sc_io_open_mode_t;
  *                              FILENAME: const char * (name of file to open).
  *                              FILEFILE: FILE * (file open for writing).
  *                              These buffers are only borrowed by the sink.
+ *                              MMAP is not supported for sinks.
  * \param [in] iomode           Mode must be a value from \ref sc_io_mode_t.
  *                              For type FILEFILE, data is always appended.
  * \param [in] ioencode         Must be a value from \ref sc_io_encode_t.
+ *                              With a compressing encoding, the data
+ *                              written is compressed incrementally and
+ *                              bytes_out counts the compressed bytes.
+ *                              Each call to \ref sc_io_sink_complete ends
+ *                              one compressed stream.
  * \return                      Newly allocated sink, or NULL on error.
+ *                              This includes requesting an encoding
+ *                              whose library has not been configured.
  */
 sc_io_sink_t       *sc_io_sink_new (int iotype, int iomode,
                                     int ioencode, ...);
@@ -208,6 +235,8 @@ int                 sc_io_sink_write (sc_io_sink_t * sink,
  * been created.  In particular, the bytes counters are reset to zero.
  * The internal state of the sink is not changed otherwise.
  * It is legal to continue writing to the sink hereafter.
+ * With a compressing encoding, the compressed stream is finished first.
+ * Data written afterwards starts a new stream appended to the previous.
  * The sink actions taken depend on its type.
  * BUFFER, FILEFILE: none.
  * FILENAME: call fclose on sink->file.
@@ -235,8 +264,17 @@ int                 sc_io_sink_align (sc_io_sink_t * sink,
  *                              BUFFER: sc_array_t * (existing array).
  *                              FILENAME: const char * (name of file to open).
  *                              FILEFILE: FILE * (file open for reading).
+ *                              MMAP: const char * (name of file to map,
+ *                              see \ref sc_io_file_map).
  * \param [in] ioencode         Encoding value from \ref sc_io_encode_t.
+ *                              With a compressing encoding, the data is
+ *                              decompressed on the fly in blocks of bounded
+ *                              size and bytes_in counts compressed bytes.
+ *                              Streams appended to each other are read as
+ *                              one.  The source must not contain other data.
  * \return                      Newly allocated source, or NULL on error.
+ *                              This includes requesting an encoding
+ *                              whose library has not been configured.
  */
 sc_io_source_t     *sc_io_source_new (int iotype, int ioencode, ...);
 
@@ -311,6 +349,7 @@ int                 sc_io_source_align (sc_io_source_t * source,
                                         size_t bytes_align);
 
 /** Activate a buffer that mirrors (i.e., stores) the data that was read.
+ * With a compressing encoding, the mirror stores the decompressed data.
  * \param [in,out] source       The source object to activate mirror in.
  * \return                      0 on success, nonzero on error.
  */
@@ -353,6 +392,27 @@ int                 sc_io_file_save (const char *filename,
 int                 sc_io_file_load (const char *filename,
                                      sc_array_t * buffer);
 
+/** Map a file into memory for reading without copying it.
+ * The pages of the file are read from disk when they are first accessed.
+ * The result may be passed as input to \ref sc_io_decode with a separate
+ * output array, or to \ref sc_io_source_new as a BUFFER.
+ * Without memory mapping support on the system, the file is loaded
+ * into an array by \ref sc_io_file_load instead.
+ * \param [in] filename     Name of a regular file.  It must not be
+ *                          modified or truncated while it is mapped.
+ * \return                  On success, an array of element size 1 with the
+ *                          complete file contents that must not be written
+ *                          to, resized, or destroyed other than by
+ *                          \ref sc_io_file_unmap.  NULL on error.
+ */
+sc_array_t         *sc_io_file_map (const char *filename);
+
+/** Release a file mapping and the array that refers to it.
+ * \param [in] map          Array returned by \ref sc_io_file_map.
+ * \return                  0 on success, -1 on error.
+ */
+int                 sc_io_file_unmap (sc_array_t * map);
+
 /** Encode a block of arbitrary data with the default sc_io format.
  * The corresponding decoder function is \ref sc_io_decode.
  * This function cannot crash unless out of memory.
@@ -363,7 +423,8 @@ int                 sc_io_file_load (const char *filename,
  *
  * The encoding method and input data size can be retrieved, optionally,
  * from the encoded data by \ref sc_io_decode_info.  This function decodes
- * the method as a character, which is 'z' for \ref sc_io_encode_zlib.
+ * the method as a character, which is 'z' for \ref sc_io_encode_zlib
+ * and 'p' for \ref sc_io_encode_chunked.
  * We reserve the characters A-C, d-z indefinitely.
  *
  * \param [in,out] data     If \a out is NULL, we work in place.
@@ -427,6 +488,40 @@ void                sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
                                        int zlib_compression_level,
                                        int line_break_character);
 
+/** Encode a block of arbitrary data in independently compressed blocks.
+ * The output is a NUL-terminated string of printable characters with the
+ * same line layout as that of \ref sc_io_encode_zlib.  Both compression
+ * of the blocks and the base 64 encoding are executed by multiple threads
+ * if the library is configured with pthreads.  The output does not depend
+ * on the number of threads.
+ *
+ * We process the input data size as an 8-byte big-endian number, then
+ * the letter 'p', the block size and the byte length of every compressed
+ * block as 8-byte big-endian numbers, and the compressed blocks in order.
+ * Each block holds the block size of original data except the last one,
+ * which may be shorter, and is compressed as in \ref sc_io_encode_zlib.
+ * The result is readable by \ref sc_io_decode and \ref sc_io_decode_info.
+ *
+ * \param [in,out] data     Same as for \ref sc_io_encode_zlib.
+ * \param [in,out] out      Same as for \ref sc_io_encode_zlib.
+ * \param [in] zlib_compression_level     Compression level between 0
+ *                          (no compression) and 9 (best compression).
+ *                          The value -1 indicates some default level.
+ * \param [in] line_break_character       This character is arbitrary
+ *                          and specifies the first of two line break
+ *                          bytes.  The second byte is always '\n'.
+ * \param [in] block_size   Byte size of each uncompressed block.
+ *                          If 0, we use a default of 1 MiB.
+ * \param [in] num_threads  Maximum number of threads to use.
+ *                          Without pthreads we run serially.
+ */
+void                sc_io_encode_chunked (sc_array_t *data,
+                                          sc_array_t *out,
+                                          int zlib_compression_level,
+                                          int line_break_character,
+                                          size_t block_size,
+                                          int num_threads);
+
 /** Decode length and format of original input from encoded data.
  * We expect at least 12 bytes of the format produced by \ref sc_io_encode.
  * No matter how much data has been encoded by it, this much is available.
@@ -464,8 +559,10 @@ int                 sc_io_decode_info (sc_array_t *data,
  * 'z', and execute a zlib decompression on the remaining decoded data.
  * This function detects malformed input by erroring out.
  *
+ * If the format character is 'p', the data has been produced by
+ * \ref sc_io_encode_chunked and we decompress its blocks independently.
  * If we should add another format in the future, the format character
- * may be something else than 'z', as permitted by our specification.
+ * may be something else than 'z' or 'p', as permitted by our specification.
  * To this end, we reserve the characters A-C and d-z indefinitely.
  *
  * Any error condition is indicated by a negative return value.
@@ -514,6 +611,18 @@ int                 sc_io_decode_info (sc_array_t *data,
 int                 sc_io_decode (sc_array_t *data, sc_array_t *out,
                                   size_t max_original_size, void *re);
 
+/** Decode a block of base 64 encoded compressed data using threads.
+ * This function works exactly as \ref sc_io_decode.  It distributes the
+ * lines of base 64 code to multiple threads and, for data in the format of
+ * \ref sc_io_encode_chunked, decompresses the blocks in parallel as well.
+ * \param [in] num_threads  Maximum number of threads to use.
+ *                          Without pthreads we run serially.
+ * All other parameters and the return value are as in \ref sc_io_decode.
+ */
+int                 sc_io_decode_threads (sc_array_t *data, sc_array_t *out,
+                                          size_t max_original_size,
+                                          int num_threads, void *re);
+
 /** This function writes numeric binary data in VTK base64 encoding.
  * \param vtkfile        Stream opened for writing.
  * \param numeric_data   A pointer to a numeric data array.
@@ -533,6 +642,76 @@ int                 sc_vtk_write_compressed (FILE * vtkfile,
                                              char *numeric_data,
                                              size_t byte_length);
 
+/** Layout of the data written by \ref sc_vtk_write_binary_uint64 and
+ * \ref sc_vtk_write_compressed_uint64. */
+typedef enum
+{
+  SC_VTK_FORMAT_BINARY, /**< Base64 code for an inline DataArray
+                             with format="binary". */
+  SC_VTK_FORMAT_RAW,    /**< Unencoded bytes for a DataArray with
+                             format="appended" that refers into an
+                             <AppendedData encoding="raw"> section. */
+  SC_VTK_FORMAT_LAST    /**< Invalid entry to close list */
+}
+sc_vtk_format_t;
+
+/** Write numeric binary data in VTK format with a 64-bit header.
+ * Unlike \ref sc_vtk_write_binary, there is no limit on the data size.
+ * The VTKFile element must declare header_type="UInt64".
+ * In raw format, the caller writes the underscore that begins the appended
+ * data and obtains the offset of each array by ftell(3) on the stream.
+ * \param vtkfile        Stream opened for writing.
+ * \param numeric_data   A pointer to a numeric data array.
+ * \param byte_length    The length of the data array in bytes.
+ * \param format         Base64 code for inline or raw for appended data.
+ * \return               Returns 0 on success, -1 on file error.
+ */
+int                 sc_vtk_write_binary_uint64 (FILE * vtkfile,
+                                                const char *numeric_data,
+                                                size_t byte_length,
+                                                sc_vtk_format_t format);
+
+/** Write numeric binary data in VTK compressed format with 64-bit headers.
+ * Unlike \ref sc_vtk_write_compressed, there is no limit on the data size.
+ * The VTKFile element must declare header_type="UInt64" and
+ * compressor="vtkZLibDataCompressor".  The blocks of 32 KiB each are
+ * compressed in parallel by batches while the stream is written serially.
+ * Without zlib, the blocks are stored uncompressed in zlib format.
+ * The stream must support seeking since the header is written last.
+ * \param vtkfile        Stream opened for writing.
+ * \param numeric_data   A pointer to a numeric data array.
+ * \param byte_length    The length of the data array in bytes.
+ * \param format         Base64 code for inline or raw for appended data.
+ *                       See \ref sc_vtk_write_binary_uint64.
+ * \param zlib_compression_level  Compression level between 0 (no
+ *                       compression) and 9 (best); -1 for zlib's default.
+ * \param num_threads    Maximum number of threads to compress with.
+ *                       Without pthreads we run serially.
+ * \return               Returns 0 on success, -1 on file error.
+ */
+int                 sc_vtk_write_compressed_uint64 (FILE * vtkfile,
+                                                    const char *numeric_data,
+                                                    size_t byte_length,
+                                                    sc_vtk_format_t format,
+                                                    int
+                                                    zlib_compression_level,
+                                                    int num_threads);
+
+/** Compress numeric data into the VTK compressed layout in memory.
+ * The output equals what \ref sc_vtk_write_compressed_uint64 writes in
+ * \ref SC_VTK_FORMAT_RAW: the 64-bit header followed by the blocks.
+ * \param [in,out] out  Byte array resized to hold the output.
+ * \param numeric_data   A pointer to a numeric data array.
+ * \param byte_length    The length of the data array in bytes.
+ * \param zlib_compression_level  As in \ref sc_vtk_write_compressed_uint64.
+ * \param num_threads    Maximum number of threads to compress with.
+ */
+void                sc_vtk_compress_uint64 (sc_array_t * out,
+                                            const char *numeric_data,
+                                            size_t byte_length,
+                                            int zlib_compression_level,
+                                            int num_threads);
+
 /** Wrapper for fopen(3).
  * We provide an additional argument that contains the error message.
  */
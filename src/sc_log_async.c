@@ -0,0 +1,478 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_log_async.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#endif
+
+/** One queued message, followed in memory by its text. */
+typedef struct sc_log_async_record
+{
+  struct sc_log_async_record *next;     /**< Next record in the queue. */
+  FILE               *stream;   /**< Destination, NULL for a flush. */
+  size_t              len;      /**< Length of the text. */
+  int                 priority; /**< Log priority of the message. */
+}
+sc_log_async_record_t;
+
+int                 sc_log_async_active = 0;
+
+/* these are only accessed by the writing thread and by start and stop */
+static FILE        *sc_log_async_file = NULL;
+static size_t       sc_log_async_flush_bytes;
+static char        *sc_log_async_batch = NULL;
+static size_t       sc_log_async_batch_len;
+static size_t       sc_log_async_batch_alloc;
+static FILE        *sc_log_async_batch_stream;
+static int          sc_log_async_errors;
+
+#ifdef SC_ENABLE_PTHREAD
+
+static pthread_t    sc_log_async_thread;
+static pthread_mutex_t sc_log_async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sc_log_async_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t sc_log_async_done = PTHREAD_COND_INITIALIZER;
+static int          sc_log_async_quit;
+static int          sc_log_async_urgent;
+static long         sc_log_async_requested;
+static long         sc_log_async_completed;
+
+/* Multiple producer, single consumer queue with a stub record.  The
+ * producers only exchange the tail pointer and the consumer owns the head.
+ * Without atomic builtins the queue is protected by a mutex instead. */
+static sc_log_async_record_t sc_log_async_stub;
+static sc_log_async_record_t *sc_log_async_head;
+static sc_log_async_record_t *sc_log_async_tail;
+
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+static size_t       sc_log_async_pending;
+#define SC_LOG_ASYNC_LOAD(p) __atomic_load_n (&(p), __ATOMIC_ACQUIRE)
+#else
+static pthread_mutex_t sc_log_async_qmutex = PTHREAD_MUTEX_INITIALIZER;
+#define SC_LOG_ASYNC_LOAD(p) (p)
+#endif
+
+#endif /* SC_ENABLE_PTHREAD */
+
+/** Write and flush the buffered text. */
+static void
+sc_log_async_write (void)
+{
+  size_t              len = sc_log_async_batch_len;
+
+  if (len > 0) {
+    if (fwrite (sc_log_async_batch, 1, len, sc_log_async_batch_stream) !=
+        len || fflush (sc_log_async_batch_stream)) {
+      ++sc_log_async_errors;
+    }
+    sc_log_async_batch_len = 0;
+  }
+}
+
+/** Add the text of a record to the buffer and write it if due. */
+static void
+sc_log_async_append (const sc_log_async_record_t * rec)
+{
+  const char         *text = (const char *) (rec + 1);
+
+  if (sc_log_async_batch_stream != rec->stream ||
+      sc_log_async_batch_len + rec->len > sc_log_async_batch_alloc) {
+    sc_log_async_write ();
+    sc_log_async_batch_stream = rec->stream;
+  }
+  if (rec->len > sc_log_async_batch_alloc) {
+    /* this message does not fit into the buffer at all */
+    if (fwrite (text, 1, rec->len, rec->stream) != rec->len ||
+        fflush (rec->stream)) {
+      ++sc_log_async_errors;
+    }
+    return;
+  }
+  memcpy (sc_log_async_batch + sc_log_async_batch_len, text, rec->len);
+  sc_log_async_batch_len += rec->len;
+  if (sc_log_async_batch_len >= sc_log_async_flush_bytes ||
+      rec->priority >= SC_LP_ERROR) {
+    sc_log_async_write ();
+  }
+}
+
+/** Allocate a record with the concatenation of two strings. */
+static sc_log_async_record_t *
+sc_log_async_record_new (FILE * stream, int priority,
+                         const char *prefix, const char *msg)
+{
+  size_t              plen, mlen;
+  char               *text;
+  sc_log_async_record_t *rec;
+
+  plen = prefix != NULL ? strlen (prefix) : 0;
+  mlen = msg != NULL ? strlen (msg) : 0;
+
+  /* the system allocator keeps the memory counters and their locks out of
+     the logging path; the records are freed by the writing thread */
+  rec = (sc_log_async_record_t *) malloc (sizeof (*rec) + plen + mlen);
+  if (rec == NULL) {
+    return NULL;
+  }
+  rec->next = NULL;
+  rec->stream = stream;
+  rec->len = plen + mlen;
+  rec->priority = priority;
+  text = (char *) (rec + 1);
+  if (plen > 0) {
+    memcpy (text, prefix, plen);
+  }
+  if (mlen > 0) {
+    memcpy (text + plen, msg, mlen);
+  }
+  return rec;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+/** Append a record to the queue without locking. */
+static void
+sc_log_async_link (sc_log_async_record_t * rec)
+{
+  sc_log_async_record_t *prev;
+
+  rec->next = NULL;
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  prev = __atomic_exchange_n (&sc_log_async_tail, rec, __ATOMIC_ACQ_REL);
+  __atomic_store_n (&prev->next, rec, __ATOMIC_RELEASE);
+#else
+  prev = sc_log_async_tail;
+  sc_log_async_tail = rec;
+  prev->next = rec;
+#endif
+}
+
+static void
+sc_log_async_enqueue (sc_log_async_record_t * rec)
+{
+#ifndef SC_HAVE_ATOMIC_BUILTINS
+  pthread_mutex_lock (&sc_log_async_qmutex);
+#endif
+  sc_log_async_link (rec);
+#ifndef SC_HAVE_ATOMIC_BUILTINS
+  pthread_mutex_unlock (&sc_log_async_qmutex);
+#endif
+}
+
+/** Remove the oldest record from the queue.
+ * \return          The record or NULL if the queue is empty, or if the
+ *                  oldest record is still being linked in by its producer.
+ */
+static sc_log_async_record_t *
+sc_log_async_dequeue (void)
+{
+  sc_log_async_record_t *head, *next, *rec = NULL;
+
+#ifndef SC_HAVE_ATOMIC_BUILTINS
+  pthread_mutex_lock (&sc_log_async_qmutex);
+#endif
+  head = sc_log_async_head;
+  next = SC_LOG_ASYNC_LOAD (head->next);
+  if (head == &sc_log_async_stub) {
+    if (next == NULL) {
+      goto done;
+    }
+    sc_log_async_head = head = next;
+    next = SC_LOG_ASYNC_LOAD (head->next);
+  }
+  if (next == NULL) {
+    if (head != SC_LOG_ASYNC_LOAD (sc_log_async_tail)) {
+      goto done;
+    }
+    /* head is the last record: put the stub behind it to take it out */
+    sc_log_async_link (&sc_log_async_stub);
+    next = SC_LOG_ASYNC_LOAD (head->next);
+    if (next == NULL) {
+      goto done;
+    }
+  }
+  sc_log_async_head = next;
+  rec = head;
+
+done:
+#ifndef SC_HAVE_ATOMIC_BUILTINS
+  pthread_mutex_unlock (&sc_log_async_qmutex);
+#endif
+  return rec;
+}
+
+/** Move all queued records into the buffer.
+ * \return          The number of flush requests encountered.
+ */
+static long
+sc_log_async_drain (void)
+{
+  long                flushes = 0;
+  sc_log_async_record_t *rec;
+
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  __atomic_store_n (&sc_log_async_pending, 0, __ATOMIC_RELAXED);
+#endif
+  while ((rec = sc_log_async_dequeue ()) != NULL) {
+    if (rec->stream == NULL) {
+      sc_log_async_write ();
+      ++flushes;
+    }
+    else {
+      sc_log_async_append (rec);
+    }
+    free (rec);
+  }
+  return flushes;
+}
+
+static void        *
+sc_log_async_main (void *v)
+{
+  int                 quit, timedout = 0;
+  long                flushes;
+  struct timespec     deadline;
+
+  pthread_mutex_lock (&sc_log_async_mutex);
+  for (;;) {
+    quit = sc_log_async_quit;
+    sc_log_async_urgent = 0;
+    pthread_mutex_unlock (&sc_log_async_mutex);
+
+    flushes = sc_log_async_drain ();
+    if (timedout || quit) {
+      sc_log_async_write ();
+    }
+
+    pthread_mutex_lock (&sc_log_async_mutex);
+    if (flushes > 0) {
+      sc_log_async_completed += flushes;
+      pthread_cond_broadcast (&sc_log_async_done);
+    }
+    if (quit) {
+      break;
+    }
+    timedout = 0;
+    if (sc_log_async_requested == sc_log_async_completed &&
+        !sc_log_async_quit && !sc_log_async_urgent) {
+      clock_gettime (CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += SC_LOG_ASYNC_INTERVAL * 1000000L;
+      deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+      deadline.tv_nsec %= 1000000000L;
+      timedout = pthread_cond_timedwait (&sc_log_async_wake,
+                                         &sc_log_async_mutex,
+                                         &deadline) == ETIMEDOUT;
+    }
+  }
+  pthread_mutex_unlock (&sc_log_async_mutex);
+
+  return NULL;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+void
+sc_log_async_start (sc_MPI_Comm mpicomm, const char *filename,
+                    size_t flush_bytes)
+{
+  int                 mpiret;
+  int                 rank;
+  char                buffer[BUFSIZ];
+
+  SC_CHECK_ABORT (!sc_log_async_active, "Asynchronous log already active");
+
+  if (filename != NULL) {
+    if (mpicomm != sc_MPI_COMM_NULL) {
+      mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+      SC_CHECK_MPI (mpiret);
+      snprintf (buffer, BUFSIZ, "%s.%d.log", filename, rank);
+    }
+    else {
+      snprintf (buffer, BUFSIZ, "%s.log", filename);
+    }
+    sc_log_async_file = fopen (buffer, "wb");
+    SC_CHECK_ABORT (sc_log_async_file != NULL, "Log file open");
+  }
+
+  sc_log_async_flush_bytes = flush_bytes > 0 ? flush_bytes :
+    SC_LOG_ASYNC_FLUSH;
+  sc_log_async_batch_alloc = SC_MAX (2 * sc_log_async_flush_bytes, BUFSIZ);
+  /* like the records, the buffer stays outside of the package memory */
+  sc_log_async_batch = (char *) malloc (sc_log_async_batch_alloc);
+  SC_CHECK_ABORT (sc_log_async_batch != NULL, "Log buffer");
+  sc_log_async_batch_len = 0;
+  sc_log_async_batch_stream = NULL;
+  sc_log_async_errors = 0;
+
+#ifdef SC_ENABLE_PTHREAD
+  {
+    int                 pth;
+
+    sc_log_async_stub.next = NULL;
+    sc_log_async_head = sc_log_async_tail = &sc_log_async_stub;
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+    sc_log_async_pending = 0;
+#endif
+    sc_log_async_quit = sc_log_async_urgent = 0;
+    sc_log_async_requested = sc_log_async_completed = 0;
+    pth = pthread_create (&sc_log_async_thread, NULL,
+                          sc_log_async_main, NULL);
+    SC_CHECK_ABORT (pth == 0, "Log thread create");
+  }
+#endif
+
+  sc_log_async_active = 1;
+}
+
+void
+sc_log_async_push (FILE * stream, int redirect, int priority,
+                   const char *prefix, const char *msg)
+{
+#if defined SC_ENABLE_PTHREAD && defined SC_HAVE_ATOMIC_BUILTINS
+  size_t              len;
+#endif
+  sc_log_async_record_t *rec;
+
+  SC_ASSERT (sc_log_async_active);
+  SC_ASSERT (stream != NULL);
+
+  if (redirect && sc_log_async_file != NULL) {
+    stream = sc_log_async_file;
+  }
+  rec = sc_log_async_record_new (stream, priority, prefix, msg);
+  if (rec == NULL) {
+    /* there is no good way to report this */
+    return;
+  }
+
+#ifdef SC_ENABLE_PTHREAD
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  /* the record may be freed by the writer as soon as it is queued */
+  len = rec->len;
+#endif
+  sc_log_async_enqueue (rec);
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  {
+    size_t              pending;
+
+    /* wake the writer once per buffer worth of messages */
+    pending = __atomic_fetch_add (&sc_log_async_pending, len,
+                                  __ATOMIC_RELAXED);
+    if (pending < sc_log_async_flush_bytes &&
+        pending + len >= sc_log_async_flush_bytes) {
+      pthread_cond_signal (&sc_log_async_wake);
+    }
+  }
+#endif
+  if (priority >= SC_LP_ERROR) {
+    /* the flag keeps the writer from waiting if it misses the signal */
+    pthread_mutex_lock (&sc_log_async_mutex);
+    sc_log_async_urgent = 1;
+    pthread_cond_signal (&sc_log_async_wake);
+    pthread_mutex_unlock (&sc_log_async_mutex);
+  }
+#else
+  sc_log_async_append (rec);
+  free (rec);
+#endif
+}
+
+void
+sc_log_async_flush (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  long                ticket;
+  sc_log_async_record_t *rec;
+#endif
+
+  if (!sc_log_async_active) {
+    return;
+  }
+
+#ifdef SC_ENABLE_PTHREAD
+  if (pthread_equal (pthread_self (), sc_log_async_thread)) {
+    /* we are the writer, for example when aborting from a signal */
+    sc_log_async_drain ();
+    sc_log_async_write ();
+    return;
+  }
+
+  rec = sc_log_async_record_new (NULL, SC_LP_ALWAYS, NULL, NULL);
+  if (rec == NULL) {
+    return;
+  }
+
+  /* enqueue under the mutex such that the tickets are in queue order */
+  pthread_mutex_lock (&sc_log_async_mutex);
+  sc_log_async_enqueue (rec);
+  ticket = ++sc_log_async_requested;
+  pthread_cond_signal (&sc_log_async_wake);
+  while (sc_log_async_completed < ticket) {
+    pthread_cond_wait (&sc_log_async_done, &sc_log_async_mutex);
+  }
+  pthread_mutex_unlock (&sc_log_async_mutex);
+#else
+  sc_log_async_write ();
+#endif
+}
+
+int
+sc_log_async_stop (void)
+{
+  int                 num_errors;
+
+  if (!sc_log_async_active) {
+    return 0;
+  }
+
+  /* from now on sc_log writes synchronously */
+  sc_log_async_active = 0;
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_log_async_mutex);
+  sc_log_async_quit = 1;
+  pthread_cond_signal (&sc_log_async_wake);
+  pthread_mutex_unlock (&sc_log_async_mutex);
+  if (pthread_join (sc_log_async_thread, NULL)) {
+    ++sc_log_async_errors;
+  }
+  SC_ASSERT (sc_log_async_head == &sc_log_async_stub);
+#endif
+  sc_log_async_write ();
+
+  if (sc_log_async_file != NULL) {
+    if (fclose (sc_log_async_file)) {
+      ++sc_log_async_errors;
+    }
+    sc_log_async_file = NULL;
+  }
+  free (sc_log_async_batch);
+  sc_log_async_batch = NULL;
+
+  num_errors = sc_log_async_errors;
+  sc_log_async_errors = 0;
+  return num_errors;
+}
@@ -0,0 +1,119 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_log_async.h
+ *
+ * Write log messages from a background thread in large batches.
+ *
+ * By default, \ref sc_log calls the log handler synchronously and the
+ * builtin handler flushes the stream after every message.  With many
+ * processes and threads logging, this serializes the threads on the
+ * package lock and sends a small write to the file system per message.
+ *
+ * While the asynchronous backend is active, the builtin log handler
+ * formats each message on the calling thread and pushes it into a
+ * lock-free queue.  A background thread drains the queue into a buffer
+ * and writes it out when it holds a given number of bytes, when a message
+ * of priority \ref SC_LP_ERROR or higher arrives, or when the queue has
+ * been idle for a short interval.  Optionally, each process writes its
+ * log into a file of its own instead of the log stream.  Packages that
+ * register their own log handler keep calling it synchronously.
+ * When all processes write to one forwarded stream such as the standard
+ * output of mpirun, the launcher may split the large writes and mix the
+ * lines of different processes; per-process files avoid this.
+ *
+ * The backend is started by \ref sc_init if the environment variable
+ * SC_LOG_ASYNC is set to a nonzero number or SC_LOG_FILE names a file.
+ * SC_LOG_FLUSH sets the number of bytes that triggers a write.  It is
+ * stopped by \ref sc_finalize, and \ref sc_abort flushes it before
+ * terminating the program.
+ *
+ * Without pthread support there is no background thread, and the messages
+ * are batched and written by the logging thread itself.
+ *
+ * \ingroup sc
+ */
+
+#ifndef SC_LOG_ASYNC_H
+#define SC_LOG_ASYNC_H
+
+#include <sc.h>
+
+/** The default number of buffered bytes that triggers a write. */
+#define SC_LOG_ASYNC_FLUSH (1 << 16)
+
+/** The interval in milliseconds after which an idle backend writes out
+ * the messages it holds. */
+#define SC_LOG_ASYNC_INTERVAL 100
+
+SC_EXTERN_C_BEGIN;
+
+/** True while the asynchronous backend is running.
+ * Do not change this directly. */
+extern int          sc_log_async_active;
+
+/** Start the asynchronous backend.
+ * This function must be called while no other thread is logging.
+ * \param [in] mpicomm      Communicator to query the rank for the file
+ *                          name.  May be sc_MPI_COMM_NULL.
+ * \param [in] filename     If NULL, messages are written to the stream
+ *                          set by \ref sc_set_log_defaults or stdout.
+ *                          Otherwise the messages of this process are
+ *                          written to filename.rank.log, or filename.log
+ *                          if \a mpicomm is sc_MPI_COMM_NULL.
+ * \param [in] flush_bytes  Write the buffer when it holds at least this
+ *                          many bytes.  0 selects \ref SC_LOG_ASYNC_FLUSH.
+ */
+void                sc_log_async_start (sc_MPI_Comm mpicomm,
+                                        const char *filename,
+                                        size_t flush_bytes);
+
+/** Write all messages logged so far and wait until they are written.
+ * May be called from any thread.  Does nothing if the backend is inactive.
+ */
+void                sc_log_async_flush (void);
+
+/** Write all pending messages and stop the backend.
+ * This function must be called while no other thread is logging.
+ * \return          The number of errors encountered writing the output,
+ *                  0 on success or if the backend was not active.
+ */
+int                 sc_log_async_stop (void);
+
+/** Queue one formatted message.
+ * This function is called by \ref sc_log and should not be called directly.
+ * \param [in] stream       The stream the message is meant for.
+ * \param [in] redirect     If true and a file was given to \ref
+ *                          sc_log_async_start, write into that file.
+ * \param [in] priority     A priority of at least \ref SC_LP_ERROR causes
+ *                          the buffer to be written immediately.
+ * \param [in] prefix       Formatted message prefix.
+ * \param [in] msg          The message.
+ */
+void                sc_log_async_push (FILE * stream, int redirect,
+                                       int priority, const char *prefix,
+                                       const char *msg);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_LOG_ASYNC_H */
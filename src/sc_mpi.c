@@ -306,6 +306,43 @@ sc_MPI_Gatherv (void *p, int np, sc_MPI_Datatype tp,
   return sc_MPI_SUCCESS;
 }
 
+int
+sc_MPI_Scatter (void *p, int np, sc_MPI_Datatype tp,
+                void *q, int nq, sc_MPI_Datatype tq, int rank,
+                sc_MPI_Comm comm)
+{
+  return sc_MPI_Gather (p, np, tp, q, nq, tq, rank, comm);
+}
+
+int
+sc_MPI_Scatterv (void *p, int *sendc, int *displ, sc_MPI_Datatype tp,
+                 void *q, int nq, sc_MPI_Datatype tq, int rank,
+                 sc_MPI_Comm comm)
+{
+  size_t              lq;
+#ifdef SC_ENABLE_DEBUG
+  size_t              lp;
+  int                 np;
+
+  np = sendc[0];
+#endif
+  SC_ASSERT (rank == 0 && np >= 0 && nq >= 0);
+
+/* *INDENT-OFF* horrible indent bug */
+  lq = (size_t) nq * sc_mpi_sizeof (tq);
+#ifdef SC_ENABLE_DEBUG
+  lp = (size_t) np * sc_mpi_sizeof (tp);
+#endif
+/* *INDENT-ON* */
+
+  SC_ASSERT (lp == lq);
+  if (lq > 0) {
+    memcpy (q, (char *) p + displ[0] * sc_mpi_sizeof (tp), lq);
+  }
+
+  return sc_MPI_SUCCESS;
+}
+
 int
 sc_MPI_Allgather (void *p, int np, sc_MPI_Datatype tp,
                   void *q, int nq, sc_MPI_Datatype tq, sc_MPI_Comm comm)
@@ -328,6 +365,33 @@ sc_MPI_Alltoall (void *p, int np, sc_MPI_Datatype tp,
   return sc_MPI_Gather (p, np, tp, q, nq, tq, 0, comm);
 }
 
+int
+sc_MPI_Alltoallv (void *p, int *sendc, int *sdispl, sc_MPI_Datatype tp,
+                  void *q, int *recvc, int *rdispl,
+                  sc_MPI_Datatype tq, sc_MPI_Comm comm)
+{
+  size_t              lp;
+#ifdef SC_ENABLE_DEBUG
+  size_t              lq;
+#endif
+  SC_ASSERT (sendc[0] >= 0 && recvc[0] >= 0);
+
+/* *INDENT-OFF* horrible indent bug */
+  lp = (size_t) sendc[0] * sc_mpi_sizeof (tp);
+#ifdef SC_ENABLE_DEBUG
+  lq = (size_t) recvc[0] * sc_mpi_sizeof (tq);
+#endif
+/* *INDENT-ON* */
+
+  SC_ASSERT (lp == lq);
+  if (lp > 0) {
+    memcpy ((char *) q + rdispl[0] * sc_mpi_sizeof (tq),
+            (char *) p + sdispl[0] * sc_mpi_sizeof (tp), lp);
+  }
+
+  return sc_MPI_SUCCESS;
+}
+
 int
 sc_MPI_Reduce (void *p, void *q, int n, sc_MPI_Datatype t,
                sc_MPI_Op op, int rank, sc_MPI_Comm comm)
@@ -98,6 +98,9 @@ typedef enum
   SC_TAG_REDUCE = SC_TAG_NOTIFY_NARY + 32,  /**< Used in MPI reduce replacement. */
   SC_TAG_PSORT_LO,              /**< Internal tag to \ref sc_psort. */
   SC_TAG_PSORT_HI,              /**< Internal tag to \ref sc_psort. */
+  SC_TAG_REDUCE_LARGE,          /**< Internal tag to \ref sc_allreduce. */
+  SC_TAG_NOTIFY_NBX_ODD,        /**< Internal tag to \ref sc_notify. */
+  SC_TAG_NOTIFY_NBXV_ODD,       /**< Internal tag to \ref sc_notify. */
   SC_TAG_LAST                   /**< End marker of tag enumeration. */
 }
 sc_tag_t;
@@ -272,9 +275,12 @@ sc_MPI_IO_Errorcode_t;
 #define sc_MPI_Bcast               MPI_Bcast
 #define sc_MPI_Gather              MPI_Gather
 #define sc_MPI_Gatherv             MPI_Gatherv
+#define sc_MPI_Scatter             MPI_Scatter
+#define sc_MPI_Scatterv            MPI_Scatterv
 #define sc_MPI_Allgather           MPI_Allgather
 #define sc_MPI_Allgatherv          MPI_Allgatherv
 #define sc_MPI_Alltoall            MPI_Alltoall
+#define sc_MPI_Alltoallv           MPI_Alltoallv
 #define sc_MPI_Reduce              MPI_Reduce
 #define sc_MPI_Reduce_scatter_block MPI_Reduce_scatter_block
 #define sc_MPI_Allreduce           MPI_Allreduce
@@ -531,6 +537,15 @@ int                 sc_MPI_Gatherv (void *, int, sc_MPI_Datatype, void *,
                                     int *, int *, sc_MPI_Datatype, int,
                                     sc_MPI_Comm);
 
+/** Execute the MPI_Scatter algorithm. */
+int                 sc_MPI_Scatter (void *, int, sc_MPI_Datatype, void *,
+                                    int, sc_MPI_Datatype, int, sc_MPI_Comm);
+
+/** Execute the MPI_Scatterv algorithm. */
+int                 sc_MPI_Scatterv (void *, int *, int *, sc_MPI_Datatype,
+                                     void *, int, sc_MPI_Datatype, int,
+                                     sc_MPI_Comm);
+
 /** Execute the MPI_Allgather algorithm. */
 int                 sc_MPI_Allgather (void *, int, sc_MPI_Datatype, void *,
                                       int, sc_MPI_Datatype, sc_MPI_Comm);
@@ -544,6 +559,11 @@ int                 sc_MPI_Allgatherv (void *, int, sc_MPI_Datatype, void *,
 int                 sc_MPI_Alltoall (void *, int, sc_MPI_Datatype, void *,
                                      int, sc_MPI_Datatype, sc_MPI_Comm);
 
+/** Execute the MPI_Alltoallv algorithm. */
+int                 sc_MPI_Alltoallv (void *, int *, int *, sc_MPI_Datatype,
+                                      void *, int *, int *, sc_MPI_Datatype,
+                                      sc_MPI_Comm);
+
 /** Execute the MPI_Reduce algorithm. */
 int                 sc_MPI_Reduce (void *, void *, int, sc_MPI_Datatype,
                                    sc_MPI_Op, int, sc_MPI_Comm);
@@ -23,11 +23,15 @@
 
 #include <sc_functions.h>
 #include <sc_notify.h>
+#include <sc_private.h>
 #include <sc_ranges.h>
 #include <sc_flops.h>
+#include <sc_shmem.h>
+#include <sc_timeline.h>
 
 #define SC_NOTIFY_FUNC_SNAP(notify,snap)                   \
 do {                                                       \
+  SC_TIMELINE_BEGIN (__func__);                            \
   if (notify->stats) {                                     \
     SC_FUNC_SNAP (notify->stats, &(notify->flop), (snap)); \
   }                                                        \
@@ -38,6 +42,7 @@ do {                                                       \
   if (notify->stats) {                                     \
     SC_FUNC_SHOT (notify->stats, &(notify->flop), (snap)); \
   }                                                        \
+  SC_TIMELINE_END (__func__);                              \
 } while (0)
 
 /*== INTERFACE == */
@@ -70,6 +75,28 @@ typedef struct sc_notify_superset_s
 }
 sc_notify_superset_t;
 
+typedef struct sc_notify_hier_s
+{
+  int                 node_size;   /**< Processes per node, < 1 to detect. */
+  int                 setup;       /**< True once the communicators exist. */
+  int                 own_intranode;        /**< True if we split it. */
+  int                 own_leaders;          /**< True if we split it. */
+  sc_MPI_Comm         intranode;   /**< Processes on the same node. */
+  sc_MPI_Comm         leaders;     /**< Node leaders; NULL on other ranks. */
+  int                *node_table;  /**< Shared array of node and intranode
+                                        rank for each rank of the notify. */
+}
+sc_notify_hier_t;
+
+typedef struct sc_notify_automatic_s
+{
+  /** Controllers for the algorithms chosen so far, created on demand. */
+  sc_notify_t        *sub[SC_NOTIFY_NUM_TYPES];
+  /** True once the calibration table has been broadcast. */
+  int                 synced;
+}
+sc_notify_automatic_t;
+
 struct sc_notify_s
 {
   sc_MPI_Comm         mpicomm;
@@ -82,10 +109,36 @@ struct sc_notify_s
     sc_notify_nary_t    nary;
     sc_notify_ranges_t  ranges;
     sc_notify_superset_t superset;
+    sc_notify_hier_t    hier;
+    sc_notify_automatic_t automatic;
   }
   data;
 };
 
+struct sc_notify_request_s
+{
+  sc_notify_t        *notify;
+  sc_array_t         *receivers;
+  sc_array_t         *senders;
+  sc_array_t         *in_payload;
+  sc_array_t         *out_payload;
+  int                 sorted;
+  int                 done;     /**< True when all communication is done. */
+  int                 split;    /**< False if completed by the blocking call. */
+  sc_notify_type_t    type;     /**< Algorithm used by this request. */
+  int                 mpisize;
+  int                 msg_size; /**< NBX: payload bytes per message. */
+  int                 barr;     /**< NBX: true once the barrier is posted. */
+  sc_array_t         *recv_buf; /**< NBX: received senders and payload. */
+  int                 num_sends; /**< NBX: synchronous sends posted. */
+  int                 tag;      /**< NBX: message tag of this round. */
+  sc_MPI_Request     *sendreqs; /**< NBX: one synchronous send per receiver. */
+  sc_MPI_Request      req;      /**< NBX barrier or PEX alltoall request. */
+  int                 stride;   /**< PEX: ints per rank in the buffers. */
+  int                *sendbuf;  /**< PEX: flags and payload to send. */
+  int                *recvbuf;  /**< PEX: flags and payload received. */
+};
+
 const char         *sc_notify_type_strings[SC_NOTIFY_NUM_TYPES] = {
   SC_NOTIFY_STR_ALLGATHER,
   SC_NOTIFY_STR_BINARY,
@@ -96,8 +149,13 @@ const char         *sc_notify_type_strings[SC_NOTIFY_NUM_TYPES] = {
   SC_NOTIFY_STR_NBX,
   SC_NOTIFY_STR_RANGES,
   SC_NOTIFY_STR_SUPERSET,
+  SC_NOTIFY_STR_HIER,
+  SC_NOTIFY_STR_AUTO,
 };
 
+static void         sc_notify_hier_reset (sc_notify_t * notify);
+static void         sc_notify_automatic_reset (sc_notify_t * notify);
+
 sc_notify_t        *
 sc_notify_new (sc_MPI_Comm comm)
 {
@@ -132,6 +190,12 @@ sc_notify_destroy (sc_notify_t * notify)
   case SC_NOTIFY_RANGES:
   case SC_NOTIFY_SUPERSET:
     break;
+  case SC_NOTIFY_HIER:
+    sc_notify_hier_reset (notify);
+    break;
+  case SC_NOTIFY_AUTO:
+    sc_notify_automatic_reset (notify);
+    break;
   default:
     SC_ABORT_NOT_REACHED ();
   }
@@ -152,6 +216,8 @@ sc_notify_get_type (sc_notify_t * notify)
 
 static void         sc_notify_nary_init (sc_notify_t * notify);
 static void         sc_notify_ranges_init (sc_notify_t * notify);
+static void         sc_notify_hier_init (sc_notify_t * notify);
+static void         sc_notify_automatic_init (sc_notify_t * notify);
 
 int
 sc_notify_supports_type (sc_notify_type_t type)
@@ -171,6 +237,12 @@ sc_notify_set_type (sc_notify_t * notify, sc_notify_type_t in_type)
     in_type = sc_notify_type_default;
   }
   if (current_type != in_type) {
+    if (current_type == SC_NOTIFY_HIER) {
+      sc_notify_hier_reset (notify);
+    }
+    else if (current_type == SC_NOTIFY_AUTO) {
+      sc_notify_automatic_reset (notify);
+    }
     notify->type = in_type;
     /* initialize_data */
     switch (in_type) {
@@ -188,6 +260,12 @@ sc_notify_set_type (sc_notify_t * notify, sc_notify_type_t in_type)
     case SC_NOTIFY_NARY:
       sc_notify_nary_init (notify);
       break;
+    case SC_NOTIFY_HIER:
+      sc_notify_hier_init (notify);
+      break;
+    case SC_NOTIFY_AUTO:
+      sc_notify_automatic_init (notify);
+      break;
     default:
       SC_ABORT_NOT_REACHED ();
     }
@@ -857,10 +935,6 @@ sc_notify_init_input (sc_array_t * input, int *receivers, int num_receivers,
               payload->elem_size);
     }
   }
-
-  if (payload != NULL) {
-    sc_array_reset (payload);
-  }
 }
 
 /** Decode sender list into an array for output.
@@ -1138,7 +1212,7 @@ sc_notify_nary_get_widths (sc_notify_t * notify, int *ntop, int *nint,
   if (nint)
     *nint = notify->data.nary.nint;
   if (nbot)
-    *nint = notify->data.nary.nbot;
+    *nbot = notify->data.nary.nbot;
 }
 
 void
@@ -1540,8 +1614,12 @@ sc_notify_payload_nary (sc_array_t * receivers, sc_array_t * senders,
     senders = receivers;
   }
   SC_ASSERT (senders != NULL && senders->elem_count == 0);
-  if (in_payload && out_payload == NULL) {
-    out_payload = in_payload;
+  if (in_payload) {
+    /* a separate output payload leaves the input untouched */
+    if (out_payload == NULL) {
+      out_payload = in_payload;
+    }
+    sc_array_reset (out_payload);
   }
 
   /* the recursive algorithm works in-place */
@@ -1559,31 +1637,18 @@ sc_notify_payload_nary (sc_array_t * receivers, sc_array_t * senders,
 
 /*== SC_NOTIFY_PEX ==*/
 
-static void
-sc_notify_payload_pex (sc_array_t * receivers, sc_array_t * senders,
-                       sc_array_t * in_payload,
-                       sc_array_t * out_payload, sc_notify_t * notify)
+/** Fill the alltoall buffer with one flag and the payload per rank.
+ * \return             The stride of the buffer in ints.
+ */
+static int
+sc_notify_pex_pack (sc_array_t * receivers, sc_array_t * in_payload,
+                    int mpisize, int **buffered_receivers)
 {
   int                 i;
-  int                 found_num_senders, num_receivers;
-  int                 mpiret;
-  int                 mpisize, mpirank;
-  int                *buffered_receivers;
-  int                *all_receivers;
-  int                *ireceivers = NULL;
-  int                *isenders = NULL;
+  int                 num_receivers;
+  int                *ireceivers;
   int                 stride;
   int                 npay = 0;
-  sc_MPI_Comm         mpicomm;
-  sc_flopinfo_t       snap;
-
-  SC_NOTIFY_FUNC_SNAP (notify, &snap);
-
-  mpicomm = sc_notify_get_comm (notify);
-  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
-  SC_CHECK_MPI (mpiret);
-  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
-  SC_CHECK_MPI (mpiret);
 
   ireceivers = (int *) receivers->array;
 
@@ -1596,22 +1661,28 @@ sc_notify_payload_pex (sc_array_t * receivers, sc_array_t * senders,
   }
   stride = 1 + npay;
 
-  buffered_receivers = SC_ALLOC_ZERO (int, stride * mpisize);
+  *buffered_receivers = SC_ALLOC_ZERO (int, stride * mpisize);
   num_receivers = (int) receivers->elem_count;
   for (i = 0; i < num_receivers; i++) {
     SC_ASSERT (ireceivers[i] >= 0 && ireceivers[i] < mpisize);
-    buffered_receivers[stride * ireceivers[i] + 0] = 1;
+    (*buffered_receivers)[stride * ireceivers[i] + 0] = 1;
     if (in_payload) {
-      memcpy (&buffered_receivers[stride * ireceivers[i] + 1],
+      memcpy (&(*buffered_receivers)[stride * ireceivers[i] + 1],
               sc_array_index_int (in_payload, i), in_payload->elem_size);
     }
   }
+  return stride;
+}
 
-  all_receivers = SC_ALLOC (int, stride * mpisize);
-
-  mpiret = sc_MPI_Alltoall (buffered_receivers, stride, sc_MPI_INT,
-                            all_receivers, stride, sc_MPI_INT, mpicomm);
-  SC_CHECK_MPI (mpiret);
+/** Extract senders and payload from the result of the alltoall. */
+static void
+sc_notify_pex_unpack (sc_array_t * receivers, sc_array_t * senders,
+                      sc_array_t * in_payload, sc_array_t * out_payload,
+                      const int *all_receivers, int stride, int mpisize)
+{
+  int                 i;
+  int                 found_num_senders;
+  int                *isenders = NULL;
 
   found_num_senders = 0;
   for (i = 0; i < mpisize; i++) {
@@ -1645,6 +1716,39 @@ sc_notify_payload_pex (sc_array_t * receivers, sc_array_t * senders,
       isenders[found_num_senders++] = i;
     }
   }
+}
+
+static void
+sc_notify_payload_pex (sc_array_t * receivers, sc_array_t * senders,
+                       sc_array_t * in_payload,
+                       sc_array_t * out_payload, sc_notify_t * notify)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                *buffered_receivers;
+  int                *all_receivers;
+  int                 stride;
+  sc_MPI_Comm         mpicomm;
+  sc_flopinfo_t       snap;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+
+  mpicomm = sc_notify_get_comm (notify);
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  stride = sc_notify_pex_pack (receivers, in_payload, mpisize,
+                               &buffered_receivers);
+  all_receivers = SC_ALLOC (int, stride * mpisize);
+
+  mpiret = sc_MPI_Alltoall (buffered_receivers, stride, sc_MPI_INT,
+                            all_receivers, stride, sc_MPI_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_notify_pex_unpack (receivers, senders, in_payload, out_payload,
+                        all_receivers, stride, mpisize);
   SC_FREE (buffered_receivers);
   SC_FREE (all_receivers);
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
@@ -1877,118 +1981,209 @@ sc_notify_censusv_rsx (sc_array_t * receivers, sc_array_t * in_offsets,
 
 /*== SC_NOTIFY_NBX ==*/
 
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+
+static int          sc_notify_nbx_keyval = MPI_KEYVAL_INVALID;
+
+/** Count the NBX rounds on a communicator and return the tag for this one.
+ * A process may start the next round before another has noticed the end of
+ * the current one, but it cannot get further ahead.  Alternating the tags
+ * keeps the messages of consecutive rounds apart.
+ */
+static int
+sc_notify_nbx_tag (MPI_Comm comm, int even_tag, int odd_tag)
+{
+  int                 mpiret, flag;
+  void               *value;
+  intptr_t            round;
+
+  if (sc_notify_nbx_keyval == MPI_KEYVAL_INVALID) {
+    mpiret = MPI_Comm_create_keyval (MPI_COMM_NULL_COPY_FN,
+                                     MPI_COMM_NULL_DELETE_FN,
+                                     &sc_notify_nbx_keyval, NULL);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Comm_get_attr (comm, sc_notify_nbx_keyval, &value, &flag);
+  SC_CHECK_MPI (mpiret);
+  round = flag ? (intptr_t) value : 0;
+  mpiret = MPI_Comm_set_attr (comm, sc_notify_nbx_keyval,
+                              (void *) (round + 1));
+  SC_CHECK_MPI (mpiret);
+
+  return round % 2 ? odd_tag : even_tag;
+}
+
+/** Post the synchronous sends of the NBX algorithm. */
 static void
-sc_notify_payload_nbx (sc_array_t * receivers, sc_array_t * senders,
-                       sc_array_t * in_payload, sc_array_t * out_payload,
-                       int sorted, sc_notify_t * notify)
+sc_notify_nbx_start (sc_notify_request_t * req)
 {
-#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
   int                 num_receivers;
   int                *ireceivers, i;
-  int                 mpiret, rank, size;
+  int                 mpiret;
   char               *cpayload = NULL;
-  int                 msg_size = 0;
-  MPI_Request        *sendreqs;
   MPI_Comm            comm;
-  int                 done;
-  int                 barr;
-  sc_array_t         *recv_buf = NULL;
-  MPI_Request         barreq = MPI_REQUEST_NULL;
-  sc_flopinfo_t       snap;
-
-  SC_NOTIFY_FUNC_SNAP (notify, &snap);
-  comm = sc_notify_get_comm (notify);
-  mpiret = MPI_Comm_size (comm, &size);
-  SC_CHECK_MPI (mpiret);
-  mpiret = MPI_Comm_rank (comm, &rank);
-  SC_CHECK_MPI (mpiret);
 
-  num_receivers = (int) receivers->elem_count;
-  ireceivers = (int *) receivers->array;
-  if (in_payload) {
-    msg_size = (int) in_payload->elem_size;
-    cpayload = (char *) in_payload->array;
+  comm = sc_notify_get_comm (req->notify);
+  num_receivers = (int) req->receivers->elem_count;
+  ireceivers = (int *) req->receivers->array;
+  req->msg_size = 0;
+  if (req->in_payload) {
+    req->msg_size = (int) req->in_payload->elem_size;
+    cpayload = (char *) req->in_payload->array;
   }
 
-  sendreqs = SC_ALLOC (MPI_Request, num_receivers);
+  /* the receivers array is reused for the senders when working in place */
+  req->num_sends = num_receivers;
+  req->tag = sc_notify_nbx_tag (comm, SC_TAG_NOTIFY_NBX,
+                                SC_TAG_NOTIFY_NBX_ODD);
+  req->sendreqs = SC_ALLOC (MPI_Request, num_receivers);
 
   for (i = 0; i < num_receivers; i++) {
     int                 j = ireceivers[i];
-    char               *buf = msg_size ? &cpayload[i * msg_size] : NULL;
+    char               *buf =
+      req->msg_size ? &cpayload[i * req->msg_size] : NULL;
 
     mpiret =
-      MPI_Issend (buf, msg_size, MPI_BYTE, j, SC_TAG_NOTIFY_NBX, comm,
-                  &sendreqs[i]);
+      MPI_Issend (buf, req->msg_size, MPI_BYTE, j, req->tag, comm,
+                  &req->sendreqs[i]);
     SC_CHECK_MPI (mpiret);
   }
 
-  if (!senders) {
-    sc_array_reset (receivers);
-    senders = receivers;
+  if (!req->senders) {
+    sc_array_reset (req->receivers);
+    req->senders = req->receivers;
   }
 
-  if (sorted && msg_size) {
-    recv_buf = sc_array_new ((size_t) msg_size + sizeof (int));
+  req->recv_buf = NULL;
+  if (req->sorted && req->msg_size) {
+    req->recv_buf = sc_array_new ((size_t) req->msg_size + sizeof (int));
   }
-  else if (msg_size) {
-    if (out_payload) {
-      recv_buf = out_payload;
+  else if (req->msg_size) {
+    if (req->out_payload) {
+      req->recv_buf = req->out_payload;
     }
     else {
-      recv_buf = sc_array_new ((size_t) msg_size);
+      req->recv_buf = sc_array_new ((size_t) req->msg_size);
     }
   }
 
-  barr = 0;
-  for (done = 0; !done;) {
+  req->barr = 0;
+  req->req = MPI_REQUEST_NULL;
+  req->done = 0;
+}
+
+/** Receive all messages available and advance the termination protocol.
+ * \return             True if the algorithm has completed.
+ */
+static int
+sc_notify_nbx_progress (sc_notify_request_t * req)
+{
+  int                 mpiret;
+  int                 msg_size = req->msg_size;
+  MPI_Comm            comm;
+
+  comm = sc_notify_get_comm (req->notify);
+  while (!req->done) {
     int                 j, flag;
     MPI_Status          status;
 
-    mpiret =
-      MPI_Iprobe (MPI_ANY_SOURCE, SC_TAG_NOTIFY_NBX, comm, &flag, &status);
+    mpiret = MPI_Iprobe (MPI_ANY_SOURCE, req->tag, comm, &flag, &status);
     SC_CHECK_MPI (mpiret);
     if (flag) {
       int                *r;
       char               *rc = NULL;
       j = status.MPI_SOURCE;
 
-      if (sorted && msg_size) {
-        r = (int *) sc_array_push (recv_buf);
+      if (req->sorted && msg_size) {
+        r = (int *) sc_array_push (req->recv_buf);
       }
       else {
-        r = (int *) sc_array_push (senders);
+        r = (int *) sc_array_push (req->senders);
       }
       r[0] = j;
       if (msg_size) {
-        rc = sorted ? (char *) &r[1] : (char *) sc_array_push (recv_buf);
+        rc = req->sorted ? (char *) &r[1] :
+          (char *) sc_array_push (req->recv_buf);
       }
 
       mpiret =
-        MPI_Recv (rc, msg_size, MPI_BYTE, j, SC_TAG_NOTIFY_NBX, comm,
+        MPI_Recv (rc, msg_size, MPI_BYTE, j, req->tag, comm,
                   MPI_STATUS_IGNORE);
       SC_CHECK_MPI (mpiret);
     }
-    if (!barr) {
+    if (!req->barr) {
       int                 sent;
 
       mpiret =
-        sc_MPI_Testall (num_receivers, sendreqs, &sent, MPI_STATUSES_IGNORE);
+        sc_MPI_Testall (req->num_sends, req->sendreqs, &sent,
+                        MPI_STATUSES_IGNORE);
       SC_CHECK_MPI (mpiret);
       if (sent) {
-        mpiret = MPI_Ibarrier (comm, &barreq);
+        mpiret = MPI_Ibarrier (comm, &req->req);
         SC_CHECK_MPI (mpiret);
-        barr = 1;
+        req->barr = 1;
       }
     }
     else {
-      mpiret = MPI_Test (&barreq, &done, MPI_STATUS_IGNORE);
+      mpiret = MPI_Test (&req->req, &req->done, MPI_STATUS_IGNORE);
       SC_CHECK_MPI (mpiret);
     }
+    if (!flag) {
+      /* nothing more to receive right now */
+      break;
+    }
   }
-  SC_FREE (sendreqs);
+  return req->done;
+}
 
-  sc_notify_payload_cleanup (senders, recv_buf, in_payload, out_payload,
-                             sorted);
+/** Complete the output arrays of a finished NBX algorithm. */
+static void
+sc_notify_nbx_finish (sc_notify_request_t * req)
+{
+  SC_ASSERT (req->done);
+  SC_FREE (req->sendreqs);
+  sc_notify_payload_cleanup (req->senders, req->recv_buf, req->in_payload,
+                             req->out_payload, req->sorted);
+}
+
+#endif
+
+void
+sc_notify_finalize (void)
+{
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  int                 mpiret;
+
+  if (sc_notify_nbx_keyval != MPI_KEYVAL_INVALID) {
+    mpiret = MPI_Comm_free_keyval (&sc_notify_nbx_keyval);
+    SC_CHECK_MPI (mpiret);
+    sc_notify_nbx_keyval = MPI_KEYVAL_INVALID;
+  }
+#endif
+}
+
+static void
+sc_notify_payload_nbx (sc_array_t * receivers, sc_array_t * senders,
+                       sc_array_t * in_payload, sc_array_t * out_payload,
+                       int sorted, sc_notify_t * notify)
+{
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  sc_notify_request_t req;
+  sc_flopinfo_t       snap;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  memset (&req, 0, sizeof (sc_notify_request_t));
+  req.notify = notify;
+  req.receivers = receivers;
+  req.senders = senders;
+  req.in_payload = in_payload;
+  req.out_payload = out_payload;
+  req.sorted = sorted;
+
+  sc_notify_nbx_start (&req);
+  while (!sc_notify_nbx_progress (&req)) {
+  }
+  sc_notify_nbx_finish (&req);
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 #else
   SC_ABORT ("nbx implementation of sc_notify requires MPI-3 or greater");
@@ -2005,7 +2200,7 @@ sc_notify_payloadv_nbx (sc_array_t * receivers, sc_array_t * senders,
   int                 num_receivers;
   int                *ireceivers, i;
   int                *inoff;
-  int                 mpiret, rank, size;
+  int                 mpiret, rank, size, tag;
   char               *cpayload = NULL;
   int                 msg_size = 0;
   MPI_Request        *sendreqs;
@@ -2035,6 +2230,7 @@ sc_notify_payloadv_nbx (sc_array_t * receivers, sc_array_t * senders,
   cpayload = (char *) in_payload->array;
   inoff = (int *) in_offsets->array;
 
+  tag = sc_notify_nbx_tag (comm, SC_TAG_NOTIFY_NBXV, SC_TAG_NOTIFY_NBXV_ODD);
   sendreqs = SC_ALLOC (MPI_Request, num_receivers);
 
   for (i = 0; i < num_receivers; i++) {
@@ -2043,8 +2239,7 @@ sc_notify_payloadv_nbx (sc_array_t * receivers, sc_array_t * senders,
     int                 total = msg_size * (inoff[i + 1] - inoff[i]);
 
     mpiret =
-      MPI_Issend (buf, total, MPI_BYTE, j, SC_TAG_NOTIFY_NBXV, comm,
-                  &sendreqs[i]);
+      MPI_Issend (buf, total, MPI_BYTE, j, tag, comm, &sendreqs[i]);
     SC_CHECK_MPI (mpiret);
   }
 
@@ -2071,8 +2266,7 @@ sc_notify_payloadv_nbx (sc_array_t * receivers, sc_array_t * senders,
     int                 j, flag;
     MPI_Status          status;
 
-    mpiret =
-      MPI_Iprobe (MPI_ANY_SOURCE, SC_TAG_NOTIFY_NBX, comm, &flag, &status);
+    mpiret = MPI_Iprobe (MPI_ANY_SOURCE, tag, comm, &flag, &status);
     SC_CHECK_MPI (mpiret);
     if (flag) {
       int                *r;
@@ -2091,7 +2285,7 @@ sc_notify_payloadv_nbx (sc_array_t * receivers, sc_array_t * senders,
       *off = (int) recv_buf->elem_count;
 
       mpiret =
-        MPI_Recv (rc, msg_size * count, MPI_BYTE, j, SC_TAG_NOTIFY_NBX, comm,
+        MPI_Recv (rc, msg_size * count, MPI_BYTE, j, tag, comm,
                   MPI_STATUS_IGNORE);
       SC_CHECK_MPI (mpiret);
     }
@@ -2550,67 +2744,403 @@ sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
-/*== SC_NOTIFY_BINARY ==*/
+/*== SC_NOTIFY_HIER ==*/
+
+int
+sc_notify_hier_get_node_size (sc_notify_t * notify)
+{
+  SC_ASSERT (notify->type == SC_NOTIFY_HIER);
+  return notify->data.hier.node_size;
+}
+
+void
+sc_notify_hier_set_node_size (sc_notify_t * notify, int node_size)
+{
+  SC_ASSERT (notify->type == SC_NOTIFY_HIER);
+  if (node_size != notify->data.hier.node_size) {
+    /* the communicators are recomputed by the next notification */
+    sc_notify_hier_reset (notify);
+    notify->data.hier.node_size = node_size;
+  }
+}
 
-/** Internally used function to execute the sc_notify recursion.
- * The internal data format of the input and output arrays is as follows:
- * forall(torank): (torank, howmanyfroms, listoffromranks).
- * \param [in] mpicomm      Communicator to use.
- * \param [in] start        Offset of range of ranks.
- * \param [in] me           Current MPI process in range of ranks.
- * \param [in] length       Next-biggest or equal power of 2 for range.
- * \param [in] groupsize    Global count of ranks.
- * \param [in,out] array    Input/output array of integers.
- */
 static void
-sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
-                     int groupsize, sc_array_t * array)
+sc_notify_hier_init (sc_notify_t * notify)
 {
-  int                 i;
-  int                 mpiret;
-  int                 num_ta;
-  int                 length2, half;
-  int                 torank, numfroms;
-#ifdef SC_ENABLE_DEBUG
-  int                 j, fromrank, num_out;
-#endif
-  int                 peer, peer2, source;
-  int                 tag, count;
-  int                *pint, *pout;
-  sc_array_t         *sendbuf, *recvbuf, morebuf;
-  sc_MPI_Request      outrequest;
-  sc_MPI_Status       instatus;
+  memset (&notify->data.hier, 0, sizeof (sc_notify_hier_t));
+  notify->data.hier.intranode = sc_MPI_COMM_NULL;
+  notify->data.hier.leaders = sc_MPI_COMM_NULL;
+}
 
-  tag = SC_TAG_NOTIFY_RECURSIVE + SC_LOG2_32 (length);
-  length2 = length / 2;
-  SC_ASSERT (start <= me && me < start + length && me < groupsize);
-  SC_ASSERT (start % length == 0);
-  SC_ASSERT (array != NULL && array->elem_size == sizeof (int));
+static void
+sc_notify_hier_reset (sc_notify_t * notify)
+{
+  int                 mpiret;
+  sc_notify_hier_t   *hier = &notify->data.hier;
 
-  if (length > 1) {
-    /* execute recursion in-place */
-    if (me < start + length2) {
-      half = 0;
-      sc_notify_recursive (mpicomm, start, me, length2, groupsize, array);
+  if (hier->setup) {
+    sc_shmem_free (sc_package_id, hier->node_table, notify->mpicomm);
+    if (hier->own_leaders && hier->leaders != sc_MPI_COMM_NULL) {
+      mpiret = sc_MPI_Comm_free (&hier->leaders);
+      SC_CHECK_MPI (mpiret);
     }
-    else {
-      half = 1;
-      sc_notify_recursive (mpicomm, start + length2, me, length2,
-                           groupsize, array);
+    if (hier->own_intranode) {
+      mpiret = sc_MPI_Comm_free (&hier->intranode);
+      SC_CHECK_MPI (mpiret);
     }
+  }
+  hier->node_table = NULL;
+  hier->setup = hier->own_intranode = hier->own_leaders = 0;
+  hier->intranode = sc_MPI_COMM_NULL;
+  hier->leaders = sc_MPI_COMM_NULL;
+}
 
-    /* determine communication pattern */
-    peer = me ^ length2;
-    SC_ASSERT (start <= peer && peer < start + length);
-    if (peer < groupsize) {
-      /* peer exists even when mpisize is not a power of 2 */
-      SC_ASSERT ((!half && me < peer) || (half && me > peer));
-    }
-    else {
-      /* peer does not exist; send to a lower processor if nonnegative */
-      SC_ASSERT (!half && me < peer);
-      peer -= length;
-      SC_ASSERT (start - length2 <= peer && peer < start);
+/** Compute the node communicators and the shared node table. */
+static void
+sc_notify_hier_setup (sc_notify_t * notify)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 intrarank;
+  int                 entry[2];
+  sc_MPI_Comm         mpicomm = notify->mpicomm;
+  sc_MPI_Comm         intranode, internode;
+  sc_notify_hier_t   *hier = &notify->data.hier;
+
+  SC_ASSERT (!hier->setup);
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  if (hier->node_size >= 1) {
+    /* consecutive groups of ranks as in sc_mpi_comm_attach_node_comms */
+    mpiret = sc_MPI_Comm_split (mpicomm, mpirank / hier->node_size, mpirank,
+                                &hier->intranode);
+    SC_CHECK_MPI (mpiret);
+    hier->own_intranode = 1;
+  }
+  else {
+    sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+    if (intranode != sc_MPI_COMM_NULL) {
+      /* the internode communicator of intranode rank 0 joins the leaders */
+      hier->intranode = intranode;
+      mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+      SC_CHECK_MPI (mpiret);
+      if (intrarank == 0) {
+        hier->leaders = internode;
+      }
+    }
+    else {
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+      mpiret = MPI_Comm_split_type (mpicomm, MPI_COMM_TYPE_SHARED, mpirank,
+                                    MPI_INFO_NULL, &hier->intranode);
+#else
+      /* without shared memory information every process is a node */
+      mpiret = sc_MPI_Comm_split (mpicomm, mpirank, 0, &hier->intranode);
+#endif
+      SC_CHECK_MPI (mpiret);
+      hier->own_intranode = 1;
+    }
+  }
+  mpiret = sc_MPI_Comm_rank (hier->intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  if (hier->own_intranode) {
+    mpiret = sc_MPI_Comm_split (mpicomm, intrarank == 0 ? 0 :
+                                sc_MPI_UNDEFINED, mpirank, &hier->leaders);
+    SC_CHECK_MPI (mpiret);
+    hier->own_leaders = 1;
+  }
+  SC_ASSERT ((intrarank == 0) == (hier->leaders != sc_MPI_COMM_NULL));
+
+  /* the node number is the rank of the node leader among the leaders */
+  entry[0] = 0;
+  if (intrarank == 0) {
+    mpiret = sc_MPI_Comm_rank (hier->leaders, &entry[0]);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = sc_MPI_Bcast (&entry[0], 1, sc_MPI_INT, 0, hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  entry[1] = intrarank;
+
+  /* the table is identical on all processes and shared where possible */
+  hier->node_table = (int *) sc_shmem_malloc (sc_package_id, 2 * sizeof (int),
+                                              (size_t) mpisize, mpicomm);
+  sc_shmem_allgather (entry, 2, sc_MPI_INT, hier->node_table, 2, sc_MPI_INT,
+                      mpicomm);
+  hier->setup = 1;
+}
+
+/** Sort records of ints by the source rank stored in their second int. */
+static int
+sc_notify_hier_compare (const void *v1, const void *v2)
+{
+  return sc_int_compare (&((const int *) v1)[1], &((const int *) v2)[1]);
+}
+
+/** Notification through the node leaders.
+ * Each process sends records (receiver, sender, payload) to its node leader.
+ * The leaders exchange the records among themselves, grouped by the node of
+ * the receiver, and scatter the records they obtain to the processes on
+ * their node.  Thus only the leaders communicate between nodes.
+ */
+static void
+sc_notify_payload_hier (sc_array_t * receivers, sc_array_t * senders,
+                        sc_array_t * in_payload, sc_array_t * out_payload,
+                        sc_notify_t * notify)
+{
+  int                 mpiret;
+  int                 mpirank;
+  int                 intrarank, intrasize;
+  int                 num_nodes;
+  int                 i, j, k;
+  int                 num_receivers, num_records;
+  int                 npay, stride;
+  int                 my_count, node_count;
+  int                *ireceivers, *isenders;
+  int                *table;
+  int                *records, *node_records = NULL;
+  int                *sorted_records = NULL, *recv_records = NULL;
+  int                *counts = NULL, *displs = NULL;
+  int                *send_counts = NULL, *send_displs = NULL;
+  int                *recv_counts = NULL, *recv_displs = NULL;
+  int                *place = NULL;
+  sc_array_t          mine;
+  sc_notify_hier_t   *hier = &notify->data.hier;
+  sc_flopinfo_t       snap;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+
+  if (!hier->setup) {
+    sc_notify_hier_setup (notify);
+  }
+  table = hier->node_table;
+  mpiret = sc_MPI_Comm_rank (notify->mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (hier->intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (hier->intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+
+  /* pack one record of receiver, sender and payload per receiver */
+  npay = 0;
+  if (in_payload) {
+    npay = (int) ((in_payload->elem_size + sizeof (int) - 1) / sizeof (int));
+  }
+  stride = 2 + npay;
+  num_receivers = (int) receivers->elem_count;
+  ireceivers = (int *) receivers->array;
+  records = SC_ALLOC_ZERO (int, stride * num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    records[stride * i + 0] = ireceivers[i];
+    records[stride * i + 1] = mpirank;
+    if (in_payload) {
+      memcpy (&records[stride * i + 2], sc_array_index_int (in_payload, i),
+              in_payload->elem_size);
+    }
+  }
+
+  /* gather the records of this node on its leader */
+  my_count = stride * num_receivers;
+  if (intrarank == 0) {
+    counts = SC_ALLOC (int, intrasize);
+    displs = SC_ALLOC (int, intrasize + 1);
+  }
+  mpiret = sc_MPI_Gather (&my_count, 1, sc_MPI_INT, counts, 1, sc_MPI_INT,
+                          0, hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  if (intrarank == 0) {
+    displs[0] = 0;
+    for (i = 0; i < intrasize; ++i) {
+      displs[i + 1] = displs[i] + counts[i];
+    }
+    node_records = SC_ALLOC (int, displs[intrasize]);
+  }
+  mpiret = sc_MPI_Gatherv (records, my_count, sc_MPI_INT, node_records,
+                           counts, displs, sc_MPI_INT, 0, hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (records);
+
+  if (intrarank == 0) {
+    /* group the records by the node of the receiver */
+    mpiret = sc_MPI_Comm_size (hier->leaders, &num_nodes);
+    SC_CHECK_MPI (mpiret);
+    num_records = displs[intrasize] / stride;
+    send_counts = SC_ALLOC_ZERO (int, num_nodes);
+    send_displs = SC_ALLOC (int, num_nodes + 1);
+    recv_counts = SC_ALLOC (int, num_nodes);
+    recv_displs = SC_ALLOC (int, num_nodes + 1);
+    place = SC_ALLOC (int, SC_MAX (num_nodes, intrasize));
+    for (j = 0; j < num_records; ++j) {
+      k = table[2 * node_records[stride * j]];
+      SC_ASSERT (0 <= k && k < num_nodes);
+      send_counts[k] += stride;
+    }
+    send_displs[0] = 0;
+    for (k = 0; k < num_nodes; ++k) {
+      place[k] = send_displs[k];
+      send_displs[k + 1] = send_displs[k] + send_counts[k];
+    }
+    sorted_records = SC_ALLOC (int, send_displs[num_nodes]);
+    for (j = 0; j < num_records; ++j) {
+      k = table[2 * node_records[stride * j]];
+      memcpy (&sorted_records[place[k]], &node_records[stride * j],
+              stride * sizeof (int));
+      place[k] += stride;
+    }
+
+    /* the census proper runs among the node leaders only */
+    mpiret = sc_MPI_Alltoall (send_counts, 1, sc_MPI_INT,
+                              recv_counts, 1, sc_MPI_INT, hier->leaders);
+    SC_CHECK_MPI (mpiret);
+    recv_displs[0] = 0;
+    for (k = 0; k < num_nodes; ++k) {
+      recv_displs[k + 1] = recv_displs[k] + recv_counts[k];
+    }
+    SC_FREE (node_records);
+    node_records = SC_ALLOC (int, recv_displs[num_nodes]);
+    mpiret = sc_MPI_Alltoallv (sorted_records, send_counts, send_displs,
+                               sc_MPI_INT, node_records, recv_counts,
+                               recv_displs, sc_MPI_INT, hier->leaders);
+    SC_CHECK_MPI (mpiret);
+
+    /* group the records received for this node by their receiver */
+    num_records = recv_displs[num_nodes] / stride;
+    memset (counts, 0, intrasize * sizeof (int));
+    for (j = 0; j < num_records; ++j) {
+      i = table[2 * node_records[stride * j] + 1];
+      SC_ASSERT (table[2 * node_records[stride * j]] == table[2 * mpirank]);
+      SC_ASSERT (0 <= i && i < intrasize);
+      counts[i] += stride;
+    }
+    displs[0] = 0;
+    for (i = 0; i < intrasize; ++i) {
+      place[i] = displs[i];
+      displs[i + 1] = displs[i] + counts[i];
+    }
+    SC_FREE (sorted_records);
+    sorted_records = SC_ALLOC (int, displs[intrasize]);
+    for (j = 0; j < num_records; ++j) {
+      i = table[2 * node_records[stride * j] + 1];
+      memcpy (&sorted_records[place[i]], &node_records[stride * j],
+              stride * sizeof (int));
+      place[i] += stride;
+    }
+  }
+
+  /* scatter the records to the processes of the node */
+  mpiret = sc_MPI_Scatter (counts, 1, sc_MPI_INT, &node_count, 1,
+                           sc_MPI_INT, 0, hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  recv_records = SC_ALLOC (int, node_count);
+  mpiret = sc_MPI_Scatterv (sorted_records, counts, displs, sc_MPI_INT,
+                            recv_records, node_count, sc_MPI_INT, 0,
+                            hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  if (intrarank == 0) {
+    SC_FREE (counts);
+    SC_FREE (displs);
+    SC_FREE (send_counts);
+    SC_FREE (send_displs);
+    SC_FREE (recv_counts);
+    SC_FREE (recv_displs);
+    SC_FREE (place);
+    SC_FREE (node_records);
+    SC_FREE (sorted_records);
+  }
+
+  /* order the records by sender and extract the output */
+  num_records = node_count / stride;
+  sc_array_init_data (&mine, recv_records, stride * sizeof (int),
+                      (size_t) num_records);
+  sc_array_sort (&mine, sc_notify_hier_compare);
+
+  if (!senders) {
+    sc_array_reset (receivers);
+    senders = receivers;
+  }
+  sc_array_resize (senders, (size_t) num_records);
+  isenders = (int *) senders->array;
+  if (in_payload && out_payload == NULL) {
+    sc_array_reset (in_payload);
+    out_payload = in_payload;
+  }
+  if (out_payload) {
+    sc_array_resize (out_payload, (size_t) num_records);
+  }
+  for (j = 0; j < num_records; ++j) {
+    SC_ASSERT (recv_records[stride * j] == mpirank);
+    isenders[j] = recv_records[stride * j + 1];
+    if (out_payload) {
+      memcpy (sc_array_index_int (out_payload, j),
+              &recv_records[stride * j + 2], out_payload->elem_size);
+    }
+  }
+  SC_FREE (recv_records);
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
+/*== SC_NOTIFY_BINARY ==*/
+
+/** Internally used function to execute the sc_notify recursion.
+ * The internal data format of the input and output arrays is as follows:
+ * forall(torank): (torank, howmanyfroms, listoffromranks).
+ * \param [in] mpicomm      Communicator to use.
+ * \param [in] start        Offset of range of ranks.
+ * \param [in] me           Current MPI process in range of ranks.
+ * \param [in] length       Next-biggest or equal power of 2 for range.
+ * \param [in] groupsize    Global count of ranks.
+ * \param [in,out] array    Input/output array of integers.
+ */
+static void
+sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
+                     int groupsize, sc_array_t * array)
+{
+  int                 i;
+  int                 mpiret;
+  int                 num_ta;
+  int                 length2, half;
+  int                 torank, numfroms;
+#ifdef SC_ENABLE_DEBUG
+  int                 j, fromrank, num_out;
+#endif
+  int                 peer, peer2, source;
+  int                 tag, count;
+  int                *pint, *pout;
+  sc_array_t         *sendbuf, *recvbuf, morebuf;
+  sc_MPI_Request      outrequest;
+  sc_MPI_Status       instatus;
+
+  tag = SC_TAG_NOTIFY_RECURSIVE + SC_LOG2_32 (length);
+  length2 = length / 2;
+  SC_ASSERT (start <= me && me < start + length && me < groupsize);
+  SC_ASSERT (start % length == 0);
+  SC_ASSERT (array != NULL && array->elem_size == sizeof (int));
+
+  if (length > 1) {
+    /* execute recursion in-place */
+    if (me < start + length2) {
+      half = 0;
+      sc_notify_recursive (mpicomm, start, me, length2, groupsize, array);
+    }
+    else {
+      half = 1;
+      sc_notify_recursive (mpicomm, start + length2, me, length2,
+                           groupsize, array);
+    }
+
+    /* determine communication pattern */
+    peer = me ^ length2;
+    SC_ASSERT (start <= peer && peer < start + length);
+    if (peer < groupsize) {
+      /* peer exists even when mpisize is not a power of 2 */
+      SC_ASSERT ((!half && me < peer) || (half && me > peer));
+    }
+    else {
+      /* peer does not exist; send to a lower processor if nonnegative */
+      SC_ASSERT (!half && me < peer);
+      peer -= length;
+      SC_ASSERT (start - length2 <= peer && peer < start);
     }
     peer2 = me + length2;
     if (half && peer2 < groupsize && (peer2 ^ length2) >= groupsize) {
@@ -2760,6 +3290,488 @@ sc_notify (int *receivers, int num_receivers,
   return sc_MPI_SUCCESS;
 }
 
+/*== SC_NOTIFY_AUTO ==*/
+
+/** Maximum number of calibration entries kept in memory. */
+#define SC_NOTIFY_AUTO_MAX_ENTRIES 1024
+
+/** Payload sizes up to this many bytes are considered small. */
+#define SC_NOTIFY_AUTO_SMALL 64
+
+/** The fastest algorithm measured for one class of problems. */
+typedef struct sc_notify_auto_entry_s
+{
+  int                 log_size;         /**< Bits of mpisize - 1. */
+  int                 log_density;      /**< Bits of global max receivers. */
+  int                 payload_class;    /**< None, small or large payload. */
+  sc_notify_type_t    type;             /**< The fastest algorithm. */
+  int                 ntop, nint, nbot; /**< Widths for SC_NOTIFY_NARY. */
+  double              seconds;          /**< Time measured for it. */
+}
+sc_notify_auto_entry_t;
+
+const char         *sc_notify_auto_filename = NULL;
+
+static int          sc_notify_auto_loaded = 0;
+static int          sc_notify_auto_num_entries = 0;
+static sc_notify_auto_entry_t
+  sc_notify_auto_entries[SC_NOTIFY_AUTO_MAX_ENTRIES];
+
+static int
+sc_notify_auto_bits (int x)
+{
+  return x <= 0 ? 0 : SC_LOG2_32 (x) + 1;
+}
+
+static int
+sc_notify_auto_payload_class (int msg_bytes)
+{
+  return msg_bytes <= 0 ? 0 : msg_bytes <= SC_NOTIFY_AUTO_SMALL ? 1 : 2;
+}
+
+/** Return whether an algorithm may be chosen in this configuration. */
+static int
+sc_notify_auto_candidate (sc_notify_type_t type)
+{
+  switch (type) {
+  case SC_NOTIFY_NARY:
+  case SC_NOTIFY_PEX:
+    return 1;
+#ifdef SC_ENABLE_MPI
+    /* without MPI, these would send point-to-point messages to self */
+  case SC_NOTIFY_ALLGATHER:
+  case SC_NOTIFY_BINARY:
+  case SC_NOTIFY_RANGES:
+  case SC_NOTIFY_HIER:
+    return 1;
+#endif
+#if defined SC_ENABLE_MPI && \
+    (MPI_VERSION > 2 || (MPI_VERSION == 2 && MPI_SUBVERSION >= 2))
+  case SC_NOTIFY_PCX:
+    return 1;
+#endif
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 2
+  case SC_NOTIFY_RSX:
+    return 1;
+#endif
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  case SC_NOTIFY_NBX:
+    return 1;
+#endif
+  default:
+    return 0;
+  }
+}
+
+/** Insert an entry into the table, replacing one of the same class. */
+static void
+sc_notify_auto_store (const sc_notify_auto_entry_t * entry)
+{
+  int                 i;
+
+  for (i = 0; i < sc_notify_auto_num_entries; ++i) {
+    if (sc_notify_auto_entries[i].log_size == entry->log_size &&
+        sc_notify_auto_entries[i].log_density == entry->log_density &&
+        sc_notify_auto_entries[i].payload_class == entry->payload_class) {
+      break;
+    }
+  }
+  if (i == SC_NOTIFY_AUTO_MAX_ENTRIES) {
+    SC_LERROR ("sc_notify calibration table full\n");
+    return;
+  }
+  sc_notify_auto_entries[i] = *entry;
+  if (i == sc_notify_auto_num_entries) {
+    ++sc_notify_auto_num_entries;
+  }
+}
+
+int
+sc_notify_auto_load (const char *filename)
+{
+  int                 i, count;
+  char                name[BUFSIZ];
+  FILE               *file;
+  sc_notify_auto_entry_t entry;
+
+  SC_ASSERT (filename != NULL);
+  if ((file = fopen (filename, "r")) == NULL) {
+    SC_LERRORF ("Could not open notify calibration %s\n", filename);
+    return -1;
+  }
+  count = 0;
+  for (;;) {
+    /* skip comment lines */
+    while ((i = fgetc (file)) == '#') {
+      while ((i = fgetc (file)) != EOF && i != '\n') {
+      }
+    }
+    if (i == EOF || ungetc (i, file) == EOF) {
+      break;
+    }
+    if (fscanf (file, "%d %d %d %63s %d %d %d %lf",
+                &entry.log_size, &entry.log_density, &entry.payload_class,
+                name, &entry.ntop, &entry.nint, &entry.nbot,
+                &entry.seconds) != 8) {
+      break;
+    }
+    /* consume the rest of the record before deciding on it */
+    while ((i = fgetc (file)) != EOF && i != '\n') {
+    }
+    for (i = 0; i < SC_NOTIFY_NUM_TYPES; ++i) {
+      if (!strcmp (name, sc_notify_type_strings[i])) {
+        break;
+      }
+    }
+    if (i == SC_NOTIFY_NUM_TYPES ||
+        !sc_notify_auto_candidate ((sc_notify_type_t) i)) {
+      SC_LERRORF ("Ignore notify calibration for type %s\n", name);
+      continue;
+    }
+    entry.type = (sc_notify_type_t) i;
+    sc_notify_auto_store (&entry);
+    ++count;
+  }
+  if (fclose (file)) {
+    SC_LERRORF ("Could not close notify calibration %s\n", filename);
+    return -1;
+  }
+  SC_LDEBUGF ("Loaded %d notify calibration entries\n", count);
+  sc_notify_auto_loaded = 1;
+  return 0;
+}
+
+/** Write the calibration table in the format read by sc_notify_auto_load. */
+static int
+sc_notify_auto_save (const char *filename)
+{
+  int                 i;
+  FILE               *file;
+  sc_notify_auto_entry_t *entry;
+
+  if ((file = fopen (filename, "w")) == NULL) {
+    SC_LERRORF ("Could not create notify calibration %s\n", filename);
+    return -1;
+  }
+  fprintf (file, "# sc_notify calibration: log_size log_density"
+           " payload_class type ntop nint nbot seconds\n");
+  for (i = 0; i < sc_notify_auto_num_entries; ++i) {
+    entry = &sc_notify_auto_entries[i];
+    fprintf (file, "%d %d %d %s %d %d %d %.6e\n", entry->log_size,
+             entry->log_density, entry->payload_class,
+             sc_notify_type_strings[entry->type], entry->ntop, entry->nint,
+             entry->nbot, entry->seconds);
+  }
+  if (fclose (file)) {
+    SC_LERRORF ("Could not write notify calibration %s\n", filename);
+    return -1;
+  }
+  return 0;
+}
+
+/** Choose an algorithm from the calibration table or by a default rule.
+ * The arguments are identical on all processes, and so is the result.
+ */
+static void
+sc_notify_auto_choose (int mpisize, int max_receivers, int msg_bytes,
+                       sc_notify_auto_entry_t * choice)
+{
+  int                 i, dist, best;
+  sc_notify_auto_entry_t *entry;
+
+  choice->log_size = sc_notify_auto_bits (mpisize - 1);
+  choice->log_density = sc_notify_auto_bits (max_receivers);
+  choice->payload_class = sc_notify_auto_payload_class (msg_bytes);
+  choice->ntop = choice->nint = choice->nbot = 0;
+  choice->seconds = 0.;
+
+  /* find the closest calibration of the same payload class */
+  best = -1;
+  for (i = 0; i < sc_notify_auto_num_entries; ++i) {
+    entry = &sc_notify_auto_entries[i];
+    if (entry->payload_class != choice->payload_class) {
+      continue;
+    }
+    dist = 2 * abs (entry->log_size - choice->log_size) +
+      abs (entry->log_density - choice->log_density);
+    if (best == -1 || dist < best) {
+      best = dist;
+      choice->type = entry->type;
+      choice->ntop = entry->ntop;
+      choice->nint = entry->nint;
+      choice->nbot = entry->nbot;
+    }
+  }
+  if (best >= 0) {
+    return;
+  }
+
+  /* without calibration, the dense exchange is fine for small sizes
+     and the consensus algorithm scales best for sparse patterns */
+  choice->type = SC_NOTIFY_PEX;
+  if (mpisize > 64 && 8 * max_receivers < mpisize) {
+    choice->type = sc_notify_auto_candidate (SC_NOTIFY_NBX) ?
+      SC_NOTIFY_NBX : SC_NOTIFY_NARY;
+  }
+}
+
+/** Make the calibration table of the first process known to all.
+ * Only the first process reads the calibration file if it has not done so.
+ * Different tables would select different algorithms and deadlock.
+ * This function is collective.
+ */
+static void
+sc_notify_auto_sync (sc_MPI_Comm comm)
+{
+  int                 mpiret, mpirank;
+  const char         *filename;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the calibration file is read once per program */
+  if (mpirank == 0 && !sc_notify_auto_loaded) {
+    filename = sc_notify_auto_filename != NULL ? sc_notify_auto_filename :
+      getenv ("SC_NOTIFY_AUTO_FILE");
+    if (filename != NULL) {
+      (void) sc_notify_auto_load (filename);
+    }
+  }
+  sc_notify_auto_loaded = 1;
+
+  mpiret = sc_MPI_Bcast (&sc_notify_auto_num_entries, 1, sc_MPI_INT, 0,
+                         comm);
+  SC_CHECK_MPI (mpiret);
+  if (sc_notify_auto_num_entries > 0) {
+    mpiret = sc_MPI_Bcast (sc_notify_auto_entries,
+                           (int) (sc_notify_auto_num_entries *
+                                  sizeof (sc_notify_auto_entry_t)),
+                           sc_MPI_BYTE, 0, comm);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+/** Return a controller of the given type owned by an automatic one. */
+static sc_notify_t *
+sc_notify_automatic_sub (sc_notify_t * notify,
+                         const sc_notify_auto_entry_t * choice)
+{
+  sc_notify_t        *sub;
+
+  SC_ASSERT (sc_notify_get_type (notify) == SC_NOTIFY_AUTO);
+  SC_ASSERT (sc_notify_auto_candidate (choice->type));
+
+  if ((sub = notify->data.automatic.sub[choice->type]) == NULL) {
+    sub = notify->data.automatic.sub[choice->type] =
+      sc_notify_new (sc_notify_get_comm (notify));
+    sc_notify_set_type (sub, choice->type);
+  }
+  if (choice->type == SC_NOTIFY_NARY) {
+    /* the cached controller must not keep the widths of an earlier call */
+    if (choice->ntop >= 2 && choice->nint >= 2 && choice->nbot >= 2) {
+      sc_notify_nary_set_widths (sub, choice->ntop, choice->nint,
+                                 choice->nbot);
+    }
+    else {
+      sc_notify_nary_set_widths (sub, sc_notify_nary_ntop_default,
+                                 sc_notify_nary_nint_default,
+                                 sc_notify_nary_nbot_default);
+    }
+  }
+  sub->eager_threshold = notify->eager_threshold;
+  sub->stats = notify->stats;
+  return sub;
+}
+
+/** Select the algorithm for one call of an automatic controller.
+ * This function is collective.
+ * \param [in] num_receivers    Local number of receivers.
+ * \param [in] msg_bytes        Local maximum of bytes per message.
+ * \return                      Controller to execute the call.
+ */
+static sc_notify_t *
+sc_notify_automatic_select (sc_notify_t * notify, int num_receivers,
+                            size_t msg_bytes)
+{
+  int                 mpiret, mpisize;
+  int                 local[2], global[2];
+  sc_MPI_Comm         comm;
+  sc_notify_auto_entry_t choice;
+
+  comm = sc_notify_get_comm (notify);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  if (!notify->data.automatic.synced) {
+    sc_notify_auto_sync (comm);
+    notify->data.automatic.synced = 1;
+  }
+  local[0] = num_receivers;
+  local[1] = (int) SC_MIN (msg_bytes, (size_t) INT_MAX);
+  mpiret = sc_MPI_Allreduce (local, global, 2, sc_MPI_INT, sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_notify_auto_choose (mpisize, global[0], global[1], &choice);
+  SC_GLOBAL_LDEBUGF ("sc_notify auto chooses %s\n",
+                     sc_notify_type_strings[choice.type]);
+  return sc_notify_automatic_sub (notify, &choice);
+}
+
+static void
+sc_notify_automatic_init (sc_notify_t * notify)
+{
+  memset (&notify->data.automatic, 0, sizeof (sc_notify_automatic_t));
+}
+
+static void
+sc_notify_automatic_reset (sc_notify_t * notify)
+{
+  int                 i;
+
+  for (i = 0; i < SC_NOTIFY_NUM_TYPES; ++i) {
+    if (notify->data.automatic.sub[i] != NULL) {
+      sc_notify_destroy (notify->data.automatic.sub[i]);
+      notify->data.automatic.sub[i] = NULL;
+    }
+  }
+}
+
+/** Time one call of sc_notify_payload as the maximum over all processes. */
+static double
+sc_notify_auto_time (sc_notify_t * notify, sc_array_t * receivers,
+                     sc_array_t * in_payload, int reps)
+{
+  int                 r, mpiret;
+  double              elapsed, global, best = -1.;
+  sc_MPI_Comm         comm = sc_notify_get_comm (notify);
+  sc_array_t         *senders, *out_payload;
+
+  senders = sc_array_new (sizeof (int));
+  out_payload = in_payload == NULL ? NULL :
+    sc_array_new (in_payload->elem_size);
+  for (r = 0; r < reps; ++r) {
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    elapsed = -sc_MPI_Wtime ();
+    sc_notify_payload (receivers, senders, in_payload, out_payload, 1,
+                       notify);
+    elapsed += sc_MPI_Wtime ();
+    mpiret = sc_MPI_Allreduce (&elapsed, &global, 1, sc_MPI_DOUBLE,
+                               sc_MPI_MAX, comm);
+    SC_CHECK_MPI (mpiret);
+    if (best < 0. || global < best) {
+      best = global;
+    }
+  }
+  sc_array_destroy (senders);
+  if (out_payload != NULL) {
+    sc_array_destroy (out_payload);
+  }
+  return best;
+}
+
+int
+sc_notify_auto_calibrate (sc_MPI_Comm mpicomm, int reps,
+                          const char *filename)
+{
+  const int           payload_bytes[3] = { 0, 8, 256 };
+  const int           nary_widths[3] = { 0, 4, 16 };
+  int                 mpiret, mpisize, mpirank;
+  int                 density, k, stride, pc, t, w, retval;
+  int                 num_types;
+  double              seconds;
+  sc_array_t         *receivers, *in_payload;
+  sc_notify_t        *notify;
+  sc_notify_auto_entry_t entry;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  reps = SC_MAX (reps, 1);
+
+  /* complete the table of previous runs so we may extend the file */
+  sc_notify_auto_sync (mpicomm);
+
+  notify = sc_notify_new (mpicomm);
+  receivers = sc_array_new (sizeof (int));
+  num_types = 0;
+  for (density = 1;; density *= 4) {
+    /* every process notifies density peers spread over the communicator */
+    density = SC_MIN (density, SC_MAX (mpisize - 1, 1));
+    stride = SC_MAX ((mpisize - 1) / density, 1);
+    sc_array_resize (receivers, (size_t) density);
+    for (k = 0; k < density; ++k) {
+      *(int *) sc_array_index_int (receivers, k) =
+        (mpirank + 1 + k * stride) % mpisize;
+    }
+    sc_array_sort (receivers, sc_int_compare);
+
+    for (pc = 0; pc < 3; ++pc) {
+      in_payload = NULL;
+      if (payload_bytes[pc] > 0) {
+        in_payload = sc_array_new_count ((size_t) payload_bytes[pc],
+                                         (size_t) density);
+        memset (in_payload->array, 0, in_payload->elem_size * density);
+      }
+      entry.log_size = sc_notify_auto_bits (mpisize - 1);
+      entry.log_density = sc_notify_auto_bits (density);
+      entry.payload_class = sc_notify_auto_payload_class (payload_bytes[pc]);
+      entry.seconds = -1.;
+      for (t = 0; t < SC_NOTIFY_NUM_TYPES; ++t) {
+        if (!sc_notify_auto_candidate ((sc_notify_type_t) t) ||
+            (t == SC_NOTIFY_RSX && mpisize == 1)) {
+          /* some MPI implementations fail on single process windows */
+          continue;
+        }
+        sc_notify_set_type (notify, (sc_notify_type_t) t);
+        for (w = 0; w < (t == SC_NOTIFY_NARY ? 3 : 1); ++w) {
+          if (t == SC_NOTIFY_NARY && nary_widths[w] > 0) {
+            sc_notify_nary_set_widths (notify, nary_widths[w],
+                                       nary_widths[w], nary_widths[w]);
+          }
+          seconds = sc_notify_auto_time (notify, receivers, in_payload, reps);
+          SC_GLOBAL_STATISTICSF ("Notify %s%s density %d payload %d"
+                                 " time %g\n", sc_notify_type_strings[t],
+                                 t == SC_NOTIFY_NARY && w > 0 ? " widths" :
+                                 "", density, payload_bytes[pc], seconds);
+          if (entry.seconds < 0. || seconds < entry.seconds) {
+            entry.type = (sc_notify_type_t) t;
+            entry.seconds = seconds;
+            entry.ntop = entry.nint = entry.nbot = 0;
+            if (t == SC_NOTIFY_NARY) {
+              sc_notify_nary_get_widths (notify, &entry.ntop, &entry.nint,
+                                         &entry.nbot);
+            }
+          }
+          ++num_types;
+        }
+      }
+      SC_GLOBAL_PRODUCTIONF ("Notify density %d payload %d fastest %s\n",
+                             density, payload_bytes[pc],
+                             sc_notify_type_strings[entry.type]);
+      sc_notify_auto_store (&entry);
+      if (in_payload != NULL) {
+        sc_array_destroy (in_payload);
+      }
+    }
+    if (density >= mpisize - 1 || density >= 1024) {
+      break;
+    }
+  }
+  sc_array_destroy (receivers);
+  sc_notify_destroy (notify);
+  SC_GLOBAL_LDEBUGF ("Calibrated %d notify configurations\n", num_types);
+
+  /* save the table on the first process */
+  retval = 0;
+  if (filename != NULL && mpirank == 0) {
+    retval = sc_notify_auto_save (filename);
+  }
+  mpiret = sc_MPI_Bcast (&retval, 1, sc_MPI_INT, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return retval;
+}
+
 /*== SC_NOTIFY_PAYLOAD ==*/
 
 void
@@ -2774,6 +3786,14 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
   sc_array_t         *receivers_copy = NULL;
   sc_flopinfo_t       snap;
 
+  if (type == SC_NOTIFY_AUTO) {
+    sc_notify_payload (receivers, senders, in_payload, out_payload, sorted,
+                       sc_notify_automatic_select
+                       (notify, (int) receivers->elem_count,
+                        in_payload != NULL ? in_payload->elem_size : 0));
+    return;
+  }
+
   SC_NOTIFY_FUNC_SNAP (notify, &snap);
   SC_GLOBAL_LDEBUGF ("Into sc_notify_payload, type %s\n",
                      sc_notify_type_strings[type]);
@@ -2856,6 +3876,10 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
     sc_notify_payload_superset (receivers, senders, first_in_payload,
                                 first_out_payload, sorted, notify);
     break;
+  case SC_NOTIFY_HIER:
+    sc_notify_payload_hier (receivers, senders, first_in_payload,
+                            first_out_payload, notify);
+    break;
   default:
     SC_ABORT_NOT_REACHED ();
   }
@@ -2979,6 +4003,8 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
   case SC_NOTIFY_PEX:
   case SC_NOTIFY_RANGES:
   case SC_NOTIFY_SUPERSET:
+  case SC_NOTIFY_HIER:
+  case SC_NOTIFY_AUTO:
     sc_notify_payloadv_wrapper (receivers, senders, in_payload, out_payload,
                                 in_offsets, out_offsets, sorted, notify);
     break;
@@ -3004,6 +4030,141 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
+/*== SC_NOTIFY_PAYLOAD SPLIT PHASE ==*/
+
+sc_notify_request_t *
+sc_notify_payload_begin (sc_array_t * receivers, sc_array_t * senders,
+                         sc_array_t * in_payload, sc_array_t * out_payload,
+                         int sorted, sc_notify_t * notify)
+{
+  sc_notify_request_t *req;
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  int                 mpiret;
+  MPI_Comm            comm;
+#endif
+
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders == NULL || senders->elem_size == sizeof (int));
+  SC_ASSERT (in_payload != NULL || out_payload == NULL);
+
+  if (sc_notify_get_type (notify) == SC_NOTIFY_AUTO) {
+    notify = sc_notify_automatic_select
+      (notify, (int) receivers->elem_count,
+       in_payload != NULL ? in_payload->elem_size : 0);
+  }
+
+  req = SC_ALLOC_ZERO (sc_notify_request_t, 1);
+  req->notify = notify;
+  req->type = sc_notify_get_type (notify);
+  req->receivers = receivers;
+  req->senders = senders;
+  req->in_payload = in_payload;
+  req->out_payload = out_payload;
+  req->sorted = sorted;
+
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  comm = sc_notify_get_comm (notify);
+  if (req->type == SC_NOTIFY_NBX) {
+    /* the payload travels with the notification regardless of its size */
+    SC_ASSERT (in_payload == NULL || (int) in_payload->elem_count ==
+               (int) receivers->elem_count);
+    if (senders != NULL) {
+      SC_ASSERT (SC_ARRAY_IS_OWNER (senders));
+      sc_array_reset (senders);
+    }
+    req->split = 1;
+    sc_notify_nbx_start (req);
+    (void) sc_notify_nbx_progress (req);
+    return req;
+  }
+  if (req->type == SC_NOTIFY_PEX &&
+      (in_payload == NULL ||
+       in_payload->elem_size <= notify->eager_threshold)) {
+    mpiret = MPI_Comm_size (comm, &req->mpisize);
+    SC_CHECK_MPI (mpiret);
+    req->split = 1;
+    req->stride = sc_notify_pex_pack (receivers, in_payload, req->mpisize,
+                                      &req->sendbuf);
+    req->recvbuf = SC_ALLOC (int, req->stride * req->mpisize);
+    mpiret = MPI_Ialltoall (req->sendbuf, req->stride, MPI_INT,
+                            req->recvbuf, req->stride, MPI_INT, comm,
+                            &req->req);
+    SC_CHECK_MPI (mpiret);
+    return req;
+  }
+#endif
+
+  /* all other cases complete right away */
+  sc_notify_payload (receivers, senders, in_payload, out_payload, sorted,
+                     notify);
+  req->done = 1;
+  return req;
+}
+
+int
+sc_notify_payload_test (sc_notify_request_t * req)
+{
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  int                 mpiret;
+#endif
+
+  SC_ASSERT (req != NULL);
+  if (req->done) {
+    return 1;
+  }
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  SC_ASSERT (req->split);
+  if (req->type == SC_NOTIFY_NBX) {
+    return sc_notify_nbx_progress (req);
+  }
+  SC_ASSERT (req->type == SC_NOTIFY_PEX);
+  mpiret = MPI_Test (&req->req, &req->done, MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
+#else
+  SC_ABORT_NOT_REACHED ();
+#endif
+  return req->done;
+}
+
+void
+sc_notify_payload_end (sc_notify_request_t * req)
+{
+  sc_notify_t        *notify;
+  sc_flopinfo_t       snap;
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  int                 mpiret;
+#endif
+
+  SC_ASSERT (req != NULL);
+  notify = req->notify;
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  if (req->split) {
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+    if (req->type == SC_NOTIFY_NBX) {
+      while (!sc_notify_nbx_progress (req)) {
+      }
+      sc_notify_nbx_finish (req);
+    }
+    else {
+      SC_ASSERT (req->type == SC_NOTIFY_PEX);
+      if (!req->done) {
+        mpiret = MPI_Wait (&req->req, MPI_STATUS_IGNORE);
+        SC_CHECK_MPI (mpiret);
+      }
+      sc_notify_pex_unpack (req->receivers, req->senders, req->in_payload,
+                            req->out_payload, req->recvbuf, req->stride,
+                            req->mpisize);
+      SC_FREE (req->sendbuf);
+      SC_FREE (req->recvbuf);
+    }
+#else
+    SC_ABORT_NOT_REACHED ();
+#endif
+  }
+  SC_FREE (req);
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
 void
 sc_notify_nary (sc_array_t * receivers, sc_array_t * senders,
                 sc_array_t * in_payload, sc_array_t * out_payload,
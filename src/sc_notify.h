@@ -156,6 +156,11 @@ void                sc_notify_ext (sc_array_t * receivers,
  */
 typedef struct sc_notify_s sc_notify_t;
 
+/** Opaque handle of a notification in progress, see
+ * \ref sc_notify_payload_begin.
+ */
+typedef struct sc_notify_request_s sc_notify_request_t;
+
 /** Type of callback function for the \ref SC_NOTIFY_SUPERSET variant. */
 typedef void        (*sc_compute_superset_t) (sc_array_t *, sc_array_t *,
                                               sc_array_t *, sc_notify_t *,
@@ -176,6 +181,14 @@ typedef enum
   SC_NOTIFY_RANGES,        /**< Use the sc_ranges functionality.  Likely suboptimal. */
   SC_NOTIFY_SUPERSET,      /**< Use a computable superset of communicators, computed by
                                 a callback function. */
+  SC_NOTIFY_HIER,          /**< Aggregate the receivers of each shared memory
+                                node on a node leader, run the census among
+                                the node leaders only and distribute the
+                                result to the processes of each node. */
+  SC_NOTIFY_AUTO,          /**< Choose one of the above for every call, depending on
+                                the size of the communicator, the global maximum
+                                number of receivers and the payload size.
+                                See \ref sc_notify_auto_calibrate. */
   SC_NOTIFY_NUM_TYPES      /**< End of list marker for notify algorithms. */
 }
 sc_notify_type_t;
@@ -189,6 +202,8 @@ sc_notify_type_t;
 #define SC_NOTIFY_STR_NBX "nbx"             /**< String for the NBX variant. */
 #define SC_NOTIFY_STR_RANGES "ranges"       /**< String for the ranges variant. */
 #define SC_NOTIFY_STR_SUPERSET "superset"   /**< String for the superset variant. */
+#define SC_NOTIFY_STR_HIER "hier"           /**< String for the hierarchical variant. */
+#define SC_NOTIFY_STR_AUTO "auto"           /**< String for the automatic choice. */
 
 /** Names for each notify method */
 extern const char  *sc_notify_type_strings[SC_NOTIFY_NUM_TYPES];
@@ -201,6 +216,13 @@ extern sc_notify_type_t sc_notify_type_default;
  * with the notification packet.  Initialized to 1024 (2^10) */
 extern size_t       sc_notify_eager_threshold_default;
 
+/** Calibration file read when a controller of type \ref SC_NOTIFY_AUTO
+ * is used first.  If NULL, which is the default, we use the environment
+ * variable SC_NOTIFY_AUTO_FILE if it is set.  Only the first process of the
+ * communicator reads the file and broadcasts the calibration table.
+ */
+extern const char  *sc_notify_auto_filename;
+
 /** @{ \name Optional, most general interface. */
 
 /** Create a notify controller that can be used in \ref sc_notify_payload
@@ -369,6 +391,30 @@ void                sc_notify_superset_get_callback
 void                sc_notify_superset_set_callback
   (sc_notify_t * notify, sc_compute_superset_t compute_superset, void *ctx);
 
+/** Query the number of processes per node for the \ref SC_NOTIFY_HIER method.
+ * \param [in] notify       Must be of type \ref SC_NOTIFY_HIER.
+ * \return                  The value set by \ref sc_notify_hier_set_node_size.
+ */
+int                 sc_notify_hier_get_node_size (sc_notify_t * notify);
+
+/** Set the number of processes per node for the \ref SC_NOTIFY_HIER method.
+ * By default, or if \a node_size is less than 1, we use the node
+ * communicators attached by \ref sc_mpi_comm_attach_node_comms if present,
+ * and otherwise split the communicator by shared memory domains if MPI 3
+ * is available.  Without both, every process is a node of its own.
+ * If \a node_size is positive, the ranks are split into consecutive
+ * groups of this size as in \ref sc_mpi_comm_attach_node_comms.
+ * The node communicators are computed by the next notification.
+ * This function must be given the same value on every process, and it
+ * must be called collectively if the controller has been used before.
+ * Controllers of this type must be destroyed or changed to another type
+ * collectively.
+ * \param [in,out] notify   Must be of type \ref SC_NOTIFY_HIER.
+ * \param [in] node_size    The number of processes per node.
+ */
+void                sc_notify_hier_set_node_size (sc_notify_t * notify,
+                                                  int node_size);
+
 /** Collective call to notify a set of receiver ranks of current rank.
  * This function aborts on MPI error.
  * \param [in,out] receivers    On input, sorted and uniqued array of type int.
@@ -456,6 +502,74 @@ void                sc_notify_payloadv (sc_array_t * receivers,
                                         sc_array_t * in_offsets,
                                         int sorted, sc_notify_t * notify);
 
+/** Start a notification as in \ref sc_notify_payload without blocking.
+ * The types \ref SC_NOTIFY_NBX and \ref SC_NOTIFY_PEX run split-phase
+ * if MPI-3 is available; \ref SC_NOTIFY_PEX only if the payload does not
+ * exceed the eager threshold.  For any other case, this function executes
+ * \ref sc_notify_payload and returns a completed request.
+ * For \ref SC_NOTIFY_NBX the payload is always sent with the notification.
+ *
+ * All array arguments are used exactly as in \ref sc_notify_payload.
+ * They must neither be accessed nor modified until \ref
+ * sc_notify_payload_end returns.  The same holds for the controller.
+ * Like the blocking version, this function is collective, and all
+ * processes must call the matching \ref sc_notify_payload_end.
+ * \return                   Request to be passed to \ref
+ *                           sc_notify_payload_test and finally to \ref
+ *                           sc_notify_payload_end.
+ */
+sc_notify_request_t *sc_notify_payload_begin (sc_array_t * receivers,
+                                              sc_array_t * senders,
+                                              sc_array_t * in_payload,
+                                              sc_array_t * out_payload,
+                                              int sorted,
+                                              sc_notify_t * notify);
+
+/** Make progress on a notification started by \ref sc_notify_payload_begin.
+ * Call this function repeatedly while doing other work.
+ * \param [in,out] req       The request, still valid on output.
+ * \return                   True if all communication has completed.
+ *                           The output arrays are only valid after
+ *                           \ref sc_notify_payload_end.
+ */
+int                 sc_notify_payload_test (sc_notify_request_t * req);
+
+/** Complete a notification started by \ref sc_notify_payload_begin.
+ * We wait for any outstanding communication and fill the output arrays.
+ * \param [in] req           The request is freed and invalid on output.
+ */
+void                sc_notify_payload_end (sc_notify_request_t * req);
+
+/** Measure all applicable algorithms and remember the fastest ones.
+ * We time \ref sc_notify_payload on the given communicator for a sequence
+ * of receiver counts, for no payload, a small and a large payload.
+ * The fastest algorithm of each configuration, including the best widths
+ * for \ref SC_NOTIFY_NARY, is used by \ref SC_NOTIFY_AUTO from now on.
+ * This function is collective and may take a while.
+ * \param [in] mpicomm      Communicator to calibrate.
+ * \param [in] reps         We take the fastest of this many runs.
+ * \param [in] filename     If not NULL, the first process writes all
+ *                          calibration data known to this file,
+ *                          which includes entries loaded previously.
+ *                          Thus we may accumulate results for several
+ *                          communicator sizes in one file.
+ * \return                  0 on success, -1 if writing the file failed.
+ */
+int                 sc_notify_auto_calibrate (sc_MPI_Comm mpicomm,
+                                              int reps,
+                                              const char *filename);
+
+/** Read calibration data written by \ref sc_notify_auto_calibrate.
+ * The entries replace any in memory for the same configurations.
+ * This is not required when using \ref sc_notify_auto_filename.
+ * An \ref SC_NOTIFY_AUTO controller broadcasts the table of the first
+ * process of its communicator when it is used first, so it suffices
+ * to call this function on that process.
+ * \param [in] filename     Name of the calibration file.
+ * \return                  0 on success, -1 if the file cannot be read.
+ */
+int                 sc_notify_auto_load (const char *filename);
+
 /** @} */
 
 /** For the \ref SC_NOTIFY_RANGES method, the default is 25. */
@@ -44,6 +44,11 @@ SC_EXTERN_C_BEGIN;
  */
 void                sc_package_rc_count_add (int package_id, int toadd);
 
+/** Release the MPI resources kept by \ref sc_notify between calls.
+ * This function is called by \ref sc_finalize.
+ */
+void                sc_notify_finalize (void);
+
 SC_EXTERN_C_END;
 
 #endif /* SC_PRIVATE_H */
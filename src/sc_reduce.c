@@ -23,6 +23,9 @@
 
 #include <sc_reduce.h>
 #include <sc_search.h>
+#include <sc_shmem.h>
+
+int                 sc_reduce_hierarchical = 0;
 
 static void
 sc_reduce_alltoall (sc_MPI_Comm mpicomm,
@@ -116,14 +119,15 @@ sc_reduce_alltoall (sc_MPI_Comm mpicomm,
         }
       }
     }
-    memcpy (data, alldata, datasize);
-    SC_FREE (alldata);          /* alldata is not used in send buffers */
 
-    /* wait for sends only after computation is done */
+    /* wait for sends only after computation is done,
+       but before the send buffer is overwritten with the result */
     if (doall) {
       mpiret = sc_MPI_Waitall (allcount, srequest, sc_MPI_STATUSES_IGNORE);
       SC_CHECK_MPI (mpiret);
     }
+    memcpy (data, alldata, datasize);
+    SC_FREE (alldata);          /* alldata is not used in send buffers */
     SC_FREE (request);
   }
   else {
@@ -220,263 +224,383 @@ sc_reduce_recursive (sc_MPI_Comm mpicomm,
   }
 }
 
-static void
-sc_reduce_max (void *sendbuf, void *recvbuf,
-               int sendcount, sc_MPI_Datatype sendtype)
+/* The elementwise kernels are written such that the compiler vectorizes
+ * them.  Where supported, we compile them for several instruction sets
+ * and the dynamic loader picks the best one for the running processor.
+ * The thread sanitizer crashes in the resolvers that run at load time. */
+#ifdef __SANITIZE_THREAD__
+#define SC_REDUCE_TSAN
+#elif defined __has_feature
+#if __has_feature (thread_sanitizer)
+#define SC_REDUCE_TSAN
+#endif
+#endif
+#if defined SC_HAVE_ATTRIBUTE_TARGET_CLONES && !defined SC_REDUCE_TSAN
+#define SC_REDUCE_CLONES \
+  __attribute__ ((target_clones ("avx512f", "avx2", "default")))
+#else
+#define SC_REDUCE_CLONES
+#endif
+
+/** Number of independent accumulators in \ref sc_reduce_minmaxsum. */
+#define SC_REDUCE_LANES 8
+
+/** Byte width of the blocks processed by the elementwise kernels.
+ * A loop over a block has a fixed trip count that the compiler unrolls
+ * and vectorizes even without aggressive optimization flags. */
+#define SC_REDUCE_BLOCK 64
+
+#define SC_REDUCE_KERNEL(op,name,tp,stmt)                               \
+SC_REDUCE_CLONES static void                                            \
+sc_reduce_##op##_##name (const tp *_sc_restrict s, tp *_sc_restrict r,  \
+                         int n)                                         \
+{                                                                       \
+  int                 i, k, nblock;                                     \
+  nblock = n - n % (int) (SC_REDUCE_BLOCK / sizeof (tp));               \
+  for (i = 0; i < nblock; i += (int) (SC_REDUCE_BLOCK / sizeof (tp)))   \
+    for (k = i; k < i + (int) (SC_REDUCE_BLOCK / sizeof (tp)); ++k)     \
+      stmt;                                                             \
+  for (k = nblock; k < n; ++k)                                          \
+    stmt;                                                               \
+}
+
+#define SC_REDUCE_KERNELS(name,tp)                                      \
+SC_REDUCE_KERNEL (max, name, tp, r[k] = s[k] > r[k] ? s[k] : r[k])      \
+SC_REDUCE_KERNEL (min, name, tp, r[k] = s[k] < r[k] ? s[k] : r[k])      \
+SC_REDUCE_KERNEL (sum, name, tp, r[k] += s[k])
+
+/* *INDENT-OFF* */
+SC_REDUCE_KERNELS (char, char)
+SC_REDUCE_KERNELS (short, short)
+SC_REDUCE_KERNELS (ushort, unsigned short)
+SC_REDUCE_KERNELS (int, int)
+SC_REDUCE_KERNELS (unsigned, unsigned)
+SC_REDUCE_KERNELS (long, long)
+SC_REDUCE_KERNELS (ulong, unsigned long)
+SC_REDUCE_KERNELS (llong, long long)
+SC_REDUCE_KERNELS (float, float)
+SC_REDUCE_KERNELS (double, double)
+SC_REDUCE_KERNELS (ldouble, long double)
+/* *INDENT-ON* */
+
+#define SC_REDUCE_DISPATCH(op)                                          \
+static void                                                             \
+sc_reduce_##op (void *sendbuf, void *recvbuf,                           \
+                int sendcount, sc_MPI_Datatype sendtype)                \
+{                                                                       \
+  if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE)               \
+    sc_reduce_##op##_char ((const char *) sendbuf,                      \
+                           (char *) recvbuf, sendcount);                \
+  else if (sendtype == sc_MPI_SHORT)                                    \
+    sc_reduce_##op##_short ((const short *) sendbuf,                    \
+                            (short *) recvbuf, sendcount);              \
+  else if (sendtype == sc_MPI_UNSIGNED_SHORT)                           \
+    sc_reduce_##op##_ushort ((const unsigned short *) sendbuf,          \
+                             (unsigned short *) recvbuf, sendcount);    \
+  else if (sendtype == sc_MPI_INT)                                      \
+    sc_reduce_##op##_int ((const int *) sendbuf,                        \
+                          (int *) recvbuf, sendcount);                  \
+  else if (sendtype == sc_MPI_UNSIGNED)                                 \
+    sc_reduce_##op##_unsigned ((const unsigned *) sendbuf,              \
+                               (unsigned *) recvbuf, sendcount);        \
+  else if (sendtype == sc_MPI_LONG)                                     \
+    sc_reduce_##op##_long ((const long *) sendbuf,                      \
+                           (long *) recvbuf, sendcount);                \
+  else if (sendtype == sc_MPI_UNSIGNED_LONG)                            \
+    sc_reduce_##op##_ulong ((const unsigned long *) sendbuf,            \
+                            (unsigned long *) recvbuf, sendcount);      \
+  else if (sendtype == sc_MPI_LONG_LONG_INT)                            \
+    sc_reduce_##op##_llong ((const long long *) sendbuf,                \
+                            (long long *) recvbuf, sendcount);          \
+  else if (sendtype == sc_MPI_FLOAT)                                    \
+    sc_reduce_##op##_float ((const float *) sendbuf,                    \
+                            (float *) recvbuf, sendcount);              \
+  else if (sendtype == sc_MPI_DOUBLE)                                   \
+    sc_reduce_##op##_double ((const double *) sendbuf,                  \
+                             (double *) recvbuf, sendcount);            \
+  else if (sendtype == sc_MPI_LONG_DOUBLE)                              \
+    sc_reduce_##op##_ldouble ((const long double *) sendbuf,            \
+                              (long double *) recvbuf, sendcount);      \
+  else                                                                  \
+    SC_ABORT ("Unsupported MPI datatype in sc_reduce_" #op);            \
+}
+
+/* *INDENT-OFF* */
+SC_REDUCE_DISPATCH (max)
+SC_REDUCE_DISPATCH (min)
+SC_REDUCE_DISPATCH (sum)
+/* *INDENT-ON* */
+
+static              sc_reduce_t
+sc_reduce_operation (sc_MPI_Op operation)
 {
-  int                 i;
+  if (operation == sc_MPI_MAX)
+    return sc_reduce_max;
+  else if (operation == sc_MPI_MIN)
+    return sc_reduce_min;
+  else if (operation == sc_MPI_SUM)
+    return sc_reduce_sum;
+  else
+    SC_ABORT ("Unsupported operation in sc_allreduce or sc_reduce");
+}
 
-  if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
-    const char         *s = (char *) sendbuf;
-    char               *r = (char *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_SHORT) {
-    const short        *s = (short *) sendbuf;
-    short              *r = (short *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
-    const unsigned short *s = (unsigned short *) sendbuf;
-    unsigned short     *r = (unsigned short *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_INT) {
-    const int          *s = (int *) sendbuf;
-    int                *r = (int *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED) {
-    const unsigned     *s = (unsigned *) sendbuf;
-    unsigned           *r = (unsigned *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_LONG) {
-    const long         *s = (long *) sendbuf;
-    long               *r = (long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED_LONG) {
-    const unsigned long *s = (unsigned long *) sendbuf;
-    unsigned long      *r = (unsigned long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_LONG_LONG_INT) {
-    const long long    *s = (long long *) sendbuf;
-    long long          *r = (long long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_FLOAT) {
-    const float        *s = (float *) sendbuf;
-    float              *r = (float *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_DOUBLE) {
-    const double       *s = (double *) sendbuf;
-    double             *r = (double *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_LONG_DOUBLE) {
-    const long double  *s = (long double *) sendbuf;
-    long double        *r = (long double *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
-  }
-  else {
-    SC_ABORT ("Unsupported MPI datatype in sc_reduce_max");
+void
+sc_reduce_local (void *inbuf, void *inoutbuf, int count,
+                 sc_MPI_Datatype datatype, sc_MPI_Op operation)
+{
+  SC_ASSERT (count >= 0);
+  SC_ASSERT (count == 0 || inbuf != inoutbuf);
+
+  sc_reduce_operation (operation) (inbuf, inoutbuf, count, datatype);
+}
+
+SC_REDUCE_CLONES void
+sc_reduce_minmaxsum (const double *values, size_t n,
+                     double *min, double *max, double *sum, double *sumsq)
+{
+  size_t              i, j, nlanes;
+  double              lmin[SC_REDUCE_LANES], lmax[SC_REDUCE_LANES];
+  double              lsum[SC_REDUCE_LANES], lsq[SC_REDUCE_LANES];
+  double              v;
+
+  SC_ASSERT (n == 0 || values != NULL);
+  SC_ASSERT (min != NULL && max != NULL);
+  SC_ASSERT (sum != NULL && sumsq != NULL);
+
+  if (n == 0) {
+    *min = *max = *sum = *sumsq = 0.;
+    return;
+  }
+
+  /* independent accumulators let the compiler use vector instructions */
+  for (j = 0; j < SC_REDUCE_LANES; ++j) {
+    lmin[j] = lmax[j] = values[0];
+    lsum[j] = lsq[j] = 0.;
+  }
+  nlanes = n - n % SC_REDUCE_LANES;
+  for (i = 0; i < nlanes; i += SC_REDUCE_LANES) {
+    for (j = 0; j < SC_REDUCE_LANES; ++j) {
+      v = values[i + j];
+      lmin[j] = v < lmin[j] ? v : lmin[j];
+      lmax[j] = v > lmax[j] ? v : lmax[j];
+      lsum[j] += v;
+      lsq[j] += v * v;
+    }
   }
+
+  /* combine the lanes and process the remainder */
+  for (j = 1; j < SC_REDUCE_LANES; ++j) {
+    lmin[0] = SC_MIN (lmin[0], lmin[j]);
+    lmax[0] = SC_MAX (lmax[0], lmax[j]);
+    lsum[0] += lsum[j];
+    lsq[0] += lsq[j];
+  }
+  for (i = nlanes; i < n; ++i) {
+    v = values[i];
+    lmin[0] = SC_MIN (lmin[0], v);
+    lmax[0] = SC_MAX (lmax[0], v);
+    lsum[0] += v;
+    lsq[0] += v * v;
+  }
+  *min = lmin[0];
+  *max = lmax[0];
+  *sum = lsum[0];
+  *sumsq = lsq[0];
 }
 
+/** Exchange a range of elements with a peer in pipelined chunks.
+ * We send \a sendcount elements from \a senddata and receive \a count
+ * elements that are combined with \a data as soon as each chunk arrives.
+ * If \a lower is true, the result is data op received, otherwise
+ * received op data, so that contributions are combined in rank order.
+ */
 static void
-sc_reduce_min (void *sendbuf, void *recvbuf,
-               int sendcount, sc_MPI_Datatype sendtype)
+sc_reduce_large_exchange (sc_MPI_Comm mpicomm, int peer,
+                          char *senddata, int sendcount,
+                          char *data, int count, char *tmp,
+                          sc_MPI_Datatype datatype, size_t typesize,
+                          int lower, sc_reduce_t reduce_fn)
 {
-  int                 i;
-
-  if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
-    const char         *s = (char *) sendbuf;
-    char               *r = (char *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_SHORT) {
-    const short        *s = (short *) sendbuf;
-    short              *r = (short *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
-    const unsigned short *s = (unsigned short *) sendbuf;
-    unsigned short     *r = (unsigned short *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_INT) {
-    const int          *s = (int *) sendbuf;
-    int                *r = (int *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED) {
-    const unsigned     *s = (unsigned *) sendbuf;
-    unsigned           *r = (unsigned *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_LONG) {
-    const long         *s = (long *) sendbuf;
-    long               *r = (long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED_LONG) {
-    const unsigned long *s = (unsigned long *) sendbuf;
-    unsigned long      *r = (unsigned long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_LONG_LONG_INT) {
-    const long long    *s = (long long *) sendbuf;
-    long long          *r = (long long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_FLOAT) {
-    const float        *s = (float *) sendbuf;
-    float              *r = (float *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
-  }
-  else if (sendtype == sc_MPI_DOUBLE) {
-    const double       *s = (double *) sendbuf;
-    double             *r = (double *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+  int                 mpiret;
+  int                 chunk, nsend, nrecv, i, c;
+  sc_MPI_Request     *request;
+
+  chunk = (int) SC_MAX (SC_REDUCE_PIPELINE_BYTES / typesize, 1);
+  nsend = (sendcount + chunk - 1) / chunk;
+  nrecv = (count + chunk - 1) / chunk;
+  request = SC_ALLOC (sc_MPI_Request, nsend + nrecv);
+
+  /* post all receives first to let data flow in while we reduce */
+  for (i = 0; i < nrecv; ++i) {
+    c = SC_MIN (chunk, count - i * chunk);
+    mpiret = sc_MPI_Irecv (tmp + i * chunk * typesize, (int) (c * typesize),
+                           sc_MPI_BYTE, peer, SC_TAG_REDUCE_LARGE, mpicomm,
+                           request + i);
+    SC_CHECK_MPI (mpiret);
   }
-  else if (sendtype == sc_MPI_LONG_DOUBLE) {
-    const long double  *s = (long double *) sendbuf;
-    long double        *r = (long double *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+  for (i = 0; i < nsend; ++i) {
+    c = SC_MIN (chunk, sendcount - i * chunk);
+    mpiret = sc_MPI_Isend (senddata + i * chunk * typesize,
+                           (int) (c * typesize), sc_MPI_BYTE, peer,
+                           SC_TAG_REDUCE_LARGE, mpicomm, request + nrecv + i);
+    SC_CHECK_MPI (mpiret);
   }
-  else {
-    SC_ABORT ("Unsupported MPI datatype in sc_reduce_min");
+
+  /* reduce each chunk as soon as it has arrived */
+  for (i = 0; i < nrecv; ++i) {
+    char               *d = data + i * chunk * typesize;
+    char               *t = tmp + i * chunk * typesize;
+
+    c = SC_MIN (chunk, count - i * chunk);
+    mpiret = sc_MPI_Wait (request + i, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    if (lower) {
+      reduce_fn (t, d, c, datatype);
+    }
+    else {
+      reduce_fn (d, t, c, datatype);
+      memcpy (d, t, c * typesize);
+    }
   }
+  mpiret = sc_MPI_Waitall (nsend, request + nrecv, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (request);
 }
 
+/** Allreduce by recursive halving reduce-scatter and doubling allgather.
+ * A number of processes that is not a power of two is first reduced by
+ * combining the data of the even ranks below twice the excess into their
+ * odd neighbors, which then act for both.
+ * \param [in,out] data     On input the contribution of this process,
+ *                          on output the reduced result.
+ */
 static void
-sc_reduce_sum (void *sendbuf, void *recvbuf,
-               int sendcount, sc_MPI_Datatype sendtype)
+sc_allreduce_large (sc_MPI_Comm mpicomm, char *data, int count,
+                    sc_MPI_Datatype datatype, int mpisize, int mpirank,
+                    sc_reduce_t reduce_fn)
 {
-  int                 i;
-
-  if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
-    const char         *s = (char *) sendbuf;
-    char               *r = (char *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_SHORT) {
-    const short        *s = (short *) sendbuf;
-    short              *r = (short *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
-    const unsigned short *s = (unsigned short *) sendbuf;
-    unsigned short     *r = (unsigned short *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_INT) {
-    const int          *s = (int *) sendbuf;
-    int                *r = (int *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED) {
-    const unsigned     *s = (unsigned *) sendbuf;
-    unsigned           *r = (unsigned *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_LONG) {
-    const long         *s = (long *) sendbuf;
-    long               *r = (long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_UNSIGNED_LONG) {
-    const unsigned long *s = (unsigned long *) sendbuf;
-    unsigned long      *r = (unsigned long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_LONG_LONG_INT) {
-    const long long    *s = (long long *) sendbuf;
-    long long          *r = (long long *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_FLOAT) {
-    const float        *s = (float *) sendbuf;
-    float              *r = (float *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_DOUBLE) {
-    const double       *s = (double *) sendbuf;
-    double             *r = (double *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
-  }
-  else if (sendtype == sc_MPI_LONG_DOUBLE) {
-    const long double  *s = (long double *) sendbuf;
-    long double        *r = (long double *) recvbuf;
-    for (i = 0; i < sendcount; ++i)
-      r[i] += s[i];
+  int                 mpiret;
+  int                 pof2, rem;
+  int                 vrank, vpeer, peer;
+  int                 mask, step, nsteps;
+  int                 lo, hi, mid;
+  int                *los, *his;
+  size_t              typesize;
+  char               *tmp;
+
+  typesize = sc_mpi_sizeof (datatype);
+  nsteps = SC_LOG2_32 (mpisize);
+  pof2 = 1 << nsteps;
+  rem = mpisize - pof2;
+  tmp = SC_ALLOC (char, count * typesize);
+
+  /* fold the excess processes into their odd neighbors */
+  if (mpirank < 2 * rem) {
+    if (mpirank % 2 == 0) {
+      mpiret = sc_MPI_Send (data, (int) (count * typesize), sc_MPI_BYTE,
+                            mpirank + 1, SC_TAG_REDUCE_LARGE, mpicomm);
+      SC_CHECK_MPI (mpiret);
+      vrank = -1;
+    }
+    else {
+      mpiret = sc_MPI_Recv (tmp, (int) (count * typesize), sc_MPI_BYTE,
+                            mpirank - 1, SC_TAG_REDUCE_LARGE, mpicomm,
+                            sc_MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+      reduce_fn (data, tmp, count, datatype);
+      memcpy (data, tmp, count * typesize);
+      vrank = mpirank / 2;
+    }
   }
   else {
-    SC_ABORT ("Unsupported MPI datatype in sc_reduce_sum");
+    vrank = mpirank - rem;
+  }
+
+  if (vrank >= 0) {
+    los = SC_ALLOC (int, nsteps + 1);
+    his = SC_ALLOC (int, nsteps + 1);
+
+    /* reduce-scatter: combine neighboring groups of growing size */
+    lo = 0;
+    hi = count;
+    for (step = 0, mask = 1; mask < pof2; ++step, mask <<= 1) {
+      los[step] = lo;
+      his[step] = hi;
+      vpeer = vrank ^ mask;
+      peer = vpeer < rem ? 2 * vpeer + 1 : vpeer + rem;
+      mid = lo + (hi - lo) / 2;
+      if (vrank < vpeer) {
+        sc_reduce_large_exchange (mpicomm, peer, data + mid * typesize,
+                                  hi - mid, data + lo * typesize, mid - lo,
+                                  tmp, datatype, typesize, 1, reduce_fn);
+        hi = mid;
+      }
+      else {
+        sc_reduce_large_exchange (mpicomm, peer, data + lo * typesize,
+                                  mid - lo, data + mid * typesize, hi - mid,
+                                  tmp, datatype, typesize, 0, reduce_fn);
+        lo = mid;
+      }
+    }
+    SC_ASSERT (step == nsteps);
+
+    /* allgather: retrace the steps to exchange the reduced ranges */
+    for (step = nsteps - 1, mask = pof2 >> 1; step >= 0; --step, mask >>= 1) {
+      sc_MPI_Request      request[2];
+
+      vpeer = vrank ^ mask;
+      peer = vpeer < rem ? 2 * vpeer + 1 : vpeer + rem;
+      mid = los[step] + (his[step] - los[step]) / 2;
+      if (vrank < vpeer) {
+        SC_ASSERT (lo == los[step] && hi == mid);
+        mpiret = sc_MPI_Irecv (data + mid * typesize,
+                               (int) ((his[step] - mid) * typesize),
+                               sc_MPI_BYTE, peer, SC_TAG_REDUCE_LARGE,
+                               mpicomm, request + 0);
+      }
+      else {
+        SC_ASSERT (lo == mid && hi == his[step]);
+        mpiret = sc_MPI_Irecv (data + los[step] * typesize,
+                               (int) ((mid - los[step]) * typesize),
+                               sc_MPI_BYTE, peer, SC_TAG_REDUCE_LARGE,
+                               mpicomm, request + 0);
+      }
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Isend (data + lo * typesize,
+                             (int) ((hi - lo) * typesize), sc_MPI_BYTE,
+                             peer, SC_TAG_REDUCE_LARGE, mpicomm,
+                             request + 1);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Waitall (2, request, sc_MPI_STATUSES_IGNORE);
+      SC_CHECK_MPI (mpiret);
+      lo = los[step];
+      hi = his[step];
+    }
+    SC_ASSERT (lo == 0 && hi == count);
+    SC_FREE (los);
+    SC_FREE (his);
+  }
+
+  /* return the result to the folded processes */
+  if (mpirank < 2 * rem) {
+    if (mpirank % 2 == 0) {
+      mpiret = sc_MPI_Recv (data, (int) (count * typesize), sc_MPI_BYTE,
+                            mpirank + 1, SC_TAG_REDUCE_LARGE, mpicomm,
+                            sc_MPI_STATUS_IGNORE);
+    }
+    else {
+      mpiret = sc_MPI_Send (data, (int) (count * typesize), sc_MPI_BYTE,
+                            mpirank - 1, SC_TAG_REDUCE_LARGE, mpicomm);
+    }
+    SC_CHECK_MPI (mpiret);
   }
+  SC_FREE (tmp);
 }
 
 static int
-sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
-                           sc_MPI_Datatype sendtype, sc_reduce_t reduce_fn,
-                           int target, sc_MPI_Comm mpicomm)
+sc_reduce_flat (void *sendbuf, void *recvbuf, int sendcount,
+                sc_MPI_Datatype sendtype, sc_reduce_t reduce_fn,
+                int target, sc_MPI_Comm mpicomm)
 {
   int                 mpiret;
   int                 mpisize;
@@ -498,6 +622,12 @@ sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
 
   SC_ASSERT (-1 <= target && target < mpisize);
 
+  if (target == -1 && mpisize > 1 && datasize >= SC_REDUCE_LARGE_BYTES) {
+    sc_allreduce_large (mpicomm, (char *) recvbuf, sendcount, sendtype,
+                        mpisize, mpirank, reduce_fn);
+    return sc_MPI_SUCCESS;
+  }
+
   maxlevel = SC_LOG2_32 (mpisize - 1) + 1;
   sc_reduce_recursive (mpicomm, recvbuf, sendcount, sendtype, mpisize,
                        target, maxlevel, maxlevel, mpirank, reduce_fn);
@@ -505,6 +635,93 @@ sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
   return sc_MPI_SUCCESS;
 }
 
+int
+sc_reduce_node_custom (void *sendbuf, void *recvbuf, int sendcount,
+                       sc_MPI_Datatype sendtype, sc_reduce_t reduce_fn,
+                       int target, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 intrasize, intrarank;
+  int                 i;
+  size_t              datasize;
+  char               *nodedata = NULL;
+  char               *shared;
+  sc_MPI_Comm         intranode, internode;
+
+  SC_ASSERT (sendcount >= 0);
+
+  if (!sc_shmem_is_shared (mpicomm)) {
+    return sc_reduce_flat (sendbuf, recvbuf, sendcount, sendtype,
+                           reduce_fn, target, mpicomm);
+  }
+
+  /* *INDENT-OFF* HORRIBLE indent bug */
+  datasize = (size_t) sendcount * sc_mpi_sizeof (sendtype);
+  /* *INDENT-ON* */
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+
+  SC_ASSERT (-1 <= target && target < mpisize);
+  SC_ASSERT (mpisize % intrasize == 0);
+
+  /* node root gathers from node and reduces in rank order */
+  if (!intrarank) {
+    nodedata = SC_ALLOC (char, intrasize * datasize);
+  }
+  mpiret = sc_MPI_Gather (sendbuf, (int) datasize, sc_MPI_BYTE,
+                          nodedata, (int) datasize, sc_MPI_BYTE, 0,
+                          intranode);
+  SC_CHECK_MPI (mpiret);
+
+  /* node roots reduce between nodes into the shared array */
+  shared = (char *) sc_shmem_malloc (sc_package_id, datasize, 1, mpicomm);
+  if (sc_shmem_write_start (shared, mpicomm)) {
+    for (i = 1; i < intrasize; ++i) {
+      reduce_fn (nodedata + i * datasize, nodedata, sendcount, sendtype);
+    }
+    if (target == -1) {
+      sc_allreduce_custom (nodedata, shared, sendcount, sendtype,
+                           reduce_fn, internode);
+    }
+    else {
+      sc_reduce_custom (nodedata, shared, sendcount, sendtype,
+                        reduce_fn, target / intrasize, internode);
+    }
+    SC_FREE (nodedata);
+  }
+  sc_shmem_write_end (shared, mpicomm);
+
+  /* every process reads the result from the shared array */
+  if (target == -1 || target == mpirank) {
+    memcpy (recvbuf, shared, datasize);
+  }
+  sc_shmem_free (sc_package_id, shared, mpicomm);
+
+  return sc_MPI_SUCCESS;
+}
+
+static int
+sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
+                           sc_MPI_Datatype sendtype, sc_reduce_t reduce_fn,
+                           int target, sc_MPI_Comm mpicomm)
+{
+  if (sc_reduce_hierarchical) {
+    return sc_reduce_node_custom (sendbuf, recvbuf, sendcount, sendtype,
+                                  reduce_fn, target, mpicomm);
+  }
+  return sc_reduce_flat (sendbuf, recvbuf, sendcount, sendtype,
+                         reduce_fn, target, mpicomm);
+}
+
 int
 sc_allreduce_custom (void *sendbuf, void *recvbuf, int sendcount,
                      sc_MPI_Datatype sendtype, sc_reduce_t reduce_fn,
@@ -531,19 +748,9 @@ sc_reduce_dispatch (void *sendbuf, void *recvbuf, int sendcount,
                     sc_MPI_Datatype sendtype, sc_MPI_Op operation,
                     int target, sc_MPI_Comm mpicomm)
 {
-  sc_reduce_t         reduce_fn;
-
-  if (operation == sc_MPI_MAX)
-    reduce_fn = sc_reduce_max;
-  else if (operation == sc_MPI_MIN)
-    reduce_fn = sc_reduce_min;
-  else if (operation == sc_MPI_SUM)
-    reduce_fn = sc_reduce_sum;
-  else
-    SC_ABORT ("Unsupported operation in sc_allreduce or sc_reduce");
-
-  return sc_reduce_custom_dispatch (sendbuf, recvbuf, sendcount,
-                                    sendtype, reduce_fn, target, mpicomm);
+  return sc_reduce_custom_dispatch (sendbuf, recvbuf, sendcount, sendtype,
+                                    sc_reduce_operation (operation),
+                                    target, mpicomm);
 }
 
 int
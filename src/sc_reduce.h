@@ -30,6 +30,12 @@
  * not suffer from random or otherwise obscure influences.
  *
  * Both algorithms use a binary communication tree.
+ * An allreduce of at least \ref SC_REDUCE_LARGE_BYTES bytes instead uses a
+ * recursive halving reduce-scatter followed by a recursive doubling
+ * allgather (Rabenseifner's algorithm), which sends each byte a constant
+ * number of times instead of once per tree level.  It combines the
+ * contributions in rank order as well, so the operator need not commute,
+ * and its associativity again depends on the size of the communicator only.
  * We provide implementations via a customizable reduction operator
  * as well as drop-in replacements for minimum, maximum, and sum.
  * We do not currently support user-defined MPI datatypes.
@@ -47,8 +53,24 @@
 #define SC_REDUCE_ALLTOALL_LEVEL        3
 #endif
 
+#ifndef SC_REDUCE_LARGE_BYTES
+/** The smallest message in bytes that an allreduce sends through a
+ * reduce-scatter followed by an allgather instead of the binary tree. */
+#define SC_REDUCE_LARGE_BYTES           (1 << 16)
+#endif
+
+#ifndef SC_REDUCE_PIPELINE_BYTES
+/** The size of the chunks that the large allreduce reduces while the
+ * next ones are still being received. */
+#define SC_REDUCE_PIPELINE_BYTES        (1 << 14)
+#endif
+
 SC_EXTERN_C_BEGIN;
 
+/** If true, the functions in this file call \ref sc_reduce_node_custom.
+ * This may be changed at runtime; initialized to 0. */
+extern int          sc_reduce_hierarchical;
+
 /** Prototype for a user-defined reduce operation. */
 typedef void        (*sc_reduce_t) (void *sendbuf, void *recvbuf,
                                     int sendcount, sc_MPI_Datatype sendtype);
@@ -83,6 +105,31 @@ int                 sc_reduce_custom (void *sendbuf, void *recvbuf,
                                       sc_reduce_t reduce_fn,
                                       int target, sc_MPI_Comm mpicomm);
 
+/** Node-aware custom reduce or allreduce operation.
+ * It is active if \ref sc_shmem_is_shared is true for \a mpicomm, that is,
+ * after \ref sc_mpi_comm_attach_node_comms and \ref sc_shmem_set_type with
+ * a shared type.  Then the node root gathers and reduces the data of its
+ * node in rank order, the node roots reduce over the internode communicator
+ * into a shared array, and every process reads the result from there.
+ * The ranks of each node must be consecutive in \a mpicomm.
+ * The associativity depends on the node size in addition to the size of
+ * the communicator.  Otherwise, we use the flat algorithm.
+ * \param [in] sendbuf      Send buffer conforming to MPI specification.
+ * \param [out] recvbuf     Receive buffer conforming to MPI specification.
+ * \param [in] sendcount    Number of data items to reduce.
+ * \param [in] sendtype     Valid MPI datatype.
+ * \param [in] reduce_fn    Custom, associative reduction operator.
+ * \param [in] target       The MPI rank that obtains the result,
+ *                          or -1 for an allreduce.
+ * \param [in] mpicomm      Valid MPI communicator.
+ * \return                  sc_MPI_SUCCESS if not aborting on MPI error.
+ */
+int                 sc_reduce_node_custom (void *sendbuf, void *recvbuf,
+                                           int sendcount,
+                                           sc_MPI_Datatype sendtype,
+                                           sc_reduce_t reduce_fn,
+                                           int target, sc_MPI_Comm mpicomm);
+
 /** Drop-in MPI_Allreduce replacement with reproducible associativity.
  * Currently we support the operations minimum, maximum, and sum.
  * \param [in] sendbuf      Send buffer conforming to MPI specification.
@@ -114,6 +161,36 @@ int                 sc_reduce (void *sendbuf, void *recvbuf, int sendcount,
                                sc_MPI_Datatype sendtype, sc_MPI_Op operation,
                                int target, sc_MPI_Comm mpicomm);
 
+/** Combine two local arrays elementwise like MPI_Reduce_local.
+ * This is the computation done at each step of \ref sc_reduce and
+ * \ref sc_allreduce.  The loops over the elements are vectorized and,
+ * if the compiler supports it, selected at runtime for the processor.
+ * \param [in] inbuf        Array of \a count items of type \a datatype.
+ * \param [in,out] inoutbuf On output, \a inoutbuf op \a inbuf.
+ *                          Must not overlap with \a inbuf.
+ * \param [in] count        Number of data items to combine.
+ * \param [in] datatype     Valid MPI datatype.
+ * \param [in] operation    \ref sc_MPI_MIN, \ref sc_MPI_MAX, or \ref
+ *                          sc_MPI_SUM.  We abort otherwise.
+ */
+void                sc_reduce_local (void *inbuf, void *inoutbuf, int count,
+                                     sc_MPI_Datatype datatype,
+                                     sc_MPI_Op operation);
+
+/** Compute minimum, maximum, sum and sum of squares in one pass.
+ * The sums are accumulated in several interleaved partial sums, so they
+ * may differ in the last bits from a sequential loop.
+ * \param [in] values       Array of \a n values.
+ * \param [in] n            Number of values.  If 0, all results are 0.
+ * \param [out] min         Minimum value.
+ * \param [out] max         Maximum value.
+ * \param [out] sum         Sum of the values.
+ * \param [out] sumsq       Sum of the squares of the values.
+ */
+void                sc_reduce_minmaxsum (const double *values, size_t n,
+                                         double *min, double *max,
+                                         double *sum, double *sumsq);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_REDUCE_H */
@@ -22,3 +22,1849 @@
 */
 
 #include <sc_scda.h>
+#include <sc_io.h>
+
+/* File layout
+ * ===========
+ *
+ * The file header consists of the magic "scdata0 ", a vendor string padded
+ * to 24 bytes, the section type 'F' with the padded user string and 32 bytes
+ * of data padding, in total \ref SC_SCDA_HEADER_BYTES bytes.
+ *
+ * Each file section begins with a 64 byte header, i.e. the section type, a
+ * space and the user string padded to 62 bytes.  The section types 'B', 'A'
+ * and 'V' add one respectively two count entries of 32 bytes, i.e. a letter,
+ * a space and a decimal number padded to 30 bytes.
+ *
+ *  - 'I': 32 bytes of inline data.
+ *  - 'B': count 'E' (block bytes), the block data, padding.
+ *  - 'A': counts 'N' (elements) and 'E' (element bytes), the N * E data
+ *         bytes, padding.
+ *  - 'V': counts 'N' (elements) and 'E' (total data bytes), the N element
+ *         sizes as 8-byte little-endian numbers, padding, the data bytes,
+ *         padding.
+ *
+ * The data padding fills up to a multiple of 32 bytes using at least 7
+ * bytes.  It begins and ends with a newline and is filled with '='.
+ *
+ * An encoded section is written as an 'I' section with the user string
+ * \ref SC_SCDA_ENCODE_STRING, whose inline data is a count entry holding
+ * the original section type and its uncompressed block, element or total
+ * byte size, followed by the raw section that holds the data.  A block is
+ * stored as a 'B' section of the output of \ref sc_io_encode, fixed- and
+ * variable-size arrays are stored as a 'V' section of element-wise encoded
+ * data.  Each process encodes and decodes its own elements.
+ */
+
+#define SC_SCDA_MAGIC "scdata0 "     /**< first 8 bytes of a file */
+#define SC_SCDA_VENDOR_STRING "libsc"  /**< vendor string in the header */
+#define SC_SCDA_VENDOR_BYTES 24        /**< padded vendor string bytes */
+#define SC_SCDA_SECTION_BYTES 64       /**< bytes of a section header */
+#define SC_SCDA_USER_FIELD_BYTES 62    /**< padded user string bytes */
+#define SC_SCDA_COUNT_BYTES 32         /**< bytes of a count entry */
+#define SC_SCDA_COUNT_FIELD_BYTES 30   /**< padded decimal number bytes */
+#define SC_SCDA_COUNT_DIGITS 26        /**< maximal decimal digits */
+#define SC_SCDA_INLINE_BYTES 32        /**< bytes of inline data */
+#define SC_SCDA_PAD_MOD 32             /**< data is padded to this modulus */
+#define SC_SCDA_PAD_MIN 7              /**< minimal number of pad bytes */
+#define SC_SCDA_PAD_FIX_MIN 4          /**< minimal fixed length padding */
+#define SC_SCDA_ENCODE_STRING "scda element-wise encoding"
+
+/** Byte count of a single collective I/O call.
+ * Larger local data is written and read in multiple rounds.
+ */
+#define SC_SCDA_IO_CHUNK ((size_t) 1 << 30)
+
+/** The context of an opened scda file. */
+struct sc_scda_fcontext
+{
+  sc_MPI_Comm         mpicomm;          /**< communicator of the file */
+  int                 mpisize;          /**< size of the communicator */
+  int                 mpirank;          /**< rank in the communicator */
+  int                 reading;          /**< opened for reading */
+  sc_MPI_File         file;             /**< opened file */
+  sc_MPI_Offset       accessed_bytes;   /**< begin of next section */
+
+  /* the following is only used for reading */
+  char                section;          /**< raw type of the pending section
+                                             or '\0' if a header is due */
+  char                type;             /**< type reported to the user */
+  int                 decode;           /**< section is decoded */
+  int                 vsizes_read;      /**< 'V' element sizes are read */
+  sc_scda_ulong       elem_count;       /**< count 'N' of the raw section */
+  sc_scda_ulong       elem_size;        /**< count 'E' of the raw section */
+  sc_scda_ulong       decoded_size;     /**< uncompressed size of a decoded
+                                             block, element or array */
+  sc_MPI_Offset       data_offset;      /**< section data after the counts */
+  int                 have_encoded;     /**< encoded elements are cached */
+  sc_array_t          encoded_sizes;    /**< local encoded element sizes */
+  sc_array_t          encoded;          /**< local encoded element data */
+};
+
+static size_t
+sc_scda_pad_to_mod_len (sc_scda_ulong bytes)
+{
+  size_t              pad;
+
+  pad = SC_SCDA_PAD_MOD - (size_t) (bytes % SC_SCDA_PAD_MOD);
+  if (pad < SC_SCDA_PAD_MIN) {
+    pad += SC_SCDA_PAD_MOD;
+  }
+  return pad;
+}
+
+static void
+sc_scda_pad_to_mod (char *out, size_t pad)
+{
+  SC_ASSERT (pad >= SC_SCDA_PAD_MIN);
+
+  out[0] = '\n';
+  memset (out + 1, '=', pad - 2);
+  out[pad - 1] = '\n';
+}
+
+/** Pad \a len bytes of \a in to exactly \a pad_len bytes in \a out. */
+static void
+sc_scda_pad_to_fix_len (const char *in, size_t len, char *out, size_t pad_len)
+{
+  SC_ASSERT (len + SC_SCDA_PAD_FIX_MIN <= pad_len);
+
+  memcpy (out, in, len);
+  out[len] = ' ';
+  memset (out + len + 1, '-', pad_len - len - 2);
+  out[pad_len - 1] = '\n';
+}
+
+/** Undo \ref sc_scda_pad_to_fix_len and nul-terminate the output.
+ * \return          0 on success and -1 if the padding is invalid.
+ */
+static int
+sc_scda_get_fix_len (const char *in, size_t pad_len, char *out, size_t *len)
+{
+  size_t              i;
+
+  if (in[pad_len - 1] != '\n') {
+    return -1;
+  }
+  for (i = pad_len - 1; i > 0 && in[i - 1] == '-'; --i);
+  if (i == 0 || in[i - 1] != ' ' || i - 1 + SC_SCDA_PAD_FIX_MIN > pad_len) {
+    return -1;
+  }
+  --i;
+  memcpy (out, in, i);
+  out[i] = '\0';
+  *len = i;
+  return 0;
+}
+
+/** Write a count entry of \ref SC_SCDA_COUNT_BYTES bytes. */
+static void
+sc_scda_count_entry (char letter, sc_scda_ulong count, char *out)
+{
+  char                number[SC_SCDA_COUNT_FIELD_BYTES];
+  int                 len;
+
+  len = snprintf (number, SC_SCDA_COUNT_FIELD_BYTES, "%llu",
+                  (unsigned long long) count);
+  SC_ASSERT (0 < len && len <= SC_SCDA_COUNT_DIGITS);
+  out[0] = letter;
+  out[1] = ' ';
+  sc_scda_pad_to_fix_len (number, (size_t) len, out + 2,
+                          SC_SCDA_COUNT_FIELD_BYTES);
+}
+
+/** Parse a count entry of \ref SC_SCDA_COUNT_BYTES bytes.
+ * \param [in] letter   The expected letter or '\0' to accept any.
+ * \return              0 on success and -1 if the entry is invalid.
+ */
+static int
+sc_scda_parse_count (const char *in, char letter, char *oletter,
+                     sc_scda_ulong *count)
+{
+  char                number[SC_SCDA_COUNT_FIELD_BYTES];
+  size_t              len, i;
+  sc_scda_ulong       value, digit;
+
+  if ((letter != '\0' && in[0] != letter) || in[1] != ' ' ||
+      sc_scda_get_fix_len (in + 2, SC_SCDA_COUNT_FIELD_BYTES, number, &len)
+      || len == 0) {
+    return -1;
+  }
+  value = 0;
+  for (i = 0; i < len; ++i) {
+    if (number[i] < '0' || number[i] > '9') {
+      return -1;
+    }
+    digit = (sc_scda_ulong) (number[i] - '0');
+    if (value > (UINT64_MAX - digit) / 10) {
+      /* the number is valid but does not fit into our data type */
+      return -1;
+    }
+    value = 10 * value + digit;
+  }
+  if (oletter != NULL) {
+    *oletter = in[0];
+  }
+  *count = value;
+  return 0;
+}
+
+/** Write a section header of \ref SC_SCDA_SECTION_BYTES bytes. */
+static void
+sc_scda_section_header (char type, const char *user_string, size_t len,
+                        char *out)
+{
+  out[0] = type;
+  out[1] = ' ';
+  sc_scda_pad_to_fix_len (user_string, len, out + 2,
+                          SC_SCDA_USER_FIELD_BYTES);
+}
+
+static void
+sc_scda_store_le (const sc_scda_ulong *in, size_t count, unsigned char *out)
+{
+  size_t              zz;
+  int                 i;
+
+  for (zz = 0; zz < count; ++zz) {
+    for (i = 0; i < 8; ++i) {
+      out[8 * zz + i] = (unsigned char) ((in[zz] >> (8 * i)) & 0xFF);
+    }
+  }
+}
+
+static void
+sc_scda_load_le (const unsigned char *in, size_t count, sc_scda_ulong *out)
+{
+  size_t              zz;
+  int                 i;
+
+  for (zz = 0; zz < count; ++zz) {
+    out[zz] = 0;
+    for (i = 0; i < 8; ++i) {
+      out[zz] |= ((sc_scda_ulong) in[8 * zz + i]) << (8 * i);
+    }
+  }
+}
+
+static void
+sc_scda_set_error (sc_scda_ferror_t * errcode, sc_scda_ret_t scdaret)
+{
+  SC_ASSERT (scdaret != SC_SCDA_FERR_MPI);
+
+  errcode->scdaret = scdaret;
+  errcode->mpiret = sc_MPI_SUCCESS;
+}
+
+static void
+sc_scda_set_mpi_error (sc_scda_ferror_t * errcode, int mpiret)
+{
+  SC_ASSERT (mpiret != sc_MPI_SUCCESS);
+
+  errcode->scdaret = SC_SCDA_FERR_MPI;
+  errcode->mpiret = mpiret;
+}
+
+/** Check the user string for writing.
+ * \return          0 on success and -1 if it is invalid.
+ */
+static int
+sc_scda_check_user_string (const char *user_string, size_t *len,
+                           size_t *ulen)
+{
+  *ulen = 0;
+  if (user_string == NULL) {
+    return -1;
+  }
+  if (len == NULL) {
+    *ulen = strlen (user_string);
+  }
+  else {
+    *ulen = *len;
+    if (*ulen <= SC_SCDA_USER_STRING_BYTES && user_string[*ulen] != '\0') {
+      return -1;
+    }
+  }
+  return *ulen <= SC_SCDA_USER_STRING_BYTES ? 0 : -1;
+}
+
+/** Make the first error of any process known to all processes.
+ * \return          0 if no process has an error and -1 otherwise.
+ */
+static int
+sc_scda_sync_error (sc_scda_fcontext_t * fc, sc_scda_ferror_t * errcode)
+{
+  int                 mpiret;
+  int                 local, first;
+  int                 buf[2];
+
+  local = errcode->scdaret != SC_SCDA_FERR_SUCCESS ?
+    fc->mpirank : fc->mpisize;
+  mpiret = sc_MPI_Allreduce (&local, &first, 1, sc_MPI_INT, sc_MPI_MIN,
+                             fc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (first == fc->mpisize) {
+    return 0;
+  }
+
+  buf[0] = errcode->mpiret;
+  buf[1] = (int) errcode->scdaret;
+  mpiret = sc_MPI_Bcast (buf, 2, sc_MPI_INT, first, fc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  errcode->mpiret = buf[0];
+  errcode->scdaret = (sc_scda_ret_t) buf[1];
+  return -1;
+}
+
+/** Close the file after an error and free the context.
+ * The error code is preserved.
+ * \return          NULL.
+ */
+static sc_scda_fcontext_t *
+sc_scda_fail (sc_scda_fcontext_t * fc)
+{
+  /* we report the original error only */
+  (void) sc_io_close (&fc->file);
+  sc_array_reset (&fc->encoded_sizes);
+  sc_array_reset (&fc->encoded);
+  SC_FREE (fc);
+  return NULL;
+}
+
+/** Collectively write or read local data at a local offset.
+ * Local data larger than \ref SC_SCDA_IO_CHUNK is processed in multiple
+ * collective calls.  Errors are synchronized.
+ * \param [in] max_bytes    Maximum of \a bytes over all processes.
+ * \return                  0 on success and -1 on error on any process.
+ */
+static int
+sc_scda_io_all (sc_scda_fcontext_t * fc, int write, sc_MPI_Offset offset,
+                void *buf, size_t bytes, size_t max_bytes,
+                sc_scda_ferror_t * errcode)
+{
+  int                 mpiret, ocount;
+  size_t              rounds, r, done, chunk;
+
+  SC_ASSERT (bytes <= max_bytes);
+  SC_ASSERT (errcode->scdaret == SC_SCDA_FERR_SUCCESS);
+
+  rounds = SC_MAX ((max_bytes + SC_SCDA_IO_CHUNK - 1) / SC_SCDA_IO_CHUNK, 1);
+#if defined SC_ENABLE_MPI && !defined SC_ENABLE_MPIIO
+  if (rounds > 1) {
+    /* the serialized fallback appends and cannot process multiple rounds */
+    sc_scda_set_error (errcode, SC_SCDA_FERR_COUNT);
+    return -1;
+  }
+#endif
+
+  for (done = 0, r = 0; r < rounds; ++r) {
+    /* after an error we still participate in the collective calls */
+    chunk = errcode->scdaret == SC_SCDA_FERR_SUCCESS ?
+      SC_MIN (bytes - done, SC_SCDA_IO_CHUNK) : 0;
+    if (write) {
+      mpiret = sc_io_write_at_all (fc->file, offset + (sc_MPI_Offset) done,
+                                   chunk > 0 ? (char *) buf + done : NULL,
+                                   (int) chunk, sc_MPI_BYTE, &ocount);
+    }
+    else {
+      mpiret = sc_io_read_at_all (fc->file, offset + (sc_MPI_Offset) done,
+                                  chunk > 0 ? (char *) buf + done : NULL,
+                                  (int) chunk, sc_MPI_BYTE, &ocount);
+    }
+    if (errcode->scdaret == SC_SCDA_FERR_SUCCESS) {
+      if (mpiret != sc_MPI_SUCCESS) {
+        sc_scda_set_mpi_error (errcode, mpiret);
+      }
+      else if ((size_t) ocount != chunk) {
+        sc_scda_set_error (errcode, SC_SCDA_FERR_COUNT);
+      }
+    }
+    done += chunk;
+  }
+  return sc_scda_sync_error (fc, errcode);
+}
+
+/** Collectively write data given on one process only. */
+static int
+sc_scda_write_single (sc_scda_fcontext_t * fc, int rank,
+                      sc_MPI_Offset offset, const void *buf, size_t bytes,
+                      sc_scda_ferror_t * errcode)
+{
+  return sc_scda_io_all (fc, 1, offset, fc->mpirank == rank ?
+                         (void *) buf : NULL, fc->mpirank == rank ?
+                         bytes : 0, bytes, errcode);
+}
+
+/** Collectively write the data padding on rank zero. */
+static int
+sc_scda_write_padding (sc_scda_fcontext_t * fc, sc_MPI_Offset offset,
+                       sc_scda_ulong data_bytes, sc_scda_ferror_t * errcode)
+{
+  char                pad[SC_SCDA_PAD_MOD + SC_SCDA_PAD_MIN];
+  size_t              pad_len;
+
+  pad_len = sc_scda_pad_to_mod_len (data_bytes);
+  sc_scda_pad_to_mod (pad, pad_len);
+  return sc_scda_write_single (fc, 0, offset, pad, pad_len, errcode);
+}
+
+/** Read up to \a bytes on rank zero and broadcast them.
+ * \param [out] obytes  The number of bytes actually read.
+ * \return              0 on success and -1 on error on any process.
+ */
+static int
+sc_scda_read_bcast (sc_scda_fcontext_t * fc, sc_MPI_Offset offset,
+                    char *buf, size_t bytes, size_t *obytes,
+                    sc_scda_ferror_t * errcode)
+{
+  int                 mpiret;
+  int                 info[2];
+
+  SC_ASSERT (bytes <= SC_SCDA_HEADER_BYTES);
+
+  if (fc->mpirank == 0) {
+    info[0] = sc_io_read_at (fc->file, offset, buf, (int) bytes,
+                             sc_MPI_BYTE, &info[1]);
+  }
+  mpiret = sc_MPI_Bcast (info, 2, sc_MPI_INT, 0, fc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (info[0] != sc_MPI_SUCCESS) {
+    sc_scda_set_mpi_error (errcode, info[0]);
+    return -1;
+  }
+  mpiret = sc_MPI_Bcast (buf, info[1], sc_MPI_BYTE, 0, fc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  *obytes = (size_t) info[1];
+  return 0;
+}
+
+/** Examine a partition of array elements.
+ * \return          0 if \a elem_counts is valid and -1 otherwise.
+ */
+static int
+sc_scda_partition (sc_scda_fcontext_t * fc, sc_array_t * elem_counts,
+                   sc_scda_ulong *global, sc_scda_ulong *offset,
+                   sc_scda_ulong *local, sc_scda_ulong *max_local)
+{
+  int                 p;
+  sc_scda_ulong       count;
+
+  if (elem_counts == NULL || elem_counts->elem_size != sizeof (sc_scda_ulong)
+      || elem_counts->elem_count != (size_t) fc->mpisize) {
+    return -1;
+  }
+  *global = *offset = *local = *max_local = 0;
+  for (p = 0; p < fc->mpisize; ++p) {
+    count = *(sc_scda_ulong *) sc_array_index_int (elem_counts, p);
+    if (count > UINT64_MAX - *global) {
+      return -1;
+    }
+    if (p < fc->mpirank) {
+      *offset += count;
+    }
+    else if (p == fc->mpirank) {
+      *local = count;
+    }
+    *max_local = SC_MAX (*max_local, count);
+    *global += count;
+  }
+  return 0;
+}
+
+/** Check whether an array of sc_arrays has the given element sizes.
+ * \param [in] sizes    If NULL, each element must have \a size bytes.
+ */
+static int
+sc_scda_check_indirect (sc_array_t * array, sc_scda_ulong count,
+                        const sc_scda_ulong *sizes, sc_scda_ulong size)
+{
+  size_t              zz;
+  sc_array_t         *elem;
+
+  if (array->elem_size != sizeof (sc_array_t) || array->elem_count != count) {
+    return -1;
+  }
+  for (zz = 0; zz < count; ++zz) {
+    elem = (sc_array_t *) sc_array_index (array, zz);
+    if (elem->elem_count != 1 ||
+        elem->elem_size != (sizes != NULL ? sizes[zz] : size)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/** Check whether an array holds one block of the given bytes.
+ * Since an sc_array cannot have zero element size, an empty block may
+ * also be passed as an array of zero elements.
+ */
+static int
+sc_scda_is_block (sc_array_t * array, sc_scda_ulong bytes)
+{
+  if (bytes == 0 && array->elem_count == 0) {
+    return 1;
+  }
+  return array->elem_count == 1 && array->elem_size == bytes;
+}
+
+/** Return a pointer to the local element data of an array section.
+ * For indirect arrays the elements are copied into \a buffer.
+ */
+static char        *
+sc_scda_gather_indirect (sc_array_t * array, sc_array_t * buffer)
+{
+  size_t              zz, offset;
+  sc_array_t         *elem;
+
+  offset = 0;
+  for (zz = 0; zz < array->elem_count; ++zz) {
+    elem = (sc_array_t *) sc_array_index (array, zz);
+    offset += elem->elem_size;
+  }
+  sc_array_resize (buffer, offset);
+  for (offset = 0, zz = 0; zz < array->elem_count; ++zz) {
+    elem = (sc_array_t *) sc_array_index (array, zz);
+    memcpy (buffer->array + offset, elem->array, elem->elem_size);
+    offset += elem->elem_size;
+  }
+  return buffer->array;
+}
+
+static void
+sc_scda_scatter_indirect (const char *data, sc_array_t * array)
+{
+  size_t              zz, offset;
+  sc_array_t         *elem;
+
+  for (offset = 0, zz = 0; zz < array->elem_count; ++zz) {
+    elem = (sc_array_t *) sc_array_index (array, zz);
+    memcpy (elem->array, data + offset, elem->elem_size);
+    offset += elem->elem_size;
+  }
+}
+
+/** Encode the local elements one by one.
+ * \param [in] data     Contiguous element data.
+ * \param [in] sizes    Element byte sizes or NULL for all of \a size bytes.
+ * \param [out] esizes  Initialized with the encoded element sizes.
+ * \param [out] edata   Initialized with the encoded element data.
+ */
+static void
+sc_scda_encode_elements (const char *data, sc_scda_ulong count,
+                         const sc_scda_ulong *sizes, sc_scda_ulong size,
+                         sc_array_t * esizes, sc_array_t * edata)
+{
+  size_t              zz, offset;
+  sc_scda_ulong       bytes;
+  sc_array_t          view, out;
+
+  sc_array_init_size (esizes, sizeof (sc_scda_ulong), (size_t) count);
+  sc_array_init (edata, 1);
+  sc_array_init (&out, 1);
+  for (offset = 0, zz = 0; zz < count; ++zz) {
+    bytes = sizes != NULL ? sizes[zz] : size;
+    sc_array_init_data (&view, (void *) (data + offset), 1, (size_t) bytes);
+    sc_io_encode (&view, &out);
+    memcpy (sc_array_push_count (edata, out.elem_count), out.array,
+            out.elem_count);
+    *(sc_scda_ulong *) sc_array_index (esizes, zz) = out.elem_count;
+    offset += (size_t) bytes;
+  }
+  sc_array_reset (&out);
+}
+
+/** Decode one element of exactly \a size bytes.
+ * \return          0 on success and -1 on error.
+ */
+static int
+sc_scda_decode_element (char *edata, size_t esize, char *out, size_t size)
+{
+  size_t              original_size;
+  sc_array_t          in, view;
+
+  sc_array_init_data (&in, edata, 1, esize);
+  if (sc_io_decode_info (&in, &original_size, NULL, NULL) ||
+      original_size != size) {
+    return -1;
+  }
+  if (size == 0) {
+    return 0;
+  }
+  sc_array_init_data (&view, out, 1, size);
+  return sc_io_decode (&in, &view, size, NULL);
+}
+
+/** Write a raw 'B' section. */
+static int
+sc_scda_write_block_raw (sc_scda_fcontext_t * fc, const char *user_string,
+                         size_t ulen, const char *data,
+                         sc_scda_ulong block_size, int root,
+                         sc_scda_ferror_t * errcode)
+{
+  char                header[SC_SCDA_SECTION_BYTES + SC_SCDA_COUNT_BYTES];
+  sc_MPI_Offset       offset;
+
+  offset = fc->accessed_bytes;
+  if (fc->mpirank == 0) {
+    sc_scda_section_header ('B', user_string, ulen, header);
+    sc_scda_count_entry ('E', block_size, header + SC_SCDA_SECTION_BYTES);
+  }
+  if (sc_scda_write_single (fc, 0, offset, header, sizeof (header), errcode)) {
+    return -1;
+  }
+  offset += sizeof (header);
+  if (sc_scda_write_single (fc, root, offset, data, (size_t) block_size,
+                            errcode)) {
+    return -1;
+  }
+  offset += (sc_MPI_Offset) block_size;
+  if (sc_scda_write_padding (fc, offset, block_size, errcode)) {
+    return -1;
+  }
+  fc->accessed_bytes = offset + sc_scda_pad_to_mod_len (block_size);
+  return 0;
+}
+
+/** Write a raw 'V' section of contiguous local data.
+ * \param [in] sizes        The local element sizes.
+ * \param [in] proc_sizes   The byte counts of all processes.
+ */
+static int
+sc_scda_write_varray_raw (sc_scda_fcontext_t * fc, const char *user_string,
+                          size_t ulen, sc_array_t * elem_counts,
+                          const sc_scda_ulong *sizes,
+                          const sc_scda_ulong *proc_sizes, const char *data,
+                          sc_scda_ferror_t * errcode)
+{
+  int                 p, retval;
+  char                header[SC_SCDA_SECTION_BYTES + 2 * SC_SCDA_COUNT_BYTES];
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_scda_ulong       total, doffset, max_bytes;
+  sc_MPI_Offset       offset;
+  unsigned char      *le;
+
+  SC_EXECUTE_ASSERT_FALSE (sc_scda_partition (fc, elem_counts, &global,
+                                              &eoffset, &local, &max_local));
+  total = doffset = max_bytes = 0;
+  for (p = 0; p < fc->mpisize; ++p) {
+    if (p < fc->mpirank) {
+      doffset += proc_sizes[p];
+    }
+    max_bytes = SC_MAX (max_bytes, proc_sizes[p]);
+    total += proc_sizes[p];
+  }
+
+  /* section header and counts */
+  offset = fc->accessed_bytes;
+  if (fc->mpirank == 0) {
+    sc_scda_section_header ('V', user_string, ulen, header);
+    sc_scda_count_entry ('N', global, header + SC_SCDA_SECTION_BYTES);
+    sc_scda_count_entry ('E', total, header + SC_SCDA_SECTION_BYTES +
+                         SC_SCDA_COUNT_BYTES);
+  }
+  if (sc_scda_write_single (fc, 0, offset, header, sizeof (header), errcode)) {
+    return -1;
+  }
+  offset += sizeof (header);
+
+  /* element sizes in little endian byte order */
+  le = SC_ALLOC (unsigned char, 8 * local);
+  sc_scda_store_le (sizes, (size_t) local, le);
+  retval = sc_scda_io_all (fc, 1, offset + (sc_MPI_Offset) (8 * eoffset), le,
+                           (size_t) (8 * local), (size_t) (8 * max_local),
+                           errcode);
+  SC_FREE (le);
+  if (retval) {
+    return -1;
+  }
+  offset += (sc_MPI_Offset) (8 * global);
+  if (sc_scda_write_padding (fc, offset, 8 * global, errcode)) {
+    return -1;
+  }
+  offset += sc_scda_pad_to_mod_len (8 * global);
+
+  /* element data */
+  if (sc_scda_io_all (fc, 1, offset + (sc_MPI_Offset) doffset, (void *) data,
+                      (size_t) proc_sizes[fc->mpirank], (size_t) max_bytes,
+                      errcode)) {
+    return -1;
+  }
+  offset += (sc_MPI_Offset) total;
+  if (sc_scda_write_padding (fc, offset, total, errcode)) {
+    return -1;
+  }
+  fc->accessed_bytes = offset + sc_scda_pad_to_mod_len (total);
+  return 0;
+}
+
+/** Write the inline section that announces an encoded section. */
+static int
+sc_scda_write_encoding (sc_scda_fcontext_t * fc, char type,
+                        sc_scda_ulong size, sc_scda_ferror_t * errcode)
+{
+  char                section[SC_SCDA_SECTION_BYTES + SC_SCDA_INLINE_BYTES];
+
+  if (fc->mpirank == 0) {
+    sc_scda_section_header ('I', SC_SCDA_ENCODE_STRING,
+                            strlen (SC_SCDA_ENCODE_STRING), section);
+    sc_scda_count_entry (type, size, section + SC_SCDA_SECTION_BYTES);
+  }
+  if (sc_scda_write_single (fc, 0, fc->accessed_bytes, section,
+                            sizeof (section), errcode)) {
+    return -1;
+  }
+  fc->accessed_bytes += sizeof (section);
+  return 0;
+}
+
+/** Encode local elements and write them as a 'V' section. */
+static int
+sc_scda_write_encoded_elements (sc_scda_fcontext_t * fc,
+                                const char *user_string, size_t ulen,
+                                sc_array_t * elem_counts, const char *data,
+                                const sc_scda_ulong *sizes,
+                                sc_scda_ulong size,
+                                sc_scda_ferror_t * errcode)
+{
+  int                 mpiret, retval;
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_scda_ulong       local_bytes;
+  sc_array_t          esizes, edata, proc_sizes;
+
+  SC_EXECUTE_ASSERT_FALSE (sc_scda_partition (fc, elem_counts, &global,
+                                              &eoffset, &local, &max_local));
+
+  /* every process compresses its own elements */
+  sc_scda_encode_elements (data, local, sizes, size, &esizes, &edata);
+  local_bytes = edata.elem_count;
+  sc_array_init_size (&proc_sizes, sizeof (sc_scda_ulong),
+                      (size_t) fc->mpisize);
+  mpiret = sc_MPI_Allgather (&local_bytes, sizeof (sc_scda_ulong),
+                             sc_MPI_BYTE, proc_sizes.array,
+                             sizeof (sc_scda_ulong), sc_MPI_BYTE,
+                             fc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  retval = sc_scda_write_varray_raw (fc, user_string, ulen, elem_counts,
+                                     (sc_scda_ulong *) esizes.array,
+                                     (sc_scda_ulong *) proc_sizes.array,
+                                     edata.array, errcode);
+  sc_array_reset (&proc_sizes);
+  sc_array_reset (&esizes);
+  sc_array_reset (&edata);
+  return retval;
+}
+
+static sc_scda_fcontext_t *
+sc_scda_fcontext_new (sc_MPI_Comm mpicomm, int reading)
+{
+  int                 mpiret;
+  sc_scda_fcontext_t *fc;
+
+  fc = SC_ALLOC_ZERO (sc_scda_fcontext_t, 1);
+  fc->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &fc->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &fc->mpirank);
+  SC_CHECK_MPI (mpiret);
+  fc->reading = reading;
+  fc->file = sc_MPI_FILE_NULL;
+  sc_array_init (&fc->encoded_sizes, sizeof (sc_scda_ulong));
+  sc_array_init (&fc->encoded, 1);
+  return fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fopen_write (sc_MPI_Comm mpicomm, const char *filename,
+                     const char *user_string, size_t *len,
+                     sc_scda_fopen_options_t * opt,
+                     sc_scda_ferror_t * errcode)
+{
+  int                 mpiret;
+  size_t              ulen;
+  char                header[SC_SCDA_HEADER_BYTES];
+  sc_scda_fcontext_t *fc;
+
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (filename == NULL || sc_scda_check_user_string (user_string, len, &ulen)) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+    return NULL;
+  }
+
+  fc = sc_scda_fcontext_new (mpicomm, 0);
+  mpiret = sc_io_open (mpicomm, filename, SC_IO_WRITE_CREATE,
+                       opt != NULL ? opt->info : sc_MPI_INFO_NULL, &fc->file);
+  if (mpiret != sc_MPI_SUCCESS) {
+    sc_scda_set_mpi_error (errcode, mpiret);
+    sc_array_reset (&fc->encoded_sizes);
+    sc_array_reset (&fc->encoded);
+    SC_FREE (fc);
+    return NULL;
+  }
+
+  if (fc->mpirank == 0) {
+    memcpy (header, SC_SCDA_MAGIC, strlen (SC_SCDA_MAGIC));
+    sc_scda_pad_to_fix_len (SC_SCDA_VENDOR_STRING,
+                            strlen (SC_SCDA_VENDOR_STRING), header + 8,
+                            SC_SCDA_VENDOR_BYTES);
+    sc_scda_section_header ('F', user_string, ulen,
+                            header + 8 + SC_SCDA_VENDOR_BYTES);
+    sc_scda_pad_to_mod (header + SC_SCDA_HEADER_BYTES - SC_SCDA_PAD_MOD,
+                        SC_SCDA_PAD_MOD);
+  }
+  if (sc_scda_write_single (fc, 0, 0, header, SC_SCDA_HEADER_BYTES,
+                            errcode)) {
+    return sc_scda_fail (fc);
+  }
+  fc->accessed_bytes = SC_SCDA_HEADER_BYTES;
+
+  return fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fwrite_inline (sc_scda_fcontext_t * fc, const char *user_string,
+                       size_t *len, sc_array_t * inline_data, int root,
+                       sc_scda_ferror_t * errcode)
+{
+  size_t              ulen;
+  char                section[SC_SCDA_SECTION_BYTES + SC_SCDA_INLINE_BYTES];
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (sc_scda_check_user_string (user_string, len, &ulen) ||
+           root < 0 || root >= fc->mpisize ||
+           (fc->mpirank == root &&
+            (inline_data == NULL || inline_data->elem_count != 1 ||
+             inline_data->elem_size != SC_SCDA_INLINE_BYTES))) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  if (fc->reading) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  if (fc->mpirank == root) {
+    sc_scda_section_header ('I', user_string, ulen, section);
+    memcpy (section + SC_SCDA_SECTION_BYTES, inline_data->array,
+            SC_SCDA_INLINE_BYTES);
+  }
+  if (sc_scda_write_single (fc, root, fc->accessed_bytes, section,
+                            sizeof (section), errcode)) {
+    return sc_scda_fail (fc);
+  }
+  fc->accessed_bytes += sizeof (section);
+
+  return fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fwrite_block (sc_scda_fcontext_t * fc, const char *user_string,
+                      size_t *len, sc_array_t * block_data,
+                      size_t block_size, int root, int encode,
+                      sc_scda_ferror_t * errcode)
+{
+  int                 mpiret, retval;
+  size_t              ulen;
+  sc_scda_ulong       encoded_size;
+  sc_array_t          view, encoded;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (sc_scda_check_user_string (user_string, len, &ulen) ||
+           root < 0 || root >= fc->mpisize ||
+           (fc->mpirank == root &&
+            (block_data == NULL || block_data->elem_count != 1 ||
+             block_data->elem_size != block_size))) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  if (fc->reading) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  if (!encode) {
+    retval = sc_scda_write_block_raw (fc, user_string, ulen,
+                                      fc->mpirank == root ?
+                                      block_data->array : NULL, block_size,
+                                      root, errcode);
+    return retval ? sc_scda_fail (fc) : fc;
+  }
+
+  /* the root compresses the block and shares the compressed size */
+  sc_array_init (&encoded, 1);
+  encoded_size = 0;
+  if (fc->mpirank == root) {
+    sc_array_init_data (&view, block_data->array, 1, block_size);
+    sc_io_encode (&view, &encoded);
+    encoded_size = encoded.elem_count;
+  }
+  mpiret = sc_MPI_Bcast (&encoded_size, sizeof (sc_scda_ulong), sc_MPI_BYTE,
+                         root, fc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  retval = sc_scda_write_encoding (fc, 'B', block_size, errcode) ||
+    sc_scda_write_block_raw (fc, user_string, ulen, encoded.array,
+                             encoded_size, root, errcode);
+  sc_array_reset (&encoded);
+  return retval ? sc_scda_fail (fc) : fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fwrite_array (sc_scda_fcontext_t * fc, const char *user_string,
+                      size_t *len, sc_array_t * array_data,
+                      sc_array_t * elem_counts, size_t elem_size,
+                      int indirect, int encode, sc_scda_ferror_t * errcode)
+{
+  int                 retval;
+  size_t              ulen;
+  char                header[SC_SCDA_SECTION_BYTES + 2 * SC_SCDA_COUNT_BYTES];
+  const char         *data;
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_MPI_Offset       offset;
+  sc_array_t          buffer;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (sc_scda_check_user_string (user_string, len, &ulen) ||
+           sc_scda_partition (fc, elem_counts, &global, &eoffset,
+                              &local, &max_local) ||
+           (elem_size > 0 && global > UINT64_MAX / elem_size) ||
+           array_data == NULL ||
+           (indirect ? sc_scda_check_indirect (array_data, local, NULL,
+                                               elem_size) :
+            (array_data->elem_count != local ||
+             array_data->elem_size != elem_size))) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  if (fc->reading) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  sc_array_init (&buffer, 1);
+  data = indirect ? sc_scda_gather_indirect (array_data, &buffer) :
+    array_data->array;
+  if (encode) {
+    retval = sc_scda_write_encoding (fc, 'A', elem_size, errcode) ||
+      sc_scda_write_encoded_elements (fc, user_string, ulen, elem_counts,
+                                      data, NULL, elem_size, errcode);
+    sc_array_reset (&buffer);
+    return retval ? sc_scda_fail (fc) : fc;
+  }
+
+  /* section header and counts */
+  offset = fc->accessed_bytes;
+  if (fc->mpirank == 0) {
+    sc_scda_section_header ('A', user_string, ulen, header);
+    sc_scda_count_entry ('N', global, header + SC_SCDA_SECTION_BYTES);
+    sc_scda_count_entry ('E', elem_size, header + SC_SCDA_SECTION_BYTES +
+                         SC_SCDA_COUNT_BYTES);
+  }
+  retval = sc_scda_write_single (fc, 0, offset, header, sizeof (header),
+                                 errcode);
+  offset += sizeof (header);
+
+  /* each process writes its partition in one call */
+  if (!retval) {
+    retval = sc_scda_io_all (fc, 1, offset +
+                             (sc_MPI_Offset) (eoffset * elem_size),
+                             (void *) data, (size_t) (local * elem_size),
+                             (size_t) (max_local * elem_size), errcode);
+  }
+  sc_array_reset (&buffer);
+  offset += (sc_MPI_Offset) (global * elem_size);
+  if (retval || sc_scda_write_padding (fc, offset, global * elem_size,
+                                       errcode)) {
+    return sc_scda_fail (fc);
+  }
+  fc->accessed_bytes = offset + sc_scda_pad_to_mod_len (global * elem_size);
+
+  return fc;
+}
+
+int
+sc_scda_proc_sizes (sc_scda_fcontext_t * fc, sc_array_t * elem_sizes,
+                    sc_array_t * elem_counts, sc_array_t * proc_sizes,
+                    sc_scda_ferror_t * errcode)
+{
+  int                 mpiret;
+  size_t              zz;
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_scda_ulong       local_bytes;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  local_bytes = 0;
+  if (proc_sizes == NULL ||
+      proc_sizes->elem_size != sizeof (sc_scda_ulong) ||
+      sc_scda_partition (fc, elem_counts, &global, &eoffset,
+                         &local, &max_local) ||
+      elem_sizes == NULL || elem_sizes->elem_size != sizeof (sc_scda_ulong)
+      || elem_sizes->elem_count != local) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  else {
+    for (zz = 0; zz < elem_sizes->elem_count; ++zz) {
+      local_bytes += *(sc_scda_ulong *) sc_array_index (elem_sizes, zz);
+    }
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return -1;
+  }
+
+  sc_array_resize (proc_sizes, (size_t) fc->mpisize);
+  mpiret = sc_MPI_Allgather (&local_bytes, sizeof (sc_scda_ulong),
+                             sc_MPI_BYTE, proc_sizes->array,
+                             sizeof (sc_scda_ulong), sc_MPI_BYTE,
+                             fc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fwrite_varray (sc_scda_fcontext_t * fc, const char *user_string,
+                       size_t *len, sc_array_t * array_data,
+                       sc_array_t * elem_counts, sc_array_t * elem_sizes,
+                       sc_array_t * proc_sizes, int indirect, int encode,
+                       sc_scda_ferror_t * errcode)
+{
+  int                 retval;
+  size_t              ulen, zz;
+  const char         *data;
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_scda_ulong       local_bytes, total;
+  sc_array_t          buffer;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (sc_scda_check_user_string (user_string, len, &ulen) ||
+           sc_scda_partition (fc, elem_counts, &global, &eoffset,
+                              &local, &max_local) ||
+           proc_sizes == NULL ||
+           proc_sizes->elem_size != sizeof (sc_scda_ulong) ||
+           proc_sizes->elem_count != (size_t) fc->mpisize ||
+           elem_sizes == NULL ||
+           elem_sizes->elem_size != sizeof (sc_scda_ulong) ||
+           elem_sizes->elem_count != local || array_data == NULL) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  else {
+    local_bytes = 0;
+    for (zz = 0; zz < local; ++zz) {
+      local_bytes += *(sc_scda_ulong *) sc_array_index (elem_sizes, zz);
+    }
+    total = 0;
+    for (zz = 0; zz < proc_sizes->elem_count; ++zz) {
+      total += *(sc_scda_ulong *) sc_array_index (proc_sizes, zz);
+    }
+    if (local_bytes != *(sc_scda_ulong *)
+        sc_array_index_int (proc_sizes, fc->mpirank) || total < local_bytes ||
+        (indirect ? sc_scda_check_indirect (array_data, local,
+                                            (sc_scda_ulong *)
+                                            elem_sizes->array, 0) :
+         !sc_scda_is_block (array_data, local_bytes))) {
+      sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+    }
+  }
+  if (fc->reading) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  sc_array_init (&buffer, 1);
+  data = indirect ? sc_scda_gather_indirect (array_data, &buffer) :
+    array_data->array;
+  if (encode) {
+    total = 0;
+    for (zz = 0; zz < proc_sizes->elem_count; ++zz) {
+      total += *(sc_scda_ulong *) sc_array_index (proc_sizes, zz);
+    }
+    retval = sc_scda_write_encoding (fc, 'V', total, errcode) ||
+      sc_scda_write_encoded_elements (fc, user_string, ulen, elem_counts,
+                                      data, (sc_scda_ulong *)
+                                      elem_sizes->array, 0, errcode);
+  }
+  else {
+    retval = sc_scda_write_varray_raw (fc, user_string, ulen, elem_counts,
+                                       (sc_scda_ulong *) elem_sizes->array,
+                                       (sc_scda_ulong *) proc_sizes->array,
+                                       data, errcode);
+  }
+  sc_array_reset (&buffer);
+
+  return retval ? sc_scda_fail (fc) : fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fopen_read (sc_MPI_Comm mpicomm, const char *filename,
+                    char *user_string, size_t *len,
+                    sc_scda_fopen_options_t * opt,
+                    sc_scda_ferror_t * errcode)
+{
+  int                 mpiret;
+  size_t              obytes, vlen;
+  char                header[SC_SCDA_HEADER_BYTES];
+  char                vendor[SC_SCDA_VENDOR_BYTES];
+  char                pad[SC_SCDA_PAD_MOD];
+  sc_scda_fcontext_t *fc;
+
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (filename == NULL || user_string == NULL || len == NULL) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+    return NULL;
+  }
+
+  fc = sc_scda_fcontext_new (mpicomm, 1);
+  mpiret = sc_io_open (mpicomm, filename, SC_IO_READ,
+                       opt != NULL ? opt->info : sc_MPI_INFO_NULL, &fc->file);
+  if (mpiret != sc_MPI_SUCCESS) {
+    sc_scda_set_mpi_error (errcode, mpiret);
+    sc_array_reset (&fc->encoded_sizes);
+    sc_array_reset (&fc->encoded);
+    SC_FREE (fc);
+    return NULL;
+  }
+
+  if (sc_scda_read_bcast (fc, 0, header, SC_SCDA_HEADER_BYTES, &obytes,
+                          errcode)) {
+    return sc_scda_fail (fc);
+  }
+  if (obytes != SC_SCDA_HEADER_BYTES) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_COUNT);
+    return sc_scda_fail (fc);
+  }
+
+  /* all processes parse the same bytes */
+  sc_scda_pad_to_mod (pad, SC_SCDA_PAD_MOD);
+  if (memcmp (header, SC_SCDA_MAGIC, strlen (SC_SCDA_MAGIC)) ||
+      sc_scda_get_fix_len (header + 8, SC_SCDA_VENDOR_BYTES, vendor, &vlen) ||
+      header[8 + SC_SCDA_VENDOR_BYTES] != 'F' ||
+      header[9 + SC_SCDA_VENDOR_BYTES] != ' ' ||
+      sc_scda_get_fix_len (header + 10 + SC_SCDA_VENDOR_BYTES,
+                           SC_SCDA_USER_FIELD_BYTES, user_string, len) ||
+      memcmp (header + SC_SCDA_HEADER_BYTES - SC_SCDA_PAD_MOD, pad,
+              SC_SCDA_PAD_MOD)) {
+    SC_LERRORF ("File header of %s does not conform to scda\n", filename);
+    sc_scda_set_error (errcode, SC_SCDA_FERR_FORMAT);
+    return sc_scda_fail (fc);
+  }
+  fc->accessed_bytes = SC_SCDA_HEADER_BYTES;
+
+  return fc;
+}
+
+/** Read and parse the raw section header at the current file position.
+ * On success, the raw type, counts and data offset are stored in \a fc.
+ * \param [out] inline_data     If not NULL and the section is of type 'I',
+ *                              receives its \ref SC_SCDA_INLINE_BYTES bytes.
+ */
+static int
+sc_scda_read_section (sc_scda_fcontext_t * fc, char *user_string,
+                      size_t *len, char *inline_data,
+                      sc_scda_ferror_t * errcode)
+{
+  int                 entries;
+  size_t              obytes, need;
+  char                buf[SC_SCDA_SECTION_BYTES + 2 * SC_SCDA_COUNT_BYTES];
+  const char         *pos;
+
+  if (sc_scda_read_bcast (fc, fc->accessed_bytes, buf, sizeof (buf),
+                          &obytes, errcode)) {
+    return -1;
+  }
+  if (obytes < SC_SCDA_SECTION_BYTES) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_COUNT);
+    return -1;
+  }
+
+  fc->section = buf[0];
+  fc->elem_count = fc->elem_size = 0;
+  switch (fc->section) {
+  case 'I':
+  case 'B':
+    entries = 1;
+    break;
+  case 'A':
+  case 'V':
+    entries = 2;
+    break;
+  default:
+    sc_scda_set_error (errcode, SC_SCDA_FERR_FORMAT);
+    return -1;
+  }
+  need = SC_SCDA_SECTION_BYTES + entries * SC_SCDA_COUNT_BYTES;
+  if (obytes < need) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_COUNT);
+    return -1;
+  }
+  pos = buf + SC_SCDA_SECTION_BYTES;
+  if (buf[1] != ' ' ||
+      sc_scda_get_fix_len (buf + 2, SC_SCDA_USER_FIELD_BYTES,
+                           user_string, len) ||
+      (fc->section == 'B' &&
+       sc_scda_parse_count (pos, 'E', NULL, &fc->elem_size)) ||
+      ((fc->section == 'A' || fc->section == 'V') &&
+       (sc_scda_parse_count (pos, 'N', NULL, &fc->elem_count) ||
+        sc_scda_parse_count (pos + SC_SCDA_COUNT_BYTES, 'E', NULL,
+                             &fc->elem_size)))) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_FORMAT);
+    return -1;
+  }
+  if (fc->section == 'A' && fc->elem_size > 0 &&
+      fc->elem_count > UINT64_MAX / fc->elem_size) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_FORMAT);
+    return -1;
+  }
+  if (fc->section == 'I') {
+    if (inline_data != NULL) {
+      memcpy (inline_data, pos, SC_SCDA_INLINE_BYTES);
+    }
+    fc->data_offset = fc->accessed_bytes + SC_SCDA_SECTION_BYTES;
+  }
+  else {
+    fc->data_offset = fc->accessed_bytes + (sc_MPI_Offset) need;
+  }
+  return 0;
+}
+
+/** Move past the pending section and reset the reading state. */
+static void
+sc_scda_section_done (sc_scda_fcontext_t * fc, sc_MPI_Offset end)
+{
+  fc->accessed_bytes = end;
+  fc->section = '\0';
+  fc->type = '\0';
+  fc->decode = 0;
+  fc->vsizes_read = 0;
+  fc->have_encoded = 0;
+  sc_array_reset (&fc->encoded_sizes);
+  sc_array_reset (&fc->encoded);
+}
+
+/** Return the offset of the data of the pending 'V' section. */
+static sc_MPI_Offset
+sc_scda_varray_data_offset (sc_scda_fcontext_t * fc)
+{
+  return fc->data_offset + (sc_MPI_Offset) (8 * fc->elem_count +
+                                            sc_scda_pad_to_mod_len
+                                            (8 * fc->elem_count));
+}
+
+/** Return the offset behind the pending 'V' section. */
+static sc_MPI_Offset
+sc_scda_varray_end (sc_scda_fcontext_t * fc)
+{
+  return sc_scda_varray_data_offset (fc) +
+    (sc_MPI_Offset) (fc->elem_size + sc_scda_pad_to_mod_len (fc->elem_size));
+}
+
+sc_scda_fcontext_t *
+sc_scda_fread_section_header (sc_scda_fcontext_t * fc, char *user_string,
+                              size_t *len, char *type, size_t *elem_count,
+                              size_t *elem_size, int *decode,
+                              sc_scda_ferror_t * errcode)
+{
+  int                 encoded;
+  char                inline_data[SC_SCDA_INLINE_BYTES];
+  char                orig_type;
+  sc_scda_ulong       orig_size;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (!fc->reading || fc->section != '\0') {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+    return sc_scda_fail (fc);
+  }
+  if (user_string == NULL || len == NULL || type == NULL ||
+      elem_count == NULL || elem_size == NULL || decode == NULL) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+    return sc_scda_fail (fc);
+  }
+
+  if (sc_scda_read_section (fc, user_string, len, inline_data, errcode)) {
+    return sc_scda_fail (fc);
+  }
+  encoded = *decode && fc->section == 'I' &&
+    *len == strlen (SC_SCDA_ENCODE_STRING) &&
+    !memcmp (user_string, SC_SCDA_ENCODE_STRING, *len);
+  fc->decode = 0;
+  fc->type = fc->section;
+  if (encoded) {
+    /* the encoding section announces the original type and size */
+    if (sc_scda_parse_count (inline_data, '\0', &orig_type, &orig_size) ||
+        (orig_type != 'B' && orig_type != 'A' && orig_type != 'V')) {
+      sc_scda_set_error (errcode, SC_SCDA_FERR_DECODE);
+      return sc_scda_fail (fc);
+    }
+    fc->accessed_bytes = fc->data_offset + SC_SCDA_INLINE_BYTES;
+    if (sc_scda_read_section (fc, user_string, len, NULL, errcode)) {
+      return sc_scda_fail (fc);
+    }
+    if (fc->section != (orig_type == 'B' ? 'B' : 'V')) {
+      sc_scda_set_error (errcode, SC_SCDA_FERR_DECODE);
+      return sc_scda_fail (fc);
+    }
+    fc->decode = 1;
+    fc->type = orig_type;
+    fc->decoded_size = orig_size;
+  }
+
+  *type = fc->type;
+  *elem_count = 0;
+  *elem_size = 0;
+  switch (fc->type) {
+  case 'B':
+    *elem_size = (size_t) (fc->decode ? fc->decoded_size : fc->elem_size);
+    break;
+  case 'A':
+    *elem_count = (size_t) fc->elem_count;
+    *elem_size = (size_t) (fc->decode ? fc->decoded_size : fc->elem_size);
+    break;
+  case 'V':
+    *elem_count = (size_t) fc->elem_count;
+    break;
+  }
+  *decode = fc->decode;
+
+  return fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fread_inline_data (sc_scda_fcontext_t * fc, sc_array_t * data,
+                           int root, sc_scda_ferror_t * errcode)
+{
+  int                 skip;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (!fc->reading || fc->type != 'I') {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+    return sc_scda_fail (fc);
+  }
+  skip = data == NULL;
+  if (root < 0 || root >= fc->mpisize ||
+      (fc->mpirank == root && !skip &&
+       (data->elem_count != 1 || data->elem_size != SC_SCDA_INLINE_BYTES))) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  if (sc_scda_io_all (fc, 0, fc->data_offset,
+                      fc->mpirank == root && !skip ? data->array : NULL,
+                      fc->mpirank == root && !skip ?
+                      SC_SCDA_INLINE_BYTES : 0, SC_SCDA_INLINE_BYTES,
+                      errcode)) {
+    return sc_scda_fail (fc);
+  }
+  sc_scda_section_done (fc, fc->data_offset + SC_SCDA_INLINE_BYTES);
+
+  return fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fread_block_data (sc_scda_fcontext_t * fc, sc_array_t * block_data,
+                          size_t block_size, int root,
+                          sc_scda_ferror_t * errcode)
+{
+  int                 active, retval;
+  sc_array_t          encoded;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (!fc->reading || fc->type != 'B') {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+    return sc_scda_fail (fc);
+  }
+  active = fc->mpirank == root && block_data != NULL;
+  if (root < 0 || root >= fc->mpisize ||
+      block_size != (fc->decode ? fc->decoded_size : fc->elem_size) ||
+      (active && (block_data->elem_count != 1 ||
+                  block_data->elem_size != block_size))) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  if (!fc->decode) {
+    if (sc_scda_io_all (fc, 0, fc->data_offset,
+                        active ? block_data->array : NULL,
+                        active ? block_size : 0, block_size, errcode)) {
+      return sc_scda_fail (fc);
+    }
+  }
+  else {
+    /* the root reads the compressed block and decodes it */
+    sc_array_init_size (&encoded, 1, active ? (size_t) fc->elem_size : 0);
+    retval = sc_scda_io_all (fc, 0, fc->data_offset, encoded.array,
+                             encoded.elem_count, (size_t) fc->elem_size,
+                             errcode);
+    if (!retval) {
+      if (active && sc_scda_decode_element (encoded.array, encoded.elem_count,
+                                            block_data->array, block_size)) {
+        sc_scda_set_error (errcode, SC_SCDA_FERR_DECODE);
+      }
+      retval = sc_scda_sync_error (fc, errcode);
+    }
+    sc_array_reset (&encoded);
+    if (retval) {
+      return sc_scda_fail (fc);
+    }
+  }
+  sc_scda_section_done (fc, fc->data_offset +
+                        (sc_MPI_Offset) (fc->elem_size +
+                                         sc_scda_pad_to_mod_len
+                                         (fc->elem_size)));
+
+  return fc;
+}
+
+/** Read the local raw element sizes of the pending 'V' section.
+ * \param [out] sizes   Local element sizes or NULL to skip reading.
+ */
+static int
+sc_scda_read_vsizes (sc_scda_fcontext_t * fc, sc_scda_ulong eoffset,
+                     sc_scda_ulong local, sc_scda_ulong max_local,
+                     sc_scda_ulong *sizes, sc_scda_ferror_t * errcode)
+{
+  int                 retval;
+  unsigned char      *le;
+
+  le = SC_ALLOC (unsigned char, sizes != NULL ? 8 * local : 0);
+  retval = sc_scda_io_all (fc, 0, fc->data_offset +
+                           (sc_MPI_Offset) (8 * eoffset), le,
+                           sizes != NULL ? (size_t) (8 * local) : 0,
+                           (size_t) (8 * max_local), errcode);
+  if (!retval && sizes != NULL) {
+    sc_scda_load_le (le, (size_t) local, sizes);
+  }
+  SC_FREE (le);
+  return retval;
+}
+
+/** Read the local encoded elements of the pending 'V' section into \a fc.
+ * The encoded data offsets are computed from the local byte counts.
+ */
+static int
+sc_scda_read_encoded (sc_scda_fcontext_t * fc, sc_array_t * elem_counts,
+                      sc_scda_ferror_t * errcode)
+{
+  int                 mpiret, p;
+  size_t              zz;
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_scda_ulong       local_bytes, doffset, max_bytes;
+  sc_array_t          proc_bytes;
+
+  SC_EXECUTE_ASSERT_FALSE (sc_scda_partition (fc, elem_counts, &global,
+                                              &eoffset, &local, &max_local));
+  sc_array_resize (&fc->encoded_sizes, (size_t) local);
+  if (sc_scda_read_vsizes (fc, eoffset, local, max_local,
+                           (sc_scda_ulong *) fc->encoded_sizes.array,
+                           errcode)) {
+    return -1;
+  }
+  local_bytes = 0;
+  for (zz = 0; zz < local; ++zz) {
+    local_bytes += *(sc_scda_ulong *) sc_array_index (&fc->encoded_sizes, zz);
+  }
+
+  sc_array_init_size (&proc_bytes, sizeof (sc_scda_ulong),
+                      (size_t) fc->mpisize);
+  mpiret = sc_MPI_Allgather (&local_bytes, sizeof (sc_scda_ulong),
+                             sc_MPI_BYTE, proc_bytes.array,
+                             sizeof (sc_scda_ulong), sc_MPI_BYTE,
+                             fc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  doffset = max_bytes = 0;
+  for (p = 0; p < fc->mpisize; ++p) {
+    if (p < fc->mpirank) {
+      doffset += *(sc_scda_ulong *) sc_array_index_int (&proc_bytes, p);
+    }
+    max_bytes = SC_MAX (max_bytes,
+                        *(sc_scda_ulong *) sc_array_index_int (&proc_bytes,
+                                                               p));
+  }
+  sc_array_reset (&proc_bytes);
+
+  sc_array_resize (&fc->encoded, (size_t) local_bytes);
+  if (sc_scda_io_all (fc, 0, sc_scda_varray_data_offset (fc) +
+                      (sc_MPI_Offset) doffset, fc->encoded.array,
+                      (size_t) local_bytes, (size_t) max_bytes, errcode)) {
+    return -1;
+  }
+  fc->have_encoded = 1;
+  return 0;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fread_array_data (sc_scda_fcontext_t * fc, sc_array_t * array_data,
+                          sc_array_t * elem_counts, size_t elem_size,
+                          int indirect, sc_scda_ferror_t * errcode)
+{
+  int                 retval;
+  size_t              zz, eoffs;
+  char               *data;
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_scda_ulong       esize;
+  sc_array_t          buffer;
+  sc_MPI_Offset       end;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (!fc->reading || fc->type != 'A') {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+    return sc_scda_fail (fc);
+  }
+  if (sc_scda_partition (fc, elem_counts, &global, &eoffset,
+                         &local, &max_local) || global != fc->elem_count ||
+      elem_size != (fc->decode ? fc->decoded_size : fc->elem_size) ||
+      (array_data != NULL &&
+       (indirect ? sc_scda_check_indirect (array_data, local, NULL,
+                                           elem_size) :
+        (array_data->elem_count != local ||
+         array_data->elem_size != elem_size)))) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  sc_array_init (&buffer, 1);
+  if (!fc->decode) {
+    if (array_data == NULL) {
+      data = NULL;
+      local = 0;
+    }
+    else if (indirect) {
+      sc_array_resize (&buffer, (size_t) (local * elem_size));
+      data = buffer.array;
+    }
+    else {
+      data = array_data->array;
+    }
+    retval = sc_scda_io_all (fc, 0, fc->data_offset +
+                             (sc_MPI_Offset) (eoffset * elem_size), data,
+                             (size_t) (local * elem_size),
+                             (size_t) (max_local * elem_size), errcode);
+    if (!retval && array_data != NULL && indirect) {
+      sc_scda_scatter_indirect (buffer.array, array_data);
+    }
+    end = fc->data_offset + (sc_MPI_Offset)
+      (global * elem_size + sc_scda_pad_to_mod_len (global * elem_size));
+  }
+  else {
+    /* every process decodes its own elements */
+    retval = sc_scda_read_encoded (fc, elem_counts, errcode);
+    if (!retval && array_data != NULL) {
+      for (eoffs = 0, zz = 0; zz < local; ++zz) {
+        data = indirect ? ((sc_array_t *) sc_array_index (array_data,
+                                                          zz))->array :
+          array_data->array + zz * elem_size;
+        esize = *(sc_scda_ulong *) sc_array_index (&fc->encoded_sizes, zz);
+        if (sc_scda_decode_element (fc->encoded.array + eoffs,
+                                    (size_t) esize, data, elem_size)) {
+          sc_scda_set_error (errcode, SC_SCDA_FERR_DECODE);
+          break;
+        }
+        eoffs += (size_t) esize;
+      }
+    }
+    if (!retval) {
+      retval = sc_scda_sync_error (fc, errcode);
+    }
+    end = sc_scda_varray_end (fc);
+  }
+  sc_array_reset (&buffer);
+  if (retval) {
+    return sc_scda_fail (fc);
+  }
+  sc_scda_section_done (fc, end);
+
+  return fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fread_varray_sizes (sc_scda_fcontext_t * fc, sc_array_t * elem_sizes,
+                            sc_array_t * elem_counts,
+                            sc_scda_ferror_t * errcode)
+{
+  size_t              zz, eoffs, original_size;
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_scda_ulong       esize;
+  sc_array_t          view;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (!fc->reading || fc->type != 'V' || fc->vsizes_read) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+    return sc_scda_fail (fc);
+  }
+  if (sc_scda_partition (fc, elem_counts, &global, &eoffset,
+                         &local, &max_local) || global != fc->elem_count ||
+      (elem_sizes != NULL &&
+       (elem_sizes->elem_size != sizeof (sc_scda_ulong) ||
+        elem_sizes->elem_count != local))) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  if (!fc->decode) {
+    if (sc_scda_read_vsizes (fc, eoffset, local, max_local,
+                             elem_sizes != NULL ?
+                             (sc_scda_ulong *) elem_sizes->array : NULL,
+                             errcode)) {
+      return sc_scda_fail (fc);
+    }
+  }
+  else {
+    /* the encoded elements are cached for reading the data */
+    if (sc_scda_read_encoded (fc, elem_counts, errcode)) {
+      return sc_scda_fail (fc);
+    }
+    if (elem_sizes != NULL) {
+      for (eoffs = 0, zz = 0; zz < local; ++zz) {
+        esize = *(sc_scda_ulong *) sc_array_index (&fc->encoded_sizes, zz);
+        sc_array_init_data (&view, fc->encoded.array + eoffs, 1,
+                            (size_t) esize);
+        if (sc_io_decode_info (&view, &original_size, NULL, NULL)) {
+          sc_scda_set_error (errcode, SC_SCDA_FERR_DECODE);
+          break;
+        }
+        *(sc_scda_ulong *) sc_array_index (elem_sizes, zz) = original_size;
+        eoffs += (size_t) esize;
+      }
+    }
+    if (sc_scda_sync_error (fc, errcode)) {
+      return sc_scda_fail (fc);
+    }
+  }
+  fc->vsizes_read = 1;
+
+  return fc;
+}
+
+sc_scda_fcontext_t *
+sc_scda_fread_varray_data (sc_scda_fcontext_t * fc, sc_array_t * array_data,
+                           sc_array_t * elem_counts, sc_array_t * elem_sizes,
+                           sc_array_t * proc_sizes, int indirect,
+                           sc_scda_ferror_t * errcode)
+{
+  int                 p, retval;
+  size_t              zz, eoffs, doffs;
+  char               *data;
+  sc_scda_ulong       global, eoffset, local, max_local;
+  sc_scda_ulong       doffset, max_bytes, total, bytes, esize, size;
+  sc_array_t          buffer;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  if (!fc->reading || fc->type != 'V' || !fc->vsizes_read) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_USAGE);
+    return sc_scda_fail (fc);
+  }
+  doffset = max_bytes = total = bytes = 0;
+  if (sc_scda_partition (fc, elem_counts, &global, &eoffset,
+                         &local, &max_local) || global != fc->elem_count ||
+      proc_sizes == NULL ||
+      proc_sizes->elem_size != sizeof (sc_scda_ulong) ||
+      proc_sizes->elem_count != (size_t) fc->mpisize) {
+    sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+  }
+  else {
+    for (p = 0; p < fc->mpisize; ++p) {
+      size = *(sc_scda_ulong *) sc_array_index_int (proc_sizes, p);
+      if (p < fc->mpirank) {
+        doffset += size;
+      }
+      else if (p == fc->mpirank) {
+        bytes = size;
+      }
+      max_bytes = SC_MAX (max_bytes, size);
+      total += size;
+    }
+    if (total != (fc->decode ? fc->decoded_size : fc->elem_size) ||
+        (array_data != NULL &&
+         (elem_sizes == NULL ||
+          elem_sizes->elem_size != sizeof (sc_scda_ulong) ||
+          elem_sizes->elem_count != local ||
+          (fc->decode && !fc->have_encoded) ||
+          (indirect ? sc_scda_check_indirect (array_data, local,
+                                              (sc_scda_ulong *)
+                                              elem_sizes->array, 0) :
+           !sc_scda_is_block (array_data, bytes))))) {
+      sc_scda_set_error (errcode, SC_SCDA_FERR_ARG);
+    }
+  }
+  if (sc_scda_sync_error (fc, errcode)) {
+    return sc_scda_fail (fc);
+  }
+
+  sc_array_init (&buffer, 1);
+  if (!fc->decode) {
+    if (array_data == NULL) {
+      data = NULL;
+      bytes = 0;
+    }
+    else if (indirect) {
+      sc_array_resize (&buffer, (size_t) bytes);
+      data = buffer.array;
+    }
+    else {
+      data = array_data->array;
+    }
+    retval = sc_scda_io_all (fc, 0, sc_scda_varray_data_offset (fc) +
+                             (sc_MPI_Offset) doffset, data, (size_t) bytes,
+                             (size_t) max_bytes, errcode);
+    if (!retval && array_data != NULL && indirect) {
+      sc_scda_scatter_indirect (buffer.array, array_data);
+    }
+  }
+  else {
+    /* decode the elements cached by reading the sizes */
+    if (array_data != NULL) {
+      for (eoffs = doffs = 0, zz = 0; zz < local; ++zz) {
+        size = *(sc_scda_ulong *) sc_array_index (elem_sizes, zz);
+        data = indirect ? ((sc_array_t *) sc_array_index (array_data,
+                                                          zz))->array :
+          array_data->array + doffs;
+        esize = *(sc_scda_ulong *) sc_array_index (&fc->encoded_sizes, zz);
+        if (sc_scda_decode_element (fc->encoded.array + eoffs,
+                                    (size_t) esize, data, (size_t) size)) {
+          sc_scda_set_error (errcode, SC_SCDA_FERR_DECODE);
+          break;
+        }
+        eoffs += (size_t) esize;
+        doffs += (size_t) size;
+      }
+    }
+    retval = sc_scda_sync_error (fc, errcode);
+  }
+  sc_array_reset (&buffer);
+  if (retval) {
+    return sc_scda_fail (fc);
+  }
+  sc_scda_section_done (fc, sc_scda_varray_end (fc));
+
+  return fc;
+}
+
+int
+sc_scda_ferror_class (sc_scda_ferror_t errcode, sc_scda_ferror_t * errclass)
+{
+  int                 mpiret;
+
+  if (errclass == NULL ||
+      (errcode.scdaret == SC_SCDA_FERR_MPI) ==
+      (errcode.mpiret == sc_MPI_SUCCESS)) {
+    return SC_SCDA_FERR_ARG;
+  }
+
+  *errclass = errcode;
+  if (errcode.scdaret == SC_SCDA_FERR_MPI) {
+    mpiret = sc_MPI_Error_class (errcode.mpiret, &errclass->mpiret);
+    if (mpiret != sc_MPI_SUCCESS) {
+      return SC_SCDA_FERR_ARG;
+    }
+  }
+  return SC_SCDA_FERR_SUCCESS;
+}
+
+int
+sc_scda_ferror_string (sc_scda_ferror_t errcode, char *str, int *len)
+{
+  int                 mpiret;
+  const char         *tstr;
+
+  if (str == NULL || len == NULL ||
+      (errcode.scdaret == SC_SCDA_FERR_MPI) ==
+      (errcode.mpiret == sc_MPI_SUCCESS)) {
+    return SC_SCDA_FERR_ARG;
+  }
+
+  switch (errcode.scdaret) {
+  case SC_SCDA_FERR_SUCCESS:
+    tstr = "Success";
+    break;
+  case SC_SCDA_FERR_FORMAT:
+    tstr = "File not conforming to the scda format";
+    break;
+  case SC_SCDA_FERR_USAGE:
+    tstr = "Incorrect workflow of scda functions";
+    break;
+  case SC_SCDA_FERR_DECODE:
+    tstr = "Section does not conform to the scda encoding convention";
+    break;
+  case SC_SCDA_FERR_ARG:
+    tstr = "Invalid argument to an scda function";
+    break;
+  case SC_SCDA_FERR_COUNT:
+    tstr = "Byte count error on scda I/O";
+    break;
+  case SC_SCDA_FERR_MPI:
+    mpiret = sc_MPI_Error_string (errcode.mpiret, str, len);
+    return mpiret == sc_MPI_SUCCESS ? SC_SCDA_FERR_SUCCESS : SC_SCDA_FERR_ARG;
+  default:
+    return SC_SCDA_FERR_ARG;
+  }
+  *len = snprintf (str, sc_MPI_MAX_ERROR_STRING, "%s", tstr);
+  return SC_SCDA_FERR_SUCCESS;
+}
+
+int
+sc_scda_fclose (sc_scda_fcontext_t * fc, sc_scda_ferror_t * errcode)
+{
+  int                 mpiret;
+
+  SC_ASSERT (fc != NULL);
+  SC_ASSERT (errcode != NULL);
+  sc_scda_set_error (errcode, SC_SCDA_FERR_SUCCESS);
+
+  mpiret = sc_io_close (&fc->file);
+  if (mpiret != sc_MPI_SUCCESS) {
+    sc_scda_set_mpi_error (errcode, mpiret);
+  }
+  sc_array_reset (&fc->encoded_sizes);
+  sc_array_reset (&fc->encoded);
+  SC_FREE (fc);
+
+  return errcode->scdaret == SC_SCDA_FERR_SUCCESS ? 0 : -1;
+}
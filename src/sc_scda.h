@@ -531,8 +531,12 @@ sc_scda_fcontext_t *sc_scda_fwrite_array (sc_scda_fcontext_t * fc,
  * \ref sc_scda_fwrite_varray given \b elem_sizes and \b elem_counts as passed
  * to \ref sc_scda_fwrite_varray.
  * \note
- * All parameters are collective.
+ * All parameters except of \b elem_sizes are collective.
  *
+ * \param [in]    fc            File context previously opened by \ref
+ *                              sc_scda_fopen_write or \ref sc_scda_fopen_read.
+ *                              It provides the MPI communicator and is not
+ *                              modified.
  * \param [in]    elem_sizes    The \b elem_sizes array as retrieved by \ref
  *                              sc_scda_fread_varray_sizes or passed to \ref
  *                              sc_scda_fwrite_varray.
@@ -548,7 +552,8 @@ sc_scda_fcontext_t *sc_scda_fwrite_array (sc_scda_fcontext_t * fc,
  *                              by \ref sc_scda_ferror_class.
  * \return                      0 in case of success and -1 otherwise.
  */
-int                 sc_scda_proc_sizes (sc_array_t * elem_sizes,
+int                 sc_scda_proc_sizes (sc_scda_fcontext_t * fc,
+                                        sc_array_t * elem_sizes,
                                         sc_array_t * elem_counts,
                                         sc_array_t * proc_sizes,
                                         sc_scda_ferror_t * errcode);
@@ -579,6 +584,8 @@ int                 sc_scda_proc_sizes (sc_array_t * elem_sizes,
  *                              \b proc_sizes. The data of the array must be the
  *                              local array elements conforming with
  *                              \b elem_counts, \b proc_sizes and \b elem_sizes.
+ *                              If the p-th entry of \b proc_sizes is zero,
+ *                              an array of element count 0 is accepted.
  *                              If \b indirect is true, \b array_data must be
  *                              a sc_array with element count equal to the p-th
  *                              array entry of \b elem_counts and element size
@@ -966,6 +973,8 @@ sc_scda_fcontext_t *sc_scda_fread_varray_sizes (sc_scda_fcontext_t * fc,
  *                              is set to the local array elements conforming
  *                              with \b elem_counts, \b proc_sizes and
  *                              \b elem_sizes.
+ *                              If the p-th entry of \b proc_sizes is zero,
+ *                              an array of element count 0 is accepted.
  *                              If \b indirect is true, \b array_data must be
  *                              a sc_array with element count equal to the p-th
  *                              array entry of \b elem_counts and element size
@@ -671,6 +671,21 @@ sc_shmem_write_end_window (void *array, sc_MPI_Comm comm,
 
 #endif /* SC_ENABLE_MPIWINSHARED */
 
+int
+sc_shmem_is_shared (sc_MPI_Comm comm)
+{
+  sc_shmem_type_t     type;
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL, internode =
+    sc_MPI_COMM_NULL;
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
+    return 0;
+  }
+  type = sc_shmem_get_type_default (comm);
+  return type != SC_SHMEM_BASIC && type != SC_SHMEM_PRESCAN;
+}
+
 void               *
 sc_shmem_malloc (int package, size_t elem_size, size_t elem_count,
                  sc_MPI_Comm comm)
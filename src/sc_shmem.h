@@ -75,6 +75,17 @@ void                sc_shmem_set_type (sc_MPI_Comm comm,
  */
 sc_shmem_type_t     sc_shmem_get_type (sc_MPI_Comm comm);
 
+/** Query whether shmem arrays on this communicator are shared in memory by
+ * the processes of each node.  This requires node communicators attached
+ * by \ref sc_mpi_comm_attach_node_comms and a shared type such as
+ * SC_SHMEM_WINDOW.  Otherwise each process holds a private copy.
+ *
+ * \param[in] comm        the mpi communicator
+ *
+ * \return true if only the node root writes to shmem arrays on \a comm.
+ */
+int                 sc_shmem_is_shared (sc_MPI_Comm comm);
+
 /** Allocate a shmem array: an array that is redundant on every process.
  *
  * \param[in] package         package requesting memory
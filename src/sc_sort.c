@@ -23,6 +23,7 @@
 
 #include <sc_containers.h>
 #include <sc_sort.h>
+#include <sc_timeline.h>
 
 typedef struct sc_psort_peer
 {
@@ -44,6 +45,8 @@ typedef struct sc_psort
   size_t             *gmemb;
   char               *my_base;
   int                 (*compar) (const void *, const void *);
+  size_t              key_offset, key_width;
+  int                 key_signed;
 }
 sc_psort_t;
 
@@ -428,25 +431,54 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
 }
 
 static void
-sc_psort_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
+sc_psort_qsort (sc_psort_t * pst, char *base, size_t n, int dir)
 {
-  const size_t        n = hi - lo;
-
-  if (n > 1 && pst->my_hi > lo && pst->my_lo < hi) {
-    if (lo >= pst->my_lo && hi <= pst->my_hi) {
+  if (n <= 1) {
+    return;
+  }
+  if (pst->key_width > 0) {
+    size_t              zz;
+    char               *lo_data, *hi_data;
+    char               *temp;
+    sc_array_t          view;
+
+    /* radix sort by the integer key and reverse for descending order */
+    sc_array_init_data (&view, base, pst->size, n);
+    sc_array_sort_key (&view, pst->key_offset, pst->key_width,
+                       pst->key_signed);
+    if (!dir) {
+      temp = SC_ALLOC (char, pst->size);
+      for (zz = 0; zz < n / 2; ++zz) {
+        lo_data = base + zz * pst->size;
+        hi_data = base + (n - 1 - zz) * pst->size;
+        memcpy (temp, lo_data, pst->size);
+        memcpy (lo_data, hi_data, pst->size);
+        memcpy (hi_data, temp, pst->size);
+      }
+      SC_FREE (temp);
+    }
+    return;
+  }
 #ifndef SC_HAVE_QSORT_R
-      qsort (pst->my_base + (lo - pst->my_lo) * pst->size,
-             n, pst->size, dir ? sc_compare : sc_icompare);
+  qsort (base, n, pst->size, dir ? sc_compare : sc_icompare);
 #else
 #ifndef SC_HAVE_BSD_QSORT_R
-      qsort_r (pst->my_base + (lo - pst->my_lo) * pst->size,
-               n, pst->size, dir ? sc_compare_r : sc_icompare_r, pst);
-
+  qsort_r (base, n, pst->size, dir ? sc_compare_r : sc_icompare_r, pst);
 #else
-      qsort_r (pst->my_base + (lo - pst->my_lo) * pst->size,
-               n, pst->size, pst, dir ? sc_compare_r : sc_icompare_r);
+  qsort_r (base, n, pst->size, pst, dir ? sc_compare_r : sc_icompare_r);
 #endif
 #endif
+}
+
+static void
+sc_psort_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
+{
+  const size_t        n = hi - lo;
+
+  if (n > 1 && pst->my_hi > lo && pst->my_lo < hi) {
+    if (lo >= pst->my_lo && hi <= pst->my_hi) {
+      sc_psort_qsort (pst, pst->my_base + (lo - pst->my_lo) * pst->size,
+                      n, dir);
     }
     else {
       const size_t        n2 = n / 2;
@@ -458,16 +490,326 @@ sc_psort_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
   }
 }
 
-void
-sc_psort (sc_MPI_Comm mpicomm, void *base, size_t *nmemb, size_t size,
-          int (*compar) (const void *, const void *))
+/** Average number of samples per process to select the splitters. */
+#define SC_PSORT_OVERSAMPLE 64
+
+/* compare two run heads of the merge heap, ties go to the lower run */
+static int
+sc_psort_heap_less (sc_psort_t * pst, char **heads, int a, int b)
+{
+  const int           c = pst->compar (heads[a], heads[b]);
+
+  return c < 0 || (c == 0 && a < b);
+}
+
+static void
+sc_psort_heap_down (sc_psort_t * pst, char **heads, int *heap,
+                    int heap_count, int i)
+{
+  int                 child;
+  const int           top = heap[i];
+
+  for (;;) {
+    child = 2 * i + 1;
+    if (child >= heap_count) {
+      break;
+    }
+    if (child + 1 < heap_count &&
+        sc_psort_heap_less (pst, heads, heap[child + 1], heap[child])) {
+      ++child;
+    }
+    if (!sc_psort_heap_less (pst, heads, heap[child], top)) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = top;
+}
+
+/* k-way merge of sorted runs into out; heads and remain are consumed.
+ * Items are compared by their leading bytes and copied by stride.
+ * The merge is stable: equal items are taken from the lower run first. */
+static void
+sc_psort_merge (sc_psort_t * pst, int num_runs, char **heads,
+                size_t * remain, size_t stride, char *out)
+{
+  int                 i, r;
+  int                 heap_count;
+  int                *heap;
+
+  heap = SC_ALLOC (int, num_runs);
+  heap_count = 0;
+  for (i = 0; i < num_runs; ++i) {
+    if (remain[i] > 0) {
+      heap[heap_count++] = i;
+    }
+  }
+  for (i = heap_count / 2 - 1; i >= 0; --i) {
+    sc_psort_heap_down (pst, heads, heap, heap_count, i);
+  }
+  while (heap_count > 1) {
+    r = heap[0];
+    memcpy (out, heads[r], stride);
+    out += stride;
+    heads[r] += stride;
+    if (--remain[r] == 0) {
+      heap[0] = heap[--heap_count];
+    }
+    sc_psort_heap_down (pst, heads, heap, heap_count, 0);
+  }
+  if (heap_count == 1) {
+    /* the last remaining run is copied in one piece */
+    r = heap[0];
+    memcpy (out, heads[r], remain[r] * stride);
+    remain[r] = 0;
+  }
+  SC_FREE (heap);
+}
+
+/* number of samples drawn by a process proportional to its item count */
+static              size_t
+sc_psort_num_samples (size_t count, size_t total, size_t target)
+{
+  size_t              ns;
+
+  if (count == 0) {
+    return 0;
+  }
+  ns = (size_t) ceil ((double) count * (double) target / (double) total);
+  return SC_MAX (SC_MIN (ns, count), 1);
+}
+
+/* Return a datatype of one item to count the items of the all-to-all
+ * exchanges, since their byte counts may overflow int.  Sample sort is only
+ * used with more than one process and thus requires MPI. */
+static              sc_MPI_Datatype
+sc_psort_item_type (size_t size)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+  sc_MPI_Datatype     itype;
+
+  SC_CHECK_ABORT (size <= (size_t) INT_MAX, "Item size too large");
+  mpiret = MPI_Type_contiguous ((int) size, MPI_BYTE, &itype);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&itype);
+  SC_CHECK_MPI (mpiret);
+  return itype;
+#else
+  SC_ABORT_NOT_REACHED ();
+  return sc_MPI_BYTE;
+#endif
+}
+
+static void
+sc_psort_item_type_free (sc_MPI_Datatype * itype)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+
+  mpiret = MPI_Type_free (itype);
+  SC_CHECK_MPI (mpiret);
+#endif
+}
+
+/* Sample sort: sort locally, select splitters from a global sample,
+ * exchange the items with one all-to-all and merge the received runs.
+ * Ties are broken by the position of an item after the local sort, so
+ * many equal items are still distributed evenly over the processes.
+ * Returns the local part of the sorted data in the splitter partition. */
+static char        *
+sc_psort_sample (sc_psort_t * pst, size_t * nmemb, size_t * out_count)
+{
+  const int           num_procs = pst->num_procs;
+  const size_t        size = pst->size;
+  const size_t        stride = size + sizeof (size_t);
+  const size_t        total = pst->gmemb[num_procs];
+  int                 mpiret;
+  int                 q;
+  int                *scounts, *sdispl, *rcounts, *rdispl;
+  sc_MPI_Datatype     itype;
+  size_t              zz, ns, my_ns, gns, target;
+  size_t              pos, tag, lo, hi, mid;
+  size_t              count;
+  size_t             *bound, *remain;
+  char               *samples, *gsamples, *ssorted, *split;
+  char               *recvbuf, *merged;
+  char              **heads;
+
+  SC_ASSERT (total > 0);
+  scounts = SC_ALLOC (int, 4 * num_procs);
+  sdispl = scounts + num_procs;
+  rcounts = sdispl + num_procs;
+  rdispl = rcounts + num_procs;
+  heads = SC_ALLOC (char *, num_procs);
+  remain = SC_ALLOC (size_t, num_procs);
+
+  /* sort the process-local items */
+  sc_psort_qsort (pst, pst->my_base, pst->my_count, 1);
+
+  /* draw regular samples tagged with their global sorted position */
+  target = (size_t) num_procs * SC_PSORT_OVERSAMPLE;
+  gns = 0;
+  for (q = 0; q < num_procs; ++q) {
+    ns = sc_psort_num_samples (nmemb[q], total, target);
+    rcounts[q] = (int) (ns * stride);
+    rdispl[q] = (int) (gns * stride);
+    gns += ns;
+  }
+  SC_ASSERT (gns > 0);
+  SC_CHECK_ABORT (gns * stride <= (size_t) INT_MAX, "Sample size too large");
+  my_ns = sc_psort_num_samples (pst->my_count, total, target);
+  samples = SC_ALLOC (char, my_ns * stride);
+  for (zz = 0; zz < my_ns; ++zz) {
+    pos = ((2 * zz + 1) * pst->my_count) / (2 * my_ns);
+    tag = pst->my_lo + pos;
+    memcpy (samples + zz * stride, pst->my_base + pos * size, size);
+    memcpy (samples + zz * stride + size, &tag, sizeof (size_t));
+  }
+  gsamples = SC_ALLOC (char, gns * stride);
+  mpiret = sc_MPI_Allgatherv (samples, (int) (my_ns * stride), sc_MPI_BYTE,
+                              gsamples, rcounts, rdispl, sc_MPI_BYTE,
+                              pst->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (samples);
+
+  /* the sample runs are sorted per process and tagged in process order */
+  for (q = 0; q < num_procs; ++q) {
+    heads[q] = gsamples + rdispl[q];
+    remain[q] = (size_t) rcounts[q] / stride;
+  }
+  ssorted = SC_ALLOC (char, gns * stride);
+  sc_psort_merge (pst, num_procs, heads, remain, stride, ssorted);
+  SC_FREE (gsamples);
+
+  /* find the local item range destined for each process by bisection */
+  bound = SC_ALLOC (size_t, num_procs + 1);
+  bound[0] = 0;
+  for (q = 1; q < num_procs; ++q) {
+    split = ssorted + (((size_t) q * gns) / num_procs) * stride;
+    memcpy (&tag, split + size, sizeof (size_t));
+    lo = bound[q - 1];
+    hi = pst->my_count;
+    while (lo < hi) {
+      int                 c;
+
+      mid = lo + (hi - lo) / 2;
+      c = pst->compar (pst->my_base + mid * size, split);
+      if (c < 0 || (c == 0 && pst->my_lo + mid < tag)) {
+        lo = mid + 1;
+      }
+      else {
+        hi = mid;
+      }
+    }
+    bound[q] = lo;
+  }
+  bound[num_procs] = pst->my_count;
+  SC_FREE (ssorted);
+
+  /* exchange the item counts and then the items in a single all-to-all */
+  SC_CHECK_ABORT (pst->my_count <= (size_t) INT_MAX, "Too many items");
+  for (q = 0; q < num_procs; ++q) {
+    SC_ASSERT (bound[q] <= bound[q + 1]);
+    scounts[q] = (int) (bound[q + 1] - bound[q]);
+    sdispl[q] = (int) bound[q];
+  }
+  SC_FREE (bound);
+  mpiret = sc_MPI_Alltoall (scounts, 1, sc_MPI_INT,
+                            rcounts, 1, sc_MPI_INT, pst->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  count = 0;
+  for (q = 0; q < num_procs; ++q) {
+    rdispl[q] = (int) count;
+    count += (size_t) rcounts[q];
+    SC_CHECK_ABORT (count <= (size_t) INT_MAX, "Too many items received");
+  }
+  recvbuf = SC_ALLOC (char, count * size);
+  itype = sc_psort_item_type (size);
+  mpiret = sc_MPI_Alltoallv (pst->my_base, scounts, sdispl, itype,
+                             recvbuf, rcounts, rdispl, itype, pst->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  sc_psort_item_type_free (&itype);
+
+  /* merge the sorted runs received from all processes */
+  for (q = 0; q < num_procs; ++q) {
+    heads[q] = recvbuf + (size_t) rdispl[q] * size;
+    remain[q] = (size_t) rcounts[q];
+  }
+  merged = SC_ALLOC (char, count * size);
+  sc_psort_merge (pst, num_procs, heads, remain, size, merged);
+  SC_FREE (recvbuf);
+
+  SC_FREE (remain);
+  SC_FREE (heads);
+  SC_FREE (scounts);
+
+  *out_count = count;
+  return merged;
+}
+
+/* move the sorted items from the splitter partition back to the input one */
+static void
+sc_psort_restore (sc_psort_t * pst, char *merged, size_t count)
+{
+  const int           num_procs = pst->num_procs;
+  const size_t        size = pst->size;
+  int                 mpiret;
+  int                 q;
+  int                *scounts, *sdispl, *rcounts, *rdispl;
+  sc_MPI_Datatype     itype;
+  size_t              lo, hi;
+  size_t             *newmemb;
+
+  newmemb = SC_ALLOC (size_t, num_procs + 1);
+  newmemb[0] = 0;
+  mpiret = sc_MPI_Allgather (&count, (int) sizeof (size_t), sc_MPI_BYTE,
+                             newmemb + 1, (int) sizeof (size_t), sc_MPI_BYTE,
+                             pst->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (q = 0; q < num_procs; ++q) {
+    newmemb[q + 1] += newmemb[q];
+  }
+  SC_ASSERT (newmemb[num_procs] == pst->gmemb[num_procs]);
+
+  /* send and receive the overlaps of the old and new ranges in items */
+  SC_CHECK_ABORT (count <= (size_t) INT_MAX &&
+                  pst->my_count <= (size_t) INT_MAX, "Too many items");
+  scounts = SC_ALLOC (int, 4 * num_procs);
+  sdispl = scounts + num_procs;
+  rcounts = sdispl + num_procs;
+  rdispl = rcounts + num_procs;
+  for (q = 0; q < num_procs; ++q) {
+    lo = SC_MAX (newmemb[pst->rank], pst->gmemb[q]);
+    hi = SC_MIN (newmemb[pst->rank + 1], pst->gmemb[q + 1]);
+    scounts[q] = lo < hi ? (int) (hi - lo) : 0;
+    sdispl[q] = lo < hi ? (int) (lo - newmemb[pst->rank]) : 0;
+    lo = SC_MAX (newmemb[q], pst->my_lo);
+    hi = SC_MIN (newmemb[q + 1], pst->my_hi);
+    rcounts[q] = lo < hi ? (int) (hi - lo) : 0;
+    rdispl[q] = lo < hi ? (int) (lo - pst->my_lo) : 0;
+  }
+  itype = sc_psort_item_type (size);
+  mpiret = sc_MPI_Alltoallv (merged, scounts, sdispl, itype,
+                             pst->my_base, rcounts, rdispl, itype,
+                             pst->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  sc_psort_item_type_free (&itype);
+
+  SC_FREE (scounts);
+  SC_FREE (newmemb);
+}
+
+static void
+sc_psort_init (sc_psort_t * pst, sc_MPI_Comm mpicomm, void *base,
+               size_t * nmemb, size_t size,
+               int (*compar) (const void *, const void *))
 {
   int                 mpiret;
   int                 num_procs, rank;
   int                 i;
-  size_t              total;
   size_t             *gmemb;
-  sc_psort_t          pst;
 
 #ifndef SC_HAVE_QSORT_R
   SC_ASSERT (sc_compare == NULL);
@@ -486,28 +828,115 @@ sc_psort (sc_MPI_Comm mpicomm, void *base, size_t *nmemb, size_t size,
     gmemb[i + 1] = gmemb[i] + nmemb[i];
   }
 
-  /* set up internal state and call recursion */
-  pst.mpicomm = mpicomm;
-  pst.num_procs = num_procs;
-  pst.rank = rank;
-  pst.size = size;
-  pst.my_lo = gmemb[rank];
-  pst.my_hi = gmemb[rank + 1];
-  pst.my_count = nmemb[rank];
-  SC_ASSERT (pst.my_lo + pst.my_count == pst.my_hi);
-  pst.gmemb = gmemb;
-  pst.my_base = (char *) base;
-  pst.compar = compar;
+  /* set up internal state */
+  pst->mpicomm = mpicomm;
+  pst->num_procs = num_procs;
+  pst->rank = rank;
+  pst->size = size;
+  pst->my_lo = gmemb[rank];
+  pst->my_hi = gmemb[rank + 1];
+  pst->my_count = nmemb[rank];
+  SC_ASSERT (pst->my_lo + pst->my_count == pst->my_hi);
+  pst->gmemb = gmemb;
+  pst->my_base = (char *) base;
+  pst->compar = compar;
+  pst->key_offset = pst->key_width = 0;
+  pst->key_signed = 0;
 #ifndef SC_HAVE_QSORT_R
   sc_compare = compar;
 #endif
-  total = gmemb[num_procs];
-  SC_GLOBAL_LDEBUGF ("Total values to sort %lld\n", (long long) total);
-  sc_psort_bitonic (&pst, 0, total, 1);
+}
 
-  /* clean up and free memory */
+static void
+sc_psort_reset (sc_psort_t * pst)
+{
 #ifndef SC_HAVE_QSORT_R
   sc_compare = NULL;
 #endif
-  SC_FREE (gmemb);
+  SC_FREE (pst->gmemb);
+}
+
+void
+sc_psort (sc_MPI_Comm mpicomm, void *base, size_t *nmemb, size_t size,
+          int (*compar) (const void *, const void *))
+{
+  sc_psort_ext (mpicomm, base, nmemb, size, compar, SC_PSORT_BITONIC);
+}
+
+void
+sc_psort_ext (sc_MPI_Comm mpicomm, void *base, size_t *nmemb, size_t size,
+              int (*compar) (const void *, const void *),
+              sc_psort_algorithm_t algorithm)
+{
+  sc_psort_key (mpicomm, base, nmemb, size, compar, algorithm, 0, 0, 0);
+}
+
+void
+sc_psort_key (sc_MPI_Comm mpicomm, void *base, size_t *nmemb, size_t size,
+              int (*compar) (const void *, const void *),
+              sc_psort_algorithm_t algorithm,
+              size_t key_offset, size_t key_width, int key_signed)
+{
+  size_t              total, count;
+  char               *merged;
+  sc_psort_t          pst;
+
+  SC_ASSERT (algorithm == SC_PSORT_BITONIC || algorithm == SC_PSORT_SAMPLE);
+  SC_ASSERT (key_width == 0 || key_offset + key_width <= size);
+
+  SC_TIMELINE_BEGIN ("sc_psort");
+  sc_psort_init (&pst, mpicomm, base, nmemb, size, compar);
+  pst.key_offset = key_offset;
+  pst.key_width = key_width;
+  pst.key_signed = key_signed;
+  total = pst.gmemb[pst.num_procs];
+  SC_GLOBAL_LDEBUGF ("Total values to sort %lld\n", (long long) total);
+  if (algorithm == SC_PSORT_BITONIC || pst.num_procs == 1) {
+    sc_psort_bitonic (&pst, 0, total, 1);
+  }
+  else if (total > 0) {
+    merged = sc_psort_sample (&pst, nmemb, &count);
+    sc_psort_restore (&pst, merged, count);
+    SC_FREE (merged);
+  }
+  sc_psort_reset (&pst);
+  SC_TIMELINE_END ("sc_psort");
+}
+
+void
+sc_psort_rebalance (sc_MPI_Comm mpicomm, sc_array_t * array, size_t *nmemb,
+                    int (*compar) (const void *, const void *))
+{
+  int                 mpiret;
+  size_t              total, count;
+  char               *merged;
+  sc_psort_t          pst;
+
+  SC_ASSERT (array != NULL && SC_ARRAY_IS_OWNER (array));
+
+  SC_TIMELINE_BEGIN ("sc_psort_rebalance");
+  sc_psort_init (&pst, mpicomm, array->array, nmemb, array->elem_size,
+                 compar);
+  SC_ASSERT (pst.my_count == array->elem_count);
+  total = pst.gmemb[pst.num_procs];
+  SC_GLOBAL_LDEBUGF ("Total values to sort %lld\n", (long long) total);
+  if (pst.num_procs == 1 || total == 0) {
+    sc_psort_qsort (&pst, pst.my_base, pst.my_count, 1);
+  }
+  else {
+    merged = sc_psort_sample (&pst, nmemb, &count);
+    sc_array_resize (array, count);
+    if (count > 0) {
+      memcpy (array->array, merged, count * array->elem_size);
+    }
+    SC_FREE (merged);
+
+    /* report the new partition */
+    mpiret = sc_MPI_Allgather (&count, (int) sizeof (size_t), sc_MPI_BYTE,
+                               nmemb, (int) sizeof (size_t), sc_MPI_BYTE,
+                               mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  sc_psort_reset (&pst);
+  SC_TIMELINE_END ("sc_psort_rebalance");
 }
@@ -23,19 +23,32 @@
 
 /** \file sc_sort.h
  *
- * Provide a parallel sort algorithm.
- * We use a variant of the bitonic sort algorithm.
+ * Provide parallel sort algorithms.
+ * By default we use a variant of the bitonic sort algorithm.
+ * Alternatively, a sample sort exchanges all data in one all-to-all step.
  * Within each process we rely on the system quick sort function.
- * The partition of data on input is arbitrary and remains invariant.
+ * The partition of data on input is arbitrary and remains invariant,
+ * unless the sorted output is explicitly requested to be rebalanced.
  */
 
 #ifndef SC_SORT_H
 #define SC_SORT_H
 
-#include <sc.h>
+#include <sc_containers.h>
 
 SC_EXTERN_C_BEGIN;
 
+/** The algorithm used by \ref sc_psort_ext. */
+typedef enum sc_psort_algorithm
+{
+  SC_PSORT_BITONIC,     /**< Bitonic sort between processes; many rounds of
+                             point-to-point messages.  The default. */
+  SC_PSORT_SAMPLE       /**< Sample sort: splitters are selected from a
+                             global sample, the data is exchanged in one
+                             all-to-all step and merged locally. */
+}
+sc_psort_algorithm_t;
+
 /** Sort a distributed set of fixed-size data items in parallel.
  * This algorithm uses bitonic sort between processors and qsort locally.
  *
@@ -60,6 +73,80 @@ void                sc_psort (sc_MPI_Comm mpicomm, void *base,
                               size_t * nmemb, size_t size,
                               int (*compar) (const void *, const void *));
 
+/** Sort a distributed set of fixed-size data items with a choice of algorithm.
+ * The parameters and thread-safety are those of \ref sc_psort.
+ * The partition of the data can be arbitrary and is not changed.
+ *
+ * With \ref SC_PSORT_SAMPLE, each process sorts its items locally and
+ * contributes a regular sample proportional to its item count.  The samples
+ * determine mpisize - 1 splitters, the items are sent to their destination
+ * with one MPI_Alltoallv and each process merges the received runs.
+ * A second all-to-all restores the input partition.  For large counts per
+ * process this is usually much faster than the bitonic sort.
+ * Temporary memory of about twice the local data size is required.
+ *
+ * \param [in] mpicomm          Communicator to use.
+ * \param [in] base             Pointer to the process-local data items.
+ * \param [in] nmemb            Array of mpisize counts of data items.
+ *                              This array must be identical on all processes.
+ * \param [in] size             Size in bytes of one data item.
+ * \param [in] compar           Comparison function to use; see \ref sc_psort.
+ * \param [in] algorithm        The parallel sort algorithm to use.
+ */
+void                sc_psort_ext (sc_MPI_Comm mpicomm, void *base,
+                                  size_t * nmemb, size_t size,
+                                  int (*compar) (const void *, const void *),
+                                  sc_psort_algorithm_t algorithm);
+
+/** Sort a distributed set of data items by an integer key inside each item.
+ * This function works like \ref sc_psort_ext.  In addition, the caller
+ * promises that \b compar orders the items by an integer key at a fixed
+ * offset.  The process-local sorts then use the radix sort \ref
+ * sc_array_sort_key instead of qsort.  The comparison function is still
+ * used to exchange and merge items between processes.
+ *
+ * \param [in] mpicomm          Communicator to use.
+ * \param [in] base             Pointer to the process-local data items.
+ * \param [in] nmemb            Array of mpisize counts of data items.
+ *                              This array must be identical on all processes.
+ * \param [in] size             Size in bytes of one data item.
+ * \param [in] compar           Comparison function consistent with the key.
+ * \param [in] algorithm        The parallel sort algorithm to use.
+ * \param [in] key_offset       Offset in bytes of the key inside an item.
+ * \param [in] key_width        Size in bytes of the key; 1, 2, 4, or 8.
+ *                              If 0, no key is used and qsort is called.
+ * \param [in] key_signed       True if the key is a signed integer.
+ */
+void                sc_psort_key (sc_MPI_Comm mpicomm, void *base,
+                                  size_t * nmemb, size_t size,
+                                  int (*compar) (const void *, const void *),
+                                  sc_psort_algorithm_t algorithm,
+                                  size_t key_offset, size_t key_width,
+                                  int key_signed);
+
+/** Sample sort a distributed array and leave it in a rebalanced partition.
+ * This is \ref sc_psort_ext with \ref SC_PSORT_SAMPLE, except that the
+ * final all-to-all restoring the input partition is skipped.  Instead, each
+ * process keeps the items between two consecutive splitters.  The splitters
+ * are chosen such that the output is close to balanced regardless of the
+ * input partition, and ties between equal items are broken consistently, so
+ * many equal items are distributed evenly as well.
+ * The thread-safety is that of \ref sc_psort.
+ *
+ * \param [in] mpicomm          Communicator to use.
+ * \param [in,out] array        The process-local data items.  Its element
+ *                              size is the size of one item.  Must not be
+ *                              a view.  Resized to the new local count.
+ * \param [in,out] nmemb        Array of mpisize counts of data items,
+ *                              identical on all processes.  On output,
+ *                              contains the new partition of the items.
+ * \param [in] compar           Comparison function to use; see \ref sc_psort.
+ */
+void                sc_psort_rebalance (sc_MPI_Comm mpicomm,
+                                        sc_array_t * array, size_t * nmemb,
+                                        int (*compar) (const void *,
+                                                       const void *));
+
 SC_EXTERN_C_END;
 
 #endif /* SC_SORT_H */
@@ -22,6 +22,7 @@
 */
 
 #include <sc_statistics.h>
+#include <sc_reduce.h>
 
 #ifdef SC_ENABLE_MPI
 
@@ -185,26 +186,39 @@ sc_stats_accumulate (sc_statinfo_t * stats, double value)
 }
 
 void
-sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
+sc_stats_accumulate_array (sc_statinfo_t * stats,
+                           const double *values, size_t n)
 {
-  int                 i;
-  int                 mpiret;
-  int                 rank;
-  double              cnt, avg;
-  double             *flat;
-  double             *flatin;
-  double             *flatout;
-#ifdef SC_ENABLE_MPI
-  sc_MPI_Op           op;
-  sc_MPI_Datatype     ctype;
-#endif
+  double              vmin, vmax, vsum, vsq;
 
-  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
-  SC_CHECK_MPI (mpiret);
+  SC_ASSERT (stats->dirty);
+  if (n == 0) {
+    return;
+  }
 
-  flat = SC_ALLOC (double, 2 * 7 * nvars);
-  flatin = flat;
-  flatout = flat + 7 * nvars;
+  sc_reduce_minmaxsum (values, n, &vmin, &vmax, &vsum, &vsq);
+  if (stats->count) {
+    stats->count += (long) n;
+    stats->sum_values += vsum;
+    stats->sum_squares += vsq;
+    stats->min = SC_MIN (stats->min, vmin);
+    stats->max = SC_MAX (stats->max, vmax);
+  }
+  else {
+    stats->count = (long) n;
+    stats->sum_values = vsum;
+    stats->sum_squares = vsq;
+    stats->min = vmin;
+    stats->max = vmax;
+  }
+}
+
+/** Write the dirty variables into a buffer of 7 doubles per variable. */
+static void
+sc_stats_pack (int rank, int nvars, const sc_statinfo_t * stats,
+               double *flatin)
+{
+  int                 i;
 
   for (i = 0; i < nvars; ++i) {
     if (!stats[i].dirty) {
@@ -219,28 +233,14 @@ sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
     flatin[7 * i + 5] = (double) rank;  /* rank that attains minimum */
     flatin[7 * i + 6] = (double) rank;  /* rank that attains maximum */
   }
+}
 
-#ifndef SC_ENABLE_MPI
-  memcpy (flatout, flatin, 7 * nvars * sizeof (*flatout));
-#else
-  mpiret = MPI_Type_contiguous (7, MPI_DOUBLE, &ctype);
-  SC_CHECK_MPI (mpiret);
-
-  mpiret = MPI_Type_commit (&ctype);
-  SC_CHECK_MPI (mpiret);
-
-  mpiret = MPI_Op_create ((MPI_User_function *) sc_stats_mpifunc, 1, &op);
-  SC_CHECK_MPI (mpiret);
-
-  mpiret = MPI_Allreduce (flatin, flatout, nvars, ctype, op, mpicomm);
-  SC_CHECK_MPI (mpiret);
-
-  mpiret = MPI_Op_free (&op);
-  SC_CHECK_MPI (mpiret);
-
-  mpiret = MPI_Type_free (&ctype);
-  SC_CHECK_MPI (mpiret);
-#endif /* SC_ENABLE_MPI */
+/** Derive the global statistics of the dirty variables from the buffer. */
+static void
+sc_stats_unpack (int nvars, sc_statinfo_t * stats, const double *flatout)
+{
+  int                 i;
+  double              cnt, avg;
 
   for (i = 0; i < nvars; ++i) {
     if (!stats[i].dirty) {
@@ -269,7 +269,52 @@ sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
     stats[i].standev = sqrt (stats[i].variance);
     stats[i].standev_mean = sqrt (stats[i].variance_mean);
   }
+}
 
+void
+sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
+{
+  int                 mpiret;
+  int                 rank;
+  double             *flat;
+  double             *flatin;
+  double             *flatout;
+#ifdef SC_ENABLE_MPI
+  sc_MPI_Op           op;
+  sc_MPI_Datatype     ctype;
+#endif
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  flat = SC_ALLOC (double, 2 * 7 * nvars);
+  flatin = flat;
+  flatout = flat + 7 * nvars;
+  sc_stats_pack (rank, nvars, stats, flatin);
+
+#ifndef SC_ENABLE_MPI
+  memcpy (flatout, flatin, 7 * nvars * sizeof (*flatout));
+#else
+  mpiret = MPI_Type_contiguous (7, MPI_DOUBLE, &ctype);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_Type_commit (&ctype);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_Op_create ((MPI_User_function *) sc_stats_mpifunc, 1, &op);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_Allreduce (flatin, flatout, nvars, ctype, op, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_Op_free (&op);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_Type_free (&ctype);
+  SC_CHECK_MPI (mpiret);
+#endif /* SC_ENABLE_MPI */
+
+  sc_stats_unpack (nvars, stats, flatout);
   SC_FREE (flat);
 }
 
@@ -431,15 +476,91 @@ sc_stats_print_ext (int package_id, int log_priority,
   }
 }
 
+/** Return the bin of the histogram sketch that counts a value. */
+static int
+sc_stats_sketch_bin (double value)
+{
+  double              b;
+
+  if (!(value >= SC_STATS_SKETCH_MIN)) {
+    return 0;
+  }
+  b = log (value / SC_STATS_SKETCH_MIN) /
+    log ((1. + SC_STATS_SKETCH_ACCURACY) / (1. - SC_STATS_SKETCH_ACCURACY));
+  return 1 + (int) SC_MIN (b, (double) (SC_STATS_SKETCH_BINS - 2));
+}
+
+/** Return the value that represents a bin of the histogram sketch.
+ * Bins 0 and the last one are unbounded and represented by \a min and
+ * \a max, respectively, which also bound the result for all bins. */
+static double
+sc_stats_sketch_value (int bin, double min, double max)
+{
+  double              gamma, value;
+
+  if (bin == 0) {
+    return min;
+  }
+  if (bin == SC_STATS_SKETCH_BINS - 1) {
+    return max;
+  }
+
+  /* the bin covers [MIN gamma^(bin - 1), MIN gamma^bin) */
+  gamma = (1. + SC_STATS_SKETCH_ACCURACY) / (1. - SC_STATS_SKETCH_ACCURACY);
+  value = SC_STATS_SKETCH_MIN * pow (gamma, bin) * 2. / (1. + gamma);
+  return SC_MAX (min, SC_MIN (value, max));
+}
+
+/** Return the local half of the sketch of a variable or NULL. */
+static double      *
+sc_statistics_sketch (sc_statistics_t * stats, int i)
+{
+  return *(double **) sc_array_index_int (stats->sketches, i);
+}
+
+/** Add a variable that is not yet known and return its statinfo. */
+static sc_statinfo_t *
+sc_statistics_push (sc_statistics_t * stats, const char *name)
+{
+  int                 i;
+
+  /* always check for wrong usage and output adequate error message */
+  SC_CHECK_ABORTF (!sc_keyvalue_exists (stats->kv, name),
+                   "Statistics variable \"%s\" exists already", name);
+  SC_ASSERT (!stats->computing);
+
+  i = (int) stats->sarray->elem_count;
+  *(double **) sc_array_push (stats->sketches) = NULL;
+  sc_keyvalue_set_int (stats->kv, name, i);
+  return (sc_statinfo_t *) sc_array_push (stats->sarray);
+}
+
+/** Find a variable by name and abort if it does not exist. */
+static int
+sc_statistics_find (sc_statistics_t * stats, const char *name)
+{
+  int                 i;
+
+  i = sc_keyvalue_get_int (stats->kv, name, -1);
+
+  /* always check for wrong usage and output adequate error message */
+  SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
+  SC_ASSERT (!stats->computing);
+
+  return i;
+}
+
 sc_statistics_t    *
 sc_statistics_new (sc_MPI_Comm mpicomm)
 {
   sc_statistics_t    *stats;
 
-  stats = SC_ALLOC (sc_statistics_t, 1);
+  stats = SC_ALLOC_ZERO (sc_statistics_t, 1);
   stats->mpicomm = mpicomm;
   stats->kv = sc_keyvalue_new ();
   stats->sarray = sc_array_new (sizeof (sc_statinfo_t));
+  stats->sketches = sc_array_new (sizeof (double *));
+  stats->request[0] = stats->request[1] = sc_MPI_REQUEST_NULL;
 
   return stats;
 }
@@ -447,8 +568,29 @@ sc_statistics_new (sc_MPI_Comm mpicomm)
 void
 sc_statistics_destroy (sc_statistics_t * stats)
 {
+  size_t              zz;
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+#endif
+
+  SC_ASSERT (!stats->computing);
+
+#ifdef SC_ENABLE_MPI
+  if (stats->cached) {
+    mpiret = MPI_Op_free (&stats->op);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Type_free (&stats->ctype);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+
+  for (zz = 0; zz < stats->sketches->elem_count; ++zz) {
+    SC_FREE (*(double **) sc_array_index (stats->sketches, zz));
+  }
+  sc_array_destroy (stats->sketches);
   sc_keyvalue_destroy (stats->kv);
   sc_array_destroy (stats->sarray);
+  SC_FREE (stats->flat);
 
   SC_FREE (stats);
 }
@@ -456,51 +598,29 @@ sc_statistics_destroy (sc_statistics_t * stats)
 void
 sc_statistics_add (sc_statistics_t * stats, const char *name)
 {
-  int                 i;
-  sc_statinfo_t      *si;
-
-  /* always check for wrong usage and output adequate error message */
-  SC_CHECK_ABORTF (!sc_keyvalue_exists (stats->kv, name),
-                   "Statistics variable \"%s\" exists already", name);
-
-  i = (int) stats->sarray->elem_count;
-  si = (sc_statinfo_t *) sc_array_push (stats->sarray);
-  sc_stats_set1 (si, 0, name);
-
-  sc_keyvalue_set_int (stats->kv, name, i);
+  sc_stats_set1 (sc_statistics_push (stats, name), 0, name);
 }
 
 void
 sc_statistics_set (sc_statistics_t * stats, const char *name, double value)
 {
   int                 i;
-  sc_statinfo_t      *si;
-
-  i = sc_keyvalue_get_int (stats->kv, name, -1);
+  double             *sketch;
 
-  /* always check for wrong usage and output adequate error message */
-  SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
+  i = sc_statistics_find (stats, name);
+  sc_stats_set1 ((sc_statinfo_t *) sc_array_index_int (stats->sarray, i),
+                 value, name);
 
-  si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, i);
-
-  sc_stats_set1 (si, value, name);
+  if ((sketch = sc_statistics_sketch (stats, i)) != NULL) {
+    memset (sketch, 0, SC_STATS_SKETCH_BINS * sizeof (double));
+    sketch[sc_stats_sketch_bin (value)] = 1.;
+  }
 }
 
 void
 sc_statistics_add_empty (sc_statistics_t * stats, const char *name)
 {
-  int                 i;
-  sc_statinfo_t      *si;
-
-  /* always check for wrong usage and output adequate error message */
-  SC_CHECK_ABORTF (!sc_keyvalue_exists (stats->kv, name),
-                   "Statistics variable \"%s\" exists already", name);
-
-  i = (int) stats->sarray->elem_count;
-  si = (sc_statinfo_t *) sc_array_push (stats->sarray);
-  sc_stats_init (si, name);
-
-  sc_keyvalue_set_int (stats->kv, name, i);
+  sc_stats_init (sc_statistics_push (stats, name), name);
 }
 
 int
@@ -514,30 +634,219 @@ sc_statistics_accumulate (sc_statistics_t * stats, const char *name,
                           double value)
 {
   int                 i;
-  sc_statinfo_t      *si;
+  double             *sketch;
 
-  i = sc_keyvalue_get_int (stats->kv, name, -1);
+  i = sc_statistics_find (stats, name);
+  sc_stats_accumulate ((sc_statinfo_t *)
+                       sc_array_index_int (stats->sarray, i), value);
 
-  /* always check for wrong usage and output adequate error message */
-  SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
+  if ((sketch = sc_statistics_sketch (stats, i)) != NULL) {
+    sketch[sc_stats_sketch_bin (value)] += 1.;
+  }
+}
+
+void
+sc_statistics_add_sketch (sc_statistics_t * stats, const char *name)
+{
+  int                 i;
+  double            **psketch;
+  sc_statinfo_t      *si;
+
+  i = sc_statistics_find (stats, name);
+  psketch = (double **) sc_array_index_int (stats->sketches, i);
+  if (*psketch != NULL) {
+    return;
+  }
 
+  /* the second half receives the global histogram */
+  *psketch = SC_ALLOC_ZERO (double, 2 * SC_STATS_SKETCH_BINS);
   si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, i);
+  if (si->dirty && si->count == 1) {
+    /* a variable that has been set or added with value 0 */
+    (*psketch)[sc_stats_sketch_bin (si->sum_values)] = 1.;
+  }
+}
+
+void
+sc_statistics_reset (sc_statistics_t * stats)
+{
+  size_t              zz;
+  double             *sketch;
 
-  sc_stats_accumulate (si, value);
+  SC_ASSERT (!stats->computing);
+
+  for (zz = 0; zz < stats->sarray->elem_count; ++zz) {
+    sc_stats_reset ((sc_statinfo_t *) sc_array_index (stats->sarray, zz), 0);
+    sketch = sc_statistics_sketch (stats, (int) zz);
+    if (sketch != NULL) {
+      memset (sketch, 0, SC_STATS_SKETCH_BINS * sizeof (double));
+    }
+  }
 }
 
 void
 sc_statistics_compute (sc_statistics_t * stats)
 {
-  sc_stats_compute (stats->mpicomm, (int) stats->sarray->elem_count,
-                    (sc_statinfo_t *) stats->sarray->array);
+  sc_statistics_compute_begin (stats);
+  sc_statistics_compute_end (stats);
+}
+
+void
+sc_statistics_compute_begin (sc_statistics_t * stats)
+{
+  int                 mpiret;
+  int                 rank;
+  int                 nvars, nsketch;
+  int                 i;
+  size_t              count;
+  double             *flatin, *flatout, *sketch;
+
+  SC_ASSERT (!stats->computing);
+
+  mpiret = sc_MPI_Comm_rank (stats->mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the buffer holds the variables followed by the sketches */
+  nvars = (int) stats->sarray->elem_count;
+  for (nsketch = 0, i = 0; i < nvars; ++i) {
+    nsketch += sc_statistics_sketch (stats, i) != NULL;
+  }
+  count = 7 * (size_t) nvars + (size_t) nsketch * SC_STATS_SKETCH_BINS;
+  if (2 * count > stats->flat_alloc) {
+    stats->flat_alloc = 2 * count;
+    stats->flat = SC_REALLOC (stats->flat, double, stats->flat_alloc);
+  }
+  stats->flat_count = count;
+  flatin = stats->flat;
+  flatout = stats->flat + count;
+
+  sc_stats_pack (rank, nvars, (sc_statinfo_t *) stats->sarray->array,
+                 flatin);
+  flatin += 7 * nvars;
+  for (i = 0; i < nvars; ++i) {
+    if ((sketch = sc_statistics_sketch (stats, i)) != NULL) {
+      memcpy (flatin, sketch, SC_STATS_SKETCH_BINS * sizeof (double));
+      flatin += SC_STATS_SKETCH_BINS;
+    }
+  }
+  flatin = stats->flat;
+
+#ifndef SC_ENABLE_MPI
+  memcpy (flatout, flatin, count * sizeof (double));
+#else
+  if (!stats->cached) {
+    mpiret = MPI_Type_contiguous (7, MPI_DOUBLE, &stats->ctype);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Type_commit (&stats->ctype);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Op_create ((MPI_User_function *) sc_stats_mpifunc, 1,
+                            &stats->op);
+    SC_CHECK_MPI (mpiret);
+    stats->cached = 1;
+  }
+#if MPI_VERSION >= 3
+  mpiret = MPI_Iallreduce (flatin, flatout, nvars, stats->ctype,
+                           stats->op, stats->mpicomm, &stats->request[0]);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Iallreduce (flatin + 7 * nvars, flatout + 7 * nvars,
+                           nsketch * SC_STATS_SKETCH_BINS, MPI_DOUBLE,
+                           MPI_SUM, stats->mpicomm, &stats->request[1]);
+  SC_CHECK_MPI (mpiret);
+#else
+  mpiret = MPI_Allreduce (flatin, flatout, nvars, stats->ctype,
+                          stats->op, stats->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Allreduce (flatin + 7 * nvars, flatout + 7 * nvars,
+                          nsketch * SC_STATS_SKETCH_BINS, MPI_DOUBLE,
+                          MPI_SUM, stats->mpicomm);
+  SC_CHECK_MPI (mpiret);
+#endif
+#endif /* SC_ENABLE_MPI */
+
+  stats->computing = 1;
+}
+
+void
+sc_statistics_compute_end (sc_statistics_t * stats)
+{
+  int                 mpiret;
+  int                 nvars, i;
+  double             *flatout, *sketch;
+
+  SC_ASSERT (stats->computing);
+
+  mpiret = sc_MPI_Waitall (2, stats->request, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+
+  nvars = (int) stats->sarray->elem_count;
+  flatout = stats->flat + stats->flat_count;
+  sc_stats_unpack (nvars, (sc_statinfo_t *) stats->sarray->array, flatout);
+  flatout += 7 * nvars;
+  for (i = 0; i < nvars; ++i) {
+    if ((sketch = sc_statistics_sketch (stats, i)) != NULL) {
+      memcpy (sketch + SC_STATS_SKETCH_BINS, flatout,
+              SC_STATS_SKETCH_BINS * sizeof (double));
+      flatout += SC_STATS_SKETCH_BINS;
+    }
+  }
+
+  stats->computing = 0;
+}
+
+double
+sc_statistics_quantile (sc_statistics_t * stats, const char *name, double q)
+{
+  int                 i, bin;
+  double              rank, cumulative;
+  double             *global;
+  sc_statinfo_t      *si;
+
+  SC_ASSERT (0. <= q && q <= 1.);
+
+  i = sc_statistics_find (stats, name);
+  si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, i);
+  global = sc_statistics_sketch (stats, i);
+  SC_CHECK_ABORTF (global != NULL,
+                   "Statistics variable \"%s\" has no sketch", name);
+  global += SC_STATS_SKETCH_BINS;
+  if (si->count <= 0) {
+    return 0.;
+  }
+
+  /* find the bin that contains the value of this rank in sorted order */
+  rank = q * (double) (si->count - 1);
+  cumulative = 0.;
+  for (bin = 0; bin < SC_STATS_SKETCH_BINS - 1; ++bin) {
+    cumulative += global[bin];
+    if (cumulative > rank) {
+      break;
+    }
+  }
+  return sc_stats_sketch_value (bin, si->min, si->max);
 }
 
 void
 sc_statistics_print (sc_statistics_t * stats,
                      int package_id, int log_priority, int full, int summary)
 {
+  int                 i;
+  sc_statinfo_t      *si;
+
   sc_stats_print (package_id, log_priority,
                   (int) stats->sarray->elem_count,
                   (sc_statinfo_t *) stats->sarray->array, full, summary);
+
+  if (full) {
+    for (i = 0; i < (int) stats->sarray->elem_count; ++i) {
+      si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, i);
+      if (sc_statistics_sketch (stats, i) == NULL || !si->count) {
+        continue;
+      }
+      SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
+                   "Quantiles of %s: median %g, 99th percentile %g\n",
+                   si->variable, sc_statistics_quantile (stats, si->variable,
+                                                         .5),
+                   sc_statistics_quantile (stats, si->variable, .99));
+    }
+  }
 }
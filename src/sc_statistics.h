@@ -58,12 +58,37 @@ typedef struct sc_statinfo
 }
 sc_statinfo_t;
 
-/** The statistics container allows dynamically adding random variables. */
+/** Number of bins in the optional histogram sketch of a variable.
+ * Bin 0 counts all values less than \ref SC_STATS_SKETCH_MIN and the last
+ * bin counts all values too large for the range of the other bins. */
+#define SC_STATS_SKETCH_BINS 512
+
+/** The smallest value resolved by the histogram sketch. */
+#define SC_STATS_SKETCH_MIN 1e-6
+
+/** The relative accuracy of the quantiles computed from the sketch.
+ * With the defaults, values up to about 2e7 are resolved. */
+#define SC_STATS_SKETCH_ACCURACY .03
+
+/** The statistics container allows dynamically adding random variables.
+ * It keeps the buffers and the MPI datatype and operation for the
+ * reduction across calls, so computing many variables repeatedly costs
+ * one nonblocking collective per call and no further setup.
+ */
 typedef struct sc_stats
 {
   sc_MPI_Comm         mpicomm;
   sc_keyvalue_t      *kv;
   sc_array_t         *sarray;
+  sc_array_t         *sketches;     /**< Per variable NULL or histogram. */
+  double             *flat;         /**< Reduction buffer kept across calls. */
+  size_t              flat_alloc;   /**< Number of doubles in \a flat. */
+  size_t              flat_count;   /**< Doubles of the pending reduction. */
+  int                 computing;    /**< Between compute_begin and _end. */
+  int                 cached;       /**< Datatype and operation are valid. */
+  sc_MPI_Datatype     ctype;        /**< Datatype of one variable. */
+  sc_MPI_Op           op;           /**< Operation combining variables. */
+  sc_MPI_Request      request[2];   /**< Pending variables and sketches. */
 }
 sc_statistics_t;
 
@@ -147,6 +172,18 @@ void                sc_stats_set_group_prio (sc_statinfo_t * stats,
  */
 void                sc_stats_accumulate (sc_statinfo_t * stats, double value);
 
+/** Add an array of instances of the random variable.
+ * This is equivalent to calling \ref sc_stats_accumulate for each value,
+ * but visits the values only once with \ref sc_reduce_minmaxsum.
+ * The sums may differ in the last bits from the one-by-one version.
+ * \param [out] stats          Must be dirty.  We bump count and values.
+ * \param [in] values          Array of \a n values.
+ * \param [in] n               Number of values, may be 0.
+ */
+void                sc_stats_accumulate_array (sc_statinfo_t * stats,
+                                               const double *values,
+                                               size_t n);
+
 /**
  * Compute global average and standard deviation.
  * Only updates dirty variables. Then removes the dirty flag.
@@ -232,6 +269,8 @@ void                sc_stats_print_ext (int package_id, int log_priority,
 sc_statistics_t    *sc_statistics_new (sc_MPI_Comm mpicomm);
 
 /** Destroy a statistics structure.
+ * This frees the cached MPI objects, so it must be called before MPI is
+ * finalized and not between \ref sc_statistics_compute_begin and _end.
  * \param [in,out] stats    Valid object is invalidated.
  */
 void                sc_statistics_destroy (sc_statistics_t * stats);
@@ -264,11 +303,56 @@ void                sc_statistics_set (sc_statistics_t * stats,
 void                sc_statistics_accumulate (sc_statistics_t * stats,
                                               const char *name, double value);
 
+/** Enable a histogram sketch for a statistics variable.
+ * From now on, the values passed to \ref sc_statistics_set and \ref
+ * sc_statistics_accumulate are also counted in a histogram of
+ * \ref SC_STATS_SKETCH_BINS logarithmically spaced bins.
+ * The histograms are summed over all processes by the compute functions,
+ * which allows for \ref sc_statistics_quantile.
+ * The variable must exist and the call must be collective.
+ */
+void                sc_statistics_add_sketch (sc_statistics_t * stats,
+                                              const char *name);
+
+/** Reset all variables to a count of 0 and clear their sketches.
+ * This prepares the variables for the next round of accumulation.
+ */
+void                sc_statistics_reset (sc_statistics_t * stats);
+
 /** Compute statistics for all variables, see sc_stats_compute.
+ * This is \ref sc_statistics_compute_begin followed by _end.
  */
 void                sc_statistics_compute (sc_statistics_t * stats);
 
+/** Begin to compute statistics for all variables, see sc_stats_compute.
+ * All variables and sketches are combined in nonblocking collectives.
+ * The variables must not be modified before \ref sc_statistics_compute_end.
+ * This function is collective.
+ */
+void                sc_statistics_compute_begin (sc_statistics_t * stats);
+
+/** Complete the computation started by \ref sc_statistics_compute_begin.
+ * This function is collective.
+ */
+void                sc_statistics_compute_end (sc_statistics_t * stats);
+
+/** Estimate a quantile of a variable over all processes from its sketch.
+ * This is valid after the statistics have been computed.
+ * The result is within the minimum and maximum of the variable and has a
+ * relative error of at most \ref SC_STATS_SKETCH_ACCURACY for values in
+ * the range of the sketch.
+ * \param [in] stats        Statistics with computed variables.
+ * \param [in] name         A variable with a sketch.
+ * \param [in] q            Quantile between 0 and 1, such as .5 for the
+ *                          median or .99 for the 99th percentile.
+ * \return                  Estimated quantile, or 0 if the count is 0.
+ */
+double              sc_statistics_quantile (sc_statistics_t * stats,
+                                            const char *name, double q);
+
 /** Print all statistics variables, see sc_stats_print.
+ * With \a full, we add the median and 99th percentile of each variable
+ * that has a sketch.
  */
 void                sc_statistics_print (sc_statistics_t * stats,
                                          int package_id, int log_priority,
@@ -0,0 +1,355 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_timeline.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+/** One recorded event. */
+typedef struct sc_timeline_event
+{
+  const char         *name;     /**< Static name of the region. */
+  unsigned long long  ticks;    /**< Clock value when recorded. */
+  char                phase;    /**< 'B' or 'E'. */
+}
+sc_timeline_event_t;
+
+/** The ring buffer of one thread. */
+typedef struct sc_timeline_thread
+{
+  sc_timeline_event_t *events;  /**< Ring of SC_TIMELINE_EVENTS entries. */
+  size_t              recorded; /**< Number of events ever recorded. */
+  int                 tid;      /**< Thread number in the output. */
+  struct sc_timeline_thread *next;      /**< List of all threads. */
+}
+sc_timeline_thread_t;
+
+#ifdef SC_ENABLE_PTHREAD
+
+/** Per-thread reference to the ring buffer of the current recording.
+ * It outlives the recording, so we compare the generation on access. */
+typedef struct sc_timeline_handle
+{
+  sc_timeline_thread_t *thread;
+  int                 generation;
+}
+sc_timeline_handle_t;
+
+static pthread_mutex_t sc_timeline_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t sc_timeline_once = PTHREAD_ONCE_INIT;
+static pthread_key_t sc_timeline_key;
+
+#endif
+
+int                 sc_timeline_active = 0;
+
+static int          sc_timeline_generation = 0;
+static int          sc_timeline_num_threads = 0;
+static sc_timeline_thread_t *sc_timeline_threads = NULL;
+static sc_MPI_Comm  sc_timeline_comm = sc_MPI_COMM_NULL;
+static char        *sc_timeline_filename = NULL;
+static int          sc_timeline_gather = 0;
+static unsigned long long sc_timeline_ticks0;
+static double       sc_timeline_seconds0;
+
+/** Read a fast, monotonic clock of unspecified unit. */
+static inline unsigned long long
+sc_timeline_ticks (void)
+{
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+  return __builtin_ia32_rdtsc ();
+#else
+  return (unsigned long long) (sc_MPI_Wtime () * 1e9);
+#endif
+}
+
+static sc_timeline_thread_t *
+sc_timeline_thread_new (void)
+{
+  sc_timeline_thread_t *th;
+
+  th = SC_ALLOC (sc_timeline_thread_t, 1);
+  th->events = SC_ALLOC (sc_timeline_event_t, SC_TIMELINE_EVENTS);
+  th->recorded = 0;
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_timeline_mutex);
+#endif
+  th->tid = sc_timeline_num_threads++;
+  th->next = sc_timeline_threads;
+  sc_timeline_threads = th;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_timeline_mutex);
+#endif
+
+  return th;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void
+sc_timeline_init_once (void)
+{
+  int                 pth;
+
+  /* the ring buffers stay in the list when a thread exits */
+  pth = pthread_key_create (&sc_timeline_key, free);
+  SC_CHECK_ABORT (pth == 0, "sc_timeline_key");
+}
+
+#endif
+
+/** Return the ring buffer of the calling thread. */
+static sc_timeline_thread_t *
+sc_timeline_thread (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  sc_timeline_handle_t *handle;
+
+  pth = pthread_once (&sc_timeline_once, sc_timeline_init_once);
+  SC_CHECK_ABORT (pth == 0, "sc_timeline_once");
+  handle = (sc_timeline_handle_t *) pthread_getspecific (sc_timeline_key);
+  if (handle == NULL) {
+    handle = (sc_timeline_handle_t *) calloc (1, sizeof (*handle));
+    SC_CHECK_ABORT (handle != NULL, "sc_timeline_thread");
+    pth = pthread_setspecific (sc_timeline_key, handle);
+    SC_CHECK_ABORT (pth == 0, "sc_timeline_thread");
+  }
+  if (handle->thread == NULL ||
+      handle->generation != sc_timeline_generation) {
+    handle->thread = sc_timeline_thread_new ();
+    handle->generation = sc_timeline_generation;
+  }
+  return handle->thread;
+#else
+  if (sc_timeline_threads == NULL) {
+    sc_timeline_thread_new ();
+  }
+  return sc_timeline_threads;
+#endif
+}
+
+void
+sc_timeline_record (const char *name, char phase)
+{
+  sc_timeline_thread_t *th;
+  sc_timeline_event_t *ev;
+
+  SC_ASSERT (phase == 'B' || phase == 'E');
+
+  th = sc_timeline_thread ();
+  ev = th->events + th->recorded++ % SC_TIMELINE_EVENTS;
+  ev->name = name;
+  ev->phase = phase;
+  ev->ticks = sc_timeline_ticks ();
+}
+
+void
+sc_timeline_start (sc_MPI_Comm mpicomm, const char *filename, int gather)
+{
+  int                 mpiret;
+
+  SC_CHECK_ABORT (!sc_timeline_active, "Timeline is already recording");
+  SC_ASSERT (filename != NULL);
+
+  sc_timeline_comm = mpicomm;
+  sc_timeline_filename = SC_STRDUP (filename);
+  sc_timeline_gather = gather && mpicomm != sc_MPI_COMM_NULL;
+
+  /* align the time origin of all processes */
+  if (mpicomm != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Barrier (mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  sc_timeline_seconds0 = sc_MPI_Wtime ();
+  sc_timeline_ticks0 = sc_timeline_ticks ();
+  sc_timeline_active = 1;
+}
+
+/** Append a string to a growing character array. */
+static void
+sc_timeline_append (sc_array_t * out, const char *str)
+{
+  size_t              len = strlen (str);
+
+  memcpy (sc_array_push_count (out, len), str, len);
+}
+
+/** Append the JSON events of this process to a character array. */
+static void
+sc_timeline_format (sc_array_t * out, int rank, double ticks_per_us)
+{
+  size_t              zz, first;
+  const char         *s;
+  char                buffer[BUFSIZ];
+  sc_timeline_thread_t *th;
+  sc_timeline_event_t *ev;
+
+  snprintf (buffer, BUFSIZ, "{\"name\":\"process_name\",\"ph\":\"M\","
+            "\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}", rank, rank);
+  sc_timeline_append (out, buffer);
+
+  for (th = sc_timeline_threads; th != NULL; th = th->next) {
+    first = th->recorded > SC_TIMELINE_EVENTS ?
+      th->recorded - SC_TIMELINE_EVENTS : 0;
+    for (zz = first; zz < th->recorded; ++zz) {
+      ev = th->events + zz % SC_TIMELINE_EVENTS;
+      sc_timeline_append (out, ",\n{\"name\":\"");
+      for (s = ev->name; *s != '\0'; ++s) {
+        /* the names are identifiers; drop what JSON needs escaped */
+        if (*s != '"' && *s != '\\' && (unsigned char) *s >= ' ') {
+          *(char *) sc_array_push (out) = *s;
+        }
+      }
+      snprintf (buffer, BUFSIZ,
+                "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                ev->phase,
+                (double) (ev->ticks - sc_timeline_ticks0) / ticks_per_us,
+                rank, th->tid);
+      sc_timeline_append (out, buffer);
+    }
+  }
+}
+
+/** Write the JSON document around the formatted events. */
+static int
+sc_timeline_write (const char *filename, const char *events, size_t len)
+{
+  int                 retval;
+  FILE               *file;
+
+  if ((file = fopen (filename, "wb")) == NULL) {
+    SC_LERRORF ("Could not open timeline file %s\n", filename);
+    return -1;
+  }
+  retval = fputs ("{\"traceEvents\":[\n", file) < 0;
+  retval = retval || fwrite (events, 1, len, file) != len;
+  retval = retval || fputs ("\n],\"displayTimeUnit\":\"ms\"}\n", file) < 0;
+  retval = fclose (file) || retval;
+  if (retval) {
+    SC_LERRORF ("Could not write timeline file %s\n", filename);
+  }
+  return retval;
+}
+
+int
+sc_timeline_stop (void)
+{
+  int                 mpiret;
+  int                 rank, size, i;
+  int                 retval;
+  int                 len, *lens, *displs;
+  double              ticks_per_us, seconds;
+  char               *all;
+  char                filename[BUFSIZ];
+  sc_array_t         *out;
+  sc_timeline_thread_t *th;
+
+  if (!sc_timeline_active) {
+    return 0;
+  }
+  sc_timeline_active = 0;
+
+  /* calibrate the clock over the duration of the recording */
+  seconds = sc_MPI_Wtime () - sc_timeline_seconds0;
+  ticks_per_us = seconds > 0. ?
+    (double) (sc_timeline_ticks () - sc_timeline_ticks0) / (seconds * 1e6) :
+    1.;
+  ticks_per_us = ticks_per_us > 0. ? ticks_per_us : 1.;
+
+  rank = 0;
+  size = 1;
+  if (sc_timeline_comm != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Comm_rank (sc_timeline_comm, &rank);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_size (sc_timeline_comm, &size);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  out = sc_array_new (sizeof (char));
+  if (rank > 0 && sc_timeline_gather) {
+    /* separate our events from those of the previous ranks */
+    sc_timeline_append (out, ",\n");
+  }
+  sc_timeline_format (out, rank, ticks_per_us);
+
+  retval = 0;
+  if (!sc_timeline_gather) {
+    if (sc_timeline_comm != sc_MPI_COMM_NULL) {
+      snprintf (filename, BUFSIZ, "%s.%d.json", sc_timeline_filename, rank);
+    }
+    else {
+      snprintf (filename, BUFSIZ, "%s.json", sc_timeline_filename);
+    }
+    retval = sc_timeline_write (filename, (char *) out->array,
+                                out->elem_count);
+  }
+  else {
+    /* collect the formatted events of all processes on rank 0 */
+    len = (int) out->elem_count;
+    lens = displs = NULL;
+    all = NULL;
+    if (rank == 0) {
+      lens = SC_ALLOC (int, size);
+      displs = SC_ALLOC (int, size + 1);
+    }
+    mpiret = sc_MPI_Gather (&len, 1, sc_MPI_INT, lens, 1, sc_MPI_INT, 0,
+                            sc_timeline_comm);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      displs[0] = 0;
+      for (i = 0; i < size; ++i) {
+        displs[i + 1] = displs[i] + lens[i];
+      }
+      all = SC_ALLOC (char, displs[size]);
+    }
+    mpiret = sc_MPI_Gatherv (out->array, len, sc_MPI_CHAR, all, lens,
+                             displs, sc_MPI_CHAR, 0, sc_timeline_comm);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      snprintf (filename, BUFSIZ, "%s.json", sc_timeline_filename);
+      retval = sc_timeline_write (filename, all, (size_t) displs[size]);
+      SC_FREE (all);
+      SC_FREE (lens);
+      SC_FREE (displs);
+    }
+  }
+  sc_array_destroy (out);
+
+  /* release the ring buffers; the threads will allocate new ones */
+  while ((th = sc_timeline_threads) != NULL) {
+    sc_timeline_threads = th->next;
+    SC_FREE (th->events);
+    SC_FREE (th);
+  }
+  sc_timeline_num_threads = 0;
+  ++sc_timeline_generation;
+  SC_FREE (sc_timeline_filename);
+  sc_timeline_filename = NULL;
+  sc_timeline_comm = sc_MPI_COMM_NULL;
+
+  return retval;
+}
@@ -0,0 +1,123 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_timeline.h
+ *
+ * Record the begin and end of code regions for a timeline view.
+ *
+ * Each thread records events into its own ring buffer, using the
+ * processor's time stamp counter where available.  When the recording is
+ * stopped, the events are written in the Chrome trace event format that
+ * is read by chrome://tracing and https://ui.perfetto.dev.
+ * Either each process writes its own file, or the events of all processes
+ * are gathered into a single file.
+ *
+ * The recording is started by \ref sc_init if the environment variable
+ * SC_TIMELINE_FILE names an output file, and gathered into one file if
+ * SC_TIMELINE_GATHER is set to a nonzero number.  It is stopped and the
+ * output written by \ref sc_finalize.  Collective libsc functions such as
+ * \ref sc_allgather, \ref sc_psort, \ref sc_notify_payload and the
+ * collective I/O functions record their regions by default.
+ *
+ * When no recording is active, \ref SC_TIMELINE_BEGIN and \ref
+ * SC_TIMELINE_END cost a load and a branch.  If SC_TIMELINE_DISABLE is
+ * defined before including this file, they are removed entirely.
+ *
+ * \ingroup sc
+ */
+
+#ifndef SC_TIMELINE_H
+#define SC_TIMELINE_H
+
+#include <sc.h>
+
+/** The number of events each thread keeps.  Older events are overwritten
+ * when a thread records more of them between start and stop. */
+#ifndef SC_TIMELINE_EVENTS
+#define SC_TIMELINE_EVENTS (1 << 16)
+#endif
+
+#ifndef SC_TIMELINE_DISABLE
+
+/** Record the beginning of a region.
+ * \param [in] name     Static string that must stay alive until
+ *                      the recording is stopped, such as __func__.
+ */
+#define SC_TIMELINE_BEGIN(name)                 \
+  do {                                          \
+    if (sc_timeline_active) {                   \
+      sc_timeline_record ((name), 'B');         \
+    }                                           \
+  } while (0)
+
+/** Record the end of a region, see \ref SC_TIMELINE_BEGIN. */
+#define SC_TIMELINE_END(name)                   \
+  do {                                          \
+    if (sc_timeline_active) {                   \
+      sc_timeline_record ((name), 'E');         \
+    }                                           \
+  } while (0)
+
+#else
+
+#define SC_TIMELINE_BEGIN(name) SC_NOOP ()
+#define SC_TIMELINE_END(name) SC_NOOP ()
+
+#endif
+
+SC_EXTERN_C_BEGIN;
+
+/** True while events are being recorded.  Do not change this directly. */
+extern int          sc_timeline_active;
+
+/** Start recording events.
+ * This function is collective over \a mpicomm and aligns the time origin
+ * of all processes with a barrier.
+ * \param [in] mpicomm      Communicator used for the output, or
+ *                          sc_MPI_COMM_NULL for a serial timeline.
+ * \param [in] filename     The output is written to filename.json if
+ *                          \a gather is true, and to filename.rank.json
+ *                          otherwise.  The string is copied.
+ * \param [in] gather       Boolean to write a single file on rank 0.
+ */
+void                sc_timeline_start (sc_MPI_Comm mpicomm,
+                                       const char *filename, int gather);
+
+/** Stop recording and write the output file.
+ * This function is collective if the recording was started with \a gather.
+ * The other threads must not be recording events during this call.
+ * \return          0 on success or if no recording is active, and nonzero
+ *                  if the output could not be written.
+ */
+int                 sc_timeline_stop (void);
+
+/** Record an event on the calling thread.
+ * Use the macros \ref SC_TIMELINE_BEGIN and \ref SC_TIMELINE_END instead.
+ * \param [in] name     Static string naming the region.
+ * \param [in] phase    'B' for begin or 'E' for end.
+ */
+void                sc_timeline_record (const char *name, char phase);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_TIMELINE_H */
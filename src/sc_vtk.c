@@ -0,0 +1,526 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_timeline.h>
+#include <sc_vtk.h>
+#include <stdarg.h>
+
+/** Maximum bytes written by one process in one collective call. */
+#define SC_VTK_IO_CHUNK ((size_t) 1 << 30)
+
+/** Sections of a piece in the order of the XML output. */
+typedef enum
+{
+  SC_VTK_SECTION_POINT_DATA,
+  SC_VTK_SECTION_CELL_DATA,
+  SC_VTK_SECTION_POINTS,
+  SC_VTK_SECTION_CELLS,
+  SC_VTK_SECTION_LAST
+}
+sc_vtk_section_t;
+
+/** One data array of a piece. */
+typedef struct sc_vtk_array
+{
+  char               *name;     /**< Value of the Name attribute. */
+  sc_vtk_type_t       type;     /**< Numeric type of the values. */
+  int                 num_components;   /**< Values per tuple. */
+  sc_vtk_section_t    section;  /**< Section the array belongs to. */
+  const void         *data;     /**< The values, referenced. */
+  size_t              bytes;    /**< Byte size of the values. */
+  sc_array_t         *encoded;  /**< Compressed layout while writing. */
+  unsigned long long  offset;   /**< Position in the appended section. */
+}
+sc_vtk_array_t;
+
+struct sc_vtk_vtu
+{
+  sc_MPI_Comm         mpicomm;
+  int                 mpisize, mpirank;
+  size_t              num_points, num_cells;
+  int                 points_set, cells_set;
+  int                 compress, level, num_threads;
+  sc_array_t         *arrays;   /**< Of sc_vtk_array_t in order added. */
+};
+
+static const char  *sc_vtk_type_names[SC_VTK_TYPE_LAST] = {
+  "Int8", "UInt8", "Int16", "UInt16", "Int32", "UInt32",
+  "Int64", "UInt64", "Float32", "Float64"
+};
+
+static const size_t sc_vtk_type_sizes[SC_VTK_TYPE_LAST] = {
+  1, 1, 2, 2, 4, 4, 8, 8, 4, 8
+};
+
+static const char  *sc_vtk_section_tags[SC_VTK_SECTION_LAST] = {
+  "PointData", "CellData", "Points", "Cells"
+};
+
+sc_vtk_vtu_t       *
+sc_vtk_vtu_new (sc_MPI_Comm mpicomm, size_t num_points, size_t num_cells)
+{
+  int                 mpiret;
+  sc_vtk_vtu_t       *vtu;
+
+  vtu = SC_ALLOC_ZERO (sc_vtk_vtu_t, 1);
+  vtu->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &vtu->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &vtu->mpirank);
+  SC_CHECK_MPI (mpiret);
+  vtu->num_points = num_points;
+  vtu->num_cells = num_cells;
+  vtu->level = -1;
+  vtu->num_threads = 1;
+  vtu->arrays = sc_array_new (sizeof (sc_vtk_array_t));
+  return vtu;
+}
+
+void
+sc_vtk_vtu_destroy (sc_vtk_vtu_t * vtu)
+{
+  size_t              zz;
+  sc_vtk_array_t     *array;
+
+  for (zz = 0; zz < vtu->arrays->elem_count; ++zz) {
+    array = (sc_vtk_array_t *) sc_array_index (vtu->arrays, zz);
+    SC_ASSERT (array->encoded == NULL);
+    SC_FREE (array->name);
+  }
+  sc_array_destroy (vtu->arrays);
+  SC_FREE (vtu);
+}
+
+void
+sc_vtk_vtu_set_compression (sc_vtk_vtu_t * vtu, int zlib_compression_level,
+                            int num_threads)
+{
+  SC_ASSERT (-1 <= zlib_compression_level && zlib_compression_level <= 9);
+
+  vtu->compress = 1;
+  vtu->level = zlib_compression_level;
+  vtu->num_threads = SC_MAX (1, num_threads);
+}
+
+static void
+sc_vtk_vtu_add (sc_vtk_vtu_t * vtu, sc_vtk_section_t section,
+                const char *name, sc_vtk_type_t type, int num_components,
+                size_t num_tuples, const void *data)
+{
+  sc_vtk_array_t     *array;
+
+  SC_ASSERT (name != NULL && strpbrk (name, "<>&\"") == NULL);
+  SC_ASSERT (0 <= type && type < SC_VTK_TYPE_LAST);
+  SC_ASSERT (num_components >= 1);
+  SC_ASSERT (data != NULL || num_tuples == 0);
+
+  array = (sc_vtk_array_t *) sc_array_push (vtu->arrays);
+  array->name = SC_STRDUP (name);
+  array->type = type;
+  array->num_components = num_components;
+  array->section = section;
+  array->data = data;
+  array->bytes = num_tuples * (size_t) num_components *
+    sc_vtk_type_sizes[type];
+  array->encoded = NULL;
+  array->offset = 0;
+}
+
+void
+sc_vtk_vtu_set_points (sc_vtk_vtu_t * vtu, sc_vtk_type_t type,
+                       const void *points)
+{
+  SC_ASSERT (!vtu->points_set);
+  SC_ASSERT (type == SC_VTK_FLOAT32 || type == SC_VTK_FLOAT64);
+
+  sc_vtk_vtu_add (vtu, SC_VTK_SECTION_POINTS, "Points", type, 3,
+                  vtu->num_points, points);
+  vtu->points_set = 1;
+}
+
+void
+sc_vtk_vtu_set_cells (sc_vtk_vtu_t * vtu, const int64_t *connectivity,
+                      const int64_t *offsets, const uint8_t *types)
+{
+  size_t              num_connect;
+
+  SC_ASSERT (!vtu->cells_set);
+  SC_ASSERT (offsets != NULL || vtu->num_cells == 0);
+
+  num_connect = vtu->num_cells > 0 ?
+    (size_t) offsets[vtu->num_cells - 1] : 0;
+  sc_vtk_vtu_add (vtu, SC_VTK_SECTION_CELLS, "connectivity", SC_VTK_INT64,
+                  1, num_connect, connectivity);
+  sc_vtk_vtu_add (vtu, SC_VTK_SECTION_CELLS, "offsets", SC_VTK_INT64,
+                  1, vtu->num_cells, offsets);
+  sc_vtk_vtu_add (vtu, SC_VTK_SECTION_CELLS, "types", SC_VTK_UINT8,
+                  1, vtu->num_cells, types);
+  vtu->cells_set = 1;
+}
+
+void
+sc_vtk_vtu_add_point_data (sc_vtk_vtu_t * vtu, const char *name,
+                           sc_vtk_type_t type, int num_components,
+                           const void *data)
+{
+  sc_vtk_vtu_add (vtu, SC_VTK_SECTION_POINT_DATA, name, type,
+                  num_components, vtu->num_points, data);
+}
+
+void
+sc_vtk_vtu_add_cell_data (sc_vtk_vtu_t * vtu, const char *name,
+                          sc_vtk_type_t type, int num_components,
+                          const void *data)
+{
+  sc_vtk_vtu_add (vtu, SC_VTK_SECTION_CELL_DATA, name, type,
+                  num_components, vtu->num_cells, data);
+}
+
+/** Append formatted text to a byte array. */
+static void
+sc_vtk_putf (sc_array_t * xml, const char *fmt, ...)
+{
+  int                 len;
+  size_t              old;
+  va_list             ap;
+
+  va_start (ap, fmt);
+  len = vsnprintf (NULL, 0, fmt, ap);
+  va_end (ap);
+  SC_ASSERT (len >= 0);
+
+  old = xml->elem_count;
+  sc_array_resize (xml, old + (size_t) len + 1);
+  va_start (ap, fmt);
+  (void) vsnprintf (xml->array + old, (size_t) len + 1, fmt, ap);
+  va_end (ap);
+  sc_array_resize (xml, old + (size_t) len);
+}
+
+/** Return the same error code on all processes.
+ * The error of the lowest failing rank wins.
+ */
+static int
+sc_vtk_sync_error (sc_vtk_vtu_t * vtu, int errcode)
+{
+  int                 mpiret;
+  int                 local, first;
+
+  local = errcode != sc_MPI_SUCCESS ? vtu->mpirank : vtu->mpisize;
+  mpiret = sc_MPI_Allreduce (&local, &first, 1, sc_MPI_INT, sc_MPI_MIN,
+                             vtu->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (first == vtu->mpisize) {
+    return sc_MPI_SUCCESS;
+  }
+  mpiret = sc_MPI_Bcast (&errcode, 1, sc_MPI_INT, first, vtu->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return errcode;
+}
+
+/** Collectively write local bytes at a local offset.
+ * The regions of the processes must be contiguous in the order of ranks
+ * for the serialized fallback without MPI I/O.
+ * \return          Error code synchronized over all processes.
+ */
+static int
+sc_vtk_write_all (sc_vtk_vtu_t * vtu, sc_MPI_File file,
+                  sc_MPI_Offset offset, const char *buf, size_t bytes)
+{
+  int                 mpiret, ocount, errcode;
+  long long           local, max_bytes;
+  size_t              rounds, r, done, chunk;
+
+  local = (long long) bytes;
+  mpiret = sc_MPI_Allreduce (&local, &max_bytes, 1, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_MAX, vtu->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  rounds = SC_MAX (((size_t) max_bytes + SC_VTK_IO_CHUNK - 1) /
+                   SC_VTK_IO_CHUNK, 1);
+#if defined SC_ENABLE_MPI && !defined SC_ENABLE_MPIIO
+  if (rounds > 1) {
+    /* the serialized fallback appends and cannot process multiple rounds */
+    return sc_MPI_ERR_COUNT;
+  }
+#endif
+
+  errcode = sc_MPI_SUCCESS;
+  for (done = 0, r = 0; r < rounds; ++r) {
+    /* after an error we still participate in the collective calls */
+    chunk = errcode == sc_MPI_SUCCESS ?
+      SC_MIN (bytes - done, SC_VTK_IO_CHUNK) : 0;
+    mpiret = sc_io_write_at_all (file, offset + (sc_MPI_Offset) done,
+                                 chunk > 0 ? buf + done : NULL, (int) chunk,
+                                 sc_MPI_BYTE, &ocount);
+    if (errcode == sc_MPI_SUCCESS) {
+      if (mpiret != sc_MPI_SUCCESS) {
+        errcode = mpiret;
+      }
+      else if ((size_t) ocount != chunk) {
+        errcode = sc_MPI_ERR_COUNT;
+      }
+    }
+    done += chunk;
+  }
+  return sc_vtk_sync_error (vtu, errcode);
+}
+
+/** Hash the names, types and shapes of the arrays in the order added. */
+static long long
+sc_vtk_vtu_signature (sc_vtk_vtu_t * vtu)
+{
+  size_t              zz;
+  uint32_t            a, b, c;
+  sc_vtk_array_t     *array;
+
+  a = b = c = (uint32_t) vtu->arrays->elem_count;
+  for (zz = 0; zz < vtu->arrays->elem_count; ++zz) {
+    array = (sc_vtk_array_t *) sc_array_index (vtu->arrays, zz);
+    a += (uint32_t) sc_hash_function_string (array->name, NULL);
+    b += (uint32_t) array->type;
+    c += (uint32_t) array->num_components * SC_VTK_SECTION_LAST +
+      (uint32_t) array->section;
+    sc_hash_mix (a, b, c);
+  }
+  sc_hash_final (a, b, c);
+  return (long long) c;
+}
+
+/** Write the XML text of the local piece. */
+static void
+sc_vtk_vtu_piece (sc_vtk_vtu_t * vtu, sc_array_t * xml)
+{
+  int                 section, first;
+  size_t              zz;
+  sc_vtk_array_t     *array;
+
+  sc_vtk_putf (xml, "    <Piece NumberOfPoints=\"%llu\" "
+               "NumberOfCells=\"%llu\">\n",
+               (unsigned long long) vtu->num_points,
+               (unsigned long long) vtu->num_cells);
+  for (section = 0; section < SC_VTK_SECTION_LAST; ++section) {
+    first = 1;
+    for (zz = 0; zz < vtu->arrays->elem_count; ++zz) {
+      array = (sc_vtk_array_t *) sc_array_index (vtu->arrays, zz);
+      if (array->section != (sc_vtk_section_t) section) {
+        continue;
+      }
+      if (first) {
+        sc_vtk_putf (xml, "      <%s>\n", sc_vtk_section_tags[section]);
+        first = 0;
+      }
+      sc_vtk_putf (xml, "        <DataArray type=\"%s\" Name=\"%s\" "
+                   "NumberOfComponents=\"%d\" format=\"appended\" "
+                   "offset=\"%llu\"/>\n", sc_vtk_type_names[array->type],
+                   array->name, array->num_components, array->offset);
+    }
+    if (!first) {
+      sc_vtk_putf (xml, "      </%s>\n", sc_vtk_section_tags[section]);
+    }
+  }
+  sc_vtk_putf (xml, "    </Piece>\n");
+}
+
+int
+sc_vtk_vtu_write (sc_vtk_vtu_t * vtu, const char *filename)
+{
+  const int           one = 1;
+  const char         *middle =
+    "  </UnstructuredGrid>\n  <AppendedData encoding=\"raw\">\n   _";
+  const char         *footer = "\n  </AppendedData>\n</VTKFile>\n";
+  int                 mpiret, errcode, section;
+  size_t              num_arrays, zz, k;
+  long long           local[4], global[4], xml_sizes[2];
+  long long          *sizes, *totals, *prefix;
+  unsigned long long  data_total;
+  sc_MPI_Offset       xml_offset, data_offset;
+  sc_MPI_File         file;
+  sc_array_t          xml, *order;
+#if defined SC_ENABLE_MPI && !defined SC_ENABLE_MPIIO
+  sc_array_t          block;
+#else
+  uint64_t            header;
+#endif
+  sc_vtk_array_t     *array;
+
+  SC_ASSERT (vtu->points_set && vtu->cells_set);
+  SC_TIMELINE_BEGIN ("sc_vtk_vtu_write");
+
+  /* all processes must describe the same arrays */
+  num_arrays = vtu->arrays->elem_count;
+  local[0] = (long long) num_arrays;
+  local[1] = -local[0];
+  local[2] = sc_vtk_vtu_signature (vtu);
+  local[3] = -local[2];
+  mpiret = sc_MPI_Allreduce (local, global, 4, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_MIN, vtu->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (global[0] != -global[1] || global[2] != -global[3]) {
+    SC_TIMELINE_END ("sc_vtk_vtu_write");
+    return sc_MPI_ERR_ARG;
+  }
+
+  /* list the arrays in the order of the XML output */
+  order = sc_array_new_count (sizeof (sc_vtk_array_t *), 0);
+  for (section = 0; section < SC_VTK_SECTION_LAST; ++section) {
+    for (zz = 0; zz < num_arrays; ++zz) {
+      array = (sc_vtk_array_t *) sc_array_index (vtu->arrays, zz);
+      if (array->section == (sc_vtk_section_t) section) {
+        *(sc_vtk_array_t **) sc_array_push (order) = array;
+      }
+    }
+  }
+
+  /* encode the arrays to know their sizes in the appended section */
+  sizes = SC_ALLOC (long long, 3 * num_arrays);
+  totals = sizes + num_arrays;
+  prefix = totals + num_arrays;
+  for (k = 0; k < num_arrays; ++k) {
+    array = *(sc_vtk_array_t **) sc_array_index (order, k);
+    if (vtu->compress) {
+      array->encoded = sc_array_new (1);
+      sc_vtk_compress_uint64 (array->encoded, (const char *) array->data,
+                              array->bytes, vtu->level, vtu->num_threads);
+      sizes[k] = (long long) array->encoded->elem_count;
+    }
+    else {
+      sizes[k] = (long long) (sizeof (uint64_t) + array->bytes);
+    }
+  }
+
+  /* the data of each array is contiguous in the order of ranks */
+  mpiret = sc_MPI_Allreduce (sizes, totals, (int) num_arrays,
+                             sc_MPI_LONG_LONG_INT, sc_MPI_SUM, vtu->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Exscan (sizes, prefix, (int) num_arrays,
+                          sc_MPI_LONG_LONG_INT, sc_MPI_SUM, vtu->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  data_total = 0;
+  for (k = 0; k < num_arrays; ++k) {
+    array = *(sc_vtk_array_t **) sc_array_index (order, k);
+    array->offset = data_total + (vtu->mpirank > 0 ?
+                                  (unsigned long long) prefix[k] : 0);
+    data_total += (unsigned long long) totals[k];
+  }
+
+  /* rank 0 writes the file header in front of its piece */
+  sc_array_init (&xml, 1);
+  if (vtu->mpirank == 0) {
+    sc_vtk_putf (&xml, "<?xml version=\"1.0\"?>\n"
+                 "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" "
+                 "byte_order=\"%s\" header_type=\"UInt64\"%s>\n"
+                 "  <UnstructuredGrid>\n",
+                 *(const char *) &one ? "LittleEndian" : "BigEndian",
+                 vtu->compress ? " compressor=\"vtkZLibDataCompressor\"" :
+                 "");
+  }
+  sc_vtk_vtu_piece (vtu, &xml);
+  local[0] = (long long) xml.elem_count;
+  mpiret = sc_MPI_Exscan (local, xml_sizes, 1, sc_MPI_LONG_LONG_INT,
+                          sc_MPI_SUM, vtu->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  xml_offset = vtu->mpirank > 0 ? (sc_MPI_Offset) xml_sizes[0] : 0;
+  mpiret = sc_MPI_Allreduce (local, xml_sizes + 1, 1, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_SUM, vtu->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  data_offset = (sc_MPI_Offset) xml_sizes[1] +
+    (sc_MPI_Offset) strlen (middle);
+
+  /* write all parts of the file in the order of their positions */
+  errcode = sc_io_open (vtu->mpicomm, filename, SC_IO_WRITE_CREATE,
+                        sc_MPI_INFO_NULL, &file);
+  errcode = sc_vtk_sync_error (vtu, errcode);
+  if (errcode == sc_MPI_SUCCESS) {
+    errcode = sc_vtk_write_all (vtu, file, xml_offset, xml.array,
+                                xml.elem_count);
+    if (errcode == sc_MPI_SUCCESS) {
+      errcode = sc_vtk_write_all (vtu, file, (sc_MPI_Offset) xml_sizes[1],
+                                  middle, vtu->mpirank == 0 ?
+                                  strlen (middle) : 0);
+    }
+#if defined SC_ENABLE_MPI && !defined SC_ENABLE_MPIIO
+    sc_array_init (&block, 1);
+#endif
+    for (k = 0; k < num_arrays && errcode == sc_MPI_SUCCESS; ++k) {
+      array = *(sc_vtk_array_t **) sc_array_index (order, k);
+      if (vtu->compress) {
+        errcode = sc_vtk_write_all (vtu, file, data_offset +
+                                    (sc_MPI_Offset) array->offset,
+                                    array->encoded->array, (size_t) sizes[k]);
+        continue;
+      }
+      /* the raw layout is the byte size followed by the values */
+#if defined SC_ENABLE_MPI && !defined SC_ENABLE_MPIIO
+      /* the serialized fallback appends each call in the order of ranks,
+         so header and values must be written together */
+      sc_array_resize (&block, sizeof (uint64_t) + array->bytes);
+      *(uint64_t *) block.array = (uint64_t) array->bytes;
+      if (array->bytes > 0) {
+        memcpy (block.array + sizeof (uint64_t), array->data, array->bytes);
+      }
+      errcode = sc_vtk_write_all (vtu, file, data_offset +
+                                  (sc_MPI_Offset) array->offset,
+                                  block.array, (size_t) sizes[k]);
+#else
+      /* write the values in place without copying them behind the header */
+      header = (uint64_t) array->bytes;
+      errcode = sc_vtk_write_all (vtu, file, data_offset +
+                                  (sc_MPI_Offset) array->offset,
+                                  (const char *) &header, sizeof (header));
+      if (errcode == sc_MPI_SUCCESS) {
+        errcode = sc_vtk_write_all (vtu, file, data_offset +
+                                    (sc_MPI_Offset) (array->offset +
+                                                     sizeof (header)),
+                                    (const char *) array->data,
+                                    array->bytes);
+      }
+#endif
+    }
+#if defined SC_ENABLE_MPI && !defined SC_ENABLE_MPIIO
+    sc_array_reset (&block);
+#endif
+    if (errcode == sc_MPI_SUCCESS) {
+      errcode = sc_vtk_write_all (vtu, file, data_offset +
+                                  (sc_MPI_Offset) data_total, footer,
+                                  vtu->mpirank == 0 ? strlen (footer) : 0);
+    }
+    mpiret = sc_io_close (&file);
+    if (errcode == sc_MPI_SUCCESS) {
+      errcode = sc_vtk_sync_error (vtu, mpiret);
+    }
+  }
+
+  /* clean up */
+  for (k = 0; k < num_arrays; ++k) {
+    array = *(sc_vtk_array_t **) sc_array_index (order, k);
+    if (array->encoded != NULL) {
+      sc_array_destroy (array->encoded);
+      array->encoded = NULL;
+    }
+  }
+  SC_FREE (sizes);
+  sc_array_reset (&xml);
+  sc_array_destroy (order);
+  SC_TIMELINE_END ("sc_vtk_vtu_write");
+  return errcode;
+}
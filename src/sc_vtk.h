@@ -0,0 +1,171 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_vtk.h
+ *
+ * Collective writer for VTK unstructured grid files.
+ *
+ * All processes of a communicator write their part of a mesh as one
+ * piece of a single .vtu file, instead of one file per process and a
+ * .pvtu index.  Each process describes its piece with \ref sc_vtk_vtu_new
+ * and the functions to set points, cells and data arrays, and then calls
+ * \ref sc_vtk_vtu_write collectively.  Rank 0 writes the file header and
+ * the closing tags, while every process writes the XML text of its piece
+ * and its binary arrays into the appended section through \ref
+ * sc_io_write_at_all.  The file offsets follow from exclusive scans over
+ * the byte sizes of the pieces.
+ *
+ * The binary data is written in raw form with 64-bit headers.  Optionally,
+ * each process compresses its arrays in the block format of the VTK zlib
+ * compressor, using multiple threads if available.
+ *
+ * Without MPI I/O but with MPI, the library falls back to appending the
+ * data of the processes in order.  This works only as long as no process
+ * writes more than 1 GiB per array and is deprecated.
+ *
+ * \ingroup io
+ */
+
+#ifndef SC_VTK_H
+#define SC_VTK_H
+
+#include <sc_io.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Numeric types of the data arrays. */
+typedef enum
+{
+  SC_VTK_INT8,          /**< VTK type Int8 */
+  SC_VTK_UINT8,         /**< VTK type UInt8 */
+  SC_VTK_INT16,         /**< VTK type Int16 */
+  SC_VTK_UINT16,        /**< VTK type UInt16 */
+  SC_VTK_INT32,         /**< VTK type Int32 */
+  SC_VTK_UINT32,        /**< VTK type UInt32 */
+  SC_VTK_INT64,         /**< VTK type Int64 */
+  SC_VTK_UINT64,        /**< VTK type UInt64 */
+  SC_VTK_FLOAT32,       /**< VTK type Float32 */
+  SC_VTK_FLOAT64,       /**< VTK type Float64 */
+  SC_VTK_TYPE_LAST      /**< Invalid entry to close list */
+}
+sc_vtk_type_t;
+
+/** Opaque description of the local piece of an unstructured grid. */
+typedef struct sc_vtk_vtu sc_vtk_vtu_t;
+
+/** Begin the description of the local piece of an unstructured grid.
+ * The data arrays given to the following functions are referenced, not
+ * copied, and must stay alive until \ref sc_vtk_vtu_write returns.
+ * \param [in] mpicomm      Communicator of all processes writing the file.
+ * \param [in] num_points   Number of points of the local piece.
+ * \param [in] num_cells    Number of cells of the local piece.
+ * \return                  A new piece without points, cells and data.
+ */
+sc_vtk_vtu_t       *sc_vtk_vtu_new (sc_MPI_Comm mpicomm,
+                                    size_t num_points, size_t num_cells);
+
+/** Free the description of a piece.
+ * \param [in] vtu          The piece is destroyed.  The data arrays it
+ *                          references are not touched.
+ */
+void                sc_vtk_vtu_destroy (sc_vtk_vtu_t * vtu);
+
+/** Compress the binary data of the piece.
+ * The setting must be the same on all processes.
+ * \param [in,out] vtu      Piece not yet written.
+ * \param [in] zlib_compression_level   Between 0 and 9, or -1 for zlib's
+ *                          default.  Without zlib, the blocks are
+ *                          stored uncompressed in zlib format.
+ * \param [in] num_threads  Maximum number of threads per process used to
+ *                          compress the blocks of each array.
+ */
+void                sc_vtk_vtu_set_compression (sc_vtk_vtu_t * vtu,
+                                                int zlib_compression_level,
+                                                int num_threads);
+
+/** Set the coordinates of the points.
+ * \param [in,out] vtu      Piece not yet written.
+ * \param [in] type         Either \ref SC_VTK_FLOAT32 or SC_VTK_FLOAT64.
+ * \param [in] points       Three coordinates per point.
+ */
+void                sc_vtk_vtu_set_points (sc_vtk_vtu_t * vtu,
+                                           sc_vtk_type_t type,
+                                           const void *points);
+
+/** Set the cells of the piece.
+ * \param [in,out] vtu      Piece not yet written.
+ * \param [in] connectivity Point indices local to the piece for all cells.
+ * \param [in] offsets      For each cell, the end of its point indices in
+ *                          \a connectivity.
+ * \param [in] types        For each cell, its VTK cell type.
+ */
+void                sc_vtk_vtu_set_cells (sc_vtk_vtu_t * vtu,
+                                          const int64_t *connectivity,
+                                          const int64_t *offsets,
+                                          const uint8_t *types);
+
+/** Add a data array with values for each point.
+ * All processes must add the same arrays in the same order.
+ * \param [in,out] vtu      Piece not yet written.
+ * \param [in] name         Name of the array.  The string is copied.
+ *                          It must not contain XML markup characters.
+ * \param [in] type         Numeric type of the values.
+ * \param [in] num_components   Number of values per point.
+ * \param [in] data         The values of all points.
+ */
+void                sc_vtk_vtu_add_point_data (sc_vtk_vtu_t * vtu,
+                                               const char *name,
+                                               sc_vtk_type_t type,
+                                               int num_components,
+                                               const void *data);
+
+/** Add a data array with values for each cell.
+ * All processes must add the same arrays in the same order.
+ * The parameters are as in \ref sc_vtk_vtu_add_point_data.
+ */
+void                sc_vtk_vtu_add_cell_data (sc_vtk_vtu_t * vtu,
+                                              const char *name,
+                                              sc_vtk_type_t type,
+                                              int num_components,
+                                              const void *data);
+
+/** Write the pieces of all processes into one .vtu file.
+ * This function is collective over the communicator of the piece.
+ * Points and cells must have been set on all processes.
+ * Uncompressed arrays are written in place.  When compressing, each
+ * process holds all of its arrays in encoded form, since their sizes are
+ * needed first.  The deprecated fallback without MPI I/O copies one array
+ * at a time to write it behind its header.
+ * \param [in] vtu          Piece to write.  It may be written again.
+ * \param [in] filename     Path of the file including the .vtu extension.
+ * \return                  \ref sc_MPI_SUCCESS or an sc_MPI_ERR_* code as
+ *                          defined in \ref sc_mpi.h, the same on all
+ *                          processes.  \ref sc_MPI_ERR_ARG indicates that
+ *                          the processes did not add the same arrays.
+ */
+int                 sc_vtk_vtu_write (sc_vtk_vtu_t * vtu,
+                                      const char *filename);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_VTK_H */
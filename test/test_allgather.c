@@ -22,6 +22,10 @@
 */
 
 #include <sc_allgather.h>
+#include <sc_shmem.h>
+
+#define TEST_ALLGATHER_COUNT 64
+#define TEST_ALLGATHER_REPS 10
 
 int
 main (int argc, char **argv)
@@ -39,6 +43,10 @@ main (int argc, char **argv)
   double             *ddata2;
   double              elapsed_allgather;
   double              elapsed_replacement;
+  double              elapsed_mpi, elapsed_flat, elapsed_node;
+  int                 node_size, shared, rep;
+  int                 isend[TEST_ALLGATHER_COUNT];
+  int                *idata1, *idata2;
 
   mpiret = sc_MPI_Init (&argc, &argv);
   SC_CHECK_MPI (mpiret);
@@ -117,12 +125,73 @@ main (int argc, char **argv)
   SC_FREE (ddata1);
   SC_FREE (ddata2);
 
+  /* compare the node-aware version with the flat one and MPI */
+  node_size = mpisize % 2 ? 1 : 2;
+  SC_GLOBAL_INFOF ("Testing node-aware allgather with node size %d\n",
+                   node_size);
+  sc_mpi_comm_attach_node_comms (mpicomm, node_size);
+#ifdef SC_ENABLE_MPIWINSHARED
+  sc_shmem_set_type (mpicomm, SC_SHMEM_WINDOW);
+#endif
+  for (i = 0; i < TEST_ALLGATHER_COUNT; ++i) {
+    isend[i] = mpirank * TEST_ALLGATHER_COUNT + i;
+  }
+  idata1 = SC_ALLOC (int, TEST_ALLGATHER_COUNT * mpisize);
+  idata2 = SC_ALLOC (int, TEST_ALLGATHER_COUNT * mpisize);
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_mpi = -sc_MPI_Wtime ();
+  for (rep = 0; rep < TEST_ALLGATHER_REPS; ++rep) {
+    mpiret = sc_MPI_Allgather (isend, TEST_ALLGATHER_COUNT, sc_MPI_INT,
+                               idata1, TEST_ALLGATHER_COUNT, sc_MPI_INT,
+                               mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  elapsed_mpi += sc_MPI_Wtime ();
+
+  sc_allgather_hierarchical = 0;
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_flat = -sc_MPI_Wtime ();
+  for (rep = 0; rep < TEST_ALLGATHER_REPS; ++rep) {
+    sc_allgather (isend, TEST_ALLGATHER_COUNT, sc_MPI_INT,
+                  idata2, TEST_ALLGATHER_COUNT, sc_MPI_INT, mpicomm);
+  }
+  elapsed_flat += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (!memcmp (idata1, idata2, TEST_ALLGATHER_COUNT * mpisize *
+                           sizeof (int)), "Flat allgather mismatch");
+
+  sc_allgather_hierarchical = 1;
+  memset (idata2, -1, TEST_ALLGATHER_COUNT * mpisize * sizeof (int));
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_node = -sc_MPI_Wtime ();
+  for (rep = 0; rep < TEST_ALLGATHER_REPS; ++rep) {
+    sc_allgather (isend, TEST_ALLGATHER_COUNT, sc_MPI_INT,
+                  idata2, TEST_ALLGATHER_COUNT, sc_MPI_INT, mpicomm);
+  }
+  elapsed_node += sc_MPI_Wtime ();
+  sc_allgather_hierarchical = 0;
+  SC_CHECK_ABORT (!memcmp (idata1, idata2, TEST_ALLGATHER_COUNT * mpisize *
+                           sizeof (int)), "Node allgather mismatch");
+  SC_FREE (idata1);
+  SC_FREE (idata2);
+  shared = sc_shmem_is_shared (mpicomm);
+  sc_mpi_comm_detach_node_comms (mpicomm);
+
   SC_GLOBAL_STATISTICSF ("Timings with threshold %d on %d cores\n",
                          SC_ALLGATHER_ALLTOALL_MAX, mpisize);
   SC_GLOBAL_STATISTICSF ("   alltoall %g\n", elapsed_alltoall);
   SC_GLOBAL_STATISTICSF ("   recursive %g\n", elapsed_recursive);
   SC_GLOBAL_STATISTICSF ("   allgather %g\n", elapsed_allgather);
   SC_GLOBAL_STATISTICSF ("   replacement %g\n", elapsed_replacement);
+  SC_GLOBAL_STATISTICSF ("Timings of %d allgathers of %d ints, node size %d"
+                         " (shared %d)\n", TEST_ALLGATHER_REPS,
+                         TEST_ALLGATHER_COUNT, node_size, shared);
+  SC_GLOBAL_STATISTICSF ("   MPI %g\n", elapsed_mpi);
+  SC_GLOBAL_STATISTICSF ("   flat %g\n", elapsed_flat);
+  SC_GLOBAL_STATISTICSF ("   node %g\n", elapsed_node);
 
   sc_finalize ();
 
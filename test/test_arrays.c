@@ -103,6 +103,90 @@ test_new_data (sc_array_t * a)
   sc_array_destroy (v);
 }
 
+typedef struct test_key_record
+{
+  int32_t             seq;
+  int32_t             k32;
+  int64_t             k64;
+  uint64_t            u64;
+  uint16_t            u16;
+}
+test_key_record_t;
+
+static int
+test_key_compare_k64 (const void *v1, const void *v2)
+{
+  const test_key_record_t *r1 = (const test_key_record_t *) v1;
+  const test_key_record_t *r2 = (const test_key_record_t *) v2;
+
+  return r1->k64 < r2->k64 ? -1 : r1->k64 > r2->k64;
+}
+
+/* sort by each key and check the order and the stability */
+static void
+test_sort_key (size_t count)
+{
+  size_t              zz;
+  test_key_record_t  *r, *q;
+  sc_array_t         *a, *b;
+
+  a = sc_array_new_count (sizeof (test_key_record_t), count);
+  b = sc_array_new_count (sizeof (test_key_record_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    r = (test_key_record_t *) sc_array_index (a, zz);
+    memset (r, 0, sizeof (*r));
+    r->seq = (int32_t) zz;
+    r->k32 = (int32_t) (rand () % 2001) - 1000;
+    r->k64 = ((int64_t) rand () << 31 | rand ()) * (rand () % 2 ? 1 : -1);
+    r->u64 = (uint64_t) rand () << 33 | (uint64_t) rand ();
+    r->u16 = (uint16_t) (rand () % 17);
+  }
+
+  /* signed 32-bit keys with many duplicates */
+  sc_array_copy (b, a);
+  sc_array_sort_key (b, offsetof (test_key_record_t, k32), 4, 1);
+  for (zz = 1; zz < count; ++zz) {
+    r = (test_key_record_t *) sc_array_index (b, zz - 1);
+    q = (test_key_record_t *) sc_array_index (b, zz);
+    SC_CHECK_ABORT (r->k32 < q->k32 ||
+                    (r->k32 == q->k32 && r->seq < q->seq), "Sort k32");
+  }
+
+  /* unsigned 16 and 64-bit keys */
+  sc_array_sort_key (b, offsetof (test_key_record_t, u16), 2, 0);
+  for (zz = 1; zz < count; ++zz) {
+    r = (test_key_record_t *) sc_array_index (b, zz - 1);
+    q = (test_key_record_t *) sc_array_index (b, zz);
+    SC_CHECK_ABORT (r->u16 < q->u16 || (r->u16 == q->u16 &&
+                                        (r->k32 < q->k32 ||
+                                         (r->k32 == q->k32 &&
+                                          r->seq < q->seq))), "Sort u16");
+  }
+  sc_array_sort_key (b, offsetof (test_key_record_t, u64), 8, 0);
+  for (zz = 1; zz < count; ++zz) {
+    r = (test_key_record_t *) sc_array_index (b, zz - 1);
+    q = (test_key_record_t *) sc_array_index (b, zz);
+    SC_CHECK_ABORT (r->u64 <= q->u64, "Sort u64");
+  }
+
+  /* signed 64-bit keys, serial and threaded */
+  sc_array_copy (b, a);
+  sc_array_sort_key (b, offsetof (test_key_record_t, k64), 8, 1);
+  SC_CHECK_ABORT (sc_array_is_sorted (b, test_key_compare_k64), "Sort k64");
+
+  sc_array_copy (b, a);
+  sc_array_sort_key_ext (b, offsetof (test_key_record_t, k64), 8, 1, 4);
+  for (zz = 1; zz < count; ++zz) {
+    r = (test_key_record_t *) sc_array_index (b, zz - 1);
+    q = (test_key_record_t *) sc_array_index (b, zz);
+    SC_CHECK_ABORT (r->k64 < q->k64 ||
+                    (r->k64 == q->k64 && r->seq < q->seq), "Threaded k64");
+  }
+
+  sc_array_destroy (a);
+  sc_array_destroy (b);
+}
+
 static void
 test_mstamp (void)
 {
@@ -144,6 +228,112 @@ test_mstamp (void)
   }
 }
 
+/* resize an array back and forth across a power of two boundary */
+static void
+test_churn_run (const sc_array_policy_t * policy, int rounds,
+                sc_array_counts_t * counts)
+{
+  int                 i, j;
+  sc_array_t         *a;
+  sc_array_counts_t   before, after;
+
+  sc_array_set_policy (policy);
+  sc_array_get_counts (&before);
+
+  a = sc_array_new (sizeof (int));
+  for (i = 0; i < rounds; ++i) {
+    sc_array_resize (a, 1024);
+    sc_array_resize (a, 1025);
+    *(int *) sc_array_index (a, 1024) = i;
+    for (j = 0; j < 4; ++j) {
+      *(int *) sc_array_push (a) = j;
+      sc_array_resize (a, a->elem_count - 1);
+    }
+  }
+  SC_CHECK_ABORT (a->elem_count == 1025 &&
+                  *(int *) sc_array_index (a, 1024) == rounds - 1,
+                  "Churn content");
+  sc_array_destroy (a);
+
+  sc_array_get_counts (&after);
+  counts->grows = after.grows - before.grows;
+  counts->shrinks = after.shrinks - before.shrinks;
+  counts->bytes = after.bytes - before.bytes;
+}
+
+static void
+test_policy (void)
+{
+  const int           rounds = 10000;
+  int                 i;
+  sc_array_counts_t   legacy, current;
+  sc_array_t         *a;
+  sc_array_policy_t   saved, policy;
+
+  sc_array_get_policy (&saved);
+
+  /* the hysteresis avoids reallocation at the boundary */
+  policy.growth = 2.;
+  policy.shrink = 2.;
+  test_churn_run (&policy, rounds, &legacy);
+  policy.shrink = 4.;
+  test_churn_run (&policy, rounds, &current);
+  SC_GLOBAL_INFOF ("Churn with shrink 2: %lld grows %lld shrinks %lld bytes\n",
+                   (long long) legacy.grows, (long long) legacy.shrinks,
+                   (long long) legacy.bytes);
+  SC_GLOBAL_INFOF ("Churn with shrink 4: %lld grows %lld shrinks %lld bytes\n",
+                   (long long) current.grows, (long long) current.shrinks,
+                   (long long) current.bytes);
+  SC_CHECK_ABORT (legacy.shrinks >= (size_t) rounds - 1 &&
+                  current.grows <= 2 && current.shrinks == 0,
+                  "Churn reallocations");
+
+  /* a smaller growth factor keeps the contents as well */
+  policy.growth = 1.5;
+  policy.shrink = 0.;
+  sc_array_set_policy (&policy);
+  a = sc_array_new (sizeof (int));
+  for (i = 0; i < 5000; ++i) {
+    *(int *) sc_array_push (a) = i;
+    SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) < 2 * (i + 1) * sizeof (int) +
+                    sizeof (int), "Growth factor");
+  }
+  sc_array_resize (a, 10);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) >= 5000 * sizeof (int),
+                  "Never shrink");
+
+  /* reserve and shrink to fit */
+  sc_array_shrink_to_fit (a);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) == 10 * sizeof (int),
+                  "Shrink to fit");
+  sc_array_reserve (a, 100);
+  SC_CHECK_ABORT (a->elem_count == 10 &&
+                  SC_ARRAY_BYTE_ALLOC (a) == 100 * sizeof (int), "Reserve");
+  for (i = 0; i < 10; ++i) {
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (a, i) == i, "Reserve data");
+  }
+  sc_array_destroy (a);
+
+  /* growing within a reservation keeps it with a shrinking policy */
+  policy.growth = 2.;
+  policy.shrink = 4.;
+  sc_array_set_policy (&policy);
+  a = sc_array_new_count (sizeof (int), 10);
+  sc_array_reserve (a, 100);
+  sc_array_resize (a, 11);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) == 100 * sizeof (int),
+                  "Reserve and grow");
+  sc_array_resize (a, 12);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) == 100 * sizeof (int),
+                  "Reserve and grow again");
+  sc_array_resize (a, 10);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) < 100 * sizeof (int),
+                  "Resize down below reservation");
+  sc_array_destroy (a);
+
+  sc_array_set_policy (&saved);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -272,6 +462,10 @@ main (int argc, char **argv)
   SC_FREE (data);
 
   test_mstamp ();
+  test_sort_key (1);
+  test_sort_key (1000);
+  test_sort_key (200000);
+  test_policy ();
 
   sc_finalize ();
 
@@ -0,0 +1,426 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+typedef struct test_fhash_node
+{
+  int                 key[3];
+  int                 value;
+}
+test_fhash_node_t;
+
+typedef struct test_fhash_thread
+{
+  int                 first, last;
+  int                 added;
+  test_fhash_node_t  *nodes;
+  size_t             *positions;
+  sc_chash_t         *chash;
+}
+test_fhash_thread_t;
+
+static unsigned int
+test_fhash_hash (const void *v, const void *u)
+{
+  const test_fhash_node_t *n = (const test_fhash_node_t *) v;
+  unsigned int        a, b, c;
+
+  a = (unsigned int) n->key[0];
+  b = (unsigned int) n->key[1];
+  c = (unsigned int) n->key[2];
+  sc_hash_mix (a, b, c);
+  sc_hash_final (a, b, c);
+
+  return c;
+}
+
+static int
+test_fhash_equal (const void *v1, const void *v2, const void *u)
+{
+  const test_fhash_node_t *n1 = (const test_fhash_node_t *) v1;
+  const test_fhash_node_t *n2 = (const test_fhash_node_t *) v2;
+
+  return n1->key[0] == n2->key[0] &&
+    n1->key[1] == n2->key[1] && n1->key[2] == n2->key[2];
+}
+
+static int
+test_fhash_count (void *v, const void *u)
+{
+  const test_fhash_node_t *n = (const test_fhash_node_t *) v;
+
+  SC_CHECK_ABORT (n->value == n->key[0] + n->key[1], "Foreach value");
+  ++*(size_t *) u;
+
+  return 1;
+}
+
+static void
+test_fhash_key (test_fhash_node_t * n, int range)
+{
+  n->key[0] = rand () % range;
+  n->key[1] = rand () % 7;
+  n->key[2] = -n->key[0];
+  n->value = n->key[0] + n->key[1];
+}
+
+/* insert, look up and remove items and compare with the chained table */
+static void
+test_fhash_table (int count)
+{
+  int                 i, added, fadded, found, ffound;
+  size_t              foreach_count;
+  void              **pfound;
+  void               *ffound_item;
+  test_fhash_node_t  *nodes, removed;
+  sc_hash_t          *hash;
+  sc_fhash_t         *fhash;
+
+  nodes = SC_ALLOC (test_fhash_node_t, count);
+  hash = sc_hash_new (test_fhash_hash, test_fhash_equal, NULL, NULL);
+  foreach_count = 0;
+  fhash = sc_fhash_new (sizeof (test_fhash_node_t),
+                        test_fhash_hash, test_fhash_equal, &foreach_count);
+
+  for (i = 0; i < count; ++i) {
+    test_fhash_key (&nodes[i], count / 3 + 1);
+    added = sc_hash_insert_unique (hash, &nodes[i], &pfound);
+    fadded = sc_fhash_insert_unique (fhash, &nodes[i], &ffound_item);
+    SC_CHECK_ABORT (added == fadded, "Insert mismatch");
+    SC_CHECK_ABORT (test_fhash_equal (*pfound, ffound_item, NULL),
+                    "Insert result");
+  }
+  SC_CHECK_ABORT (hash->elem_count == fhash->elem_count, "Count mismatch");
+  sc_fhash_foreach (fhash, test_fhash_count);
+  SC_CHECK_ABORT (foreach_count == fhash->elem_count, "Foreach count");
+  sc_fhash_print_statistics (sc_package_id, SC_LP_STATISTICS, fhash);
+
+  /* remove every other item and verify the remaining ones */
+  for (i = 0; i < count; i += 2) {
+    found = sc_hash_remove (hash, &nodes[i], NULL);
+    ffound = sc_fhash_remove (fhash, &nodes[i], &removed);
+    SC_CHECK_ABORT (found == ffound, "Remove mismatch");
+    SC_CHECK_ABORT (!ffound || test_fhash_equal (&removed, &nodes[i], NULL),
+                    "Remove result");
+  }
+  SC_CHECK_ABORT (hash->elem_count == fhash->elem_count, "Count mismatch");
+  for (i = 0; i < count; ++i) {
+    found = sc_hash_lookup (hash, &nodes[i], NULL);
+    ffound = sc_fhash_lookup (fhash, &nodes[i], &ffound_item);
+    SC_CHECK_ABORT (found == ffound, "Lookup mismatch");
+    SC_CHECK_ABORT (!ffound ||
+                    ((test_fhash_node_t *) ffound_item)->value ==
+                    nodes[i].value, "Lookup value");
+  }
+  sc_fhash_print_statistics (sc_package_id, SC_LP_STATISTICS, fhash);
+
+  /* remove everything such that the table shrinks and is reused */
+  for (i = 0; i < count; ++i) {
+    (void) sc_fhash_remove (fhash, &nodes[i], NULL);
+  }
+  SC_CHECK_ABORT (fhash->elem_count == 0, "Empty table");
+  for (i = 0; i < count; ++i) {
+    (void) sc_fhash_insert_unique (fhash, &nodes[i], NULL);
+  }
+  sc_fhash_truncate (fhash);
+  SC_CHECK_ABORT (fhash->elem_count == 0, "Truncated table");
+  SC_CHECK_ABORT (!sc_fhash_lookup (fhash, &nodes[0], NULL), "Truncate");
+
+  sc_fhash_destroy_null (&fhash);
+  sc_hash_destroy_null (&hash);
+  SC_FREE (nodes);
+}
+
+/* deduplicate with both hash arrays and compare results and timings */
+static void
+test_fhash_array (int count)
+{
+  int                 i;
+  size_t              p1, p2;
+  double              elapsed_hash, elapsed_fhash;
+  test_fhash_node_t  *nodes, *n1, *n2;
+  sc_hash_array_t    *ha;
+  sc_fhash_array_t   *fa;
+  sc_array_t          r1, r2;
+
+  nodes = SC_ALLOC (test_fhash_node_t, count);
+  for (i = 0; i < count; ++i) {
+    test_fhash_key (&nodes[i], count / 2 + 1);
+  }
+
+  ha = sc_hash_array_new (sizeof (test_fhash_node_t),
+                          test_fhash_hash, test_fhash_equal, NULL);
+  elapsed_hash = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    n1 = (test_fhash_node_t *)
+      sc_hash_array_insert_unique (ha, &nodes[i], &p1);
+    if (n1 != NULL) {
+      *n1 = nodes[i];
+    }
+  }
+  elapsed_hash += sc_MPI_Wtime ();
+  SC_GLOBAL_INFOF ("Hash array memory %lld\n",
+                   (long long) sc_hash_array_memory_used (ha));
+
+  fa = sc_fhash_array_new (sizeof (test_fhash_node_t),
+                           test_fhash_hash, test_fhash_equal, NULL);
+  elapsed_fhash = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    n2 = (test_fhash_node_t *)
+      sc_fhash_array_insert_unique (fa, &nodes[i], &p2);
+    if (n2 != NULL) {
+      *n2 = nodes[i];
+    }
+  }
+  elapsed_fhash += sc_MPI_Wtime ();
+  SC_GLOBAL_INFOF ("Flat hash array memory %lld\n",
+                   (long long) sc_fhash_array_memory_used (fa));
+
+  /* both variants assign the same positions in order of first insertion */
+  for (i = 0; i < count; ++i) {
+    SC_CHECK_ABORT (sc_hash_array_lookup (ha, &nodes[i], &p1), "Lookup");
+    SC_CHECK_ABORT (sc_fhash_array_lookup (fa, &nodes[i], &p2), "Lookup");
+    SC_CHECK_ABORT (p1 == p2, "Position mismatch");
+  }
+  SC_CHECK_ABORT (sc_hash_array_is_valid (ha), "Hash array invalid");
+  SC_CHECK_ABORT (sc_fhash_array_is_valid (fa), "Flat hash array invalid");
+
+  sc_hash_array_rip (ha, &r1);
+  sc_fhash_array_rip (fa, &r2);
+  SC_CHECK_ABORT (sc_array_is_equal (&r1, &r2), "Rip mismatch");
+  sc_array_reset (&r1);
+  sc_array_reset (&r2);
+
+  fa = sc_fhash_array_new (sizeof (test_fhash_node_t),
+                           test_fhash_hash, test_fhash_equal, NULL);
+  (void) sc_fhash_array_insert_unique (fa, &nodes[0], NULL);
+  sc_fhash_array_truncate (fa);
+  SC_CHECK_ABORT (!sc_fhash_array_lookup (fa, &nodes[0], NULL), "Truncate");
+  sc_fhash_array_destroy (fa);
+  SC_FREE (nodes);
+
+  SC_GLOBAL_STATISTICSF ("Timings for %d insertions\n", count);
+  SC_GLOBAL_STATISTICSF ("   hash array %g\n", elapsed_hash);
+  SC_GLOBAL_STATISTICSF ("   flat hash array %g\n", elapsed_fhash);
+}
+
+static void        *
+test_fhash_insert_run (void *v)
+{
+  test_fhash_thread_t *tt = (test_fhash_thread_t *) v;
+  int                 i;
+  test_fhash_node_t   found;
+
+  tt->added = 0;
+  for (i = tt->first; i < tt->last; ++i) {
+    if (sc_chash_insert_unique (tt->chash, &tt->nodes[i], &found)) {
+      ++tt->added;
+    }
+    SC_CHECK_ABORT (test_fhash_equal (&found, &tt->nodes[i], NULL) &&
+                    found.value == tt->nodes[i].value, "Concurrent found");
+    SC_CHECK_ABORT (sc_chash_lookup (tt->chash, &tt->nodes[i], NULL),
+                    "Concurrent lookup");
+  }
+  return NULL;
+}
+
+static void        *
+test_fhash_lookup_run (void *v)
+{
+  test_fhash_thread_t *tt = (test_fhash_thread_t *) v;
+  int                 i;
+
+  for (i = tt->first; i < tt->last; ++i) {
+    SC_CHECK_ABORT (sc_chash_lookup (tt->chash, &tt->nodes[i],
+                                     &tt->positions[i]), "Frozen lookup");
+  }
+  return NULL;
+}
+
+/* run a function on all threads, or serially if threads are off */
+static double
+test_fhash_threads (test_fhash_thread_t * tts, int num_threads,
+                    void *(*func) (void *))
+{
+  int                 t;
+  double              elapsed;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t          *threads;
+
+  threads = SC_ALLOC (pthread_t, num_threads);
+#endif
+  elapsed = -sc_MPI_Wtime ();
+#ifdef SC_ENABLE_PTHREAD
+  for (t = 0; t < num_threads; ++t) {
+    pth = pthread_create (&threads[t], NULL, func, &tts[t]);
+    SC_CHECK_ABORT (pth == 0, "Thread create");
+  }
+  for (t = 0; t < num_threads; ++t) {
+    pth = pthread_join (threads[t], NULL);
+    SC_CHECK_ABORT (pth == 0, "Thread join");
+  }
+  SC_FREE (threads);
+#else
+  for (t = 0; t < num_threads; ++t) {
+    func (&tts[t]);
+  }
+#endif
+  elapsed += sc_MPI_Wtime ();
+  return elapsed;
+}
+
+/* deduplicate from many threads and compare with the serial hash array */
+static void
+test_fhash_concurrent (int count, int num_threads)
+{
+  int                 i, t, added;
+  size_t              zz, position, *positions;
+  double              elapsed_insert, elapsed_lookup, elapsed_serial;
+  test_fhash_node_t  *nodes, *n;
+  test_fhash_thread_t *tts;
+  sc_fhash_array_t   *fa;
+  sc_chash_t         *chash;
+  sc_array_t          rip;
+
+  nodes = SC_ALLOC (test_fhash_node_t, count);
+  positions = SC_ALLOC (size_t, count);
+  for (i = 0; i < count; ++i) {
+    test_fhash_key (&nodes[i], count / 4 + 1);
+  }
+
+  fa = sc_fhash_array_new (sizeof (test_fhash_node_t),
+                           test_fhash_hash, test_fhash_equal, NULL);
+  elapsed_serial = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    n = (test_fhash_node_t *) sc_fhash_array_insert_unique (fa, &nodes[i],
+                                                            NULL);
+    if (n != NULL) {
+      *n = nodes[i];
+    }
+  }
+  elapsed_serial += sc_MPI_Wtime ();
+
+  /* the threads insert overlapping ranges of the same nodes */
+  chash = sc_chash_new (sizeof (test_fhash_node_t),
+                        test_fhash_hash, test_fhash_equal, NULL, 0);
+  tts = SC_ALLOC (test_fhash_thread_t, num_threads);
+  for (t = 0; t < num_threads; ++t) {
+    tts[t].first = (int) (((long) count * t) / num_threads);
+    tts[t].last = (int) (((long) count * (t + 1)) / num_threads);
+    tts[t].nodes = nodes;
+    tts[t].positions = positions;
+    tts[t].chash = chash;
+  }
+  elapsed_insert = test_fhash_threads (tts, num_threads,
+                                       test_fhash_insert_run);
+  added = 0;
+  for (t = 0; t < num_threads; ++t) {
+    added += tts[t].added;
+  }
+  sc_chash_freeze (chash);
+  SC_CHECK_ABORT ((size_t) added == chash->elem_count, "Concurrent added");
+  SC_CHECK_ABORT (chash->elem_count == fa->a.elem_count, "Concurrent count");
+  SC_GLOBAL_INFOF ("Concurrent hash array memory %lld\n",
+                   (long long) sc_chash_memory_used (chash));
+
+  /* positions are dense and refer to equal items */
+  elapsed_lookup = test_fhash_threads (tts, num_threads,
+                                       test_fhash_lookup_run);
+  for (i = 0; i < count; ++i) {
+    SC_CHECK_ABORT (positions[i] < chash->elem_count, "Position range");
+    n = (test_fhash_node_t *) sc_chash_index (chash, positions[i]);
+    SC_CHECK_ABORT (test_fhash_equal (n, &nodes[i], NULL), "Position item");
+  }
+
+  sc_chash_rip (chash, &rip);
+  SC_CHECK_ABORT (rip.elem_count == fa->a.elem_count, "Rip count");
+  for (zz = 0; zz < rip.elem_count; ++zz) {
+    n = (test_fhash_node_t *) sc_array_index (&rip, zz);
+    SC_CHECK_ABORT (sc_fhash_array_lookup (fa, n, &position), "Rip item");
+    SC_CHECK_ABORT (n->value ==
+                    ((test_fhash_node_t *) sc_array_index (&fa->a,
+                                                           position))->value,
+                    "Rip value");
+  }
+  for (i = 0; i < count; ++i) {
+    n = (test_fhash_node_t *) sc_array_index (&rip, positions[i]);
+    SC_CHECK_ABORT (test_fhash_equal (n, &nodes[i], NULL), "Rip position");
+  }
+  sc_array_reset (&rip);
+
+  /* a container without items is legal */
+  chash = sc_chash_new (sizeof (int), test_fhash_hash, test_fhash_equal,
+                        NULL, 3);
+  sc_chash_freeze (chash);
+  SC_CHECK_ABORT (chash->elem_count == 0, "Empty container");
+  sc_chash_destroy (chash);
+
+  sc_fhash_array_destroy (fa);
+  SC_FREE (tts);
+  SC_FREE (positions);
+  SC_FREE (nodes);
+
+  SC_GLOBAL_STATISTICSF ("Timings for %d insertions on %d threads\n",
+                         count, num_threads);
+  SC_GLOBAL_STATISTICSF ("   serial flat hash array %g\n", elapsed_serial);
+  SC_GLOBAL_STATISTICSF ("   concurrent insert %g\n", elapsed_insert);
+  SC_GLOBAL_STATISTICSF ("   concurrent frozen lookup %g\n", elapsed_lookup);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 count, num_threads;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* optional arguments set the number of insertions and threads */
+  count = 100000;
+  num_threads = 4;
+  if (argc >= 2) {
+    count = SC_MAX (sc_atoi (argv[1]), 1);
+  }
+  if (argc >= 3) {
+    num_threads = SC_MAX (sc_atoi (argv[2]), 1);
+  }
+
+  test_fhash_table (count);
+  test_fhash_array (count);
+  test_fhash_concurrent (count, num_threads);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
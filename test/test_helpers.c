@@ -312,6 +312,84 @@ test_encode_decode (void)
   return num_failed_tests;
 }
 
+/* encode in independent blocks and decode with several threads */
+static int
+test_encode_chunked (void)
+{
+  const size_t        sizes[5] = { 0, 1, 1000, 5700, 300001 };
+  const size_t        blocks[4] = { 0, 100, 4096, 65536 };
+  const int           threads[3] = { 1, 3, 8 };
+  int                 num_failed_tests = 0;
+  int                 is, ib, it;
+  char                fc;
+  size_t              sz, zz, original_size;
+  sc_array_t          src, ref, dest, comp;
+
+  sc_array_init (&ref, 1);
+  sc_array_init (&dest, 1);
+  sc_array_init (&comp, 1);
+  for (is = 0; is < 5; ++is) {
+    sz = sizes[is];
+    sc_array_init_count (&src, 1, sz);
+    for (zz = 0; zz < sz; ++zz) {
+      src.array[zz] = (char) ((zz * zz) % 251 + (zz / 1000) % 3);
+    }
+
+    /* the reference format remains readable with threads */
+    sc_io_encode (&src, &ref);
+    if (sc_io_decode_threads (&ref, &comp, 0, 4, NULL) ||
+        comp.elem_count != sz || memcmp (src.array, comp.array, sz)) {
+      SC_LERRORF ("threaded decode mismatch %d\n", is);
+      ++num_failed_tests;
+    }
+
+    for (ib = 0; ib < 4; ++ib) {
+      sc_io_encode_chunked (&src, &ref, -1, '=', blocks[ib], 1);
+      if (sc_io_decode_info (&ref, &original_size, &fc, NULL) ||
+          fc != 'p' || original_size != sz) {
+        SC_LERRORF ("chunked decode info error %d %d\n", is, ib);
+        ++num_failed_tests;
+      }
+      for (it = 0; it < 3; ++it) {
+        /* the encoding does not depend on the number of threads */
+        sc_io_encode_chunked (&src, &dest, -1, '=', blocks[ib], threads[it]);
+        if (dest.elem_count != ref.elem_count ||
+            memcmp (dest.array, ref.array, ref.elem_count)) {
+          SC_LERRORF ("chunked encode mismatch %d %d %d\n", is, ib, it);
+          ++num_failed_tests;
+        }
+        if (sc_io_decode_threads (&dest, &comp, 0, threads[it], NULL) ||
+            comp.elem_count != sz || memcmp (src.array, comp.array, sz)) {
+          SC_LERRORF ("chunked decode mismatch %d %d %d\n", is, ib, it);
+          ++num_failed_tests;
+        }
+      }
+
+      /* the serial decoder reads the chunked format in place */
+      if (sc_io_decode (&dest, NULL, 0, NULL) ||
+          dest.elem_count != sz || memcmp (src.array, dest.array, sz)) {
+        SC_LERRORF ("chunked in place mismatch %d %d\n", is, ib);
+        ++num_failed_tests;
+      }
+
+      /* a corrupted block table is detected */
+      if (sz > 0) {
+        /* code characters 32 to 35 hold the last byte of the first length */
+        ref.array[32] = ref.array[32] == 'A' ? 'B' : 'A';
+        if (!sc_io_decode_threads (&ref, &comp, 0, 3, NULL)) {
+          SC_LERRORF ("chunked corruption undetected %d %d\n", is, ib);
+          ++num_failed_tests;
+        }
+      }
+    }
+    sc_array_reset (&src);
+  }
+  sc_array_reset (&ref);
+  sc_array_reset (&dest);
+  sc_array_reset (&comp);
+  return num_failed_tests;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -344,6 +422,7 @@ main (int argc, char **argv)
 
   /* test encode and decode functions */
   num_failed_tests += test_encode_decode ();
+  num_failed_tests += test_encode_chunked ();
 
   /* clean up and exit */
   sc_finalize ();
@@ -106,6 +106,76 @@ test_file (const char *filename)
   return test_return (0, buffer);
 }
 
+int
+test_map (const char *filename)
+{
+  int                 retval;
+  size_t              length, bout;
+  char                read[BUFSIZ];
+  const char         *string = "This string is mapped from a file.\n";
+  sc_io_source_t     *source;
+
+  /* the buffer is freed before returning from this function */
+  sc_array_t         *buffer = NULL;
+  sc_array_t         *map;
+
+  /* save the encoded string to a file */
+  buffer = array_new_string (string, &length);
+  sc_io_encode (buffer, NULL);
+  if (sc_io_file_save (filename, buffer)) {
+    SC_LERRORF ("Error saving file %s\n", filename);
+    return test_return (-1, buffer);
+  }
+
+  /* the mapping matches the file contents */
+  if ((map = sc_io_file_map (filename)) == NULL) {
+    SC_LERRORF ("Error mapping file %s\n", filename);
+    return test_return (-1, buffer);
+  }
+  retval = map->elem_count != buffer->elem_count ||
+    memcmp (map->array, buffer->array, buffer->elem_count);
+
+  /* decode from the mapping without a copy of the input */
+  sc_array_reset (buffer);
+  retval = retval || sc_io_decode (map, buffer, 0, NULL) ||
+    buffer->elem_count != length || memcmp (buffer->array, string, length);
+  retval = sc_io_file_unmap (map) || retval;
+  if (retval) {
+    SC_LERRORF ("Error decoding mapped file %s\n", filename);
+    return test_return (-1, buffer);
+  }
+
+  /* a mapped source reads the same bytes as a file source */
+  if ((source = sc_io_source_new (SC_IO_TYPE_MMAP, SC_IO_ENCODE_NONE,
+                                  filename)) == NULL) {
+    SC_LERRORF ("Error creating mapped source %s\n", filename);
+    return test_return (-1, buffer);
+  }
+  sc_array_reset (buffer);
+  sc_io_file_load (filename, buffer);
+  retval = buffer->elem_count > BUFSIZ ||
+    sc_io_source_read (source, read, buffer->elem_count, NULL) ||
+    memcmp (read, buffer->array, buffer->elem_count) ||
+    sc_io_source_read (source, read, 1, &bout) || bout != 0;
+  retval = sc_io_source_destroy (source) || retval;
+  if (retval) {
+    SC_LERRORF ("Error reading mapped source %s\n", filename);
+    return test_return (-1, buffer);
+  }
+
+  /* an empty file is mapped to an empty array */
+  sc_array_reset (buffer);
+  if (sc_io_file_save (filename, buffer) ||
+      (map = sc_io_file_map (filename)) == NULL || map->elem_count != 0 ||
+      sc_io_file_unmap (map)) {
+    SC_LERRORF ("Error mapping empty file %s\n", filename);
+    return test_return (-1, buffer);
+  }
+  sc_array_destroy_null (&buffer);
+
+  return test_return (0, buffer);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -147,6 +217,7 @@ main (int argc, char **argv)
     /* run test function */
     snprintf (filename, BUFSIZ, "%s.%06d", filepref, mpirank);
     retloc = test_file (filename);
+    retloc = retloc || test_map (filename);
 
     /* the test function is not collective; synchronize error value */
     mpiret = sc_MPI_Allreduce (&retloc, &retval, 1, sc_MPI_INT,
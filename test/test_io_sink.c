@@ -62,6 +62,98 @@ the_test (const char *filename)
   }
 }
 
+/* write and read back compressed streams in chunks of varying size */
+static void
+test_encode (int ioencode, const char *filename)
+{
+  const size_t        total = 3 << 20;
+  const char          tail[] = "A second stream follows the first.\n";
+  int                 retval, have;
+  size_t              zz, pos, chunk, bytes_in, bytes_out, compressed;
+  char               *data, *verify;
+  sc_array_t         *buffer, view;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  have = ioencode == SC_IO_ENCODE_ZLIB ? sc_have_zlib () : sc_have_zstd ();
+  buffer = sc_array_new (sizeof (char));
+  sink = filename == NULL ?
+    sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE, ioencode, buffer) :
+    sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE, ioencode,
+                    filename);
+  SC_CHECK_ABORT ((sink != NULL) == have, "Encoded sink availability");
+  if (sink == NULL) {
+    sc_array_destroy (buffer);
+    return;
+  }
+
+  /* compressible data with some variation */
+  data = SC_ALLOC (char, total);
+  verify = SC_ALLOC (char, total);
+  for (zz = 0; zz < total; ++zz) {
+    data[zz] = (char) ('a' + (zz / 7 + (zz * zz) % 5) % 26);
+  }
+
+  for (pos = 0, chunk = 1; pos < total; pos += chunk, chunk = 3 * chunk + 1) {
+    chunk = SC_MIN (chunk % 100003, total - pos);
+    retval = sc_io_sink_write (sink, data + pos, chunk);
+    SC_CHECK_ABORT (retval == 0, "Encoded sink write");
+  }
+  retval = sc_io_sink_complete (sink, &bytes_in, &compressed);
+  SC_CHECK_ABORT (retval == 0, "Encoded sink complete");
+  SC_CHECK_ABORT (bytes_in == total, "Encoded sink bytes in");
+  SC_CHECK_ABORT (compressed < total / 4, "Encoded sink bytes out");
+  retval = sc_io_sink_write (sink, tail, strlen (tail));
+  SC_CHECK_ABORT (retval == 0, "Encoded sink tail");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Encoded sink destroy");
+  SC_GLOBAL_INFOF ("Encoding %d compressed %lld bytes into %lld\n",
+                   ioencode, (long long) total, (long long) compressed);
+
+  /* read both streams back in other chunk sizes, skipping some data */
+  source = filename == NULL ?
+    sc_io_source_new (SC_IO_TYPE_BUFFER, ioencode, buffer) :
+    sc_io_source_new (SC_IO_TYPE_FILENAME, ioencode, filename);
+  SC_CHECK_ABORT (source != NULL, "Encoded source create");
+  memset (verify, 0, total);
+  for (pos = 0, chunk = 5; pos < total; pos += chunk, chunk = 2 * chunk + 3) {
+    chunk = SC_MIN (chunk % 70001, total - pos);
+    retval = sc_io_source_read (source, chunk % 3 ? verify + pos : NULL,
+                                chunk, NULL);
+    SC_CHECK_ABORT (retval == 0, "Encoded source read");
+    if (chunk % 3 == 0) {
+      memcpy (verify + pos, data + pos, chunk);
+    }
+  }
+  SC_CHECK_ABORT (!memcmp (data, verify, total), "Encoded source data");
+  retval = sc_io_source_complete (source, NULL, NULL);
+  SC_CHECK_ABORT (retval == SC_IO_ERROR_AGAIN, "Encoded source pending");
+  retval = sc_io_source_read (source, verify, total, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_out == strlen (tail) &&
+                  !memcmp (verify, tail, bytes_out), "Encoded source tail");
+  retval = sc_io_source_complete (source, &bytes_in, &bytes_out);
+  SC_CHECK_ABORT (retval == 0, "Encoded source complete");
+  SC_CHECK_ABORT (bytes_out == total + strlen (tail), "Encoded source out");
+  SC_CHECK_ABORT (filename != NULL || bytes_in == buffer->elem_count,
+                  "Encoded source in");
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Encoded source destroy");
+
+  /* a truncated stream is an error */
+  if (filename == NULL) {
+    sc_array_init_view (&view, buffer, 0, compressed / 2);
+    source = sc_io_source_new (SC_IO_TYPE_BUFFER, ioencode, &view);
+    SC_CHECK_ABORT (source != NULL, "Truncated source create");
+    retval = sc_io_source_read (source, verify, total, &bytes_out);
+    SC_CHECK_ABORT (retval != 0, "Truncated source read");
+    (void) sc_io_source_destroy (source);
+  }
+
+  SC_FREE (verify);
+  SC_FREE (data);
+  sc_array_destroy (buffer);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -85,6 +177,12 @@ main (int argc, char **argv)
 
   if (sc_is_root ()) {
     the_test (filename);
+    test_encode (SC_IO_ENCODE_ZLIB, NULL);
+    test_encode (SC_IO_ENCODE_ZSTD, NULL);
+    if (filename != NULL) {
+      test_encode (SC_IO_ENCODE_ZLIB, filename);
+      test_encode (SC_IO_ENCODE_ZSTD, filename);
+    }
   }
 
   sc_options_destroy (opt);
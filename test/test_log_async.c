@@ -0,0 +1,151 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_log_async.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define TEST_LOG_ASYNC_THREADS 4
+#define TEST_LOG_ASYNC_MESSAGES 1000
+
+static void        *
+test_log_async_run (void *v)
+{
+  int                 t = *(int *) v;
+  int                 i;
+
+  for (i = 0; i < TEST_LOG_ASYNC_MESSAGES; ++i) {
+    SC_LOGF (SC_LP_PRODUCTION, "test_log_async %d %d\n", t, i);
+  }
+  return NULL;
+}
+
+/* log from several threads, or several times from this one */
+static void
+test_log_async_threads (void)
+{
+  int                 t, ids[TEST_LOG_ASYNC_THREADS];
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t           threads[TEST_LOG_ASYNC_THREADS];
+#endif
+
+  for (t = 0; t < TEST_LOG_ASYNC_THREADS; ++t) {
+    ids[t] = t;
+#ifdef SC_ENABLE_PTHREAD
+    pth = pthread_create (&threads[t], NULL, test_log_async_run, &ids[t]);
+    SC_CHECK_ABORT (pth == 0, "Thread create");
+#else
+    test_log_async_run (&ids[t]);
+#endif
+  }
+#ifdef SC_ENABLE_PTHREAD
+  for (t = 0; t < TEST_LOG_ASYNC_THREADS; ++t) {
+    pth = pthread_join (threads[t], NULL);
+    SC_CHECK_ABORT (pth == 0, "Thread join");
+  }
+#endif
+}
+
+/* check that each thread's messages are complete and in order */
+static void
+test_log_async_check (const char *filename, int mpirank)
+{
+  int                 t, i, rank, num;
+  int                 next[TEST_LOG_ASYNC_THREADS];
+  char                line[BUFSIZ];
+  const char         *pos;
+  FILE               *file;
+
+  file = fopen (filename, "rb");
+  SC_CHECK_ABORT (file != NULL, "Open log");
+  for (t = 0; t < TEST_LOG_ASYNC_THREADS; ++t) {
+    next[t] = 0;
+  }
+  num = 0;
+  while (fgets (line, BUFSIZ, file) != NULL) {
+    if ((pos = strstr (line, "test_log_async ")) == NULL) {
+      continue;
+    }
+    SC_CHECK_ABORT (sscanf (line, "[libsc %d]", &rank) == 1 &&
+                    rank == mpirank, "Log prefix");
+    SC_CHECK_ABORT (sscanf (pos, "test_log_async %d %d", &t, &i) == 2,
+                    "Log line");
+    SC_CHECK_ABORT (0 <= t && t < TEST_LOG_ASYNC_THREADS && i == next[t],
+                    "Log order");
+    ++next[t];
+    ++num;
+  }
+  SC_CHECK_ABORT (!fclose (file), "Close log");
+  SC_CHECK_ABORT (num == TEST_LOG_ASYNC_THREADS * TEST_LOG_ASYNC_MESSAGES,
+                  "Log count");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpirank;
+  char                filename[BUFSIZ];
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* the environment may have started the backend already */
+  SC_CHECK_ABORT (!sc_log_async_stop (), "Log stop from environment");
+
+  /* a small buffer size makes the writer flush often */
+  sc_log_async_start (mpicomm, "sc_test_log_async", 256);
+  SC_CHECK_ABORT (sc_log_async_active, "Log start");
+  test_log_async_threads ();
+  sc_log_async_flush ();
+
+  /* everything logged before the flush is in the file */
+  snprintf (filename, BUFSIZ, "sc_test_log_async.%d.log", mpirank);
+  test_log_async_check (filename, mpirank);
+
+  SC_CHECK_ABORT (!sc_log_async_stop (), "Log stop");
+  SC_CHECK_ABORT (!sc_log_async_active, "Log stopped");
+  test_log_async_check (filename, mpirank);
+  SC_CHECK_ABORT (!remove (filename), "Remove log");
+
+  /* the default large buffer writing to the log stream */
+  sc_log_async_start (mpicomm, NULL, 0);
+  test_log_async_threads ();
+  SC_CHECK_ABORT (!sc_log_async_stop (), "Log stop to stream");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
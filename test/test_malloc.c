@@ -0,0 +1,330 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+typedef struct test_malloc_thread
+{
+  int                 count;
+  int                 do_alloc;
+  int                 do_free;
+  int                 locked;
+  int                 churn;
+  void              **ptrs;
+}
+test_malloc_thread_t;
+
+static const char  *test_malloc_names[2] = { "system", "caching" };
+
+#ifdef SC_ENABLE_PTHREAD
+
+/* a thread that allocates and stays alive while others free its blocks */
+typedef struct test_malloc_hold
+{
+  int                 count;
+  int                 state;
+  void              **ptrs;
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+}
+test_malloc_hold_t;
+
+static void
+test_malloc_hold_set (test_malloc_hold_t * th, int state)
+{
+  pthread_mutex_lock (&th->mutex);
+  th->state = state;
+  pthread_cond_broadcast (&th->cond);
+  pthread_mutex_unlock (&th->mutex);
+}
+
+static void
+test_malloc_hold_wait (test_malloc_hold_t * th, int state)
+{
+  pthread_mutex_lock (&th->mutex);
+  while (th->state != state) {
+    pthread_cond_wait (&th->cond, &th->mutex);
+  }
+  pthread_mutex_unlock (&th->mutex);
+}
+
+static void        *
+test_malloc_hold_run (void *v)
+{
+  test_malloc_hold_t *th = (test_malloc_hold_t *) v;
+  int                 i;
+
+  for (i = 0; i < th->count; ++i) {
+    th->ptrs[i] = SC_ALLOC (char, 1 + i % 61);
+  }
+  test_malloc_hold_set (th, 1);
+  test_malloc_hold_wait (th, 2);
+  return NULL;
+}
+
+#endif
+
+/* create and destroy small containers as in a typical mesh algorithm */
+static void
+test_malloc_churn (int count)
+{
+  int                 i, j;
+  sc_array_t         *a;
+  sc_list_t          *l;
+
+  for (i = 0; i < count; ++i) {
+    a = sc_array_new (sizeof (int));
+    l = sc_list_new (NULL);
+    for (j = 0; j < 1 + i % 13; ++j) {
+      *(int *) sc_array_push (a) = j;
+      sc_list_append (l, a);
+    }
+    sc_list_destroy (l);
+    sc_array_destroy (a);
+  }
+}
+
+static void        *
+test_malloc_run (void *v)
+{
+  test_malloc_thread_t *tt = (test_malloc_thread_t *) v;
+  int                 i;
+
+  if (tt->churn) {
+    test_malloc_churn (tt->count);
+    return NULL;
+  }
+  if (tt->do_alloc) {
+    for (i = 0; i < tt->count; ++i) {
+      tt->ptrs[i] = SC_ALLOC (char, 1 + i % 61);
+      if (tt->locked) {
+        /* emulate the former counter update under the package mutex */
+        sc_package_lock (sc_package_id);
+        sc_package_unlock (sc_package_id);
+      }
+    }
+  }
+  if (tt->do_free) {
+    for (i = 0; i < tt->count; ++i) {
+      SC_FREE (tt->ptrs[i]);
+      if (tt->locked) {
+        sc_package_lock (sc_package_id);
+        sc_package_unlock (sc_package_id);
+      }
+    }
+  }
+  return NULL;
+}
+
+/* run allocations and/or deallocations on all threads */
+static double
+test_malloc_threads (test_malloc_thread_t * tts, int num_threads,
+                     int do_alloc, int do_free, int locked, int churn)
+{
+  int                 t;
+  double              elapsed;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t          *threads;
+
+  threads = (pthread_t *) malloc (num_threads * sizeof (pthread_t));
+  SC_CHECK_ABORT (threads != NULL, "Thread array");
+#endif
+  for (t = 0; t < num_threads; ++t) {
+    tts[t].do_alloc = do_alloc;
+    tts[t].do_free = do_free;
+    tts[t].locked = locked;
+    tts[t].churn = churn;
+  }
+  elapsed = -sc_MPI_Wtime ();
+#ifdef SC_ENABLE_PTHREAD
+  for (t = 0; t < num_threads; ++t) {
+    pth = pthread_create (&threads[t], NULL, test_malloc_run, &tts[t]);
+    SC_CHECK_ABORT (pth == 0, "Thread create");
+  }
+  for (t = 0; t < num_threads; ++t) {
+    pth = pthread_join (threads[t], NULL);
+    SC_CHECK_ABORT (pth == 0, "Thread join");
+  }
+#else
+  for (t = 0; t < num_threads; ++t) {
+    test_malloc_run (&tts[t]);
+  }
+#endif
+  elapsed += sc_MPI_Wtime ();
+#ifdef SC_ENABLE_PTHREAD
+  free (threads);
+#endif
+  return elapsed;
+}
+
+/* check alignment, contents and counts of single allocations */
+static void
+test_malloc_single (void)
+{
+  int                 status;
+  size_t              size, zz;
+  char               *p, *q;
+
+  status = sc_memory_status (sc_package_id);
+  for (size = 1; size < 9000; size += 1 + size / 4) {
+    p = SC_ALLOC (char, size);
+    SC_CHECK_ABORT ((size_t) p % sizeof (void *) == 0, "Alignment");
+#ifdef SC_MEMALIGN_BYTES
+    SC_CHECK_ABORT ((size_t) p % SC_MEMALIGN_BYTES == 0, "Memalign");
+#endif
+    memset (p, (int) (size % 127), size);
+    q = SC_ALLOC_ZERO (char, size);
+    for (zz = 0; zz < size; ++zz) {
+      SC_CHECK_ABORT (q[zz] == 0, "Calloc");
+    }
+    p = SC_REALLOC (p, char, 2 * size + 3);
+    for (zz = 0; zz < size; ++zz) {
+      SC_CHECK_ABORT (p[zz] == (char) (size % 127), "Realloc grow");
+    }
+    p = SC_REALLOC (p, char, size / 2 + 1);
+    for (zz = 0; zz < size / 2 + 1; ++zz) {
+      SC_CHECK_ABORT (p[zz] == (char) (size % 127), "Realloc shrink");
+    }
+    SC_FREE (q);
+    SC_FREE (p);
+  }
+  p = SC_ALLOC (char, 0);
+  SC_FREE (p);
+  SC_CHECK_ABORT (sc_memory_status (sc_package_id) == status,
+                  "Single balance");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 test_package;
+  int                 t, num_threads, count;
+  int                 allocator;
+  int                 status;
+  double              elapsed, elapsed_locked, elapsed_churn;
+  test_malloc_thread_t *tts;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t           holder;
+  test_malloc_hold_t  th;
+#endif
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  test_package = sc_package_register (NULL, SC_LP_DEFAULT, "test_malloc",
+                                      "Allocation test");
+
+  /* optional arguments set the number of threads and allocations */
+  num_threads = 4;
+  count = 100000;
+  if (argc >= 2) {
+    num_threads = SC_MAX (sc_atoi (argv[1]), 1);
+  }
+  if (argc >= 3) {
+    count = SC_MAX (sc_atoi (argv[2]), 1);
+  }
+
+  /* the bookkeeping is allocated outside of the libsc package */
+  tts = (test_malloc_thread_t *)
+    sc_malloc (test_package, num_threads * sizeof (test_malloc_thread_t));
+  for (t = 0; t < num_threads; ++t) {
+    tts[t].count = count;
+    tts[t].ptrs = (void **) sc_malloc (test_package, count * sizeof (void *));
+  }
+
+  for (allocator = SC_ALLOCATOR_SYSTEM; allocator <= SC_ALLOCATOR_CACHING;
+       ++allocator) {
+    sc_package_set_allocator (sc_package_id, (sc_allocator_t) allocator);
+    status = sc_memory_status (sc_package_id);
+    test_malloc_single ();
+
+    /* no allocation may be lost in concurrent counting */
+    test_malloc_threads (tts, num_threads, 1, 0, 0, 0);
+#ifndef SC_NOCOUNT_MALLOC
+    SC_CHECK_ABORT (sc_memory_status (sc_package_id) ==
+                    status + num_threads * count, "Concurrent malloc count");
+#endif
+    test_malloc_threads (tts, num_threads, 0, 1, 0, 0);
+    SC_CHECK_ABORT (sc_memory_status (sc_package_id) == status,
+                    "Concurrent free count");
+
+    /* compare with additional locking per allocation */
+    elapsed = test_malloc_threads (tts, num_threads, 1, 1, 0, 0);
+    elapsed_locked = test_malloc_threads (tts, num_threads, 1, 1, 1, 0);
+
+    /* create and destroy many small containers */
+    elapsed_churn = test_malloc_threads (tts, num_threads, 0, 0, 0, 1);
+    SC_CHECK_ABORT (sc_memory_status (sc_package_id) == status,
+                    "Concurrent balance");
+
+    SC_GLOBAL_STATISTICSF ("Timings for %d threads with %d allocations %s\n",
+                           num_threads, count, test_malloc_names[allocator]);
+    SC_GLOBAL_STATISTICSF ("   counters %g\n", elapsed);
+    SC_GLOBAL_STATISTICSF ("   counters with mutex %g\n", elapsed_locked);
+    SC_GLOBAL_STATISTICSF ("   container churn %g\n", elapsed_churn);
+  }
+
+  for (t = 0; t < num_threads; ++t) {
+    sc_free (test_package, tts[t].ptrs);
+  }
+  sc_free (test_package, tts);
+
+#ifdef SC_ENABLE_PTHREAD
+  /* blocks allocated on a live thread and freed on this one must balance
+     the caching allocator in sc_finalize while that thread is still alive */
+  th.count = count;
+  th.state = 0;
+  th.ptrs = (void **) sc_malloc (test_package, count * sizeof (void *));
+  pthread_mutex_init (&th.mutex, NULL);
+  pthread_cond_init (&th.cond, NULL);
+  pth = pthread_create (&holder, NULL, test_malloc_hold_run, &th);
+  SC_CHECK_ABORT (pth == 0, "Thread create");
+  test_malloc_hold_wait (&th, 1);
+  for (t = 0; t < count; ++t) {
+    SC_FREE (th.ptrs[t]);
+  }
+  sc_free (test_package, th.ptrs);
+#endif
+
+  sc_finalize ();
+
+#ifdef SC_ENABLE_PTHREAD
+  test_malloc_hold_set (&th, 2);
+  pth = pthread_join (holder, NULL);
+  SC_CHECK_ABORT (pth == 0, "Thread join");
+  pthread_cond_destroy (&th.cond);
+  pthread_mutex_destroy (&th.mutex);
+#endif
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
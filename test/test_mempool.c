@@ -0,0 +1,307 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_containers.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+typedef struct test_mempool_thread
+{
+  int                 id;
+  int                 other_id;
+  int                 count;
+  int                 phase;
+  sc_mempool_t       *pool;
+  sc_mempool_t       *links;
+  void              **elems;
+  void              **other;
+}
+test_mempool_thread_t;
+
+/* allocate, free and recycle elements, checking that nobody else owns them */
+static void
+test_mempool_hammer (test_mempool_thread_t * tt)
+{
+  int                 i, j, *e;
+
+  for (j = 0; j < 4; ++j) {
+    for (i = 0; i < tt->count; ++i) {
+      e = (int *) (tt->elems[i] = sc_mempool_alloc (tt->pool));
+      e[0] = tt->id;
+      e[1] = i;
+    }
+    for (i = 0; i < tt->count; ++i) {
+      e = (int *) tt->elems[i];
+      SC_CHECK_ABORT (e[0] == tt->id && e[1] == i, "Element owner");
+      if (i % 3 == j % 3) {
+        sc_mempool_free (tt->pool, e);
+        tt->elems[i] = sc_mempool_alloc (tt->pool);
+        ((int *) tt->elems[i])[0] = tt->id;
+        ((int *) tt->elems[i])[1] = i;
+      }
+    }
+    if (j < 3) {
+      for (i = 0; i < tt->count; ++i) {
+        sc_mempool_free (tt->pool, tt->elems[i]);
+      }
+    }
+  }
+}
+
+/* build a list per thread whose links come from one shared pool */
+static void
+test_mempool_list (test_mempool_thread_t * tt)
+{
+  int                 i;
+  sc_list_t          *list;
+  sc_link_t          *lynk;
+
+  list = sc_list_new (tt->links);
+  for (i = 0; i < tt->count; ++i) {
+    if (i % 2) {
+      sc_list_append (list, tt->elems[i]);
+    }
+    else {
+      sc_list_prepend (list, tt->elems[i]);
+    }
+  }
+  i = 0;
+  for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
+    SC_CHECK_ABORT (((int *) lynk->data)[0] == tt->id, "List owner");
+    ++i;
+  }
+  SC_CHECK_ABORT (i == tt->count, "List length");
+  sc_list_destroy (list);
+}
+
+static void        *
+test_mempool_run (void *v)
+{
+  test_mempool_thread_t *tt = (test_mempool_thread_t *) v;
+  int                 i, *e;
+
+  if (tt->phase == 0) {
+    test_mempool_hammer (tt);
+    test_mempool_list (tt);
+  }
+  else {
+    /* free the elements allocated by another thread */
+    for (i = 0; i < tt->count; ++i) {
+      e = (int *) tt->other[i];
+      SC_CHECK_ABORT (e[0] == tt->other_id && e[1] == i, "Foreign element");
+      sc_mempool_free (tt->pool, e);
+    }
+  }
+  return NULL;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+/* more concurrent pools than a process has thread-specific keys */
+#ifdef PTHREAD_KEYS_MAX
+#define TEST_MEMPOOL_MANY (PTHREAD_KEYS_MAX + 64)
+#else
+#define TEST_MEMPOOL_MANY 1100
+#endif
+
+static void        *
+test_mempool_many_run (void *v)
+{
+  sc_mempool_t      **pools = (sc_mempool_t **) v;
+  int                 p;
+  void               *e;
+
+  /* keep one element of every pool and recycle another */
+  for (p = 0; p < TEST_MEMPOOL_MANY; ++p) {
+    (void) sc_mempool_alloc (pools[p]);
+    e = sc_mempool_alloc (pools[p]);
+    sc_mempool_free (pools[p], e);
+  }
+  return NULL;
+}
+
+static void
+test_mempool_many (int num_threads)
+{
+  int                 p, t, pth;
+  pthread_t          *threads;
+  sc_mempool_t      **pools;
+
+  pools = SC_ALLOC (sc_mempool_t *, TEST_MEMPOOL_MANY);
+  for (p = 0; p < TEST_MEMPOOL_MANY; ++p) {
+    pools[p] = sc_mempool_new_concurrent (sizeof (int), 0);
+  }
+  threads = SC_ALLOC (pthread_t, num_threads);
+  for (t = 0; t < num_threads; ++t) {
+    pth = pthread_create (&threads[t], NULL, test_mempool_many_run, pools);
+    SC_CHECK_ABORT (pth == 0, "Thread create");
+  }
+  for (t = 0; t < num_threads; ++t) {
+    pth = pthread_join (threads[t], NULL);
+    SC_CHECK_ABORT (pth == 0, "Thread join");
+  }
+  test_mempool_many_run (pools);
+  for (p = 0; p < TEST_MEMPOOL_MANY; ++p) {
+    sc_mempool_sync (pools[p]);
+    SC_CHECK_ABORT (pools[p]->elem_count == (size_t) num_threads + 1,
+                    "Many pools count");
+    sc_mempool_destroy (pools[p]);
+  }
+  SC_FREE (threads);
+  SC_FREE (pools);
+}
+
+#endif
+
+/* run the current phase on all threads, or serially if threads are off */
+static double
+test_mempool_threads (test_mempool_thread_t * tts, int num_threads, int phase)
+{
+  int                 t;
+  double              elapsed;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t          *threads;
+
+  threads = SC_ALLOC (pthread_t, num_threads);
+#endif
+  for (t = 0; t < num_threads; ++t) {
+    tts[t].phase = phase;
+  }
+  elapsed = -sc_MPI_Wtime ();
+#ifdef SC_ENABLE_PTHREAD
+  for (t = 0; t < num_threads; ++t) {
+    pth = pthread_create (&threads[t], NULL, test_mempool_run, &tts[t]);
+    SC_CHECK_ABORT (pth == 0, "Thread create");
+  }
+  for (t = 0; t < num_threads; ++t) {
+    pth = pthread_join (threads[t], NULL);
+    SC_CHECK_ABORT (pth == 0, "Thread join");
+  }
+  SC_FREE (threads);
+#else
+  for (t = 0; t < num_threads; ++t) {
+    test_mempool_run (&tts[t]);
+  }
+#endif
+  elapsed += sc_MPI_Wtime ();
+  return elapsed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 t, i, num_threads, count;
+  int                 zero_and_persist;
+  double              elapsed_alloc, elapsed_free;
+  sc_mempool_t       *pool, *links;
+  test_mempool_thread_t *tts;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* optional arguments set the number of threads and elements */
+  num_threads = 8;
+  count = 20000;
+  if (argc >= 2) {
+    num_threads = SC_MAX (sc_atoi (argv[1]), 1);
+  }
+  if (argc >= 3) {
+    count = SC_MAX (sc_atoi (argv[2]), 1);
+  }
+
+  tts = SC_ALLOC (test_mempool_thread_t, num_threads);
+  for (t = 0; t < num_threads; ++t) {
+    tts[t].id = t;
+    tts[t].count = count;
+    tts[t].elems = SC_ALLOC (void *, count);
+  }
+  for (t = 0; t < num_threads; ++t) {
+    tts[t].other_id = (t + 1) % num_threads;
+    tts[t].other = tts[tts[t].other_id].elems;
+  }
+
+  for (zero_and_persist = 0; zero_and_persist <= 1; ++zero_and_persist) {
+    pool = sc_mempool_new_concurrent (2 * sizeof (int), zero_and_persist);
+    links = sc_mempool_new_concurrent (sizeof (sc_link_t), 0);
+    for (t = 0; t < num_threads; ++t) {
+      tts[t].pool = pool;
+      tts[t].links = links;
+    }
+
+    /* every thread keeps count elements alive after the first phase */
+    elapsed_alloc = test_mempool_threads (tts, num_threads, 0);
+    sc_mempool_sync (pool);
+    sc_mempool_sync (links);
+    SC_CHECK_ABORT (pool->elem_count == (size_t) num_threads * count,
+                    "Concurrent alloc count");
+    SC_CHECK_ABORT (links->elem_count == 0, "Concurrent link count");
+    SC_GLOBAL_INFOF ("Concurrent mempool memory %lld\n",
+                     (long long) sc_mempool_memory_used (pool));
+
+    /* all elements are distinct and freed by a different thread */
+    elapsed_free = test_mempool_threads (tts, num_threads, 1);
+    sc_mempool_sync (pool);
+    SC_CHECK_ABORT (pool->elem_count == 0, "Concurrent free count");
+
+    /* the main thread recycles elements returned by the exited threads */
+    for (i = 0; i < count; ++i) {
+      tts[0].elems[i] = sc_mempool_alloc (pool);
+    }
+    sc_mempool_sync (pool);
+    SC_CHECK_ABORT (pool->elem_count == (size_t) count, "Serial count");
+    sc_mempool_truncate (pool);
+    SC_CHECK_ABORT (pool->elem_count == 0, "Truncate count");
+    tts[0].elems[0] = sc_mempool_alloc (pool);
+    sc_mempool_free (pool, tts[0].elems[0]);
+
+    sc_mempool_destroy (links);
+    sc_mempool_destroy (pool);
+
+    SC_GLOBAL_STATISTICSF ("Timings for %d threads with %d elements\n",
+                           num_threads, count);
+    SC_GLOBAL_STATISTICSF ("   alloc and free %g\n", elapsed_alloc);
+    SC_GLOBAL_STATISTICSF ("   foreign free %g\n", elapsed_free);
+  }
+
+  for (t = 0; t < num_threads; ++t) {
+    SC_FREE (tts[t].elems);
+  }
+  SC_FREE (tts);
+
+#ifdef SC_ENABLE_PTHREAD
+  test_mempool_many (num_threads);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -102,6 +102,139 @@ compute_superset_trivial (sc_array_t * receivers,
   }
 }
 
+static const char  *test_notify_overlap_names[4] = {
+  "pex blocking with work", "pex split with work",
+  "nbx blocking with work", "nbx split with work"
+};
+
+/** Emulate local work of given duration between progress calls */
+static void
+test_notify_work (double seconds)
+{
+  double              start = sc_MPI_Wtime ();
+
+  while (sc_MPI_Wtime () - start < seconds) {
+  }
+}
+
+/** Notify with payload while doing local work, blocking or split-phase.
+ * \return             The elapsed time of notification and work.
+ */
+static double
+test_notify_overlap (sc_MPI_Comm mpicomm, sc_notify_type_t type,
+                     const int *receivers, int num_receivers,
+                     const int *senders1, int num_senders1, int split)
+{
+  int                 i, mpiret, mpirank;
+  int                 num_chunks = 10;
+  double              elapsed;
+  sc_array_t         *rec, *snd, *pay;
+  sc_notify_t        *notify;
+  sc_notify_request_t *req;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  notify = sc_notify_new (mpicomm);
+  sc_notify_set_type (notify, type);
+  rec = sc_array_new_count (sizeof (int), num_receivers);
+  snd = sc_array_new (sizeof (int));
+  pay = sc_array_new_count (2 * sizeof (int), num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    *(int *) sc_array_index_int (rec, i) = receivers[i];
+    ((int *) sc_array_index_int (pay, i))[0] = 5 * receivers[i];
+    ((int *) sc_array_index_int (pay, i))[1] = -1;
+  }
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed = -sc_MPI_Wtime ();
+  if (split) {
+    req = sc_notify_payload_begin (rec, snd, pay, NULL, 1, notify);
+    for (i = 0; i < num_chunks; ++i) {
+      test_notify_work (2.e-4);
+      (void) sc_notify_payload_test (req);
+    }
+    sc_notify_payload_end (req);
+  }
+  else {
+    sc_notify_payload (rec, snd, pay, NULL, 1, notify);
+    for (i = 0; i < num_chunks; ++i) {
+      test_notify_work (2.e-4);
+    }
+  }
+  elapsed += sc_MPI_Wtime ();
+
+  SC_CHECK_ABORT ((int) snd->elem_count == num_senders1,
+                  "Mismatch overlap sender count");
+  SC_CHECK_ABORT (pay->elem_count == snd->elem_count,
+                  "Mismatch overlap payload count");
+  for (i = 0; i < num_senders1; ++i) {
+    SC_CHECK_ABORTF (*(int *) sc_array_index_int (snd, i) == senders1[i],
+                     "Mismatch overlap sender %d", i);
+    SC_CHECK_ABORTF (((int *) sc_array_index_int (pay, i))[0] == 5 * mpirank
+                     && ((int *) sc_array_index_int (pay, i))[1] == -1,
+                     "Mismatch overlap payload %d", i);
+  }
+  sc_array_destroy (rec);
+  sc_array_destroy (snd);
+  sc_array_destroy (pay);
+  sc_notify_destroy (notify);
+  return elapsed;
+}
+
+/** Notify in place, without and with payload, blocking or split-phase. */
+static void
+test_notify_inplace (sc_MPI_Comm mpicomm, sc_notify_type_t type,
+                     const int *receivers, int num_receivers,
+                     const int *senders1, int num_senders1, int split)
+{
+  int                 i, k, mpiret, mpirank;
+  sc_array_t         *rec, *pay;
+  sc_notify_t        *notify;
+  sc_notify_request_t *req;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  notify = sc_notify_new (mpicomm);
+  sc_notify_set_type (notify, type);
+  for (k = 0; k < 2; ++k) {
+    rec = sc_array_new_count (sizeof (int), num_receivers);
+    pay = k == 0 ? NULL : sc_array_new_count (sizeof (int), num_receivers);
+    for (i = 0; i < num_receivers; ++i) {
+      *(int *) sc_array_index_int (rec, i) = receivers[i];
+      if (pay != NULL) {
+        *(int *) sc_array_index_int (pay, i) = 7 * mpirank + 1;
+      }
+    }
+    if (split) {
+      req = sc_notify_payload_begin (rec, NULL, pay, NULL, 1, notify);
+      while (!sc_notify_payload_test (req)) {
+      }
+      sc_notify_payload_end (req);
+    }
+    else {
+      sc_notify_payload (rec, NULL, pay, NULL, 1, notify);
+    }
+
+    SC_CHECK_ABORT ((int) rec->elem_count == num_senders1,
+                    "Mismatch in place sender count");
+    SC_CHECK_ABORT (pay == NULL || pay->elem_count == rec->elem_count,
+                    "Mismatch in place payload count");
+    for (i = 0; i < num_senders1; ++i) {
+      SC_CHECK_ABORTF (*(int *) sc_array_index_int (rec, i) == senders1[i],
+                       "Mismatch in place sender %d", i);
+      SC_CHECK_ABORTF (pay == NULL || *(int *) sc_array_index_int (pay, i)
+                       == 7 * senders1[i] + 1,
+                       "Mismatch in place payload %d", i);
+    }
+    sc_array_destroy (rec);
+    if (pay != NULL) {
+      sc_array_destroy (pay);
+    }
+  }
+  sc_notify_destroy (notify);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -125,7 +258,7 @@ main (int argc, char **argv)
   sc_MPI_Comm         mpicomm;
   sc_array_t         *rec2, *snd2, *rec4, *pay4, *rec5, *snd5, *inpay5,
     *outpay5, *inoff5, *outoff5;
-  sc_statinfo_t       stats[3 * SC_NOTIFY_NUM_TYPES + 2];
+  sc_statinfo_t       stats[3 * SC_NOTIFY_NUM_TYPES + 6];
   sc_notify_t        *notify;
   char                namep[SC_NOTIFY_NUM_TYPES][2][BUFSIZ];
 
@@ -225,6 +358,10 @@ main (int argc, char **argv)
                        nbot);
       sc_notify_nary_set_widths (notify, ntop, nint, nbot);
     }
+    if (j == SC_NOTIFY_HIER) {
+      /* pretend to have several nodes even when running on one */
+      sc_notify_hier_set_node_size (notify, 2);
+    }
     if (j == SC_NOTIFY_SUPERSET) {
       sc_notify_superset_set_callback (notify, compute_superset_trivial,
                                        NULL);
@@ -322,15 +459,133 @@ main (int argc, char **argv)
     sc_array_destroy (outoff5);
   }
 
+  /* compare blocking and split-phase notification overlapped with work */
+  for (j = 0; j < 2; ++j) {
+    sc_notify_type_t    type = j == 0 ? SC_NOTIFY_PEX : SC_NOTIFY_NBX;
+
+#if !defined SC_ENABLE_MPI || MPI_VERSION < 3
+    if (type == SC_NOTIFY_NBX) {
+      for (k = 0; k < 2; ++k) {
+        sc_stats_init (stats + 3 * SC_NOTIFY_NUM_TYPES + 2 + 2 * j + k,
+                       "untested");
+      }
+      continue;
+    }
+#endif
+    SC_GLOBAL_INFOF ("Testing sc_notify_payload_begin %s\n",
+                     sc_notify_type_strings[type]);
+    for (k = 0; k < 2; ++k) {
+      elapsed_payl = test_notify_overlap (mpicomm, type, receivers,
+                                          num_receivers, senders1,
+                                          num_senders1, k);
+      sc_stats_set1 (stats + 3 * SC_NOTIFY_NUM_TYPES + 2 + 2 * j + k,
+                     elapsed_payl, test_notify_overlap_names[2 * j + k]);
+    }
+  }
+
+  /* the in-place variants reuse the receivers array for the senders */
+  for (k = 0; k < 2; ++k) {
+    SC_GLOBAL_INFOF ("Testing sc_notify_payload pex in place split %d\n",
+                     k);
+    test_notify_inplace (mpicomm, SC_NOTIFY_PEX, receivers, num_receivers,
+                         senders1, num_senders1, k);
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+    SC_GLOBAL_INFOF ("Testing sc_notify_payload nbx in place split %d\n",
+                     k);
+    test_notify_inplace (mpicomm, SC_NOTIFY_NBX, receivers, num_receivers,
+                         senders1, num_senders1, k);
+#endif
+    SC_GLOBAL_INFOF ("Testing sc_notify_payload auto in place split %d\n",
+                     k);
+    test_notify_inplace (mpicomm, SC_NOTIFY_AUTO, receivers, num_receivers,
+                         senders1, num_senders1, k);
+  }
+
+  /* only the first process knows calibration data, which selects nbx
+     if available; the automatic choice must still agree on all */
+  if (mpirank == 0) {
+    FILE               *file;
+
+    file = fopen ("sc_test_notify.calib", "w");
+    SC_CHECK_ABORT (file != NULL, "Open calibration");
+    fprintf (file, "30 0 0 unknown 0 0 0 1.0 7 trailing\n");
+    for (k = 0; k < 3; ++k) {
+      fprintf (file, "0 0 %d nbx 0 0 0 1.0\n", k);
+    }
+    fprintf (file, "30 0 1 pex 0 0 0 1.0\n");
+    SC_CHECK_ABORT (!fclose (file), "Close calibration");
+    (void) sc_notify_auto_load ("sc_test_notify.calib");
+    (void) remove ("sc_test_notify.calib");
+  }
+  SC_GLOBAL_INFO ("Testing sc_notify_payload auto with calibration\n");
+  for (k = 0; k < 2; ++k) {
+    test_notify_inplace (mpicomm, SC_NOTIFY_AUTO, receivers, num_receivers,
+                         senders1, num_senders1, k);
+  }
+
+  /* the simple interface uses the default type */
+  SC_GLOBAL_INFO ("Testing sc_notify_ext auto in place\n");
+  sc_notify_type_default = SC_NOTIFY_AUTO;
+  rec2 = sc_array_new_count (sizeof (int), num_receivers);
+  memcpy (rec2->array, receivers, num_receivers * sizeof (int));
+  sc_notify_ext (rec2, NULL, NULL, NULL, mpicomm);
+  SC_CHECK_ABORT ((int) rec2->elem_count == num_senders1,
+                  "Mismatch ext sender count");
+  for (i = 0; i < num_senders1; ++i) {
+    SC_CHECK_ABORTF (*(int *) sc_array_index_int (rec2, i) == senders1[i],
+                     "Mismatch ext sender %d", i);
+  }
+  sc_array_destroy (rec2);
+  sc_notify_type_default = SC_NOTIFY_PEX;
+
+  /* the automatic choice works with calibration data as well */
+  SC_GLOBAL_INFO ("Testing sc_notify_auto_calibrate\n");
+  mpiret = sc_notify_auto_calibrate (mpicomm, 1, "sc_test_notify.calib");
+  SC_CHECK_ABORT (mpiret == 0, "Notify calibration");
+  if (mpirank == 0) {
+    char                line[BUFSIZ];
+    FILE               *file;
+
+    /* the entries after an unknown type have been loaded and kept */
+    file = fopen ("sc_test_notify.calib", "r");
+    SC_CHECK_ABORT (file != NULL, "Open saved calibration");
+    k = 0;
+    while (fgets (line, BUFSIZ, file) != NULL) {
+      k += !strncmp (line, "30 0 1 pex ", 11);
+    }
+    SC_CHECK_ABORT (!fclose (file), "Close saved calibration");
+    SC_CHECK_ABORT (k == 1, "Calibration after unknown type");
+    (void) remove ("sc_test_notify.calib");
+  }
+  for (k = 0; k < 2; ++k) {
+    (void) test_notify_overlap (mpicomm, SC_NOTIFY_AUTO, receivers,
+                                num_receivers, senders1, num_senders1, k);
+  }
+
   SC_FREE (receivers);
   SC_FREE (senders1);
   SC_FREE (senders3);
 
-  sc_stats_compute (mpicomm, 3 * SC_NOTIFY_NUM_TYPES + 2, stats);
+  sc_stats_compute (mpicomm, 3 * SC_NOTIFY_NUM_TYPES + 6, stats);
   sc_stats_print (sc_package_id, SC_LP_STATISTICS,
-                  3 * SC_NOTIFY_NUM_TYPES + 2, stats, 1, 1);
+                  3 * SC_NOTIFY_NUM_TYPES + 6, stats, 1, 1);
+
+  sc_finalize ();
 
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  /* the resources kept between nbx calls are released and created again */
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+  sc_notify_type_default = SC_NOTIFY_NBX;
+  rec2 = sc_array_new_count (sizeof (int), 1);
+  *(int *) sc_array_index_int (rec2, 0) = mpirank;
+  sc_notify_ext (rec2, NULL, NULL, NULL, mpicomm);
+  SC_CHECK_ABORT (rec2->elem_count == 1 &&
+                  *(int *) sc_array_index_int (rec2, 0) == mpirank,
+                  "Notify after init again");
+  sc_array_destroy (rec2);
+  sc_notify_type_default = SC_NOTIFY_PEX;
   sc_finalize ();
+#endif
 
   mpiret = sc_MPI_Finalize ();
   SC_CHECK_MPI (mpiret);
@@ -34,6 +34,181 @@ compar (const void *p1, const void *p2)
   return i1 - i2;
 }
 
+/* pop everything from a heap of random numbers built at once */
+static void
+test_heapify (int count)
+{
+  int                 i, temp, last, *pi;
+  sc_array_t         *heap, *sorted;
+
+  heap = sc_array_new_count (sizeof (int), (size_t) count);
+  for (i = 0; i < count; ++i) {
+    *(int *) sc_array_index_int (heap, i) = rand () % (count + 1);
+  }
+  sorted = sc_array_new (sizeof (int));
+  sc_array_copy (sorted, heap);
+  sc_array_sort (sorted, compar);
+
+  sc_array_pqueue_heapify (heap, &temp, compar);
+  for (i = 1; i < count; ++i) {
+    pi = (int *) sc_array_index_int (heap, i);
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (heap, (i - 1) / 4) <= *pi,
+                    "pqueue_heapify");
+  }
+  last = -1;
+  for (i = 0; i < count; ++i) {
+    sc_array_pqueue_pop (heap, &temp, compar);
+    SC_CHECK_ABORT (temp == *(int *) sc_array_index_int (sorted, i) &&
+                    temp >= last, "pqueue_heapify_pop");
+    last = temp;
+  }
+  SC_CHECK_ABORT (heap->elem_count == 0, "pqueue_heapify_empty");
+
+  sc_array_destroy (heap);
+  sc_array_destroy (sorted);
+}
+
+/* insert into an array sorted in descending order, so pop takes the end */
+static void
+sorted_insert (sc_array_t * sorted, int value)
+{
+  size_t              low, high, mid;
+  int                *base;
+
+  low = 0;
+  high = sorted->elem_count;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (*(int *) sc_array_index (sorted, mid) > value) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  sc_array_push (sorted);
+  base = (int *) sorted->array;
+  memmove (base + low + 1, base + low,
+           (sorted->elem_count - 1 - low) * sizeof (int));
+  base[low] = value;
+}
+
+/* time a mixed sequence of adds and pops against a sorted array */
+static void
+test_mixed (int count)
+{
+  int                 i, temp, v1, v2;
+  sc_array_t         *heap, *sorted;
+  double              start, elapsed_heap, elapsed_sorted;
+
+  heap = sc_array_new (sizeof (int));
+  sorted = sc_array_new (sizeof (int));
+
+  srand (17);
+  start = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    *(int *) sc_array_push (heap) = rand ();
+    sc_array_pqueue_add (heap, &temp, compar);
+    if (i % 3 == 2) {
+      sc_array_pqueue_pop (heap, &v1, compar);
+    }
+  }
+  elapsed_heap = start + sc_MPI_Wtime ();
+
+  srand (17);
+  start = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    sorted_insert (sorted, rand ());
+    if (i % 3 == 2) {
+      v2 = *(int *) sc_array_pop (sorted);
+    }
+  }
+  elapsed_sorted = start + sc_MPI_Wtime ();
+
+  /* both queues hold the same values */
+  SC_CHECK_ABORT (heap->elem_count == sorted->elem_count, "pqueue_mixed");
+  while (heap->elem_count > 0) {
+    sc_array_pqueue_pop (heap, &v1, compar);
+    v2 = *(int *) sc_array_pop (sorted);
+    SC_CHECK_ABORT (v1 == v2, "pqueue_mixed_pop");
+  }
+  SC_STATISTICSF ("Test timings mixed %d pqueue %g sorted array %g\n",
+                  count, elapsed_heap, elapsed_sorted);
+
+  sc_array_destroy (heap);
+  sc_array_destroy (sorted);
+}
+
+/* shortest paths on a grid graph with random edge weights */
+static void
+test_dijkstra (int side)
+{
+  const int           n = side * side;
+  int                 i, j, k, changed;
+  int                *weight, *dist, d;
+  int                 nb[4];
+  size_t              v;
+  sc_pqueue_t         pq;
+
+  /* the weight of an edge is stored with both its vertices */
+  weight = SC_ALLOC (int, 2 * n);
+  for (i = 0; i < 2 * n; ++i) {
+    weight[i] = 1 + rand () % 100;
+  }
+
+  sc_pqueue_init (&pq, sizeof (int), (size_t) n, compar);
+  d = 0;
+  sc_pqueue_push (&pq, 0, &d);
+  dist = SC_ALLOC (int, n);
+  for (i = 0; i < n; ++i) {
+    dist[i] = -1;
+  }
+  while (pq.elem_count > 0) {
+    SC_CHECK_ABORT (sc_pqueue_top (&pq) < (size_t) n, "pqueue_top");
+    v = sc_pqueue_pop (&pq);
+    SC_CHECK_ABORT (!sc_pqueue_contains (&pq, v), "pqueue_contains");
+    i = (int) v;
+    dist[i] = *(int *) sc_pqueue_key (&pq, v);
+
+    /* right, up, left, down neighbors and their edge weights */
+    nb[0] = i % side + 1 < side ? i + 1 : -1;
+    nb[1] = i + side < n ? i + side : -1;
+    nb[2] = i % side > 0 ? i - 1 : -1;
+    nb[3] = i - side >= 0 ? i - side : -1;
+    for (j = 0; j < 4; ++j) {
+      if (nb[j] < 0 || dist[nb[j]] >= 0) {
+        continue;
+      }
+      d = dist[i] + weight[2 * (j < 2 ? i : nb[j]) + j % 2];
+      if (!sc_pqueue_contains (&pq, (size_t) nb[j])) {
+        sc_pqueue_push (&pq, (size_t) nb[j], &d);
+      }
+      else if (d < *(int *) sc_pqueue_key (&pq, (size_t) nb[j])) {
+        sc_pqueue_decrease (&pq, (size_t) nb[j], &d);
+      }
+    }
+  }
+  sc_pqueue_reset (&pq);
+
+  /* no edge may relax the distances any further */
+  changed = 0;
+  for (i = 0; i < n; ++i) {
+    SC_CHECK_ABORT (dist[i] >= 0, "dijkstra_reach");
+    for (k = 0; k < 2; ++k) {
+      j = k == 0 ? (i % side + 1 < side ? i + 1 : -1) :
+        (i + side < n ? i + side : -1);
+      if (j >= 0) {
+        d = weight[2 * i + k];
+        changed += dist[j] > dist[i] + d || dist[i] > dist[j] + d;
+      }
+    }
+  }
+  SC_CHECK_ABORT (changed == 0 && dist[0] == 0, "dijkstra_relax");
+
+  SC_FREE (weight);
+  SC_FREE (dist);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -118,6 +293,7 @@ main (int argc, char **argv)
                (long long) total1, (long long) total2, (long long) total3);
 
   elapsed_pqueue = start + sc_MPI_Wtime ();
+  SC_CHECK_ABORT (a1->elem_count == 0, "pqueue_empty");
 
   sc_array_destroy (a1);
   sc_array_destroy (a2);
@@ -147,6 +323,11 @@ main (int argc, char **argv)
                   elapsed_pqueue, 3. * elapsed_qsort);
 
   sc_array_destroy (a4);
+
+  test_heapify (count);
+  test_mixed (10 * count);
+  test_dijkstra (50);
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
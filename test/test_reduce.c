@@ -22,6 +22,20 @@
 */
 
 #include <sc_reduce.h>
+#include <sc_shmem.h>
+#include <sc_statistics.h>
+
+#define TEST_REDUCE_COUNT 1000
+#define TEST_REDUCE_REPS 10
+#define TEST_REDUCE_LARGE 100003
+
+/* Non-commutative operator that keeps the right-hand operand. */
+static void
+test_reduce_right (void *sendbuf, void *recvbuf,
+                   int sendcount, sc_MPI_Datatype sendtype)
+{
+  memcpy (recvbuf, sendbuf, sendcount * sc_mpi_sizeof (sendtype));
+}
 
 int
 main (int argc, char **argv)
@@ -35,6 +49,13 @@ main (int argc, char **argv)
   long                lvalue, lresult;
   float               fvalue[3], fresult[3], fexpect[3];
   double              dvalue, dresult;
+  double             *dsend, *dresult1, *dresult2;
+  double              elapsed_mpi, elapsed_flat, elapsed_node;
+  double              elapsed_large_mpi, elapsed_large;
+  double              dmin, dmax, dsum, dsq;
+  int                *isend, *irecv;
+  sc_statinfo_t       si;
+  int                 node_size, shared, rep, hier;
   sc_MPI_Comm         mpicomm;
 
   mpiret = sc_MPI_Init (&argc, &argv);
@@ -48,59 +69,212 @@ main (int argc, char **argv)
 
   sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
 
-  /* test allreduce int max */
-  ivalue = mpirank;
-  sc_allreduce (&ivalue, &iresult, 1, sc_MPI_INT, sc_MPI_MAX, mpicomm);
-  SC_CHECK_ABORT (iresult == mpisize - 1, "Allreduce mismatch");
-
-  /* test reduce float max */
-  fvalue[0] = (float) mpirank;
-  fexpect[0] = (float) (mpisize - 1);
-  fvalue[1] = (float) (mpirank % 9 - 4);
-  fexpect[1] = (float) (mpisize >= 9 ? 4 : (mpisize - 1) % 9 - 4);
-  fvalue[2] = (float) (mpirank % 6);
-  fexpect[2] = (float) (mpisize >= 6 ? 5 : (mpisize - 1) % 6);
-  for (i = 0; i < mpisize; ++i) {
-    sc_reduce (fvalue, fresult, 3, sc_MPI_FLOAT, sc_MPI_MAX, i, mpicomm);
-    if (i == mpirank) {
-      for (j = 0; j < 3; ++j) {
-        SC_CHECK_ABORTF (fresult[j] == fexpect[j],      /* ok */
-                         "Reduce mismatch in %d", j);
+  /* test the local combine kernels including the remainder loops */
+  isend = SC_ALLOC (int, TEST_REDUCE_COUNT + 3);
+  irecv = SC_ALLOC (int, TEST_REDUCE_COUNT + 3);
+  dsend = SC_ALLOC (double, TEST_REDUCE_COUNT + 3);
+  for (i = 0; i < TEST_REDUCE_COUNT + 3; ++i) {
+    isend[i] = (i * 7) % 23 - 11;
+    irecv[i] = (i * 5) % 19 - 9;
+    dsend[i] = (double) isend[i];
+  }
+  sc_reduce_local (isend, irecv, TEST_REDUCE_COUNT + 3, sc_MPI_INT,
+                   sc_MPI_MAX);
+  for (i = 0; i < TEST_REDUCE_COUNT + 3; ++i) {
+    SC_CHECK_ABORT (irecv[i] == SC_MAX ((i * 7) % 23 - 11, (i * 5) % 19 - 9),
+                    "Local max mismatch");
+  }
+  sc_reduce_local (isend, irecv, TEST_REDUCE_COUNT + 3, sc_MPI_INT,
+                   sc_MPI_SUM);
+  for (i = 0; i < TEST_REDUCE_COUNT + 3; ++i) {
+    SC_CHECK_ABORT (irecv[i] == (i * 7) % 23 - 11 +
+                    SC_MAX ((i * 7) % 23 - 11, (i * 5) % 19 - 9),
+                    "Local sum mismatch");
+  }
+
+  /* the fused kernel agrees with accumulating one by one */
+  sc_stats_init (&si, "Local");
+  for (i = 0; i < TEST_REDUCE_COUNT + 3; ++i) {
+    sc_stats_accumulate (&si, dsend[i]);
+  }
+  sc_reduce_minmaxsum (dsend, TEST_REDUCE_COUNT + 3, &dmin, &dmax, &dsum,
+                       &dsq);
+  SC_CHECK_ABORT (dmin == si.min && dmax == si.max &&
+                  dsum == si.sum_values && dsq == si.sum_squares,
+                  "Local minmaxsum mismatch");
+  sc_stats_accumulate_array (&si, dsend, 5);
+  SC_CHECK_ABORT (si.count == TEST_REDUCE_COUNT + 8, "Stats count mismatch");
+  SC_FREE (isend);
+  SC_FREE (irecv);
+  SC_FREE (dsend);
+
+  /* run the tests flat and node-aware on pairs of ranks */
+  node_size = mpisize % 2 ? 1 : 2;
+  sc_mpi_comm_attach_node_comms (mpicomm, node_size);
+#ifdef SC_ENABLE_MPIWINSHARED
+  sc_shmem_set_type (mpicomm, SC_SHMEM_WINDOW);
+#endif
+  shared = sc_shmem_is_shared (mpicomm);
+  for (hier = 0; hier < 2; ++hier) {
+    sc_reduce_hierarchical = hier;
+
+    /* test allreduce int max */
+    ivalue = mpirank;
+    sc_allreduce (&ivalue, &iresult, 1, sc_MPI_INT, sc_MPI_MAX, mpicomm);
+    SC_CHECK_ABORT (iresult == mpisize - 1, "Allreduce mismatch");
+
+    /* test reduce float max */
+    fvalue[0] = (float) mpirank;
+    fexpect[0] = (float) (mpisize - 1);
+    fvalue[1] = (float) (mpirank % 9 - 4);
+    fexpect[1] = (float) (mpisize >= 9 ? 4 : (mpisize - 1) % 9 - 4);
+    fvalue[2] = (float) (mpirank % 6);
+    fexpect[2] = (float) (mpisize >= 6 ? 5 : (mpisize - 1) % 6);
+    for (i = 0; i < mpisize; ++i) {
+      sc_reduce (fvalue, fresult, 3, sc_MPI_FLOAT, sc_MPI_MAX, i, mpicomm);
+      if (i == mpirank) {
+        for (j = 0; j < 3; ++j) {
+          SC_CHECK_ABORTF (fresult[j] == fexpect[j],    /* ok */
+                           "Reduce mismatch in %d", j);
+        }
       }
     }
-  }
 
-  /* test allreduce char min */
-  cvalue = (char) (mpirank % 127);
-  sc_allreduce (&cvalue, &cresult, 1, sc_MPI_CHAR, sc_MPI_MIN, mpicomm);
-  SC_CHECK_ABORT (cresult == 0, "Allreduce mismatch");
+    /* test allreduce char min */
+    cvalue = (char) (mpirank % 127);
+    sc_allreduce (&cvalue, &cresult, 1, sc_MPI_CHAR, sc_MPI_MIN, mpicomm);
+    SC_CHECK_ABORT (cresult == 0, "Allreduce mismatch");
 
-  /* test reduce unsigned short min */
-  usvalue = (unsigned short) (mpirank % 32767);
-  for (i = 0; i < mpisize; ++i) {
-    sc_reduce (&usvalue, &usresult, 1, sc_MPI_UNSIGNED_SHORT, sc_MPI_MIN, i,
-               mpicomm);
-    if (i == mpirank) {
-      SC_CHECK_ABORT (usresult == 0, "Reduce mismatch");
+    /* test reduce unsigned short min */
+    usvalue = (unsigned short) (mpirank % 32767);
+    for (i = 0; i < mpisize; ++i) {
+      sc_reduce (&usvalue, &usresult, 1, sc_MPI_UNSIGNED_SHORT, sc_MPI_MIN,
+                 i, mpicomm);
+      if (i == mpirank) {
+        SC_CHECK_ABORT (usresult == 0, "Reduce mismatch");
+      }
     }
-  }
 
-  /* test allreduce long sum */
-  lvalue = (long) mpirank;
-  sc_allreduce (&lvalue, &lresult, 1, sc_MPI_LONG, sc_MPI_SUM, mpicomm);
-  SC_CHECK_ABORT (lresult == ((long) (mpisize - 1)) * mpisize / 2,
-                  "Allreduce mismatch");
+    /* test allreduce long sum */
+    lvalue = (long) mpirank;
+    sc_allreduce (&lvalue, &lresult, 1, sc_MPI_LONG, sc_MPI_SUM, mpicomm);
+    SC_CHECK_ABORT (lresult == ((long) (mpisize - 1)) * mpisize / 2,
+                    "Allreduce mismatch");
 
-  /* test reduce double sum */
-  dvalue = (double) mpirank;
-  for (i = 0; i < mpisize; ++i) {
-    sc_reduce (&dvalue, &dresult, 1, sc_MPI_DOUBLE, sc_MPI_SUM, i, mpicomm);
-    if (i == mpirank) {
-      SC_CHECK_ABORT (dresult == ((double) (mpisize - 1)) * mpisize / 2.,       /* ok */
-                      "Reduce mismatch");
+    /* test reduce double sum */
+    dvalue = (double) mpirank;
+    for (i = 0; i < mpisize; ++i) {
+      sc_reduce (&dvalue, &dresult, 1, sc_MPI_DOUBLE, sc_MPI_SUM, i, mpicomm);
+      if (i == mpirank) {
+        SC_CHECK_ABORT (dresult == ((double) (mpisize - 1)) * mpisize / 2.,     /* ok */
+                        "Reduce mismatch");
+      }
     }
   }
 
+  /* compare the node-aware version with the flat one and MPI */
+  dsend = SC_ALLOC (double, TEST_REDUCE_COUNT);
+  dresult1 = SC_ALLOC (double, TEST_REDUCE_COUNT);
+  dresult2 = SC_ALLOC (double, TEST_REDUCE_COUNT);
+  for (i = 0; i < TEST_REDUCE_COUNT; ++i) {
+    dsend[i] = (double) (mpirank * i % 1009);
+  }
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_mpi = -sc_MPI_Wtime ();
+  for (rep = 0; rep < TEST_REDUCE_REPS; ++rep) {
+    mpiret = sc_MPI_Allreduce (dsend, dresult1, TEST_REDUCE_COUNT,
+                               sc_MPI_DOUBLE, sc_MPI_SUM, mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  elapsed_mpi += sc_MPI_Wtime ();
+
+  sc_reduce_hierarchical = 0;
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_flat = -sc_MPI_Wtime ();
+  for (rep = 0; rep < TEST_REDUCE_REPS; ++rep) {
+    sc_allreduce (dsend, dresult2, TEST_REDUCE_COUNT, sc_MPI_DOUBLE,
+                  sc_MPI_SUM, mpicomm);
+  }
+  elapsed_flat += sc_MPI_Wtime ();
+  for (i = 0; i < TEST_REDUCE_COUNT; ++i) {
+    /* the sums of integers are exact */
+    SC_CHECK_ABORT (dresult1[i] == dresult2[i], "Flat allreduce mismatch");
+  }
+
+  sc_reduce_hierarchical = 1;
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_node = -sc_MPI_Wtime ();
+  for (rep = 0; rep < TEST_REDUCE_REPS; ++rep) {
+    sc_allreduce (dsend, dresult2, TEST_REDUCE_COUNT, sc_MPI_DOUBLE,
+                  sc_MPI_SUM, mpicomm);
+  }
+  elapsed_node += sc_MPI_Wtime ();
+  sc_reduce_hierarchical = 0;
+  for (i = 0; i < TEST_REDUCE_COUNT; ++i) {
+    SC_CHECK_ABORT (dresult1[i] == dresult2[i], "Node allreduce mismatch");
+  }
+  SC_FREE (dsend);
+  SC_FREE (dresult1);
+  SC_FREE (dresult2);
+  sc_mpi_comm_detach_node_comms (mpicomm);
+
+  /* compare the large message version with MPI */
+  SC_ASSERT (TEST_REDUCE_LARGE * sizeof (double) >= SC_REDUCE_LARGE_BYTES);
+  dsend = SC_ALLOC (double, TEST_REDUCE_LARGE);
+  dresult1 = SC_ALLOC (double, TEST_REDUCE_LARGE);
+  dresult2 = SC_ALLOC (double, TEST_REDUCE_LARGE);
+  for (i = 0; i < TEST_REDUCE_LARGE; ++i) {
+    dsend[i] = (double) ((mpirank + 1) * i % 1013);
+  }
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_large_mpi = -sc_MPI_Wtime ();
+  for (rep = 0; rep < TEST_REDUCE_REPS; ++rep) {
+    mpiret = sc_MPI_Allreduce (dsend, dresult1, TEST_REDUCE_LARGE,
+                               sc_MPI_DOUBLE, sc_MPI_SUM, mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  elapsed_large_mpi += sc_MPI_Wtime ();
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_large = -sc_MPI_Wtime ();
+  for (rep = 0; rep < TEST_REDUCE_REPS; ++rep) {
+    sc_allreduce (dsend, dresult2, TEST_REDUCE_LARGE, sc_MPI_DOUBLE,
+                  sc_MPI_SUM, mpicomm);
+  }
+  elapsed_large += sc_MPI_Wtime ();
+  for (i = 0; i < TEST_REDUCE_LARGE; ++i) {
+    SC_CHECK_ABORT (dresult1[i] == dresult2[i], "Large allreduce mismatch");
+  }
+
+  /* the operands must be combined in rank order */
+  sc_allreduce_custom (dsend, dresult2, TEST_REDUCE_LARGE, sc_MPI_DOUBLE,
+                       test_reduce_right, mpicomm);
+  for (i = 0; i < TEST_REDUCE_LARGE; ++i) {
+    SC_CHECK_ABORT (dresult2[i] == (double) (mpisize * i % 1013),
+                    "Large allreduce order mismatch");
+  }
+  SC_FREE (dsend);
+  SC_FREE (dresult1);
+  SC_FREE (dresult2);
+
+  SC_GLOBAL_STATISTICSF ("Timings of %d allreduces of %d doubles,"
+                         " node size %d (shared %d)\n", TEST_REDUCE_REPS,
+                         TEST_REDUCE_COUNT, node_size, shared);
+  SC_GLOBAL_STATISTICSF ("   MPI %g\n", elapsed_mpi);
+  SC_GLOBAL_STATISTICSF ("   flat %g\n", elapsed_flat);
+  SC_GLOBAL_STATISTICSF ("   node %g\n", elapsed_node);
+  SC_GLOBAL_STATISTICSF ("Timings of %d allreduces of %d doubles\n",
+                         TEST_REDUCE_REPS, TEST_REDUCE_LARGE);
+  SC_GLOBAL_STATISTICSF ("   MPI %g\n", elapsed_large_mpi);
+  SC_GLOBAL_STATISTICSF ("   large %g\n", elapsed_large);
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
@@ -23,42 +23,475 @@
 
 #include <sc_scda.h>
 
-/* WARNING: this file contains obsolete references to be removed */
+#define SC_SCDA_TEST_FILE "sc_test_scda.scd"
+#define SC_SCDA_TEST_ELEM 12
 
-#if 0
-#define SC_SCDA_FILE_EXT "scd"
-#define SC_SCDA_TEST_FILE "sc_test_scda." SC_SCDA_FILE_EXT
-#endif
+/* partition the global count evenly or, if skewed, put all on the last rank */
+static void
+test_scda_partition (sc_MPI_Comm mpicomm, size_t global, int skewed,
+                     sc_array_t * elem_counts, sc_scda_ulong *offset)
+{
+  int                 mpiret, mpisize, mpirank, p;
+  sc_scda_ulong       begin, end;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_array_init_size (elem_counts, sizeof (sc_scda_ulong), (size_t) mpisize);
+  *offset = 0;
+  for (p = 0; p < mpisize; ++p) {
+    if (skewed) {
+      begin = 0;
+      end = p < mpisize - 1 ? 0 : global;
+    }
+    else {
+      begin = (sc_scda_ulong) ((global * p) / mpisize);
+      end = (sc_scda_ulong) ((global * (p + 1)) / mpisize);
+    }
+    *(sc_scda_ulong *) sc_array_index_int (elem_counts, p) = end - begin;
+    if (p < mpirank) {
+      *offset += end - begin;
+    }
+  }
+}
+
+static size_t
+test_scda_vsize (sc_scda_ulong i)
+{
+  return (size_t) (1 + (i * 7) % 23);
+}
+
+static char
+test_scda_byte (sc_scda_ulong i, size_t j)
+{
+  return (char) ('a' + (i + 3 * j) % 26);
+}
+
+static void
+test_scda_check (sc_scda_ferror_t * errcode, const char *msg)
+{
+  char                str[sc_MPI_MAX_ERROR_STRING];
+  int                 len;
+
+  if (errcode->scdaret != SC_SCDA_FERR_SUCCESS) {
+    SC_EXECUTE_ASSERT_FALSE (sc_scda_ferror_string (*errcode, str, &len));
+    SC_LERRORF ("%s: %s\n", msg, str);
+  }
+  SC_CHECK_ABORT (errcode->scdaret == SC_SCDA_FERR_SUCCESS, msg);
+}
+
+/* fill local fixed-size and variable-size array data */
+static void
+test_scda_data (sc_scda_ulong offset, sc_scda_ulong local,
+                sc_array_t * fixed, sc_array_t * sizes, sc_array_t * vdata)
+{
+  size_t              zz, j;
+  sc_scda_ulong       i;
+  char               *pos;
+
+  sc_array_init_size (fixed, SC_SCDA_TEST_ELEM, (size_t) local);
+  sc_array_init_size (sizes, sizeof (sc_scda_ulong), (size_t) local);
+  sc_array_init (vdata, 1);
+  for (zz = 0; zz < local; ++zz) {
+    i = offset + zz;
+    pos = (char *) sc_array_index (fixed, zz);
+    for (j = 0; j < SC_SCDA_TEST_ELEM; ++j) {
+      pos[j] = test_scda_byte (i, j);
+    }
+    *(sc_scda_ulong *) sc_array_index (sizes, zz) = test_scda_vsize (i);
+    pos = (char *) sc_array_push_count (vdata, test_scda_vsize (i));
+    for (j = 0; j < test_scda_vsize (i); ++j) {
+      pos[j] = test_scda_byte (i, j);
+    }
+  }
+}
+
+/* create views of the elements of a contiguous array */
+static void
+test_scda_indirect (sc_array_t * data, sc_array_t * sizes,
+                    size_t elem_size, sc_array_t * indirect)
+{
+  size_t              zz, count, offset, size;
+
+  count = sizes != NULL ? sizes->elem_count : data->elem_count;
+  sc_array_init_size (indirect, sizeof (sc_array_t), count);
+  for (offset = 0, zz = 0; zz < count; ++zz) {
+    size = sizes != NULL ?
+      (size_t) *(sc_scda_ulong *) sc_array_index (sizes, zz) : elem_size;
+    sc_array_init_data ((sc_array_t *) sc_array_index (indirect, zz),
+                        data->array + offset, size, 1);
+    offset += size;
+  }
+}
+
+/* view the bytes of an array as one block or as empty array */
+static void
+test_scda_view_block (sc_array_t * view, sc_array_t * bytes)
+{
+  if (bytes->elem_count > 0) {
+    sc_array_init_data (view, bytes->array, bytes->elem_count, 1);
+  }
+  else {
+    sc_array_init (view, 1);
+  }
+}
+
+static void
+test_scda_write (sc_MPI_Comm mpicomm, size_t global)
+{
+  int                 mpiret, mpisize, mpirank, encode;
+  char                inline_bytes[33];
+  const char         *block = "A block of data that is written by one rank";
+  sc_scda_ulong       offset;
+  sc_scda_fcontext_t *fc;
+  sc_scda_ferror_t    errcode;
+  sc_array_t          elem_counts, proc_sizes, fixed, sizes, vdata;
+  sc_array_t          inline_data, block_data, indirect;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  test_scda_partition (mpicomm, global, 0, &elem_counts, &offset);
+  test_scda_data (offset, *(sc_scda_ulong *) sc_array_index_int
+                  (&elem_counts, mpirank), &fixed, &sizes, &vdata);
+
+  fc = sc_scda_fopen_write (mpicomm, SC_SCDA_TEST_FILE, "scda test file",
+                            NULL, NULL, &errcode);
+  test_scda_check (&errcode, "scda fopen_write");
+
+  snprintf (inline_bytes, 33, "%-31s\n", "Inline data of the last rank");
+  sc_array_init_data (&inline_data, inline_bytes, 32, 1);
+  fc = sc_scda_fwrite_inline (fc, "Inline section", NULL, &inline_data,
+                              mpisize - 1, &errcode);
+  test_scda_check (&errcode, "scda fwrite_inline");
+
+  sc_array_init_size (&proc_sizes, sizeof (sc_scda_ulong), 0);
+  SC_EXECUTE_ASSERT_FALSE (sc_scda_proc_sizes (fc, &sizes, &elem_counts,
+                                               &proc_sizes, &errcode));
+  for (encode = 0; encode < 2; ++encode) {
+    sc_array_init_data (&block_data, (void *) block, strlen (block), 1);
+    fc = sc_scda_fwrite_block (fc, "Block section", NULL, &block_data,
+                               strlen (block), mpisize - 1, encode,
+                               &errcode);
+    test_scda_check (&errcode, "scda fwrite_block");
+
+    fc = sc_scda_fwrite_array (fc, "Array section", NULL, &fixed,
+                               &elem_counts, SC_SCDA_TEST_ELEM, 0, encode,
+                               &errcode);
+    test_scda_check (&errcode, "scda fwrite_array");
+
+    test_scda_indirect (&fixed, NULL, SC_SCDA_TEST_ELEM, &indirect);
+    fc = sc_scda_fwrite_array (fc, "Indirect array section", NULL,
+                               &indirect, &elem_counts, SC_SCDA_TEST_ELEM,
+                               1, encode, &errcode);
+    test_scda_check (&errcode, "scda fwrite_array indirect");
+    sc_array_reset (&indirect);
+
+    test_scda_view_block (&block_data, &vdata);
+    fc = sc_scda_fwrite_varray (fc, "Varray section", NULL, &block_data,
+                                &elem_counts, &sizes, &proc_sizes, 0,
+                                encode, &errcode);
+    test_scda_check (&errcode, "scda fwrite_varray");
+
+    test_scda_indirect (&vdata, &sizes, 0, &indirect);
+    fc = sc_scda_fwrite_varray (fc, "Indirect varray section", NULL,
+                                &indirect, &elem_counts, &sizes,
+                                &proc_sizes, 1, encode, &errcode);
+    test_scda_check (&errcode, "scda fwrite_varray indirect");
+    sc_array_reset (&indirect);
+  }
+
+  SC_EXECUTE_ASSERT_FALSE (sc_scda_fclose (fc, &errcode));
+  test_scda_check (&errcode, "scda fclose");
+
+  sc_array_reset (&elem_counts);
+  sc_array_reset (&proc_sizes);
+  sc_array_reset (&fixed);
+  sc_array_reset (&sizes);
+  sc_array_reset (&vdata);
+}
+
+static sc_scda_fcontext_t *
+test_scda_header (sc_scda_fcontext_t * fc, const char *expected_string,
+                  char expected_type, size_t expected_count,
+                  size_t expected_size, int expected_decode, int decode)
+{
+  char                user_string[SC_SCDA_USER_STRING_BYTES + 1];
+  char                type;
+  size_t              len, elem_count, elem_size;
+  sc_scda_ferror_t    errcode;
+
+  fc = sc_scda_fread_section_header (fc, user_string, &len, &type,
+                                     &elem_count, &elem_size, &decode,
+                                     &errcode);
+  test_scda_check (&errcode, "scda fread_section_header");
+  SC_CHECK_ABORT (len == strlen (expected_string) &&
+                  !strcmp (user_string, expected_string), "User string");
+  SC_CHECK_ABORT (type == expected_type, "Section type");
+  SC_CHECK_ABORT (elem_count == expected_count, "Section count");
+  SC_CHECK_ABORT (elem_size == expected_size, "Section size");
+  SC_CHECK_ABORT (decode == expected_decode, "Section decode");
+
+  return fc;
+}
+
+/* read the file with an arbitrary communicator and partition */
+static void
+test_scda_read (sc_MPI_Comm mpicomm, size_t global, int skewed)
+{
+  int                 mpiret, mpisize, mpirank, encode, indirect;
+  char                user_string[SC_SCDA_USER_STRING_BYTES + 1];
+  char                type;
+  const char         *block = "A block of data that is written by one rank";
+  size_t              len, elem_count, elem_size;
+  sc_scda_ulong       offset, local;
+  sc_scda_fcontext_t *fc;
+  sc_scda_ferror_t    errcode;
+  sc_array_t          elem_counts, proc_sizes, fixed, sizes, vdata;
+  sc_array_t          data, read_sizes, view;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  test_scda_partition (mpicomm, global, skewed, &elem_counts, &offset);
+  local = *(sc_scda_ulong *) sc_array_index_int (&elem_counts, mpirank);
+  test_scda_data (offset, local, &fixed, &sizes, &vdata);
+
+  fc = sc_scda_fopen_read (mpicomm, SC_SCDA_TEST_FILE, user_string, &len,
+                           NULL, &errcode);
+  test_scda_check (&errcode, "scda fopen_read");
+  SC_CHECK_ABORT (!strcmp (user_string, "scda test file"), "File string");
+
+  fc = test_scda_header (fc, "Inline section", 'I', 0, 0, 0, 1);
+  sc_array_init_size (&data, 32, 1);
+  fc = sc_scda_fread_inline_data (fc, &data, mpisize - 1, &errcode);
+  test_scda_check (&errcode, "scda fread_inline_data");
+  SC_CHECK_ABORT (mpirank != mpisize - 1 ||
+                  !strncmp (data.array, "Inline data of the last rank", 28),
+                  "Inline data");
+  sc_array_reset (&data);
+
+  for (encode = 0; encode < 2; ++encode) {
+    fc = test_scda_header (fc, "Block section", 'B', 0, strlen (block),
+                           encode, 1);
+    sc_array_init_size (&data, strlen (block), 1);
+    fc = sc_scda_fread_block_data (fc, &data, strlen (block), mpisize - 1,
+                                   &errcode);
+    test_scda_check (&errcode, "scda fread_block_data");
+    SC_CHECK_ABORT (mpirank != mpisize - 1 ||
+                    !memcmp (data.array, block, strlen (block)), "Block");
+    sc_array_reset (&data);
+
+    for (indirect = 0; indirect < 2; ++indirect) {
+      fc = test_scda_header (fc, indirect ? "Indirect array section" :
+                             "Array section", 'A', global,
+                             SC_SCDA_TEST_ELEM, encode, 1);
+      sc_array_init_size (&data, SC_SCDA_TEST_ELEM, (size_t) local);
+      if (indirect) {
+        test_scda_indirect (&data, NULL, SC_SCDA_TEST_ELEM, &view);
+      }
+      fc = sc_scda_fread_array_data (fc, indirect ? &view : &data,
+                                     &elem_counts, SC_SCDA_TEST_ELEM,
+                                     indirect, &errcode);
+      test_scda_check (&errcode, "scda fread_array_data");
+      SC_CHECK_ABORT (sc_array_is_equal (&data, &fixed), "Array data");
+      if (indirect) {
+        sc_array_reset (&view);
+      }
+      sc_array_reset (&data);
+    }
+
+    for (indirect = 0; indirect < 2; ++indirect) {
+      fc = test_scda_header (fc, indirect ? "Indirect varray section" :
+                             "Varray section", 'V', global, 0, encode, 1);
+      sc_array_init_size (&read_sizes, sizeof (sc_scda_ulong),
+                          (size_t) local);
+      fc = sc_scda_fread_varray_sizes (fc, &read_sizes, &elem_counts,
+                                       &errcode);
+      test_scda_check (&errcode, "scda fread_varray_sizes");
+      SC_CHECK_ABORT (sc_array_is_equal (&read_sizes, &sizes), "Sizes");
+
+      sc_array_init (&proc_sizes, sizeof (sc_scda_ulong));
+      SC_EXECUTE_ASSERT_FALSE (sc_scda_proc_sizes (fc, &read_sizes,
+                                                   &elem_counts, &proc_sizes,
+                                                   &errcode));
+      sc_array_init_size (&data, 1, vdata.elem_count);
+      if (indirect) {
+        test_scda_indirect (&data, &read_sizes, 0, &view);
+      }
+      else {
+        test_scda_view_block (&view, &data);
+      }
+      fc = sc_scda_fread_varray_data (fc, &view, &elem_counts, &read_sizes,
+                                      &proc_sizes, indirect, &errcode);
+      test_scda_check (&errcode, "scda fread_varray_data");
+      SC_CHECK_ABORT (sc_array_is_equal (&data, &vdata), "Varray data");
+      if (indirect) {
+        sc_array_reset (&view);
+      }
+      sc_array_reset (&data);
+      sc_array_reset (&read_sizes);
+      sc_array_reset (&proc_sizes);
+    }
+  }
+
+  /* reading beyond the last section fails and closes the file */
+  fc = sc_scda_fread_section_header (fc, user_string, &len, &type,
+                                     &elem_count, &elem_size, &encode,
+                                     &errcode);
+  SC_CHECK_ABORT (fc == NULL && errcode.scdaret == SC_SCDA_FERR_COUNT,
+                  "End of file");
+
+  sc_array_reset (&elem_counts);
+  sc_array_reset (&fixed);
+  sc_array_reset (&sizes);
+  sc_array_reset (&vdata);
+}
+
+/* walk through all sections without decoding and without reading data */
+static void
+test_scda_raw (sc_MPI_Comm mpicomm, size_t global)
+{
+  int                 mpiret, mpisize, mpirank, decode, sections;
+  char                user_string[SC_SCDA_USER_STRING_BYTES + 1];
+  char                type;
+  size_t              len, elem_count, elem_size;
+  sc_scda_ulong       offset;
+  sc_scda_fcontext_t *fc;
+  sc_scda_ferror_t    errcode;
+  sc_array_t          elem_counts, sizes, proc_sizes;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  fc = sc_scda_fopen_read (mpicomm, SC_SCDA_TEST_FILE, user_string, &len,
+                           NULL, &errcode);
+  test_scda_check (&errcode, "scda fopen_read");
+  for (sections = 0;; ++sections) {
+    decode = 0;
+    fc = sc_scda_fread_section_header (fc, user_string, &len, &type,
+                                       &elem_count, &elem_size, &decode,
+                                       &errcode);
+    if (fc == NULL) {
+      SC_CHECK_ABORT (errcode.scdaret == SC_SCDA_FERR_COUNT, "End of file");
+      break;
+    }
+    SC_CHECK_ABORT (!decode, "Raw reading");
+    switch (type) {
+    case 'I':
+      fc = sc_scda_fread_inline_data (fc, NULL, 0, &errcode);
+      break;
+    case 'B':
+      fc = sc_scda_fread_block_data (fc, NULL, elem_size, 0, &errcode);
+      break;
+    case 'A':
+      SC_CHECK_ABORT (elem_count == global, "Raw array count");
+      test_scda_partition (mpicomm, elem_count, 0, &elem_counts, &offset);
+      fc = sc_scda_fread_array_data (fc, NULL, &elem_counts, elem_size, 0,
+                                     &errcode);
+      sc_array_reset (&elem_counts);
+      break;
+    case 'V':
+      /* the encoded arrays are stored as variable-size arrays */
+      SC_CHECK_ABORT (elem_count == global, "Raw varray count");
+      test_scda_partition (mpicomm, elem_count, 1, &elem_counts, &offset);
+      sc_array_init_size (&sizes, sizeof (sc_scda_ulong),
+                          (size_t) *(sc_scda_ulong *)
+                          sc_array_index_int (&elem_counts, mpirank));
+      fc = sc_scda_fread_varray_sizes (fc, &sizes, &elem_counts, &errcode);
+      test_scda_check (&errcode, "scda raw fread_varray_sizes");
+      sc_array_init (&proc_sizes, sizeof (sc_scda_ulong));
+      SC_EXECUTE_ASSERT_FALSE (sc_scda_proc_sizes (fc, &sizes, &elem_counts,
+                                                   &proc_sizes, &errcode));
+      fc = sc_scda_fread_varray_data (fc, NULL, &elem_counts, &sizes,
+                                      &proc_sizes, 0, &errcode);
+      sc_array_reset (&proc_sizes);
+      sc_array_reset (&sizes);
+      sc_array_reset (&elem_counts);
+      break;
+    default:
+      SC_ABORT_NOT_REACHED ();
+    }
+    test_scda_check (&errcode, "scda raw section data");
+  }
+
+  /* one inline section and five sections written raw and encoded */
+  SC_CHECK_ABORT (sections == 1 + 5 + 2 * 5, "Raw section count");
+}
+
+static void
+test_scda_errors (sc_MPI_Comm mpicomm)
+{
+  char                user_string[SC_SCDA_USER_STRING_BYTES + 1];
+  char                str[sc_MPI_MAX_ERROR_STRING];
+  int                 len;
+  size_t              ulen;
+  sc_scda_fcontext_t *fc;
+  sc_scda_ferror_t    errcode, errclass;
+
+  fc = sc_scda_fopen_read (mpicomm, "sc_test_scda.nonexistent", user_string,
+                           &ulen, NULL, &errcode);
+  SC_CHECK_ABORT (fc == NULL && errcode.scdaret == SC_SCDA_FERR_MPI,
+                  "Open nonexistent");
+  SC_EXECUTE_ASSERT_FALSE (sc_scda_ferror_class (errcode, &errclass));
+  SC_EXECUTE_ASSERT_FALSE (sc_scda_ferror_string (errclass, str, &len));
+  SC_GLOBAL_INFOF ("Expected error: %s\n", str);
+
+  /* a user string that is too long */
+  memset (user_string, 'x', SC_SCDA_USER_STRING_BYTES);
+  user_string[SC_SCDA_USER_STRING_BYTES] = '\0';
+  ulen = SC_SCDA_USER_STRING_BYTES + 1;
+  fc = sc_scda_fopen_write (mpicomm, SC_SCDA_TEST_FILE, user_string, &ulen,
+                            NULL, &errcode);
+  SC_CHECK_ABORT (fc == NULL && errcode.scdaret == SC_SCDA_FERR_ARG,
+                  "User string length");
+  SC_EXECUTE_ASSERT_FALSE (sc_scda_ferror_string (errcode, str, &len));
+}
 
 int
 main (int argc, char **argv)
 {
-  int                 mpiret;
-#if 0
-  int                 errcode;
-  const char         *filename = SC_SCDA_TEST_FILE;
-  char                read_user_string[SC_SCDA_USER_STRING_BYTES + 1];
-  sc_scda_fcontext_t *fc;
-#endif
+  int                 mpiret, mpirank, mpisize;
+  size_t              global;
+  sc_MPI_Comm         subcomm;
 
   mpiret = sc_MPI_Init (&argc, &argv);
   SC_CHECK_MPI (mpiret);
   sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
 
-#if 0
-  fc =
-    sc_scda_fopen_write (filename, sc_MPI_COMM_WORLD, "This is a test file",
-                        &errcode);
-  /* TODO: check errcode */
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &mpirank);
+  SC_CHECK_MPI (mpiret);
 
-  sc_scda_fclose (fc, &errcode);
+  /* an optional argument sets the global number of array elements */
+  global = 1000;
+  if (argc >= 2) {
+    global = (size_t) SC_MAX (sc_atoi (argv[1]), 0);
+  }
 
-  fc =
-    sc_scda_fopen_read (sc_MPI_COMM_WORLD, filename, read_user_string,
-                       &errcode);
+  test_scda_write (sc_MPI_COMM_WORLD, global);
+  test_scda_read (sc_MPI_COMM_WORLD, global, 0);
+  test_scda_read (sc_MPI_COMM_WORLD, global, 1);
+  test_scda_raw (sc_MPI_COMM_WORLD, global);
+
+  /* read with a different number of processes than written */
+  mpiret = sc_MPI_Comm_split (sc_MPI_COMM_WORLD, mpirank < (mpisize + 1) / 2 ?
+                              0 : sc_MPI_UNDEFINED, mpirank, &subcomm);
+  SC_CHECK_MPI (mpiret);
+  if (subcomm != sc_MPI_COMM_NULL) {
+    test_scda_read (subcomm, global, 0);
+    mpiret = sc_MPI_Comm_free (&subcomm);
+    SC_CHECK_MPI (mpiret);
+  }
 
-  sc_scda_fclose (fc, &errcode);
-#endif
+  test_scda_errors (sc_MPI_COMM_WORLD);
 
   sc_finalize ();
 
@@ -24,6 +24,180 @@
 #include <sc_allgather.h>
 #include <sc_sort.h>
 
+/* gather the distributed data on rank 0 and verify that it is sorted */
+static double      *
+test_sort_gather (sc_MPI_Comm mpicomm, double *ldata, size_t *nmemb)
+{
+  int                 mpiret;
+  int                 rank, num_procs;
+  int                 i;
+  int                *recvc, *displ;
+  size_t              zz, gtotal;
+  double             *gdata;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  gtotal = 0;
+  recvc = NULL;
+  displ = NULL;
+  gdata = NULL;
+  if (rank == 0) {
+    recvc = SC_ALLOC (int, num_procs);
+    displ = SC_ALLOC (int, num_procs + 1);
+    displ[0] = 0;
+    for (i = 0; i < num_procs; ++i) {
+      recvc[i] = (int) nmemb[i];
+      displ[i + 1] = displ[i] + recvc[i];
+    }
+    gtotal = (size_t) displ[num_procs];
+    gdata = SC_ALLOC (double, gtotal);
+  }
+  mpiret = sc_MPI_Gatherv (ldata, (int) nmemb[rank], sc_MPI_DOUBLE,
+                           gdata, recvc, displ, sc_MPI_DOUBLE, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    for (zz = 0; zz + 1 < gtotal; ++zz) {
+      SC_CHECK_ABORT (gdata[zz] <= gdata[zz + 1], "Parallel sort failed");
+    }
+  }
+  SC_FREE (displ);
+  SC_FREE (recvc);
+
+  return gdata;
+}
+
+/* sort with the sample sort variants and compare with the bitonic result */
+static void
+test_sort_sample (sc_MPI_Comm mpicomm, double *odata, double *ldata,
+                  double *gdata, size_t *nmemb, double elapsed_bitonic)
+{
+  int                 mpiret;
+  int                 rank, num_procs;
+  int                 i;
+  size_t              zz, lcount, gtotal, maxin, maxout;
+  size_t             *rnmemb;
+  double              elapsed_sample, elapsed_rebalance;
+  double             *sdata, *rdata;
+  sc_array_t         *rarray;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  lcount = nmemb[rank];
+  gtotal = maxin = 0;
+  for (i = 0; i < num_procs; ++i) {
+    gtotal += nmemb[i];
+    maxin = SC_MAX (maxin, nmemb[i]);
+  }
+
+  /* sample sort keeps the partition and yields the same values */
+  SC_GLOBAL_PRODUCTIONF ("Sample sorting %ld\n", (long) gtotal);
+  sdata = SC_ALLOC (double, lcount);
+  memcpy (sdata, odata, lcount * sizeof (double));
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_sample = -sc_MPI_Wtime ();
+  sc_psort_ext (mpicomm, sdata, nmemb, sizeof (double), sc_double_compare,
+                SC_PSORT_SAMPLE);
+  elapsed_sample += sc_MPI_Wtime ();
+  for (zz = 0; zz < lcount; ++zz) {
+    SC_CHECK_ABORT (sdata[zz] == ldata[zz], "Sample sort mismatch");
+  }
+  SC_FREE (sdata);
+
+  /* sample sort with rebalanced output */
+  rnmemb = SC_ALLOC (size_t, num_procs);
+  memcpy (rnmemb, nmemb, num_procs * sizeof (size_t));
+  rarray = sc_array_new_count (sizeof (double), lcount);
+  memcpy (rarray->array, odata, lcount * sizeof (double));
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_rebalance = -sc_MPI_Wtime ();
+  sc_psort_rebalance (mpicomm, rarray, rnmemb, sc_double_compare);
+  elapsed_rebalance += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (rarray->elem_count == rnmemb[rank], "Rebalanced count");
+  for (i = 0, zz = 0; i < num_procs; ++i) {
+    zz += rnmemb[i];
+  }
+  SC_CHECK_ABORT (zz == gtotal, "Rebalanced total");
+  rdata = (double *) rarray->array;
+  for (zz = 0; zz + 1 < rarray->elem_count; ++zz) {
+    SC_CHECK_ABORT (rdata[zz] <= rdata[zz + 1], "Rebalanced order");
+  }
+  if (gtotal < 100000) {
+    double             *rgdata = test_sort_gather (mpicomm, rdata, rnmemb);
+    if (rank == 0) {
+      for (zz = 0; zz < gtotal; ++zz) {
+        SC_CHECK_ABORT (rgdata[zz] == gdata[zz], "Rebalanced mismatch");
+      }
+    }
+    SC_FREE (rgdata);
+  }
+
+  /* many equal values must still be distributed evenly */
+  sc_array_resize (rarray, lcount);
+  rdata = (double *) rarray->array;
+  for (zz = 0; zz < lcount; ++zz) {
+    rdata[zz] = floor (odata[zz] / 40.);
+  }
+  memcpy (rnmemb, nmemb, num_procs * sizeof (size_t));
+  sc_psort_rebalance (mpicomm, rarray, rnmemb, sc_double_compare);
+  rdata = (double *) rarray->array;
+  for (zz = 0; zz + 1 < rarray->elem_count; ++zz) {
+    SC_CHECK_ABORT (rdata[zz] <= rdata[zz + 1], "Duplicates order");
+  }
+  maxout = 0;
+  for (i = 0; i < num_procs; ++i) {
+    maxout = SC_MAX (maxout, rnmemb[i]);
+  }
+  SC_GLOBAL_INFOF ("Rebalanced maximum count %ld input %ld\n",
+                   (long) maxout, (long) maxin);
+  SC_CHECK_ABORT (maxout <= 2 * (gtotal / num_procs) + maxin,
+                  "Duplicates balance");
+  sc_array_destroy (rarray);
+  SC_FREE (rnmemb);
+
+  SC_GLOBAL_STATISTICSF ("Timings for sorting %ld values on %d processes\n",
+                         (long) gtotal, num_procs);
+  SC_GLOBAL_STATISTICSF ("   bitonic %g\n", elapsed_bitonic);
+  SC_GLOBAL_STATISTICSF ("   sample %g\n", elapsed_sample);
+  SC_GLOBAL_STATISTICSF ("   sample rebalanced %g\n", elapsed_rebalance);
+}
+
+/* sort integers by key with both algorithms and compare with qsort */
+static void
+test_sort_key (sc_MPI_Comm mpicomm, size_t *nmemb, int rank)
+{
+  const size_t        lcount = nmemb[rank];
+  size_t              zz;
+  int64_t            *ref, *kdata;
+  int                 algorithm;
+
+  ref = SC_ALLOC (int64_t, lcount);
+  kdata = SC_ALLOC (int64_t, lcount);
+  for (zz = 0; zz < lcount; ++zz) {
+    ref[zz] = (int64_t) rand () - RAND_MAX / 2;
+  }
+  for (algorithm = SC_PSORT_BITONIC; algorithm <= SC_PSORT_SAMPLE;
+       ++algorithm) {
+    memcpy (kdata, ref, lcount * sizeof (int64_t));
+    sc_psort_key (mpicomm, kdata, nmemb, sizeof (int64_t), sc_int64_compare,
+                  (sc_psort_algorithm_t) algorithm, 0, sizeof (int64_t), 1);
+    if (algorithm == SC_PSORT_BITONIC) {
+      sc_psort (mpicomm, ref, nmemb, sizeof (int64_t), sc_int64_compare);
+    }
+    for (zz = 0; zz < lcount; ++zz) {
+      SC_CHECK_ABORT (kdata[zz] == ref[zz], "Key sort mismatch");
+    }
+  }
+  SC_FREE (kdata);
+  SC_FREE (ref);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -32,12 +206,12 @@ main (int argc, char **argv)
   int                 rank, num_procs;
   int                 i, isizet;
   int                 k, printed;
-  int                *recvc, *displ;
   int                 timing;
   size_t              zz;
   size_t              lcount, gtotal;
   size_t             *nmemb;
-  double             *ldata, *gdata;
+  double              elapsed_bitonic;
+  double             *ldata, *odata, *gdata;
   sc_MPI_Comm         mpicomm;
   char                buffer[BUFSIZ];
 
@@ -104,7 +278,13 @@ main (int argc, char **argv)
 
   /* call parallel sort */
   SC_GLOBAL_PRODUCTIONF ("Sorting %ld\n", (long) gtotal);
+  odata = SC_ALLOC (double, lcount);
+  memcpy (odata, ldata, lcount * sizeof (double));
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed_bitonic = -sc_MPI_Wtime ();
   sc_psort (mpicomm, ldata, nmemb, sizeof (double), sc_double_compare);
+  elapsed_bitonic += sc_MPI_Wtime ();
 
   /* output result */
   if (!timing && gtotal < 1000) {
@@ -124,37 +304,19 @@ main (int argc, char **argv)
   }
 
   /* verify result always, if the numbers are not too many */
+  gdata = NULL;
   if (gtotal < 100000) {
     SC_GLOBAL_PRODUCTION ("Verifying\n");
-    gtotal = 0;
-    recvc = NULL;
-    displ = NULL;
-    gdata = NULL;
-    if (rank == 0) {
-      recvc = SC_ALLOC (int, num_procs);
-      displ = SC_ALLOC (int, num_procs + 1);
-      displ[0] = 0;
-      for (i = 0; i < num_procs; ++i) {
-        recvc[i] = (int) nmemb[i];
-        displ[i + 1] = displ[i] + recvc[i];
-      }
-      gtotal = (size_t) displ[num_procs];
-      gdata = SC_ALLOC (double, gtotal);
-    }
-    mpiret = sc_MPI_Gatherv (ldata, (int) lcount, sc_MPI_DOUBLE,
-                             gdata, recvc, displ, sc_MPI_DOUBLE, 0, mpicomm);
-    SC_CHECK_MPI (mpiret);
-    if (rank == 0) {
-      for (zz = 0; zz < gtotal - 1; ++zz) {
-        SC_CHECK_ABORT (gdata[zz] <= gdata[zz + 1], "Parallel sort failed");
-      }
-    }
-    SC_FREE (gdata);
-    SC_FREE (displ);
-    SC_FREE (recvc);
+    gdata = test_sort_gather (mpicomm, ldata, nmemb);
   }
 
+  /* compare with the sample sort algorithms */
+  test_sort_sample (mpicomm, odata, ldata, gdata, nmemb, elapsed_bitonic);
+  SC_FREE (gdata);
+  test_sort_key (mpicomm, nmemb, rank);
+
   /* clean up and exit */
+  SC_FREE (odata);
   SC_FREE (ldata);
   SC_FREE (nmemb);
 
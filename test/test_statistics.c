@@ -0,0 +1,140 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_statistics.h>
+
+#define TEST_STATISTICS_VALUES 100
+#define TEST_STATISTICS_STEPS 3
+
+/* The values of all processes are 1, 2, ..., mpisize times the count.
+ * They are integers to make the sums independent of the reduction order. */
+static double
+test_statistics_value (int mpirank, int j)
+{
+  return (double) (mpirank * TEST_STATISTICS_VALUES + j + 1);
+}
+
+static int
+test_statistics_equal (const sc_statinfo_t * a, const sc_statinfo_t * b)
+{
+  return a->count == b->count && a->sum_values == b->sum_values &&
+    a->sum_squares == b->sum_squares && a->min == b->min &&
+    a->max == b->max && a->min_at_rank == b->min_at_rank &&
+    a->max_at_rank == b->max_at_rank && a->average == b->average &&
+    a->standev == b->standev;
+}
+
+static void
+test_statistics_quantile (sc_statistics_t * stats, const char *name,
+                          long count, double q)
+{
+  double              exact, estimate;
+
+  /* the value at position q (count - 1) in sorted order */
+  exact = floor (q * (count - 1)) + 1;
+  estimate = sc_statistics_quantile (stats, name, q);
+  SC_CHECK_ABORTF (fabs (estimate - exact) <=
+                   SC_STATS_SKETCH_ACCURACY * exact + 1e-12,
+                   "Quantile %g of %s is %g, not %g", q, name,
+                   estimate, exact);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpirank, mpisize;
+  int                 step, j;
+  long                count;
+  double              value;
+  sc_MPI_Comm         mpicomm;
+  sc_statinfo_t       si[2];
+  sc_statistics_t    *stats;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  stats = sc_statistics_new (mpicomm);
+  sc_statistics_add_empty (stats, "Many");
+  sc_statistics_add (stats, "Single");
+  sc_statistics_add_empty (stats, "Plain");
+  sc_statistics_add_sketch (stats, "Many");
+  sc_statistics_add_sketch (stats, "Single");
+
+  /* reuse the statistics for several steps as an application would */
+  count = (long) mpisize * TEST_STATISTICS_VALUES;
+  for (step = 0; step < TEST_STATISTICS_STEPS; ++step) {
+    sc_statistics_reset (stats);
+    sc_stats_init (&si[0], "Many");
+    sc_stats_init (&si[1], "Plain");
+    for (j = 0; j < TEST_STATISTICS_VALUES; ++j) {
+      value = test_statistics_value (mpirank, j);
+      sc_statistics_accumulate (stats, "Many", value);
+      sc_stats_accumulate (&si[0], value);
+      if (j % 2 == step % 2) {
+        sc_statistics_accumulate (stats, "Plain", -value);
+        sc_stats_accumulate (&si[1], -value);
+      }
+    }
+    sc_statistics_set (stats, "Single", (double) (mpirank + 1));
+
+    /* the nonblocking computation agrees with the blocking one */
+    sc_statistics_compute_begin (stats);
+    sc_stats_compute (mpicomm, 2, si);
+    sc_statistics_compute_end (stats);
+    SC_CHECK_ABORT (test_statistics_equal
+                    ((sc_statinfo_t *) sc_array_index (stats->sarray, 0),
+                     &si[0]), "Mismatch of Many");
+    SC_CHECK_ABORT (test_statistics_equal
+                    ((sc_statinfo_t *) sc_array_index (stats->sarray, 2),
+                     &si[1]), "Mismatch of Plain");
+    SC_CHECK_ABORT (si[0].count == count, "Count mismatch");
+
+    /* quantiles of the values 1, ..., count */
+    test_statistics_quantile (stats, "Many", count, 0.);
+    test_statistics_quantile (stats, "Many", count, .5);
+    test_statistics_quantile (stats, "Many", count, .99);
+    test_statistics_quantile (stats, "Many", count, 1.);
+    SC_CHECK_ABORT (fabs (sc_statistics_quantile (stats, "Single", .5) -
+                          ((mpisize - 1) / 2 + 1)) <=
+                    SC_STATS_SKETCH_ACCURACY * ((mpisize - 1) / 2 + 1),
+                    "Quantile of Single");
+  }
+  sc_statistics_print (stats, sc_package_id, SC_LP_STATISTICS, 1, 0);
+  sc_statistics_destroy (stats);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,122 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_allgather.h>
+#include <sc_timeline.h>
+
+#define TEST_TIMELINE_REPS 10
+
+/* count the occurrences of a string in a file */
+static int
+test_timeline_count (const char *filename, const char *needle)
+{
+  int                 count;
+  long                size;
+  char               *text, *pos;
+  FILE               *file;
+
+  file = fopen (filename, "rb");
+  SC_CHECK_ABORT (file != NULL, "Open timeline");
+  SC_CHECK_ABORT (!fseek (file, 0, SEEK_END), "Seek timeline");
+  size = ftell (file);
+  SC_CHECK_ABORT (size > 0, "Empty timeline");
+  rewind (file);
+  text = SC_ALLOC (char, size + 1);
+  SC_CHECK_ABORT (fread (text, 1, (size_t) size, file) == (size_t) size,
+                  "Read timeline");
+  text[size] = '\0';
+  SC_CHECK_ABORT (!fclose (file), "Close timeline");
+
+  SC_CHECK_ABORT (!strncmp (text, "{\"traceEvents\":[", 16),
+                  "Timeline header");
+  for (count = 0, pos = text; (pos = strstr (pos, needle)) != NULL; ++pos) {
+    ++count;
+  }
+  SC_FREE (text);
+  return count;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpirank, mpisize;
+  int                 i, *all;
+  int                 gather;
+  char                filename[BUFSIZ];
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* nothing is recorded while the timeline is inactive */
+  SC_TIMELINE_BEGIN ("test_inactive");
+  SC_TIMELINE_END ("test_inactive");
+
+  all = SC_ALLOC (int, mpisize);
+  for (gather = 0; gather < 2; ++gather) {
+    sc_timeline_start (mpicomm, "sc_test_timeline", gather);
+    for (i = 0; i < TEST_TIMELINE_REPS; ++i) {
+      SC_TIMELINE_BEGIN ("test_outer");
+      sc_allgather (&mpirank, 1, sc_MPI_INT, all, 1, sc_MPI_INT, mpicomm);
+      SC_TIMELINE_END ("test_outer");
+    }
+    SC_CHECK_ABORT (!sc_timeline_stop (), "Timeline stop");
+
+    /* check the events of this process or all of them */
+    if (!gather) {
+      snprintf (filename, BUFSIZ, "sc_test_timeline.%d.json", mpirank);
+    }
+    else {
+      snprintf (filename, BUFSIZ, "sc_test_timeline.json");
+    }
+    if (!gather || mpirank == 0) {
+      i = gather ? mpisize : 1;
+      SC_CHECK_ABORT (test_timeline_count (filename, "\"test_outer\"") ==
+                      2 * TEST_TIMELINE_REPS * i, "Outer events");
+      SC_CHECK_ABORT (test_timeline_count (filename, "\"sc_allgather\"") ==
+                      2 * TEST_TIMELINE_REPS * i, "Allgather events");
+      SC_CHECK_ABORT (test_timeline_count (filename, "\"process_name\"") ==
+                      i, "Process events");
+      SC_CHECK_ABORT (test_timeline_count (filename, "test_inactive") == 0,
+                      "Inactive events");
+      SC_CHECK_ABORT (!remove (filename), "Remove timeline");
+    }
+  }
+  SC_FREE (all);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
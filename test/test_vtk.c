@@ -0,0 +1,494 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/* Write VTK data with 64-bit headers in all formats and parse it back.
+ * Then write a parallel unstructured grid into one file and verify it. */
+
+#include <sc_vtk.h>
+#ifdef SC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/* read the complete contents of a stream */
+static sc_array_t  *
+test_slurp (FILE * file)
+{
+  long                size;
+  sc_array_t         *contents;
+
+  SC_CHECK_ABORT (fseek (file, 0, SEEK_END) == 0, "seek end");
+  size = ftell (file);
+  SC_CHECK_ABORT (size >= 0, "tell");
+  rewind (file);
+  contents = sc_array_new_count (1, (size_t) size);
+  SC_CHECK_ABORT (fread (contents->array, 1, (size_t) size, file) ==
+                  (size_t) size, "read");
+  rewind (file);
+  return contents;
+}
+
+/* decode one base 64 stream that ends at the first '=' or the end */
+static size_t
+test_base64_decode (const char *code, size_t length, char *out,
+                    size_t *consumed)
+{
+  static const char  *alphabet =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  const char         *p;
+  size_t              i, o;
+  int                 bits;
+  unsigned long       acc;
+
+  acc = 0;
+  bits = 0;
+  for (i = o = 0; i < length && code[i] != '='; ++i) {
+    p = strchr (alphabet, code[i]);
+    SC_CHECK_ABORT (p != NULL && *p != '\0', "base64 character");
+    acc = ((acc << 6) | (unsigned long) (p - alphabet)) & 0xffffffUL;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out[o++] = (char) (acc >> bits);
+    }
+  }
+  while (i < length && code[i] == '=') {
+    ++i;
+  }
+  *consumed = i;
+  return o;
+}
+
+/* the raw output of the base 64 format */
+static sc_array_t  *
+test_unbase64 (sc_array_t * code, int compressed)
+{
+  size_t              o, used, header_code;
+  uint64_t            num_blocks;
+  sc_array_t         *raw;
+
+  raw = sc_array_new_count (1, code->elem_count);
+  if (compressed) {
+    /* the header is a separate stream of known length */
+    SC_CHECK_ABORT (code->elem_count >= 12, "compressed header");
+    (void) test_base64_decode (code->array, 12, raw->array, &used);
+    memcpy (&num_blocks, raw->array, 8);
+    header_code = 4 * ((8 * (3 + (size_t) num_blocks) + 2) / 3);
+    SC_CHECK_ABORT (header_code <= code->elem_count, "header length");
+    o = test_base64_decode (code->array, header_code, raw->array, &used);
+    SC_CHECK_ABORT (o == 8 * (3 + (size_t) num_blocks) &&
+                    used == header_code, "header stream");
+  }
+  else {
+    o = used = 0;
+  }
+  o += test_base64_decode (code->array + used, code->elem_count - used,
+                           raw->array + o, &used);
+  sc_array_resize (raw, o);
+  return raw;
+}
+
+static void
+test_binary (const char *data, size_t length)
+{
+  int                 retval;
+  FILE               *file;
+  uint64_t            header;
+  sc_array_t         *raw, *code, *decoded;
+
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "tmpfile");
+  retval = sc_vtk_write_binary_uint64 (file, data, length,
+                                       SC_VTK_FORMAT_RAW);
+  SC_CHECK_ABORT (retval == 0, "write raw");
+  raw = test_slurp (file);
+  fclose (file);
+
+  SC_CHECK_ABORT (raw->elem_count == 8 + length, "raw length");
+  memcpy (&header, raw->array, 8);
+  SC_CHECK_ABORT (header == (uint64_t) length, "raw header");
+  SC_CHECK_ABORT (!memcmp (raw->array + 8, data, length), "raw data");
+
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "tmpfile");
+  retval = sc_vtk_write_binary_uint64 (file, data, length,
+                                       SC_VTK_FORMAT_BINARY);
+  SC_CHECK_ABORT (retval == 0, "write base64");
+  code = test_slurp (file);
+  fclose (file);
+
+  SC_CHECK_ABORT (code->elem_count == 4 * ((8 + length + 2) / 3),
+                  "base64 length");
+  decoded = test_unbase64 (code, 0);
+  SC_CHECK_ABORT (sc_array_is_equal (decoded, raw), "base64 data");
+
+  sc_array_destroy (raw);
+  sc_array_destroy (code);
+  sc_array_destroy (decoded);
+}
+
+static sc_array_t  *
+test_write_compressed (const char *data, size_t length,
+                       sc_vtk_format_t format, int num_threads)
+{
+  int                 retval;
+  FILE               *file;
+  sc_array_t         *contents;
+
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "tmpfile");
+
+  /* the data must be placed correctly after other content */
+  fputs ("_", file);
+  retval = sc_vtk_write_compressed_uint64 (file, data, length, format,
+                                           6, num_threads);
+  SC_CHECK_ABORT (retval == 0, "write compressed");
+  contents = test_slurp (file);
+  fclose (file);
+
+  SC_CHECK_ABORT (contents->elem_count > 0 && contents->array[0] == '_',
+                  "leading content");
+  memmove (contents->array, contents->array + 1, contents->elem_count - 1);
+  sc_array_resize (contents, contents->elem_count - 1);
+  return contents;
+}
+
+static void
+test_compressed (const char *data, size_t length)
+{
+  size_t              zb, pos;
+  uint64_t            header[3], csize;
+  sc_array_t         *raw, *other, *code, *decoded;
+#ifdef SC_HAVE_ZLIB
+  size_t              bsize;
+  uLongf              ulen;
+  sc_array_t         *block;
+#endif
+
+  raw = test_write_compressed (data, length, SC_VTK_FORMAT_RAW, 1);
+
+  /* parse the header and the blocks */
+  SC_CHECK_ABORT (raw->elem_count >= 24, "compressed header");
+  memcpy (header, raw->array, 24);
+  SC_CHECK_ABORT (header[0] == (length + 32767) / 32768, "block count");
+  SC_CHECK_ABORT (header[1] == 32768, "block size");
+  SC_CHECK_ABORT (header[2] == (length % 32768 > 0 || length == 0 ?
+                                length % 32768 : 32768), "last block size");
+  pos = 8 * (3 + (size_t) header[0]);
+#ifdef SC_HAVE_ZLIB
+  block = sc_array_new_count (1, 32768);
+#endif
+  for (zb = 0; zb < header[0]; ++zb) {
+    memcpy (&csize, raw->array + 8 * (3 + zb), 8);
+    SC_CHECK_ABORT (pos + csize <= raw->elem_count, "compressed size");
+#ifdef SC_HAVE_ZLIB
+    bsize = zb + 1 < header[0] ? 32768 : (size_t) header[2];
+    ulen = (uLongf) bsize;
+    SC_CHECK_ABORT (uncompress ((Bytef *) block->array, &ulen,
+                                (const Bytef *) raw->array + pos,
+                                (uLong) csize) == Z_OK, "uncompress");
+    SC_CHECK_ABORT (ulen == (uLongf) bsize, "uncompressed size");
+    SC_CHECK_ABORT (!memcmp (block->array, data + zb * 32768, bsize),
+                    "uncompressed data");
+#endif
+    pos += (size_t) csize;
+  }
+  SC_CHECK_ABORT (pos == raw->elem_count, "compressed length");
+#ifdef SC_HAVE_ZLIB
+  sc_array_destroy (block);
+#endif
+
+  /* threads do not change the output */
+  other = test_write_compressed (data, length, SC_VTK_FORMAT_RAW, 3);
+  SC_CHECK_ABORT (sc_array_is_equal (raw, other), "threaded output");
+  sc_array_destroy (other);
+
+  /* base 64 encodes header and blocks separately */
+  code = test_write_compressed (data, length, SC_VTK_FORMAT_BINARY, 2);
+  decoded = test_unbase64 (code, 1);
+  SC_CHECK_ABORT (sc_array_is_equal (decoded, raw), "base64 compressed");
+
+  sc_array_destroy (raw);
+  sc_array_destroy (code);
+  sc_array_destroy (decoded);
+}
+
+/* the local mesh of one rank: a chain of line cells, some ranks empty */
+typedef struct test_piece
+{
+  size_t              num_points, num_cells;
+  double             *points, *u;
+  int64_t            *connectivity, *offsets;
+  uint8_t            *types;
+  int32_t            *id;
+}
+test_piece_t;
+
+static void
+test_piece_init (test_piece_t * piece, int rank)
+{
+  size_t              zz;
+
+  piece->num_cells = rank % 3 == 1 ? 0 : (size_t) (100 * rank + 2);
+  piece->num_points = piece->num_cells > 0 ? piece->num_cells + 1 : 0;
+  piece->points = SC_ALLOC (double, 3 * piece->num_points);
+  piece->u = SC_ALLOC (double, piece->num_points);
+  for (zz = 0; zz < piece->num_points; ++zz) {
+    piece->points[3 * zz] = rank + zz / (double) piece->num_points;
+    piece->points[3 * zz + 1] = piece->points[3 * zz + 2] = 0.;
+    piece->u[zz] = piece->points[3 * zz] * piece->points[3 * zz];
+  }
+  piece->connectivity = SC_ALLOC (int64_t, 2 * piece->num_cells);
+  piece->offsets = SC_ALLOC (int64_t, piece->num_cells);
+  piece->types = SC_ALLOC (uint8_t, piece->num_cells);
+  piece->id = SC_ALLOC (int32_t, 2 * piece->num_cells);
+  for (zz = 0; zz < piece->num_cells; ++zz) {
+    piece->connectivity[2 * zz] = (int64_t) zz;
+    piece->connectivity[2 * zz + 1] = (int64_t) zz + 1;
+    piece->offsets[zz] = 2 * (int64_t) (zz + 1);
+    piece->types[zz] = 3;       /* VTK_LINE */
+    piece->id[2 * zz] = rank;
+    piece->id[2 * zz + 1] = (int32_t) zz;
+  }
+}
+
+static void
+test_piece_reset (test_piece_t * piece)
+{
+  SC_FREE (piece->points);
+  SC_FREE (piece->u);
+  SC_FREE (piece->connectivity);
+  SC_FREE (piece->offsets);
+  SC_FREE (piece->types);
+  SC_FREE (piece->id);
+}
+
+/* check one array in the appended section and return its block size */
+static size_t
+test_vtu_block (const char *block, const void *expected, size_t bytes,
+                int compressed)
+{
+  uint64_t            header[3], csize;
+  size_t              zb, pos;
+#ifdef SC_HAVE_ZLIB
+  uLongf              ulen;
+  char                buffer[32768];
+#endif
+
+  if (!compressed) {
+    memcpy (header, block, 8);
+    SC_CHECK_ABORT (header[0] == (uint64_t) bytes, "vtu raw header");
+    SC_CHECK_ABORT (bytes == 0 || !memcmp (block + 8, expected, bytes),
+                    "vtu raw data");
+    return 8 + bytes;
+  }
+  memcpy (header, block, 24);
+  SC_CHECK_ABORT (header[0] == (bytes + 32767) / 32768, "vtu block count");
+  pos = 8 * (3 + (size_t) header[0]);
+  for (zb = 0; zb < header[0]; ++zb) {
+    memcpy (&csize, block + 8 * (3 + zb), 8);
+#ifdef SC_HAVE_ZLIB
+    ulen = sizeof (buffer);
+    SC_CHECK_ABORT (uncompress ((Bytef *) buffer, &ulen,
+                                (const Bytef *) block + pos,
+                                (uLong) csize) == Z_OK, "vtu uncompress");
+    SC_CHECK_ABORT (ulen == SC_MIN (32768, bytes - 32768 * zb) &&
+                    !memcmp (buffer, (const char *) expected + 32768 * zb,
+                             ulen), "vtu compressed data");
+#endif
+    pos += (size_t) csize;
+  }
+  return pos;
+}
+
+/* find the next offset attribute and return the block it points to */
+static const char  *
+test_vtu_next (const char **cursor, const char *appended)
+{
+  const char         *p;
+
+  p = strstr (*cursor, "offset=\"");
+  SC_CHECK_ABORT (p != NULL && p < appended, "vtu offset attribute");
+  *cursor = p + 8;
+  return appended + strtoull (*cursor, NULL, 10);
+}
+
+static void
+test_vtu (sc_MPI_Comm mpicomm, int compressed)
+{
+  int                 mpiret, mpisize, mpirank, r;
+  const char         *filename = "sc_test_vtk.vtu";
+  const char         *cursor, *appended, *block;
+  char                expect[BUFSIZ];
+  size_t              end;
+  sc_array_t         *contents;
+  sc_vtk_vtu_t       *vtu;
+  test_piece_t        piece;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* each rank writes its piece into the shared file */
+  test_piece_init (&piece, mpirank);
+  vtu = sc_vtk_vtu_new (mpicomm, piece.num_points, piece.num_cells);
+  if (compressed) {
+    sc_vtk_vtu_set_compression (vtu, 6, 2);
+  }
+  sc_vtk_vtu_add_point_data (vtu, "u", SC_VTK_FLOAT64, 1, piece.u);
+  sc_vtk_vtu_add_cell_data (vtu, "id", SC_VTK_INT32, 2, piece.id);
+  sc_vtk_vtu_set_points (vtu, SC_VTK_FLOAT64, piece.points);
+  sc_vtk_vtu_set_cells (vtu, piece.connectivity, piece.offsets,
+                        piece.types);
+  SC_CHECK_ABORT (sc_vtk_vtu_write (vtu, filename) == sc_MPI_SUCCESS,
+                  "vtu write");
+  sc_vtk_vtu_destroy (vtu);
+  test_piece_reset (&piece);
+
+  /* rank 0 parses the file and compares with the pieces of all ranks */
+  if (mpirank == 0) {
+    contents = sc_array_new (1);
+    SC_CHECK_ABORT (!sc_io_file_load (filename, contents), "vtu load");
+    *(char *) sc_array_push (contents) = '\0';
+    SC_CHECK_ABORT (strstr (contents->array, "header_type=\"UInt64\"") &&
+                    (strstr (contents->array, "vtkZLibDataCompressor")
+                     != NULL) == compressed, "vtu file header");
+    appended = strstr (contents->array, "<AppendedData encoding=\"raw\">");
+    SC_CHECK_ABORT (appended != NULL, "vtu appended section");
+    appended = strchr (appended, '_') + 1;
+
+    cursor = contents->array;
+    end = 0;
+    for (r = 0; r < mpisize; ++r) {
+      test_piece_init (&piece, r);
+      snprintf (expect, BUFSIZ, "<Piece NumberOfPoints=\"%lu\" "
+                "NumberOfCells=\"%lu\">", (unsigned long) piece.num_points,
+                (unsigned long) piece.num_cells);
+      cursor = strstr (cursor, expect);
+      SC_CHECK_ABORT (cursor != NULL && cursor < appended, "vtu piece");
+
+      /* the arrays appear in the order point, cell data, points, cells */
+      block = test_vtu_next (&cursor, appended);
+      end = SC_MAX (end, (size_t) (block - appended) + test_vtu_block
+                    (block, piece.u, 8 * piece.num_points, compressed));
+      block = test_vtu_next (&cursor, appended);
+      end = SC_MAX (end, (size_t) (block - appended) + test_vtu_block
+                    (block, piece.id, 8 * piece.num_cells, compressed));
+      block = test_vtu_next (&cursor, appended);
+      end = SC_MAX (end, (size_t) (block - appended) + test_vtu_block
+                    (block, piece.points, 24 * piece.num_points,
+                     compressed));
+      block = test_vtu_next (&cursor, appended);
+      end = SC_MAX (end, (size_t) (block - appended) + test_vtu_block
+                    (block, piece.connectivity, 16 * piece.num_cells,
+                     compressed));
+      block = test_vtu_next (&cursor, appended);
+      end = SC_MAX (end, (size_t) (block - appended) + test_vtu_block
+                    (block, piece.offsets, 8 * piece.num_cells, compressed));
+      block = test_vtu_next (&cursor, appended);
+      end = SC_MAX (end, (size_t) (block - appended) + test_vtu_block
+                    (block, piece.types, piece.num_cells, compressed));
+      test_piece_reset (&piece);
+    }
+    SC_CHECK_ABORT (strstr (cursor, "offset=\"") == NULL ||
+                    strstr (cursor, "offset=\"") > appended,
+                    "vtu extra arrays");
+    SC_CHECK_ABORT (!strcmp (appended + end,
+                             "\n  </AppendedData>\n</VTKFile>\n"),
+                    "vtu file end");
+    sc_array_destroy (contents);
+  }
+}
+
+/* arrays differing between the processes are reported on all of them */
+static void
+test_vtu_mismatch (sc_MPI_Comm mpicomm)
+{
+  int                 mpiret, mpisize, mpirank, variant, last;
+  sc_vtk_vtu_t       *vtu;
+  test_piece_t        piece;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (mpisize == 1) {
+    return;
+  }
+
+  test_piece_init (&piece, mpirank);
+  last = mpirank == mpisize - 1;
+  for (variant = 0; variant < 3; ++variant) {
+    vtu = sc_vtk_vtu_new (mpicomm, piece.num_points, piece.num_cells);
+    sc_vtk_vtu_add_point_data (vtu, last && variant == 0 ? "v" : "u",
+                               last && variant == 1 ? SC_VTK_INT64 :
+                               SC_VTK_FLOAT64, 1, piece.u);
+    sc_vtk_vtu_add_cell_data (vtu, "id", SC_VTK_INT32,
+                              last && variant == 2 ? 1 : 2, piece.id);
+    sc_vtk_vtu_set_points (vtu, SC_VTK_FLOAT64, piece.points);
+    sc_vtk_vtu_set_cells (vtu, piece.connectivity, piece.offsets,
+                          piece.types);
+    SC_CHECK_ABORT (sc_vtk_vtu_write (vtu, "sc_test_vtk_mismatch.vtu") ==
+                    sc_MPI_ERR_ARG, "vtu mismatch");
+    sc_vtk_vtu_destroy (vtu);
+  }
+  test_piece_reset (&piece);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              i, il;
+  const size_t        lengths[] = { 0, 1, 100, 32768, 3 * 32768 + 1234,
+    40 * 32768 + 7
+  };
+  char               *data;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* compressible data with some variation */
+  data = SC_ALLOC (char, lengths[5]);
+  for (i = 0; i < lengths[5]; ++i) {
+    data[i] = (char) ((i * i) % 251 < 100 ? i % 7 : (i >> 5));
+  }
+
+  for (il = 0; il < sizeof (lengths) / sizeof (lengths[0]); ++il) {
+    SC_GLOBAL_LDEBUGF ("Testing VTK data of %lu bytes\n",
+                       (unsigned long) lengths[il]);
+    test_binary (data, lengths[il]);
+    test_compressed (data, lengths[il]);
+  }
+  SC_FREE (data);
+
+  test_vtu (sc_MPI_COMM_WORLD, 0);
+  test_vtu (sc_MPI_COMM_WORLD, 1);
+  test_vtu_mismatch (sc_MPI_COMM_WORLD);
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+  return 0;
+}